@@ -13,10 +13,13 @@
  * - Controller handles ALL behavior (timing, state, output)
  * - Easy to extend (PWM, multiple LEDs, complex sequences)
  * - Scales to complex animatronics without .ino bloat
+ * - Tickless: sleeps until the next toggle instead of spinning (battery props)
  */
 
 #include <Arduino.h>
+#include "../lib/include/avr_sleep_platform.h"
 #include "../lib/include/blink_controller.h"
+#include "../lib/include/tickless_runner.h"
 
 // Hardware configuration
 const int LED_PIN = 13;           // Built-in LED on most Arduino boards
@@ -39,9 +42,14 @@ struct LEDPin {
 
 // Hardware pin instance
 LEDPin led_pin;
+avr_sleep_platform avr_sleep;
 
 // Platform-agnostic controller with injected pin
-BlinkController<LEDPin> controller(led_pin, ON_DURATION_MS, OFF_DURATION_MS);
+blink_controller<LEDPin> controller(led_pin, ON_DURATION_MS, OFF_DURATION_MS);
+
+// Leonardo's USB serial port stops in power-down; idle keeps it alive between toggles
+tickless_runner<avr_sleep_platform, blink_controller<LEDPin>> runner(avr_sleep, &controller, 1,
+                                                                      sleep_depth::idle);
 
 void setup() {
     pinMode(LED_PIN, OUTPUT);
@@ -49,7 +57,7 @@ void setup() {
 }
 
 void loop() {
-    // That's it! Controller handles timing AND output.
+    // Update, then sleep until the next toggle. Controller handles timing AND output.
     // No logic here = nothing to test on hardware!
-    controller.update(millis());
+    runner.step();
 }
@@ -0,0 +1,701 @@
+#pragma once
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BLINK_HAVE_IO_URING 1
+#endif
+#endif
+
+#include "spsc_queue.h"
+
+/**
+ * @brief Asynchronous file writing for recorders and exporters
+ *
+ * Producers (the control loop, telemetry) append bytes to an async_file;
+ * filled fixed-size buffers are handed to an async_write_service thread that
+ * writes them and hands them back for reuse. The producer never calls
+ * write(2):
+ *
+ *   async_write_service service;                 // io_uring if the kernel allows it
+ *   async_file trace(service, 1 << 16, 8, overflow_policy::drop);
+ *   trace.open("show.trace");
+ *   trace.write(&record, sizeof(record));        // control loop: memcpy only
+ *   trace.close();                               // drains and reports errors
+ *
+ * Design:
+ * - Buffers are page aligned and page-multiple sized, allocated at construction
+ * - Each file talks to one worker through two SPSC queues (filled buffers out,
+ *   empty buffers back), so the producer side is lock-free; a semaphore post
+ *   wakes the worker
+ * - Full buffers go out with positional writes, so completion order doesn't matter
+ * - A worker locks its file list only to pick the next file, never across a
+ *   write, so open() and close() don't wait behind other files' I/O
+ * - When every buffer is in flight: overflow_policy::drop discards the record
+ *   and counts it (control loop); overflow_policy::block waits and counts the
+ *   wait (exporters)
+ * - Backends: io_uring (raw syscalls, IORING_OP_WRITE) when the headers exist
+ *   and the kernel/sandbox permits it, otherwise a pwrite() thread pool; a ring
+ *   whose io_uring_enter() starts failing finishes the writes the kernel took
+ *   and hands the rest to pwrite()
+ */
+
+enum class async_backend : uint8_t { thread_pool, io_uring };
+
+enum class overflow_policy : uint8_t { drop, block };
+
+struct async_file;
+struct async_write_service;
+
+/// One filled buffer on its way to the disk
+struct async_write_job {
+    async_file* file;
+    uint8_t* buffer;
+    size_t size;
+    uint64_t offset;
+};
+
+/**
+ * @brief Append-only file fed from one producer thread
+ */
+struct async_file {
+   public:
+    static constexpr size_t ALIGNMENT = 4096;
+
+    /**
+     * @param service Writer threads to use
+     * @param buffer_size Bytes per buffer (rounded up to a multiple of ALIGNMENT)
+     * @param buffer_count Buffers owned by this file (writes in flight + the one being filled)
+     * @param policy What write() does when no buffer is free
+     */
+    async_file(async_write_service& service, size_t buffer_size = 1 << 16,
+               size_t buffer_count = 8, overflow_policy policy = overflow_policy::drop);
+    ~async_file() {
+        close();
+        for (size_t i = 0; i < buffers_.size(); ++i) {
+            std::free(buffers_[i]);
+        }
+        sem_destroy(&completed_);
+    }
+
+    async_file(async_file const&) = delete;
+    async_file& operator=(async_file const&) = delete;
+
+    /**
+     * @brief Create or truncate path and start accepting writes
+     *
+     * @return false if the file cannot be created or no buffer could be allocated
+     *         (the file is then left closed)
+     */
+    bool open(char const* path);
+
+    /**
+     * @brief Append size bytes (producer thread only)
+     *
+     * A record is either appended whole or, under overflow_policy::drop,
+     * dropped whole.
+     *
+     * @return false if the record was dropped (or the file is not open)
+     */
+    bool write(void const* data, size_t size) {
+        if (!attached_) {
+            return false;
+        }
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        size_t const space = current_ == nullptr ? 0 : buffer_size_ - fill_;
+        if (policy_ == overflow_policy::drop && size > space) {
+            size_t const needed = (size - space + buffer_size_ - 1) / buffer_size_;
+            if (needed > free_.size()) {
+                bytes_dropped_ += size;
+                ++drops_;
+                return false;
+            }
+        }
+        while (size > 0) {
+            if (current_ == nullptr) {
+                current_ = acquire();
+                fill_ = 0;
+            }
+            size_t const chunk = std::min(size, buffer_size_ - fill_);
+            std::memcpy(current_ + fill_, bytes, chunk);
+            fill_ += chunk;
+            bytes += chunk;
+            size -= chunk;
+            if (fill_ == buffer_size_) {
+                submit();
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Hand the partly filled buffer to the writer now
+     *
+     * Later buffers then start at an unaligned file offset; prefer close().
+     */
+    void flush() {
+        if (current_ != nullptr && fill_ > 0) {
+            submit();
+        }
+    }
+
+    /**
+     * @brief Flush, wait for every write to finish and close the file
+     *
+     * @return false if any write failed
+     */
+    bool close();
+
+    uint64_t bytes_written() const { return bytes_written_.load(std::memory_order_relaxed); }
+    uint64_t buffers_written() const { return buffers_written_.load(std::memory_order_relaxed); }
+    /// Failed writes since open()
+    uint64_t write_errors() const { return write_errors_.load(std::memory_order_relaxed); }
+    /// Records discarded under overflow_policy::drop (producer thread)
+    uint64_t drops() const { return drops_; }
+    uint64_t bytes_dropped() const { return bytes_dropped_; }
+    /// Buffer fetches that blocked under overflow_policy::block (producer thread)
+    uint64_t backpressure_waits() const { return backpressure_waits_; }
+    /// Most buffers queued or being written at once (producer thread)
+    size_t max_in_flight() const { return max_in_flight_; }
+    size_t buffer_size() const { return buffer_size_; }
+
+   private:
+    friend struct async_write_service;
+
+    uint8_t* acquire() {
+        uint8_t* buffer = nullptr;
+        bool waited = false;
+        while (!free_.pop(buffer)) {
+            // Posts from completions nobody waited for are stale; use them up uncounted
+            if (sem_trywait(&completed_) == 0) {
+                continue;
+            }
+            if (!waited) {
+                ++backpressure_waits_;
+                waited = true;
+            }
+            sem_wait(&completed_);
+        }
+        return buffer;
+    }
+
+    void submit();
+
+    // Writer thread
+    void complete(uint8_t* buffer, size_t written, bool ok) {
+        if (ok) {
+            bytes_written_.fetch_add(written, std::memory_order_relaxed);
+            buffers_written_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+        }
+        free_.push(buffer);
+        in_flight_.fetch_sub(1, std::memory_order_release);
+        sem_post(&completed_);
+    }
+
+    async_write_service& service_;
+    size_t buffer_size_;
+    overflow_policy policy_;
+    std::vector<uint8_t*> buffers_;
+    spsc_queue<async_write_job> pending_;  // producer -> writer
+    spsc_queue<uint8_t*> free_;            // writer -> producer
+    sem_t completed_;
+    size_t worker_;
+    bool attached_;  // open and known to a worker
+    int fd_;
+    uint8_t* current_;
+    size_t fill_;
+    uint64_t offset_;
+    std::atomic<size_t> in_flight_;
+    std::atomic<uint64_t> bytes_written_;
+    std::atomic<uint64_t> buffers_written_;
+    std::atomic<uint64_t> write_errors_;
+    uint64_t drops_;
+    uint64_t bytes_dropped_;
+    uint64_t backpressure_waits_;
+    size_t max_in_flight_;
+};
+
+/**
+ * @brief Writer threads shared by every async_file
+ */
+struct async_write_service {
+   public:
+    /**
+     * @param preferred Backend to try first (io_uring falls back to the thread pool)
+     * @param threads Thread-pool size (io_uring uses one submission thread)
+     * @param ring_entries io_uring queue depth
+     */
+    explicit async_write_service(async_backend preferred = async_backend::io_uring,
+                                 unsigned threads = 2, unsigned ring_entries = 64)
+        : backend_(async_backend::thread_pool), stopping_(false) {
+        if (preferred == async_backend::io_uring) {
+            std::unique_ptr<worker> ring(new worker());
+            if (ring->ring.setup(ring_entries)) {
+                backend_ = async_backend::io_uring;
+                workers_.push_back(std::move(ring));
+            }
+        }
+        if (backend_ == async_backend::thread_pool) {
+            for (unsigned i = 0; i < std::max(1u, threads); ++i) {
+                workers_.push_back(std::unique_ptr<worker>(new worker()));
+            }
+        }
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            worker* w = workers_[i].get();
+            w->thread = std::thread([this, w]() { run(*w); });
+        }
+    }
+
+    /**
+     * @brief Stop after every queued write has completed (close files first)
+     */
+    ~async_write_service() {
+        stopping_.store(true);
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            sem_post(&workers_[i]->wake);
+            workers_[i]->thread.join();
+        }
+    }
+
+    async_write_service(async_write_service const&) = delete;
+    async_write_service& operator=(async_write_service const&) = delete;
+
+    async_backend backend() const { return backend_; }
+
+   private:
+    friend struct async_file;
+
+#ifdef BLINK_HAVE_IO_URING
+    /// Minimal io_uring: one ring, IORING_OP_WRITE only, raw syscalls (no liburing)
+    struct uring {
+        uring() : fd(-1), entries(0), in_flight(0), failed(false), sq_map(nullptr),
+                  cq_map(nullptr), sqes(nullptr) {}
+        ~uring() {
+            if (sqes != nullptr) {
+                munmap(sqes, entries * sizeof(io_uring_sqe));
+            }
+            if (cq_map != nullptr && cq_map != sq_map) {
+                munmap(cq_map, cq_size);
+            }
+            if (sq_map != nullptr) {
+                munmap(sq_map, sq_size);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        bool setup(unsigned depth) {
+            io_uring_params params;
+            std::memset(&params, 0, sizeof(params));
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+            if (fd < 0) {
+                return false;
+            }
+            entries = params.sq_entries;
+            sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool const single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if (single) {
+                sq_size = cq_size = std::max(sq_size, cq_size);
+            }
+            sq_map = map(sq_size, IORING_OFF_SQ_RING);
+            cq_map = single ? sq_map : map(cq_size, IORING_OFF_CQ_RING);
+            // Stored before checking, so the destructor unmaps whatever did succeed
+            sqes = static_cast<io_uring_sqe*>(map(entries * sizeof(io_uring_sqe),
+                                                  IORING_OFF_SQES));
+            if (sq_map == nullptr || cq_map == nullptr || sqes == nullptr) {
+                return false;
+            }
+            uint8_t* sq = static_cast<uint8_t*>(sq_map);
+            uint8_t* cq = static_cast<uint8_t*>(cq_map);
+            sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+            jobs.resize(entries);
+            for (unsigned i = 0; i < entries; ++i) {
+                free_slots.push_back(entries - 1 - i);
+            }
+            return probe();
+        }
+
+        void* map(size_t size, off_t offset) {
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                           offset);
+            return p == MAP_FAILED ? nullptr : p;
+        }
+
+        // Sandboxes can allow setup but reject or not implement writes
+        bool probe() {
+            int const devnull = ::open("/dev/null", O_WRONLY);
+            if (devnull < 0) {
+                return false;
+            }
+            uint8_t byte = 0;
+            async_write_job const job = {nullptr, &byte, 1, 0};
+            push(job, devnull);
+            int result = -1;
+            if (enter(1, 1) >= 0) {
+                unsigned const head = *cq_head;
+                if (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+                    io_uring_cqe const& cqe = cqes[head & cq_mask];
+                    result = cqe.res;
+                    free_slots.push_back(static_cast<unsigned>(cqe.user_data));
+                    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+                    --in_flight;
+                }
+            }
+            ::close(devnull);
+            return result == 1;
+        }
+
+        bool full() const { return free_slots.empty(); }
+
+        void push(async_write_job const& job, int file_fd) {
+            unsigned const slot = free_slots.back();
+            free_slots.pop_back();
+            jobs[slot] = job;
+            unsigned const tail = *sq_tail;
+            unsigned const index = tail & sq_mask;
+            io_uring_sqe& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_WRITE;
+            sqe.fd = file_fd;
+            sqe.addr = reinterpret_cast<uint64_t>(job.buffer);
+            sqe.len = static_cast<uint32_t>(job.size);
+            sqe.off = job.offset;
+            sqe.user_data = slot;
+            sq_array[index] = index;
+            __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+            ++to_submit;
+            ++in_flight;
+        }
+
+        int enter(unsigned submit, unsigned wait) {
+            int result = 0;
+            do {
+                result = static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait,
+                                                  wait > 0 ? IORING_ENTER_GETEVENTS : 0,
+                                                  nullptr, 0));
+            } while (result < 0 && errno == EINTR);
+            to_submit = result > 0 ? to_submit - static_cast<unsigned>(result) : to_submit;
+            return result;
+        }
+
+        int fd;
+        unsigned entries;
+        unsigned in_flight;
+        bool failed;  // enter() stopped working; jobs go through write_job()
+        unsigned to_submit = 0;
+        size_t sq_size = 0;
+        size_t cq_size = 0;
+        void* sq_map;
+        void* cq_map;
+        io_uring_sqe* sqes;
+        unsigned* sq_tail = nullptr;
+        unsigned sq_mask = 0;
+        unsigned* sq_array = nullptr;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe* cqes = nullptr;
+        std::vector<async_write_job> jobs;
+        std::vector<unsigned> free_slots;
+    };
+#else
+    struct uring {
+        bool setup(unsigned) { return false; }
+    };
+#endif
+
+    struct worker {
+        worker() : visiting(nullptr), reaping(false) { sem_init(&wake, 0, 0); }
+        ~worker() { sem_destroy(&wake); }
+        sem_t wake;
+        std::mutex mutex;  // guards files and visiting, never held across a write
+        std::condition_variable visited;
+        std::vector<async_file*> files;
+        async_file* visiting;  // file whose queue drain() is reading
+        bool reaping;  // completing ring writes, which may belong to any file
+        std::thread thread;
+        uring ring;
+    };
+
+    size_t attach(async_file* file) {
+        size_t const index = next_worker_++ % workers_.size();
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->files.push_back(file);
+        return index;
+    }
+
+    // The file has nothing in flight, but the worker may still be inside its complete()
+    // or popping its (empty) queue; wait that out so the file can be destroyed
+    void detach(async_file* file, size_t index) {
+        worker& w = *workers_[index];
+        std::unique_lock<std::mutex> lock(w.mutex);
+        w.files.erase(std::remove(w.files.begin(), w.files.end(), file), w.files.end());
+        w.visited.wait(lock, [&w, file]() { return w.visiting != file && !w.reaping; });
+    }
+
+    void wake(size_t index) { sem_post(&workers_[index]->wake); }
+
+    /// Blocking positional write of a whole job (handles short writes)
+    static void write_job(async_write_job const& job, size_t done = 0) {
+        while (done < job.size) {
+            ssize_t const n = ::pwrite(job.file->fd_, job.buffer + done, job.size - done,
+                                       static_cast<off_t>(job.offset + done));
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                job.file->complete(job.buffer, done, false);
+                return;
+            }
+            done += static_cast<size_t>(n);
+        }
+        job.file->complete(job.buffer, job.size, true);
+    }
+
+    void run(worker& w) {
+        for (;;) {
+            bool const stopping = stopping_.load();
+            if (!drain(w) && stopping) {
+                return;
+            }
+            if (!stopping) {
+                sem_wait(&w.wake);
+            }
+        }
+    }
+
+    /**
+     * @brief Write everything queued on this worker; returns true if anything was found
+     *
+     * The lock is taken per file only to pick it, so writes never block open() or
+     * close() of other files. Files are visited from the back: a detach shifts only
+     * files already visited, and an attach appends one whose submit wakes us again.
+     */
+    bool drain(worker& w) {
+        bool found = false;
+        std::unique_lock<std::mutex> lock(w.mutex);
+        for (size_t i = w.files.size(); i > 0; i = std::min(i - 1, w.files.size())) {
+            async_file* const file = w.files[i - 1];
+            w.visiting = file;
+            lock.unlock();
+            async_write_job job;
+            while (file->pending_.pop(job)) {
+                found = true;
+                if (backend_ == async_backend::io_uring) {
+                    ring_write(w, job);
+                } else {
+                    write_job(job);
+                }
+            }
+            lock.lock();
+            w.visiting = nullptr;
+            w.visited.notify_all();
+        }
+        lock.unlock();
+        if (backend_ == async_backend::io_uring) {
+            reap(w, 0);
+        }
+        return found;
+    }
+
+    void reap(worker& w, unsigned keep) {
+        {
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.reaping = true;
+        }
+        ring_wait(w.ring, keep);
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.reaping = false;
+        w.visited.notify_all();
+    }
+
+#ifdef BLINK_HAVE_IO_URING
+    void ring_write(worker& w, async_write_job const& job) {
+        if (!w.ring.failed && w.ring.full()) {
+            reap(w, 1);
+        }
+        if (w.ring.failed || w.ring.full()) {
+            write_job(job);
+            return;
+        }
+        w.ring.push(job, job.file->fd_);
+    }
+
+    /// Submit queued entries and reap completions until at most `keep` remain in flight
+    void ring_wait(uring& ring, unsigned keep) {
+        while (!ring.failed && (ring.to_submit > 0 || ring.in_flight > keep)) {
+            unsigned const wait = ring.in_flight > keep ? 1 : 0;
+            bool const entered = ring.enter(ring.to_submit, wait) >= 0;
+            // A failed enter (EBUSY: completion queue backlog) may still leave completions to reap
+            if (ring_complete(ring) == 0 && !entered) {
+                ring_fail(ring);
+            }
+        }
+    }
+
+    /// Complete every posted completion; returns how many there were
+    unsigned ring_complete(uring& ring) {
+        unsigned reaped = 0;
+        unsigned head = *ring.cq_head;
+        while (head != __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE)) {
+            io_uring_cqe const& cqe = ring.cqes[head & ring.cq_mask];
+            unsigned const slot = static_cast<unsigned>(cqe.user_data);
+            async_write_job const job = ring.jobs[slot];
+            int const result = cqe.res;
+            ++head;
+            ++reaped;
+            __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+            ring.free_slots.push_back(slot);
+            --ring.in_flight;
+            if (result >= 0 && static_cast<size_t>(result) == job.size) {
+                job.file->complete(job.buffer, job.size, true);
+            } else if (result > 0) {
+                write_job(job, static_cast<size_t>(result));  // finish a short write
+            } else {
+                job.file->complete(job.buffer, 0, false);
+            }
+        }
+        return reaped;
+    }
+
+    /**
+     * @brief Give up on the ring once the kernel has finished with it
+     *
+     * Entries the kernel never took are withdrawn from the submission queue
+     * and written with pwrite(). Entries it took still own their buffers, so
+     * their completions are waited for (blocking enter, retried; completions
+     * also land without one) before the buffers go back to their files. The
+     * worker uses write_job() from then on.
+     */
+    void ring_fail(uring& ring) {
+        unsigned const tail = *ring.sq_tail;
+        unsigned const first = tail - ring.to_submit;
+        __atomic_store_n(ring.sq_tail, first, __ATOMIC_RELEASE);
+        for (unsigned i = first; i != tail; ++i) {
+            unsigned const slot = static_cast<unsigned>(ring.sqes[i & ring.sq_mask].user_data);
+            ring.free_slots.push_back(slot);
+            --ring.in_flight;
+            write_job(ring.jobs[slot]);
+        }
+        ring.to_submit = 0;
+        while (ring.in_flight > 0) {
+            if (ring.enter(0, 1) < 0) {
+                std::this_thread::yield();
+            }
+            ring_complete(ring);
+        }
+        ring.failed = true;
+    }
+#else
+    void ring_write(worker&, async_write_job const& job) { write_job(job); }
+    void ring_wait(uring&, unsigned) {}
+#endif
+
+    async_backend backend_;
+    std::atomic<bool> stopping_;
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::atomic<size_t> next_worker_{0};
+};
+
+inline async_file::async_file(async_write_service& service, size_t buffer_size,
+                              size_t buffer_count, overflow_policy policy)
+    : service_(service),
+      buffer_size_((std::max<size_t>(buffer_size, 1) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT),
+      policy_(policy),
+      pending_(buffer_count),
+      free_(buffer_count),
+      worker_(0),
+      attached_(false),
+      fd_(-1),
+      current_(nullptr),
+      fill_(0),
+      offset_(0),
+      in_flight_(0),
+      bytes_written_(0),
+      buffers_written_(0),
+      write_errors_(0),
+      drops_(0),
+      bytes_dropped_(0),
+      backpressure_waits_(0),
+      max_in_flight_(0) {
+    sem_init(&completed_, 0, 0);
+    for (size_t i = 0; i < buffer_count; ++i) {
+        void* memory = nullptr;
+        if (posix_memalign(&memory, ALIGNMENT, buffer_size_) == 0) {
+            buffers_.push_back(static_cast<uint8_t*>(memory));
+            free_.push(buffers_.back());
+        }
+    }
+}
+
+inline bool async_file::open(char const* path) {
+    close();
+    if (buffers_.empty()) {
+        return false;
+    }
+    fd_ = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        return false;
+    }
+    offset_ = 0;
+    write_errors_.store(0, std::memory_order_relaxed);
+    worker_ = service_.attach(this);
+    attached_ = true;
+    return true;
+}
+
+inline void async_file::submit() {
+    async_write_job const job = {this, current_, fill_, offset_};
+    offset_ += fill_;
+    current_ = nullptr;
+    fill_ = 0;
+    size_t const in_flight = in_flight_.fetch_add(1, std::memory_order_acquire) + 1;
+    max_in_flight_ = std::max(max_in_flight_, in_flight);
+    pending_.push(job);  // never full: it holds every buffer
+    service_.wake(worker_);
+}
+
+inline bool async_file::close() {
+    if (!attached_) {
+        return true;
+    }
+    flush();
+    while (in_flight_.load(std::memory_order_acquire) > 0) {
+        sem_wait(&completed_);
+    }
+    service_.detach(this, worker_);
+    while (sem_trywait(&completed_) == 0) {  // posts for writes nobody waited on
+    }
+    attached_ = false;
+    bool const ok = ::close(fd_) == 0 && write_errors() == 0;
+    fd_ = -1;
+    return ok;
+}
@@ -0,0 +1,581 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "spsc_queue.h"
+#include "wav_file.h"
+
+/**
+ * @brief Multi-track sound effects mixed in sync with the show clock
+ *
+ * Sound effects are 16-bit PCM WAV files mapped into memory (mapped_wav), so
+ * starting a cue costs no I/O and no decoding. The control loop cues tracks
+ * at show times; the mixer converts them to sample positions on the same
+ * clock (sample = show_time_ms * rate / 1000, so show time 0 is sample 0)
+ * and starts each voice at its exact sample inside the block being mixed.
+ * start_at() anchors the output: the first rendered frame is the one heard
+ * when the device starts plus its output latency (default: show time 0):
+ *
+ *   setup:         mixer.start_at(show_ms + 100, device_latency_frames);
+ *                  // start the mix thread, let it fill the ring, start the device at +100
+ *   control loop:  mixer.cue(door_creak, trigger_ms + 200, 0.8f, -0.5f);
+ *   mix thread:    audio_render_thread renders blocks into an audio_ring
+ *   device:        callback pulls blocks from the ring (paced_audio_sink on hosts)
+ *
+ * Design:
+ * - Nothing in the control loop touches audio data: cues are a few words
+ *   pushed into an SPSC queue, so controller load cannot stall the mixer
+ * - The mix thread renders ahead into a lock-free ring; the device side only
+ *   copies, so it is never late while the ring holds enough audio
+ * - Gain and constant-power pan are applied while widening int16 to float,
+ *   four samples per SSE2 instruction (scalar fallback)
+ * - A cue that arrives after its start sample has been mixed is started at
+ *   the current sample with its opening skipped, so it still lines up with
+ *   the lights; such cues are counted as late
+ */
+
+/**
+ * @brief Read-only memory mapping of a 16-bit PCM WAV file
+ *
+ * Samples are used in place (little-endian hosts).
+ */
+struct mapped_wav {
+   public:
+    mapped_wav() : map_(nullptr), map_size_(0), samples_(nullptr), frames_(0) {
+        layout_ = wav_layout{0, 0, 0, 0};
+    }
+
+    ~mapped_wav() { close(); }
+
+    mapped_wav(mapped_wav const&) = delete;
+    mapped_wav& operator=(mapped_wav const&) = delete;
+
+    /**
+     * @return false if the file cannot be mapped, is not 16-bit PCM, or its
+     *         samples are not 2-byte aligned
+     */
+    bool open(char const* path) {
+        close();
+        int const fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* const map = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ,
+                                 MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (map == MAP_FAILED) {
+            return false;
+        }
+        map_ = map;
+        map_size_ = static_cast<size_t>(info.st_size);
+        uint8_t const* const bytes = static_cast<uint8_t const*>(map_);
+        if (!parse_wav_layout(bytes, map_size_, layout_) || layout_.data_offset % 2 != 0) {
+            close();
+            return false;
+        }
+        ::madvise(map_, map_size_, MADV_WILLNEED);
+        samples_ = reinterpret_cast<int16_t const*>(bytes + layout_.data_offset);
+        frames_ = layout_.data_size / 2 / layout_.channels;
+        return true;
+    }
+
+    void close() {
+        if (map_ != nullptr) {
+            ::munmap(map_, map_size_);
+        }
+        map_ = nullptr;
+        map_size_ = 0;
+        samples_ = nullptr;
+        frames_ = 0;
+    }
+
+    /// Interleaved samples
+    int16_t const* samples() const { return samples_; }
+    size_t frames() const { return frames_; }
+    uint16_t channels() const { return layout_.channels; }
+    uint32_t sample_rate() const { return layout_.sample_rate; }
+
+   private:
+    void* map_;
+    size_t map_size_;
+    wav_layout layout_;
+    int16_t const* samples_;
+    size_t frames_;
+};
+
+/**
+ * @brief Add int16 source frames into a float stereo buffer, with per-side gain
+ *
+ * Portable version of audio_mix_add().
+ *
+ * @param source Interleaved mono (channels 1) or stereo (channels 2) samples
+ * @param out Interleaved stereo accumulator (2 * frames floats)
+ */
+inline void audio_mix_add_scalar(int16_t const* source, uint16_t channels, size_t frames,
+                                 float left_gain, float right_gain, float* out) {
+    for (size_t i = 0; i < frames; ++i) {
+        float const left = source[i * channels];
+        float const right = source[i * channels + channels - 1];
+        out[2 * i] += left * left_gain;
+        out[2 * i + 1] += right * right_gain;
+    }
+}
+
+/**
+ * @brief Add int16 source frames into a float stereo buffer, SIMD where available
+ *
+ * SSE2: sign-extend four samples to int32, convert to float, multiply by
+ * (left, right, left, right) gains and accumulate; mono sources are
+ * duplicated into both sides first. Sources of more than two channels mix
+ * their first and last channel.
+ */
+inline void audio_mix_add(int16_t const* source, uint16_t channels, size_t frames,
+                          float left_gain, float right_gain, float* out) {
+    size_t done = 0;
+#if defined(__SSE2__)
+    __m128 const gains = _mm_setr_ps(left_gain, right_gain, left_gain, right_gain);
+    if (channels == 2) {
+        for (; done + 4 <= frames; done += 4) {
+            __m128i const pcm =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + 2 * done));
+            __m128i const low = _mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16);
+            __m128i const high = _mm_srai_epi32(_mm_unpackhi_epi16(pcm, pcm), 16);
+            float* const target = out + 2 * done;
+            _mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target),
+                                             _mm_mul_ps(_mm_cvtepi32_ps(low), gains)));
+            _mm_storeu_ps(target + 4, _mm_add_ps(_mm_loadu_ps(target + 4),
+                                                 _mm_mul_ps(_mm_cvtepi32_ps(high), gains)));
+        }
+    } else if (channels == 1) {
+        for (; done + 4 <= frames; done += 4) {
+            __m128i const pcm =
+                _mm_loadl_epi64(reinterpret_cast<__m128i const*>(source + done));
+            __m128 const mono = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(pcm, pcm), 16));
+            float* const target = out + 2 * done;
+            _mm_storeu_ps(target, _mm_add_ps(_mm_loadu_ps(target),
+                                             _mm_mul_ps(_mm_unpacklo_ps(mono, mono), gains)));
+            _mm_storeu_ps(target + 4, _mm_add_ps(_mm_loadu_ps(target + 4),
+                                                 _mm_mul_ps(_mm_unpackhi_ps(mono, mono), gains)));
+        }
+    }
+#endif
+    audio_mix_add_scalar(source + done * channels, channels, frames - done, left_gain,
+                         right_gain, out + 2 * done);
+}
+
+/**
+ * @brief Convert float stereo to int16 with clipping (full scale is +-32768.0f)
+ */
+inline void audio_float_to_s16(float const* in, size_t samples, int16_t* out) {
+    for (size_t i = 0; i < samples; ++i) {
+        float const value = std::max(-32768.0f, std::min(32767.0f, in[i]));
+        out[i] = static_cast<int16_t>(std::lrint(value));
+    }
+}
+
+/**
+ * @brief Lock-free SPSC ring of interleaved stereo float frames
+ *
+ * Block-oriented counterpart of spsc_queue: write() and read() copy as many
+ * frames as fit in one or two memcpy calls and never block.
+ */
+struct audio_ring {
+   public:
+    explicit audio_ring(size_t frames)
+        : samples_(round_up_pow2(frames) * 2, 0.0f),
+          mask_(samples_.size() / 2 - 1),
+          read_(0),
+          write_(0) {}
+
+    audio_ring(audio_ring const&) = delete;
+    audio_ring& operator=(audio_ring const&) = delete;
+
+    /// Producer: append up to frames frames, returns how many fit
+    size_t write(float const* data, size_t frames) {
+        size_t const write = write_.load(std::memory_order_relaxed);
+        size_t const space = capacity() - (write - read_.load(std::memory_order_acquire));
+        size_t const count = std::min(frames, space);
+        copy_in(data, write, count);
+        write_.store(write + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Consumer: take up to frames frames, returns how many were available
+    size_t read(float* data, size_t frames) {
+        size_t const read = read_.load(std::memory_order_relaxed);
+        size_t const available = write_.load(std::memory_order_acquire) - read;
+        size_t const count = std::min(frames, available);
+        copy_out(data, read, count);
+        read_.store(read + count, std::memory_order_release);
+        return count;
+    }
+
+    /// Frames queued (exact from either end while the other is idle)
+    size_t available() const {
+        return write_.load(std::memory_order_acquire) - read_.load(std::memory_order_acquire);
+    }
+
+    size_t space() const { return capacity() - available(); }
+    size_t capacity() const { return mask_ + 1; }
+
+   private:
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    // Copy count frames out of the ring from frame position (wrapping once at most)
+    void copy_out(float* data, size_t position, size_t count) {
+        size_t const start = position & mask_;
+        size_t const first = std::min(count, capacity() - start);
+        std::memcpy(data, samples_.data() + 2 * start, first * 2 * sizeof(float));
+        std::memcpy(data + 2 * first, samples_.data(), (count - first) * 2 * sizeof(float));
+    }
+
+    void copy_in(float const* data, size_t position, size_t count) {
+        size_t const start = position & mask_;
+        size_t const first = std::min(count, capacity() - start);
+        std::memcpy(samples_.data() + 2 * start, data, first * 2 * sizeof(float));
+        std::memcpy(samples_.data(), data + 2 * first, (count - first) * 2 * sizeof(float));
+    }
+
+    std::vector<float> samples_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> read_;
+    alignas(64) std::atomic<size_t> write_;
+};
+
+/**
+ * @brief Mixes cued tracks into stereo blocks on the show clock
+ *
+ * cue() is the producer side (control loop); render() and the rest run on
+ * the mix thread.
+ */
+struct audio_mixer {
+   public:
+    /// Track handle returned by add_track()
+    typedef uint32_t track_id;
+
+    /**
+     * @param sample_rate Output rate; tracks must match it
+     * @param max_voices Voices mixed at once (further cues are dropped and counted)
+     * @param cue_capacity Cues that can wait between two renders
+     */
+    explicit audio_mixer(uint32_t sample_rate, size_t max_voices = 32, size_t cue_capacity = 256)
+        : sample_rate_(sample_rate),
+          max_voices_(max_voices),
+          cues_(cue_capacity),
+          position_(0),
+          cues_dropped_(0),
+          cues_late_(0),
+          voices_dropped_(0) {
+        voices_.reserve(max_voices);
+    }
+
+    /**
+     * @brief Register a track before the show starts (not thread-safe against render())
+     *
+     * @return false if the file is not mono/stereo at the mixer's rate
+     */
+    bool add_track(mapped_wav const& wav, track_id& id) {
+        return add_track(wav.samples(), wav.channels(), wav.frames(), wav.sample_rate(), id);
+    }
+
+    bool add_track(int16_t const* samples, uint16_t channels, size_t frames, uint32_t rate,
+                   track_id& id) {
+        if (rate != sample_rate_ || (channels != 1 && channels != 2)) {
+            return false;
+        }
+        track added;
+        added.samples = samples;
+        added.channels = channels;
+        added.frames = frames;
+        id = static_cast<track_id>(tracks_.size());
+        tracks_.push_back(added);
+        return true;
+    }
+
+    /**
+     * @brief Producer side: play a track from a show time
+     *
+     * @param gain Linear gain (1.0 = unity)
+     * @param pan -1 (left) .. 0 (centre) .. 1 (right), constant power
+     * @return false if the cue queue is full (counted)
+     */
+    bool cue(track_id track, uint32_t show_time_ms, float gain = 1.0f, float pan = 0.0f) {
+        return cue_at_sample(track, sample_at(show_time_ms), gain, pan);
+    }
+
+    bool cue_at_sample(track_id track, uint64_t start_sample, float gain = 1.0f,
+                       float pan = 0.0f) {
+        float const angle = (std::max(-1.0f, std::min(1.0f, pan)) + 1.0f) * 0.785398163f;
+        audio_cue const item = {track, start_sample, gain * std::cos(angle),
+                                gain * std::sin(angle)};
+        if (!cues_.push(item)) {
+            cues_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Tie the output to the show clock (before the mix thread starts)
+     *
+     * The device starts playing the first rendered frame at show_time_ms and
+     * each frame is heard output_latency_frames after the device takes it
+     * (its buffer and converter). render() then starts at the show sample
+     * heard first, so every cue is heard at its show time; cues before it
+     * count as late. Not thread-safe against render().
+     */
+    void start_at(uint32_t show_time_ms, uint32_t output_latency_frames = 0) {
+        position_ = sample_at(show_time_ms) + output_latency_frames;
+    }
+
+    /// Sample position of a show time
+    uint64_t sample_at(uint32_t show_time_ms) const {
+        return static_cast<uint64_t>(show_time_ms) * sample_rate_ / 1000;
+    }
+
+    /**
+     * @brief Mix the next frames into out (interleaved stereo, overwritten)
+     */
+    void render(float* out, size_t frames) {
+        accept_cues();
+        std::fill(out, out + 2 * frames, 0.0f);
+        uint64_t const end = position_ + frames;
+        for (size_t v = 0; v < voices_.size();) {
+            voice& playing = voices_[v];
+            track const& source = tracks_[playing.track];
+            if (playing.start >= end) {
+                ++v;
+                continue;
+            }
+            size_t const offset = static_cast<size_t>(playing.start - position_);
+            size_t const count =
+                std::min(frames - offset, source.frames - static_cast<size_t>(playing.cursor));
+            audio_mix_add(source.samples + playing.cursor * source.channels, source.channels,
+                          count, playing.left_gain, playing.right_gain, out + 2 * offset);
+            playing.cursor += count;
+            playing.start = std::max(playing.start, end);
+            if (playing.cursor >= source.frames) {
+                voices_[v] = voices_.back();
+                voices_.pop_back();
+            } else {
+                ++v;
+            }
+        }
+        position_ = end;
+    }
+
+    /// Next sample render() produces
+    uint64_t position() const { return position_; }
+    size_t active_voices() const { return voices_.size(); }
+    uint64_t cues_dropped() const { return cues_dropped_.load(std::memory_order_relaxed); }
+    uint64_t cues_late() const { return cues_late_; }
+    uint64_t voices_dropped() const { return voices_dropped_; }
+    uint32_t sample_rate() const { return sample_rate_; }
+
+   private:
+    struct track {
+        int16_t const* samples;
+        uint16_t channels;
+        size_t frames;
+    };
+
+    struct audio_cue {
+        track_id track;
+        uint64_t start_sample;
+        float left_gain;
+        float right_gain;
+    };
+
+    struct voice {
+        track_id track;
+        uint64_t start;   // next output sample this voice writes
+        uint64_t cursor;  // next source frame
+        float left_gain;
+        float right_gain;
+    };
+
+    // Turn queued cues into voices; late ones skip what they missed
+    void accept_cues() {
+        audio_cue item;
+        while (cues_.pop(item)) {
+            if (item.track >= tracks_.size()) {
+                continue;
+            }
+            if (voices_.size() >= max_voices_) {
+                ++voices_dropped_;
+                continue;
+            }
+            voice started = {item.track, item.start_sample, 0, item.left_gain, item.right_gain};
+            if (started.start < position_) {
+                ++cues_late_;
+                started.cursor = position_ - started.start;
+                started.start = position_;
+                if (started.cursor >= tracks_[item.track].frames) {
+                    continue;
+                }
+            }
+            voices_.push_back(started);
+        }
+    }
+
+    uint32_t sample_rate_;
+    size_t max_voices_;
+    std::vector<track> tracks_;
+    spsc_queue<audio_cue> cues_;
+    std::vector<voice> voices_;
+    uint64_t position_;
+    std::atomic<uint64_t> cues_dropped_;
+    uint64_t cues_late_;
+    uint64_t voices_dropped_;
+};
+
+/**
+ * @brief Mix thread: keeps an audio_ring topped up from an audio_mixer
+ *
+ * Renders a block whenever the ring has room for one, otherwise sleeps a
+ * fraction of a block. Latency from cue to sound is at most the ring size.
+ */
+struct audio_render_thread {
+   public:
+    audio_render_thread(audio_mixer& mixer, audio_ring& ring, size_t block_frames)
+        : mixer_(mixer), ring_(ring), block_frames_(block_frames), running_(true), blocks_(0) {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~audio_render_thread() { stop(); }
+
+    audio_render_thread(audio_render_thread const&) = delete;
+    audio_render_thread& operator=(audio_render_thread const&) = delete;
+
+    void stop() {
+        running_.store(false, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    uint64_t blocks() const { return blocks_.load(std::memory_order_relaxed); }
+
+   private:
+    void run() {
+        std::vector<float> block(2 * block_frames_);
+        long const nap_us =
+            static_cast<long>(block_frames_ * 250000 / std::max<uint32_t>(mixer_.sample_rate(), 1));
+        while (running_.load(std::memory_order_relaxed)) {
+            if (ring_.space() < block_frames_) {
+                std::this_thread::sleep_for(std::chrono::microseconds(nap_us));
+                continue;
+            }
+            mixer_.render(block.data(), block_frames_);
+            ring_.write(block.data(), block_frames_);
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    audio_mixer& mixer_;
+    audio_ring& ring_;
+    size_t block_frames_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> blocks_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Host stand-in for an audio device: pulls blocks at the sample rate
+ *
+ * Calls sink(float const* block, size_t frames) once per block period on its
+ * own thread, like a device callback. A block the ring cannot fill is an
+ * underrun: it is counted and padded with silence (the audible glitch).
+ *
+ * @tparam sink_t Callable taking (float const*, size_t); e.g. a file writer or a no-op
+ */
+template<typename sink_t>
+struct paced_audio_sink {
+   public:
+    paced_audio_sink(audio_ring& ring, uint32_t sample_rate, size_t block_frames, sink_t& sink)
+        : ring_(ring),
+          sample_rate_(sample_rate),
+          block_frames_(block_frames),
+          sink_(sink),
+          running_(true),
+          blocks_(0),
+          underruns_(0) {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~paced_audio_sink() { stop(); }
+
+    paced_audio_sink(paced_audio_sink const&) = delete;
+    paced_audio_sink& operator=(paced_audio_sink const&) = delete;
+
+    void stop() {
+        running_.store(false, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    uint64_t blocks() const { return blocks_.load(std::memory_order_relaxed); }
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+   private:
+    void run() {
+        std::vector<float> block(2 * block_frames_);
+        std::chrono::nanoseconds const period(
+            static_cast<int64_t>(block_frames_) * 1000000000 / sample_rate_);
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+        bool flowing = false;
+        while (running_.load(std::memory_order_relaxed)) {
+            deadline += period;
+            std::this_thread::sleep_until(deadline);
+            size_t const got = ring_.read(block.data(), block_frames_);
+            if (got < block_frames_) {
+                // Before the first full block the mix thread is still starting up
+                if (flowing) {
+                    underruns_.fetch_add(1, std::memory_order_relaxed);
+                }
+                std::fill(block.begin() + 2 * static_cast<long>(got), block.end(), 0.0f);
+            } else {
+                flowing = true;
+            }
+            sink_(block.data(), block_frames_);
+            blocks_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    audio_ring& ring_;
+    uint32_t sample_rate_;
+    size_t block_frames_;
+    sink_t& sink_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> blocks_;
+    std::atomic<uint64_t> underruns_;
+    std::thread thread_;
+};
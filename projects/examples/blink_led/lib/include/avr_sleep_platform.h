@@ -0,0 +1,86 @@
+#pragma once
+
+/**
+ * @brief tickless_runner platform for AVR Arduinos: idle on Timer0, power-down on the watchdog
+ *
+ *   avr_sleep_platform sleep;
+ *   tickless_runner<avr_sleep_platform, blink_controller<led_pin>> runner(sleep, &led, 1);
+ *   void loop() { runner.step(); }
+ *
+ * - idle: Timer0 (millis()) keeps running and its ~1 ms overflow interrupt
+ *   wakes the CPU, so the sleep ends on the millis() tick of the deadline.
+ * - power_down: Timer0 stops; the watchdog interrupt (128 kHz oscillator,
+ *   16 ms << n, up to 8 s) wakes the CPU and the runner adds the time slept
+ *   to its clock correction. The oscillator is nominal +-10%, so long
+ *   power-down gaps drift against millis() by that much.
+ * - power_save needs an asynchronous Timer2 crystal most boards lack, so it
+ *   reports step 0 and the runner skips it.
+ *
+ * Boards with native USB (Leonardo) drop the serial port in power-down;
+ * construct the runner with sleep_depth::idle as the deepest mode to keep it.
+ *
+ * Defines the watchdog ISR, so include it from one translation unit (the
+ * sketch). AVR builds need -D__STDC_LIMIT_MACROS (see tickless_runner.h).
+ */
+#if defined(__AVR__)
+#include <Arduino.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+#include "tickless_runner.h"
+
+struct avr_sleep_platform {
+   public:
+    uint32_t millis() const { return ::millis(); }
+
+    uint32_t sleep_step_ms(sleep_depth depth) const {
+        return depth == sleep_depth::idle ? 1 : depth == sleep_depth::power_down ? 16 : 0;
+    }
+
+    bool millis_runs_during(sleep_depth depth) const { return depth == sleep_depth::idle; }
+
+    /**
+     * @brief Sleep up to ms (a multiple of the depth's step)
+     *
+     * @return Milliseconds slept by the wake timer (nominal for the watchdog)
+     */
+    uint32_t sleep(sleep_depth depth, uint32_t ms) {
+        if (depth == sleep_depth::idle) {
+            uint32_t const start = ::millis();
+            set_sleep_mode(SLEEP_MODE_IDLE);
+            while (::millis() - start < ms) {
+                sleep_mode();  // any interrupt wakes; Timer0's comes every ~1 ms
+            }
+            return ms;
+        }
+        if (depth != sleep_depth::power_down) {
+            return 0;
+        }
+        uint32_t slept = 0;
+        set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+        while (ms - slept >= 16) {
+            uint8_t step = 0;  // longest watchdog period that fits, 16 ms << 9 = 8 s at most
+            while (step < 9 && (16ul << (step + 1)) <= ms - slept) {
+                ++step;
+            }
+            cli();
+            wdt_reset();
+            MCUSR &= static_cast<uint8_t>(~_BV(WDRF));
+            // Timed sequence: WDCE opens a 4-cycle window to set interrupt-only mode
+            WDTCSR = _BV(WDCE) | _BV(WDE);
+            WDTCSR = static_cast<uint8_t>(_BV(WDIE) | (step & 7) | ((step & 8) ? _BV(WDP3) : 0));
+            sleep_enable();
+            sei();  // the instruction after sei runs first, so no wake is lost before sleeping
+            sleep_cpu();
+            sleep_disable();
+            slept += 16ul << step;
+        }
+        wdt_disable();
+        return slept;
+    }
+};
+
+// The watchdog interrupt only wakes the CPU
+ISR(WDT_vect) {}
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Batched (structure-of-arrays) blink controllers
+ *
+ * Same timing as an array of blink_controller, stored column-wise: one
+ * array each for on durations, off durations, last toggle times and states.
+ * update() walks the arrays without branches, four controllers per SSE2
+ * instruction (scalar fallback), so large banks stream through the cache
+ * and frequent toggles cost no branch mispredictions. The states array is
+ * the bank's output for the backend:
+ *
+ *   blink_bank bank;
+ *   for (...) bank.add(on_ms, off_ms);
+ *   bank.update(millis());
+ *   encode(bank.states(), bank.size());
+ *
+ * Use blink_controller for a handful of outputs with their own pins; the
+ * layout report in test_perf_counters compares the two at scale.
+ */
+struct blink_bank {
+   public:
+    /**
+     * @brief Add a controller (off, last toggle 0, like a fresh blink_controller)
+     *
+     * @return Index of the controller
+     */
+    size_t add(uint32_t on_duration_ms, uint32_t off_duration_ms) {
+        on_ms_.push_back(on_duration_ms);
+        off_ms_.push_back(off_duration_ms);
+        last_toggle_ms_.push_back(0);
+        on_.push_back(0);
+        return on_.size() - 1;
+    }
+
+    /**
+     * @brief Update every controller, as blink_controller::update() would
+     */
+    void update(uint32_t current_time_ms) {
+        size_t const count = on_.size();
+        size_t i = 0;
+#if defined(__SSE2__)
+        // Unsigned elapsed < target as a signed compare of both offset by 2^31
+        __m128i const bias = _mm_set1_epi32(static_cast<int>(0x80000000u));
+        __m128i const now = _mm_set1_epi32(static_cast<int>(current_time_ms));
+        __m128i const one = _mm_set1_epi32(1);
+        for (; i + 4 <= count; i += 4) {
+            __m128i const on = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&on_[i]));
+            __m128i const last =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(&last_toggle_ms_[i]));
+            __m128i const on_mask = _mm_sub_epi32(_mm_setzero_si128(), on);
+            __m128i const target = _mm_or_si128(
+                _mm_and_si128(on_mask,
+                              _mm_loadu_si128(reinterpret_cast<__m128i const*>(&on_ms_[i]))),
+                _mm_andnot_si128(on_mask,
+                                 _mm_loadu_si128(reinterpret_cast<__m128i const*>(&off_ms_[i]))));
+            __m128i const keep = _mm_cmpgt_epi32(_mm_xor_si128(target, bias),
+                                                 _mm_xor_si128(_mm_sub_epi32(now, last), bias));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&on_[i]),
+                             _mm_xor_si128(on, _mm_andnot_si128(keep, one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&last_toggle_ms_[i]),
+                             _mm_or_si128(_mm_and_si128(keep, last), _mm_andnot_si128(keep, now)));
+        }
+#endif
+        for (; i < count; ++i) {
+            // Modular subtraction is blink_controller's wraparound-safe elapsed time
+            uint32_t const target = on_[i] != 0 ? on_ms_[i] : off_ms_[i];
+            uint32_t const toggle = current_time_ms - last_toggle_ms_[i] >= target ? 1u : 0u;
+            uint32_t const keep = toggle - 1u;  // all ones when not toggling
+            on_[i] ^= toggle;
+            last_toggle_ms_[i] = (last_toggle_ms_[i] & keep) | (current_time_ms & ~keep);
+        }
+    }
+
+    bool is_on(size_t index) const { return on_[index] != 0; }
+
+    /// One word per controller, 1 while on
+    uint32_t const* states() const { return on_.data(); }
+
+    uint32_t last_toggle(size_t index) const { return last_toggle_ms_[index]; }
+    size_t size() const { return on_.size(); }
+
+   private:
+    std::vector<uint32_t> on_ms_;
+    std::vector<uint32_t> off_ms_;
+    std::vector<uint32_t> last_toggle_ms_;
+    std::vector<uint32_t> on_;
+};
@@ -1,6 +1,24 @@
 #pragma once
 #include <cstdint>
 
+/**
+ * @brief constexpr on members whose bodies need C++14 relaxed constexpr
+ *
+ * Lets C++14 code run a blink_controller at compile time (see
+ * pattern_table.h) while the Arduino build stays C++11.
+ */
+#if __cplusplus >= 201402L
+#define BLINK_CONSTEXPR14 constexpr
+#else
+#define BLINK_CONSTEXPR14
+#endif
+
+/// On/off timing of one blink_controller (shows, pattern tables)
+struct blink_timing {
+    uint32_t on_ms;
+    uint32_t off_ms;
+};
+
 /**
  * @brief Platform-agnostic LED blink timing controller with dependency injection
  *
@@ -13,6 +31,11 @@
  *
  * @tparam output_pin_t Type that implements set(bool) method
  *
+ * Times and durations only have to share a unit. The _ms names follow the
+ * usual millis() clock; feed micros() instead and the durations are
+ * microseconds, for strobes above ~100 Hz (see strobe_runner.h). A uint32_t
+ * microsecond clock wraps every ~71.6 minutes, handled like the millisecond wrap.
+ *
  * Example Usage:
  *
  * // Hardware implementation
@@ -43,7 +66,8 @@ struct blink_controller {
      * @param on_duration_ms How long LED stays on (milliseconds)
      * @param off_duration_ms How long LED stays off (milliseconds)
      */
-    blink_controller(output_pin_t& output, uint32_t on_duration_ms, uint32_t off_duration_ms)
+    constexpr blink_controller(output_pin_t& output, uint32_t on_duration_ms,
+                               uint32_t off_duration_ms)
         : output_(output),
           on_duration_ms_(on_duration_ms),
           off_duration_ms_(off_duration_ms),
@@ -59,9 +83,9 @@ struct blink_controller {
      *
      * @param current_time_ms Current time in milliseconds
      */
-    void update(uint32_t current_time_ms) {
+    BLINK_CONSTEXPR14 void update(uint32_t current_time_ms) {
         // Calculate time elapsed since last toggle
-        uint32_t elapsed;
+        uint32_t elapsed = 0;
         if (current_time_ms >= last_toggle_time_ms_) {
             // Normal case: no wraparound
             elapsed = current_time_ms - last_toggle_time_ms_;
@@ -89,17 +113,84 @@ struct blink_controller {
      * LED will be off, timer will be reset to 0.
      * Also updates the output pin to OFF state.
      */
-    void reset() {
+    BLINK_CONSTEXPR14 void reset() {
         last_toggle_time_ms_ = 0;
         led_on_ = false;
         output_.set(false);
     }
 
+    /**
+     * @brief Restart the blink cycle from a given time
+     *
+     * LED turns off and the off period starts counting from current_time_ms,
+     * so the next edge lands exactly off_duration_ms later. Used by show
+     * triggers to re-phase a controller without waiting for its next toggle.
+     *
+     * @param current_time_ms Time the new cycle starts (milliseconds)
+     */
+    BLINK_CONSTEXPR14 void restart(uint32_t current_time_ms) {
+        last_toggle_time_ms_ = current_time_ms;
+        led_on_ = false;
+        output_.set(false);
+    }
+
+    /**
+     * @brief Put the controller where an uninterrupted cycle from time 0 would be
+     *
+     * The cycle is restart(0)'s: off for off_duration_ms, then on for
+     * on_duration_ms, repeating. The LED state and the start of the running
+     * period follow from current_time_ms, so the next edge lands where it
+     * would have had the controller played through. Used by show seeks.
+     *
+     * @param current_time_ms Time to align to (milliseconds since the cycle origin)
+     */
+    BLINK_CONSTEXPR14 void align(uint32_t current_time_ms) {
+        uint32_t const period = on_duration_ms_ + off_duration_ms_;
+        uint32_t const phase = period == 0 ? 0 : current_time_ms % period;
+        led_on_ = period != 0 && phase >= off_duration_ms_;
+        last_toggle_time_ms_ = current_time_ms - (led_on_ ? phase - off_duration_ms_ : phase);
+        output_.set(led_on_);
+    }
+
+    /**
+     * @brief Change the on/off durations without re-phasing
+     *
+     * The running on or off period keeps its start time, so the next edge
+     * lands at the last toggle plus the new duration (on the next update if
+     * that time has already passed). Used by live show reloads.
+     *
+     * @param on_duration_ms New on duration (milliseconds)
+     * @param off_duration_ms New off duration (milliseconds)
+     */
+    BLINK_CONSTEXPR14 void set_durations(uint32_t on_duration_ms, uint32_t off_duration_ms) {
+        on_duration_ms_ = on_duration_ms;
+        off_duration_ms_ = off_duration_ms;
+    }
+
+    /**
+     * @brief Time until update() will next toggle the LED
+     *
+     * In the unit of the durations and clock (milliseconds, or microseconds
+     * for a strobe_runner); 0 if the toggle is already due. Lets a tickless
+     * loop sleep until the earliest toggle of all its controllers instead of
+     * polling.
+     *
+     * @param current_time_ms Current time in milliseconds
+     */
+    constexpr uint32_t until_toggle(uint32_t current_time_ms) const {
+        // Modular subtraction is the same wraparound-safe elapsed time update() uses
+        return current_time_ms - last_toggle_time_ms_ >= (led_on_ ? on_duration_ms_
+                                                                  : off_duration_ms_)
+                   ? 0
+                   : (led_on_ ? on_duration_ms_ : off_duration_ms_) -
+                         (current_time_ms - last_toggle_time_ms_);
+    }
+
     // Getters for testing and state inspection
-    uint32_t get_on_duration() const { return on_duration_ms_; }
-    uint32_t get_off_duration() const { return off_duration_ms_; }
-    bool is_on() const { return led_on_; }
-    uint32_t get_last_toggle_time() const { return last_toggle_time_ms_; }
+    constexpr uint32_t get_on_duration() const { return on_duration_ms_; }
+    constexpr uint32_t get_off_duration() const { return off_duration_ms_; }
+    constexpr bool is_on() const { return led_on_; }
+    constexpr uint32_t get_last_toggle_time() const { return last_toggle_time_ms_; }
 
    private:
     output_pin_t& output_;
@@ -0,0 +1,340 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Capacity planner: can a board drive a planned layout at the show's frame rate?
+ *
+ * Before buying hardware, each planned board gets a load (controllers plus
+ * bytes per frame on each of its buses) and is checked against a model of
+ * the board: CPU cycles per controller update, per frame and per byte fed
+ * to a peripheral (from the avr_bench target / the layout report), and a timing model
+ * per bus. The report gives each resource's share of the frame period, the
+ * bottleneck and the highest frame rate the board could sustain:
+ *
+ *   # board <name> <preset> [mhz N] [update_cycles N] [frame_cycles N] [byte_cycles N]
+ *   board porch avr
+ *   # bus <board> <i2c|spi|uart|dmx> [bit_rate]
+ *   bus porch i2c 400000
+ *   controllers porch 48
+ *   # load <board> <bus index> <bytes per frame> [transactions per frame]
+ *   load porch 0 96 16
+ *   fps 50
+ *   headroom 80                            # percent of the frame period
+ *
+ * Evaluation is a few multiplications per board and allocation-free once
+ * the report vector has grown, so automated partitioning can try thousands
+ * of candidate layouts per second.
+ *
+ * Design:
+ * - Costs are per frame and linear, so utilization is cost / frame period
+ *   and the sustainable frame rate is 1 / the largest cost
+ * - Bus time is transactions x fixed overhead (addressing, start/stop, DMX
+ *   break) plus bytes x wire bits per byte / bit rate; buses run in parallel
+ *   with the CPU (DMA or interrupt driven), the CPU pays byte_cycles per byte
+ * - Preset numbers are estimates; replace them with avr_bench results for
+ *   the firmware actually shipped
+ */
+
+enum class bus_kind : uint8_t { i2c = 1, spi = 2, uart = 3, dmx = 4 };
+
+/// Timing of one peripheral bus
+struct peripheral_model {
+    bus_kind kind;
+    uint32_t bit_rate;               // bits per second
+    uint8_t bits_per_byte;           // on the wire, framing included
+    double transaction_overhead_us;  // per transaction
+    uint32_t max_transaction_bytes;  // 0 for no limit
+
+    /// I2C: 9 bit times per byte (ACK), start + address + stop per transaction
+    static peripheral_model i2c(uint32_t bit_rate = 400000) {
+        return peripheral_model{bus_kind::i2c, bit_rate, 9, 20.0 * 1e6 / bit_rate, 0};
+    }
+
+    /// SPI: 8 bit times per byte, ~1 us of chip-select handling per transaction
+    static peripheral_model spi(uint32_t bit_rate = 8000000) {
+        return peripheral_model{bus_kind::spi, bit_rate, 8, 1.0, 0};
+    }
+
+    /// UART 8N1: 10 bit times per byte
+    static peripheral_model uart(uint32_t bit_rate = 115200) {
+        return peripheral_model{bus_kind::uart, bit_rate, 10, 0.0, 0};
+    }
+
+    /// DMX512: 250 kbaud 8N2, break + mark-after-break + start code, 512 slots per universe
+    static peripheral_model dmx() {
+        return peripheral_model{bus_kind::dmx, 250000, 11, 92.0 + 12.0 + 44.0, 512};
+    }
+};
+
+/// CPU model of a board and the buses it has
+struct board_model {
+    std::string name;
+    uint32_t cpu_hz;
+    double cycles_per_update;    // one blink_controller::update()
+    double cycles_per_frame;     // fixed loop cost per frame
+    double cycles_per_bus_byte;  // CPU cost of feeding one byte to a peripheral (0 with DMA)
+    std::vector<peripheral_model> buses;
+
+    /// ATmega328P (Uno class): 16 MHz, no DMA
+    static board_model avr(std::string const& name) {
+        return board_model{name, 16000000, 90.0, 600.0, 40.0, std::vector<peripheral_model>()};
+    }
+
+    /// RP2040: 133 MHz, DMA / PIO outputs
+    static board_model rp2040(std::string const& name) {
+        return board_model{name, 133000000, 40.0, 2000.0, 0.0, std::vector<peripheral_model>()};
+    }
+
+    /// ESP32: 240 MHz, DMA outputs, some cycles lost to the radio stack
+    static board_model esp32(std::string const& name) {
+        return board_model{name, 240000000, 30.0, 20000.0, 0.0, std::vector<peripheral_model>()};
+    }
+};
+
+/// Traffic on one bus of a board, per frame
+struct bus_load {
+    uint8_t bus;  // index into board_model::buses
+    uint32_t bytes;
+    uint32_t transactions;
+};
+
+/// What one board must do every frame
+struct board_load {
+    uint32_t model;  // index into the model list
+    uint32_t controllers;
+    std::vector<bus_load> loads;
+};
+
+struct show_layout {
+    double frame_rate_hz;
+    double max_utilization;  // headroom limit for "fits", e.g. 0.8
+    std::vector<board_load> boards;
+};
+
+/// Buses per board covered by a report
+constexpr size_t PLANNER_MAX_BUSES = 8;
+
+enum class planner_bottleneck : uint8_t { cpu = 0, bus = 1, invalid = 2 };
+
+struct board_report {
+    double cpu_us;  // per frame
+    double cpu_utilization;
+    double bus_us[PLANNER_MAX_BUSES];
+    double bus_utilization[PLANNER_MAX_BUSES];
+    double utilization;  // largest of the above
+    double max_frame_rate_hz;
+    planner_bottleneck bottleneck;
+    uint8_t bottleneck_bus;  // when bottleneck == bus
+    bool fits;
+};
+
+/**
+ * @brief Evaluate one board's load
+ *
+ * A load on a bus the board does not have, or a transaction larger than the
+ * bus allows (a DMX universe is 512 slots), is reported as invalid.
+ */
+inline void plan_board(board_model const& model, board_load const& load, show_layout const& layout,
+                       board_report& report) {
+    double const frame_us = 1e6 / layout.frame_rate_hz;
+    double cycles = model.cycles_per_frame + model.cycles_per_update * load.controllers;
+    for (size_t b = 0; b < PLANNER_MAX_BUSES; ++b) {
+        report.bus_us[b] = 0.0;
+        report.bus_utilization[b] = 0.0;
+    }
+    bool valid = model.buses.size() <= PLANNER_MAX_BUSES;
+    for (size_t i = 0; i < load.loads.size(); ++i) {
+        bus_load const& traffic = load.loads[i];
+        if (traffic.bus >= model.buses.size() || traffic.bus >= PLANNER_MAX_BUSES) {
+            valid = false;
+            continue;
+        }
+        peripheral_model const& bus = model.buses[traffic.bus];
+        uint32_t const transactions = traffic.transactions == 0 ? 1 : traffic.transactions;
+        if (bus.max_transaction_bytes != 0 &&
+            traffic.bytes > static_cast<uint64_t>(bus.max_transaction_bytes) * transactions) {
+            valid = false;
+        }
+        report.bus_us[traffic.bus] += transactions * bus.transaction_overhead_us +
+                                      traffic.bytes * static_cast<double>(bus.bits_per_byte) *
+                                          1e6 / bus.bit_rate;
+        cycles += model.cycles_per_bus_byte * traffic.bytes;
+    }
+
+    report.cpu_us = cycles * 1e6 / model.cpu_hz;
+    report.cpu_utilization = report.cpu_us / frame_us;
+    report.utilization = report.cpu_utilization;
+    report.bottleneck = planner_bottleneck::cpu;
+    report.bottleneck_bus = 0;
+    double slowest_us = report.cpu_us;
+    for (size_t b = 0; b < PLANNER_MAX_BUSES; ++b) {
+        report.bus_utilization[b] = report.bus_us[b] / frame_us;
+        if (report.bus_us[b] > slowest_us) {
+            slowest_us = report.bus_us[b];
+            report.utilization = report.bus_utilization[b];
+            report.bottleneck = planner_bottleneck::bus;
+            report.bottleneck_bus = static_cast<uint8_t>(b);
+        }
+    }
+    report.max_frame_rate_hz = slowest_us > 0.0 ? 1e6 / slowest_us : 0.0;
+    if (!valid) {
+        report.bottleneck = planner_bottleneck::invalid;
+    }
+    report.fits = valid && report.utilization <= layout.max_utilization;
+}
+
+/**
+ * @brief Evaluate every board of a layout
+ *
+ * @param reports One per board (resized; reuse it across candidates to avoid allocation)
+ * @return Number of boards that do not fit
+ */
+inline size_t plan_layout(std::vector<board_model> const& models, show_layout const& layout,
+                          std::vector<board_report>& reports) {
+    reports.resize(layout.boards.size());
+    size_t overloaded = 0;
+    for (size_t i = 0; i < layout.boards.size(); ++i) {
+        board_load const& load = layout.boards[i];
+        if (load.model >= models.size()) {
+            reports[i] = board_report();
+            reports[i].bottleneck = planner_bottleneck::invalid;
+            reports[i].fits = false;
+            ++overloaded;
+            continue;
+        }
+        plan_board(models[load.model], load, layout, reports[i]);
+        overloaded += reports[i].fits ? 0 : 1;
+    }
+    return overloaded;
+}
+
+// Decimal word that fits in 32 bits
+inline bool planner_number(std::string const& word, uint32_t& value) {
+    if (word.empty() || word.size() > 10 ||
+        word.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    uint64_t const parsed = std::stoull(word);
+    value = static_cast<uint32_t>(parsed);
+    return parsed <= UINT32_MAX;
+}
+
+/**
+ * @brief Parse a show description (format in the file comment)
+ *
+ * models and layout.boards are expected empty: each board line adds a model
+ * and a board load at the same index. "fps N" sets the frame rate (default
+ * 50) and "headroom N" the fit limit in percent (default 80). Unknown
+ * presets, boards or keywords and bad numbers are errors.
+ *
+ * @param error_line 1-based line of the first bad line (0 if none)
+ */
+inline bool parse_capacity_plan(std::string const& text, std::vector<board_model>& models,
+                                show_layout& layout, size_t& error_line) {
+    error_line = 0;
+    layout.frame_rate_hz = 50.0;
+    layout.max_utilization = 0.8;
+    size_t line = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        ++line;
+        size_t end = text.find('\n', pos);
+        end = end == std::string::npos ? text.size() : end;
+        std::vector<std::string> words;
+        size_t i = pos;
+        while (i < end && text[i] != '#') {
+            if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') {
+                ++i;
+                continue;
+            }
+            size_t const start = i;
+            while (i < end && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' &&
+                   text[i] != '#') {
+                ++i;
+            }
+            words.push_back(text.substr(start, i - start));
+        }
+        pos = end + 1;
+        if (words.empty()) {
+            continue;
+        }
+
+        // Board named by the second word, if any
+        size_t board = models.size();
+        for (size_t m = 0; words.size() >= 2 && m < models.size(); ++m) {
+            board = models[m].name == words[1] ? m : board;
+        }
+        bool const known = board < models.size();
+        uint32_t numbers[3] = {0, 0, 0};
+        bool ok = false;
+
+        if (words[0] == "board" && words.size() >= 3 && words.size() % 2 == 1 && !known) {
+            ok = words[2] == "avr" || words[2] == "rp2040" || words[2] == "esp32";
+            board_model model = words[2] == "avr"      ? board_model::avr(words[1])
+                                : words[2] == "rp2040" ? board_model::rp2040(words[1])
+                                                       : board_model::esp32(words[1]);
+            for (size_t w = 3; ok && w + 1 < words.size(); w += 2) {
+                ok = planner_number(words[w + 1], numbers[0]);
+                if (words[w] == "mhz" && numbers[0] > 0 && numbers[0] <= 4000) {
+                    model.cpu_hz = numbers[0] * 1000000u;
+                } else if (words[w] == "update_cycles") {
+                    model.cycles_per_update = numbers[0];
+                } else if (words[w] == "frame_cycles") {
+                    model.cycles_per_frame = numbers[0];
+                } else if (words[w] == "byte_cycles") {
+                    model.cycles_per_bus_byte = numbers[0];
+                } else {
+                    ok = false;
+                }
+            }
+            if (ok) {
+                models.push_back(model);
+                board_load load;
+                load.model = static_cast<uint32_t>(models.size() - 1);
+                load.controllers = 0;
+                layout.boards.push_back(load);
+            }
+        } else if (words[0] == "bus" && (words.size() == 3 || words.size() == 4) && known &&
+                   models[board].buses.size() < PLANNER_MAX_BUSES) {
+            ok = words.size() == 3 || (planner_number(words[3], numbers[0]) && numbers[0] > 0);
+            uint32_t const rate = numbers[0];
+            if (ok && words[2] == "i2c") {
+                models[board].buses.push_back(peripheral_model::i2c(rate == 0 ? 400000 : rate));
+            } else if (ok && words[2] == "spi") {
+                models[board].buses.push_back(peripheral_model::spi(rate == 0 ? 8000000 : rate));
+            } else if (ok && words[2] == "uart") {
+                models[board].buses.push_back(peripheral_model::uart(rate == 0 ? 115200 : rate));
+            } else if (ok && words[2] == "dmx" && words.size() == 3) {
+                models[board].buses.push_back(peripheral_model::dmx());
+            } else {
+                ok = false;
+            }
+        } else if (words[0] == "controllers" && words.size() == 3 && known) {
+            ok = planner_number(words[2], layout.boards[board].controllers);
+        } else if (words[0] == "load" && (words.size() == 4 || words.size() == 5) && known) {
+            numbers[2] = 1;
+            ok = planner_number(words[2], numbers[0]) &&
+                 numbers[0] < models[board].buses.size() &&
+                 planner_number(words[3], numbers[1]) &&
+                 (words.size() == 4 || planner_number(words[4], numbers[2]));
+            if (ok) {
+                layout.boards[board].loads.push_back(
+                    bus_load{static_cast<uint8_t>(numbers[0]), numbers[1], numbers[2]});
+            }
+        } else if (words[0] == "fps" && words.size() == 2) {
+            ok = planner_number(words[1], numbers[0]) && numbers[0] > 0;
+            layout.frame_rate_hz = numbers[0];
+        } else if (words[0] == "headroom" && words.size() == 2) {
+            ok = planner_number(words[1], numbers[0]) && numbers[0] > 0 && numbers[0] <= 100;
+            layout.max_utilization = numbers[0] / 100.0;
+        }
+        if (!ok) {
+            error_line = line;
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,233 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Compact log of clock readings for record-and-replay
+ *
+ * Each reading is stored as the unsigned 32-bit delta from the previous one
+ * (the first from 0), LEB128 varint encoded. Deltas are taken modulo 2^32, so
+ * a uint32 wraparound costs no more than any other small step: a loop that
+ * reads the clock every few milliseconds uses one byte per reading.
+ *
+ * File format: "CLKR" magic, then the varint stream (no length prefix, so a
+ * recording can be appended to while a run is in progress).
+ */
+struct clock_recording {
+   public:
+    clock_recording() : count_(0), last_ms_(0) {}
+
+    /**
+     * @brief Append one clock reading
+     */
+    void append(uint32_t time_ms) {
+        uint32_t delta = time_ms - last_ms_;
+        last_ms_ = time_ms;
+        while (delta >= 0x80) {
+            bytes_.push_back(static_cast<uint8_t>(delta | 0x80));
+            delta >>= 7;
+        }
+        bytes_.push_back(static_cast<uint8_t>(delta));
+        ++count_;
+    }
+
+    void clear() {
+        bytes_.clear();
+        count_ = 0;
+        last_ms_ = 0;
+    }
+
+    /**
+     * @brief Write the recording to a file
+     *
+     * @return false on I/O error
+     */
+    bool save(char const* path) const {
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        bool ok = std::fwrite(magic(), 1, 4, file) == 4;
+        if (!bytes_.empty()) {
+            ok = ok && std::fwrite(bytes_.data(), 1, bytes_.size(), file) == bytes_.size();
+        }
+        return std::fclose(file) == 0 && ok;
+    }
+
+    /**
+     * @brief Replace this recording with one loaded from a file
+     *
+     * @return false if the file is missing, not a recording, or truncated mid-reading
+     */
+    bool load(char const* path) {
+        std::FILE* file = std::fopen(path, "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        char header[4];
+        bool ok = std::fread(header, 1, 4, file) == 4 && std::memcmp(header, magic(), 4) == 0;
+        std::vector<uint8_t> bytes;
+        uint8_t chunk[4096];
+        size_t n = 0;
+        while (ok && (n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            bytes.insert(bytes.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        return ok && assign(bytes);
+    }
+
+    /**
+     * @brief Replace this recording with an encoded varint stream
+     *
+     * @return false (and leave the recording unchanged) if the stream is malformed
+     */
+    bool assign(std::vector<uint8_t> const& bytes) {
+        size_t count = 0;
+        uint32_t time_ms = 0;
+        size_t pos = 0;
+        while (pos < bytes.size()) {
+            uint32_t delta = 0;
+            if (!decode(bytes, pos, delta)) {
+                return false;
+            }
+            time_ms += delta;
+            ++count;
+        }
+        bytes_ = bytes;
+        count_ = count;
+        last_ms_ = time_ms;
+        return true;
+    }
+
+    /**
+     * @brief Decode one delta at pos, advancing pos
+     *
+     * @return false if the varint is truncated or longer than 5 bytes
+     */
+    static bool decode(std::vector<uint8_t> const& bytes, size_t& pos, uint32_t& delta) {
+        delta = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            if (pos >= bytes.size()) {
+                return false;
+            }
+            uint8_t const byte = bytes[pos++];
+            delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Write the file header to a sink (e.g. async_file) before streaming
+     */
+    template<typename sink_t>
+    static bool write_header(sink_t& sink) {
+        return sink.write(magic(), 4);
+    }
+
+    /**
+     * @brief Move the bytes encoded so far to a sink and release them
+     *
+     * The delta chain continues across drains, so header + every drained
+     * chunk is the same stream save() would have written.
+     *
+     * @return false if the sink rejected the bytes
+     */
+    template<typename sink_t>
+    bool drain_to(sink_t& sink) {
+        bool const ok = bytes_.empty() || sink.write(bytes_.data(), bytes_.size());
+        bytes_.clear();
+        return ok;
+    }
+
+    std::vector<uint8_t> const& bytes() const { return bytes_; }
+    size_t size() const { return count_; }
+    uint32_t last_reading() const { return last_ms_; }
+
+   private:
+    static char const* magic() { return "CLKR"; }
+
+    std::vector<uint8_t> bytes_;
+    size_t count_;
+    uint32_t last_ms_;
+};
+
+/**
+ * @brief Timer adapter that logs every reading of the wrapped timer
+ *
+ * Drop-in for the wrapped timer wherever millis() is called:
+ *
+ *   real_time_timer clock;
+ *   clock_recording log;
+ *   recording_timer<real_time_timer> timer(clock, log);
+ *   controller.update(timer.millis());  // reading is logged
+ *   log.save("run.clk");
+ *
+ * @tparam timer_t Type that implements millis()
+ */
+template<typename timer_t>
+struct recording_timer {
+   public:
+    recording_timer(timer_t& timer, clock_recording& recording)
+        : timer_(timer), recording_(recording) {}
+
+    /**
+     * @brief Read the wrapped timer and log the value
+     */
+    uint32_t millis() {
+        uint32_t const now = timer_.millis();
+        recording_.append(now);
+        return now;
+    }
+
+   private:
+    timer_t& timer_;
+    clock_recording& recording_;
+};
+
+/**
+ * @brief Timer that serves a recorded sequence of readings
+ *
+ * Returns the recorded readings in order, one per millis() call, so the same
+ * controllers calling in the same order see exactly the same times. After the
+ * last reading it keeps returning that reading and reports exhausted().
+ * Replays run as fast as the caller loops (no real-time waiting).
+ */
+struct replay_timer {
+   public:
+    explicit replay_timer(clock_recording const& recording)
+        : recording_(recording), pos_(0), served_(0), current_ms_(0) {}
+
+    uint32_t millis() {
+        uint32_t delta = 0;
+        if (pos_ < recording_.bytes().size() &&
+            clock_recording::decode(recording_.bytes(), pos_, delta)) {
+            current_ms_ += delta;
+            ++served_;
+        }
+        return current_ms_;
+    }
+
+    /**
+     * @brief Start serving from the first reading again
+     */
+    void rewind() {
+        pos_ = 0;
+        served_ = 0;
+        current_ms_ = 0;
+    }
+
+    bool exhausted() const { return served_ >= recording_.size(); }
+    size_t served() const { return served_; }
+
+   private:
+    clock_recording const& recording_;
+    size_t pos_;
+    size_t served_;
+    uint32_t current_ms_;
+};
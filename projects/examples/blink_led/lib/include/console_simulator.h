@@ -169,6 +169,20 @@ struct real_time_timer {
         return static_cast<uint32_t>(duration.count());
     }
 
+    /**
+     * @brief Get microseconds elapsed since timer creation or last reset
+     *
+     * The micros() clock for microsecond-resolution controllers; wraps
+     * after ~71.6 minutes, like Arduino's micros().
+     *
+     * @return uint32_t Elapsed time in microseconds
+     */
+    uint32_t micros() const {
+        auto now = std::chrono::steady_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time_);
+        return static_cast<uint32_t>(duration.count());
+    }
+
     /**
      * @brief Reset timer to zero
      */
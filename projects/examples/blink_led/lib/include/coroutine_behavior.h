@@ -0,0 +1,614 @@
+#pragma once
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief C++20 coroutine behaviors driven by a frame-based scheduler
+ *
+ * Lets a prop sequence read top to bottom instead of being spread across
+ * hand-written state in update():
+ *
+ * behavior scare(behavior_scheduler& s, arm_pin& arm, eye_pin& eyes, edge_signal& sensor) {
+ *     arm.set(true);
+ *     co_await s.delay(300);
+ *     for (int i = 0; i < 3; ++i) {
+ *         eyes.set(true);
+ *         co_await s.delay(100);
+ *         eyes.set(false);
+ *         co_await s.delay(100);
+ *     }
+ *     co_await s.wait_for_edge(sensor, edge_kind::rising);
+ *     arm.set(false);
+ * }
+ *
+ * behavior_scheduler scheduler(1000, 256, 8);
+ * scheduler.spawn(scare(scheduler, arm, eyes, sensor));
+ * scheduler.update(millis());  // every frame
+ *
+ * Design:
+ * - The scheduler must be the coroutine's first parameter (anything else does
+ *   not compile); the frame comes from that scheduler's preallocated pool,
+ *   never from the heap
+ * - update() resumes only coroutines that are due: expired delays come off a
+ *   min-heap, edge and cue waiters are moved to an intrusive ready list
+ * - Delays are deadline-based (relative to when the coroutine was due, not when
+ *   it actually ran), so sequences don't drift with frame jitter
+ * - No allocation after construction; wait lists are intrusive through promises,
+ *   and a coroutine destroyed while delayed leaves a dead timer that is
+ *   skipped when it comes off the heap
+ *
+ * Host-only: requires C++20 (the blink_controller header stays C++11 for AVR).
+ */
+
+struct behavior_scheduler;
+struct behavior_promise;
+struct edge_signal;
+
+/**
+ * @brief Fixed-size block allocator for coroutine frames
+ *
+ * Each block carries a small header pointing back at its pool, so frames can
+ * be released through the promise's sized operator delete.
+ */
+struct coroutine_frame_pool {
+   public:
+    /**
+     * @param block_size Largest coroutine frame (bytes) the pool can hold
+     * @param block_count Number of frames that can be live at once
+     */
+    coroutine_frame_pool(size_t block_size, size_t block_count)
+        : stride_(round_up(block_size + HEADER_SIZE)),
+          capacity_(block_count),
+          storage_(stride_ * block_count / sizeof(std::max_align_t) + 1),
+          free_list_(nullptr),
+          in_use_(0),
+          failed_allocations_(0) {
+        unsigned char* base = reinterpret_cast<unsigned char*>(storage_.data());
+        for (size_t i = block_count; i > 0; --i) {
+            free_block* block = reinterpret_cast<free_block*>(base + (i - 1) * stride_);
+            block->next = free_list_;
+            free_list_ = block;
+        }
+    }
+
+    coroutine_frame_pool(coroutine_frame_pool const&) = delete;
+    coroutine_frame_pool& operator=(coroutine_frame_pool const&) = delete;
+
+    /**
+     * @brief Take one block, or nullptr if the frame is too big or the pool is empty
+     */
+    void* allocate(size_t size) noexcept {
+        if (size + HEADER_SIZE > stride_ || free_list_ == nullptr) {
+            ++failed_allocations_;
+            return nullptr;
+        }
+        free_block* block = free_list_;
+        free_list_ = block->next;
+        ++in_use_;
+        *reinterpret_cast<coroutine_frame_pool**>(block) = this;
+        return reinterpret_cast<unsigned char*>(block) + HEADER_SIZE;
+    }
+
+    /**
+     * @brief Return a frame to the pool it came from
+     */
+    static void release(void* frame) noexcept {
+        unsigned char* raw = static_cast<unsigned char*>(frame) - HEADER_SIZE;
+        coroutine_frame_pool* pool = *reinterpret_cast<coroutine_frame_pool**>(raw);
+        free_block* block = reinterpret_cast<free_block*>(raw);
+        block->next = pool->free_list_;
+        pool->free_list_ = block;
+        --pool->in_use_;
+    }
+
+    size_t capacity() const { return capacity_; }
+    size_t in_use() const { return in_use_; }
+    size_t block_size() const { return stride_ - HEADER_SIZE; }
+    size_t failed_allocations() const { return failed_allocations_; }
+
+   private:
+    struct free_block {
+        free_block* next;
+    };
+
+    static constexpr size_t HEADER_SIZE = sizeof(std::max_align_t);
+
+    static size_t round_up(size_t size) {
+        return (size + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t) *
+               sizeof(std::max_align_t);
+    }
+
+    size_t stride_;
+    size_t capacity_;
+    std::vector<std::max_align_t> storage_;
+    free_block* free_list_;
+    size_t in_use_;
+    size_t failed_allocations_;
+};
+
+enum class edge_kind : uint8_t { rising, falling, any };
+
+/**
+ * @brief Owning handle to a not-yet-started behavior coroutine
+ *
+ * Created suspended; hand it to behavior_scheduler::spawn(). An empty
+ * behavior (valid() == false) means the frame pool was exhausted.
+ */
+struct behavior {
+   public:
+    using promise_type = behavior_promise;
+
+    behavior() : promise_(nullptr) {}
+    explicit behavior(behavior_promise* promise) : promise_(promise) {}
+    behavior(behavior&& other) noexcept : promise_(std::exchange(other.promise_, nullptr)) {}
+    behavior(behavior const&) = delete;
+    behavior& operator=(behavior const&) = delete;
+    ~behavior();
+
+    bool valid() const { return promise_ != nullptr; }
+
+    /// Transfer ownership of the coroutine (used by the scheduler)
+    behavior_promise* release() { return std::exchange(promise_, nullptr); }
+
+   private:
+    behavior_promise* promise_;
+};
+
+/**
+ * @brief Promise state shared by every behavior coroutine
+ *
+ * Doubles as the intrusive list node for ready, edge and cue wait lists
+ * (a coroutine waits on at most one thing at a time). The promise type a
+ * coroutine actually gets is behavior_promise_for its parameters, which
+ * allocates the frame from the scheduler argument.
+ */
+struct behavior_promise {
+   public:
+    template<typename... args_t>
+    explicit behavior_promise(behavior_scheduler& scheduler, args_t&&...)
+        : scheduler_(&scheduler) {}
+
+    ~behavior_promise();
+
+    /// Frames only come from a scheduler pool: a coroutine without one first does not compile
+    static void* operator new(size_t size) = delete;
+
+    static behavior get_return_object_on_allocation_failure() { return behavior(); }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+
+   protected:
+    std::coroutine_handle<> frame_;  // set by get_return_object()
+
+   private:
+    friend struct behavior;
+    friend struct behavior_scheduler;
+    friend struct edge_signal;
+
+    std::coroutine_handle<> handle() const { return frame_; }
+
+    behavior_scheduler* scheduler_;
+    behavior_promise* next_ = nullptr;  // ready / edge / cue list link
+    behavior_promise* live_prev_ = nullptr;
+    behavior_promise* live_next_ = nullptr;
+    edge_signal* waiting_edge_ = nullptr;
+    edge_kind edge_filter_ = edge_kind::any;
+    bool timer_pending_ = false;  // in the timer heap
+    bool cue_waiting_ = false;  // in a cue list
+    uint32_t slot_ = 0;  // timer slot, assigned by spawn()
+    uint32_t wake_ms_ = 0;  // time this coroutine was due when last resumed
+};
+
+/**
+ * @brief Boolean signal that behaviors can wait on for edges
+ *
+ * Implements set(bool), so it plugs in anywhere an output pin does (a sensor
+ * adapter, or a blink_controller output feeding another behavior).
+ */
+struct edge_signal {
+   public:
+    edge_signal() = default;
+    edge_signal(edge_signal const&) = delete;
+    edge_signal& operator=(edge_signal const&) = delete;
+    ~edge_signal();
+
+    /**
+     * @brief Set the signal level; waiters matching the edge become ready
+     *
+     * Waiters are resumed by the scheduler's current or next update(), never
+     * from inside set().
+     */
+    void set(bool state);
+
+    bool get_state() const { return state_; }
+
+   private:
+    friend struct behavior_scheduler;
+    friend struct behavior_promise;
+
+    void unlink(behavior_promise* promise) {
+        behavior_promise** link = &waiters_;
+        while (*link != nullptr && *link != promise) {
+            link = &(*link)->next_;
+        }
+        if (*link == promise) {
+            *link = promise->next_;
+            promise->next_ = nullptr;
+            promise->waiting_edge_ = nullptr;
+        }
+    }
+
+    bool state_ = false;
+    behavior_promise* waiters_ = nullptr;
+};
+
+/**
+ * @brief Frame-driven scheduler for behavior coroutines
+ *
+ * Call update(now_ms) once per frame. All storage is sized at construction.
+ */
+struct behavior_scheduler {
+   public:
+    /**
+     * @param max_behaviors Coroutines that can be live at once
+     * @param frame_size Largest coroutine frame in bytes
+     * @param cue_count Number of cue ids (0 .. cue_count-1)
+     */
+    behavior_scheduler(size_t max_behaviors, size_t frame_size, size_t cue_count)
+        : pool_(frame_size, max_behaviors),
+          cues_(cue_count, nullptr),
+          slots_(max_behaviors, timer_slot{nullptr, 0}) {
+        timers_.reserve(max_behaviors);
+        free_slots_.reserve(max_behaviors);
+        for (size_t i = max_behaviors; i > 0; --i) {
+            free_slots_.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+
+    behavior_scheduler(behavior_scheduler const&) = delete;
+    behavior_scheduler& operator=(behavior_scheduler const&) = delete;
+
+    ~behavior_scheduler() {
+        // Nothing will be resumed again, so skip per-coroutine unlinking from the wait lists
+        timers_.clear();
+        std::fill(cues_.begin(), cues_.end(), nullptr);
+        ready_head_ = ready_tail_ = nullptr;
+        while (live_head_ != nullptr) {
+            live_head_->timer_pending_ = false;
+            live_head_->cue_waiting_ = false;
+            live_head_->handle().destroy();
+        }
+    }
+
+    /**
+     * @brief Take ownership of a behavior; it starts on the next update()
+     *
+     * @return false if the behavior is empty (frame pool exhausted) or max_behaviors are
+     *         already live
+     */
+    bool spawn(behavior&& new_behavior) {
+        if (!new_behavior.valid() || free_slots_.empty()) {
+            return false;
+        }
+        behavior_promise& promise = *new_behavior.release();
+        promise.slot_ = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[promise.slot_].promise = &promise;
+        promise.live_next_ = live_head_;
+        if (live_head_ != nullptr) {
+            live_head_->live_prev_ = &promise;
+        }
+        live_head_ = &promise;
+        ++live_count_;
+        make_ready(&promise);
+        return true;
+    }
+
+    /**
+     * @brief Resume every coroutine that is due at now_ms
+     *
+     * Coroutines made ready during this update (e.g. by an edge another
+     * behavior produced) also run in this frame.
+     */
+    void update(uint32_t now_ms) {
+        now_ms_ = now_ms;
+        resumed_last_update_ = 0;
+        while (!timers_.empty() && static_cast<int32_t>(timers_.front().due_ms - now_ms) <= 0) {
+            std::pop_heap(timers_.begin(), timers_.end(), timer_later);
+            timer_entry const entry = timers_.back();
+            timers_.pop_back();
+            timer_slot const& slot = slots_[entry.slot];
+            if (slot.generation != entry.generation) {
+                --dead_timers_;  // its coroutine was destroyed while waiting
+                continue;
+            }
+            push_ready(slot.promise);
+            slot.promise->wake_ms_ = entry.due_ms;
+        }
+        while (ready_head_ != nullptr) {
+            behavior_promise* promise = ready_head_;
+            ready_head_ = promise->next_;
+            if (ready_head_ == nullptr) {
+                ready_tail_ = nullptr;
+            }
+            promise->next_ = nullptr;
+            ++resumed_last_update_;
+            std::coroutine_handle<> const handle = promise->handle();
+            handle.resume();
+            if (handle.done()) {
+                handle.destroy();
+            }
+        }
+    }
+
+    /**
+     * @brief Wake every coroutine waiting on a cue (on this or the next update)
+     */
+    void fire_cue(uint32_t cue) {
+        if (cue >= cues_.size()) {
+            return;
+        }
+        behavior_promise* promise = cues_[cue];
+        cues_[cue] = nullptr;
+        while (promise != nullptr) {
+            behavior_promise* next = promise->next_;
+            promise->next_ = nullptr;
+            make_ready(promise);
+            promise = next;
+        }
+    }
+
+    struct delay_awaiter {
+        behavior_scheduler& scheduler;
+        uint32_t duration_ms;
+
+        bool await_ready() const noexcept { return false; }
+        template<typename promise_t>
+        void await_suspend(std::coroutine_handle<promise_t> handle) {
+            behavior_promise& promise = handle.promise();
+            promise.timer_pending_ = true;
+            scheduler.push_timer(promise.wake_ms_ + duration_ms, &promise);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct edge_awaiter {
+        edge_signal& signal;
+        edge_kind kind;
+
+        bool await_ready() const noexcept { return false; }
+        template<typename promise_t>
+        void await_suspend(std::coroutine_handle<promise_t> handle) {
+            behavior_promise& promise = handle.promise();
+            promise.edge_filter_ = kind;
+            promise.waiting_edge_ = &signal;
+            promise.next_ = signal.waiters_;
+            signal.waiters_ = &promise;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct cue_awaiter {
+        behavior_scheduler& scheduler;
+        uint32_t cue;
+
+        bool await_ready() const noexcept { return cue >= scheduler.cues_.size(); }
+        template<typename promise_t>
+        void await_suspend(std::coroutine_handle<promise_t> handle) {
+            behavior_promise& promise = handle.promise();
+            promise.cue_waiting_ = true;
+            promise.next_ = scheduler.cues_[cue];
+            scheduler.cues_[cue] = &promise;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    /// co_await: resume duration_ms after this coroutine was last due
+    delay_awaiter delay(uint32_t duration_ms) { return delay_awaiter{*this, duration_ms}; }
+
+    /// co_await: resume on the next matching edge of signal
+    edge_awaiter wait_for_edge(edge_signal& signal, edge_kind kind = edge_kind::any) {
+        return edge_awaiter{signal, kind};
+    }
+
+    /// co_await: resume when fire_cue(cue) is called (never waits on unknown cues)
+    cue_awaiter wait_for_cue(uint32_t cue) { return cue_awaiter{*this, cue}; }
+
+    /// Time of the frame being processed
+    uint32_t now() const { return now_ms_; }
+
+    size_t live() const { return live_count_; }
+    size_t timers_pending() const { return timers_.size() - dead_timers_; }
+    size_t resumed_last_update() const { return resumed_last_update_; }
+    coroutine_frame_pool& pool() { return pool_; }
+
+   private:
+    friend struct behavior_promise;
+    friend struct edge_signal;
+
+    // The heap refers to coroutines through slots, so a destroyed one only bumps its
+    // slot's generation and its entry is recognized as dead when popped
+    struct timer_slot {
+        behavior_promise* promise;
+        uint32_t generation;
+    };
+
+    struct timer_entry {
+        uint32_t due_ms;
+        uint32_t sequence;
+        uint32_t slot;
+        uint32_t generation;
+    };
+
+    // Heap order: earliest deadline (wrap-aware), then FIFO
+    static bool timer_later(timer_entry const& a, timer_entry const& b) {
+        int32_t const diff = static_cast<int32_t>(a.due_ms - b.due_ms);
+        return diff > 0 || (diff == 0 && static_cast<int32_t>(a.sequence - b.sequence) > 0);
+    }
+
+    void push_timer(uint32_t due_ms, behavior_promise* promise) {
+        if (timers_.size() == timers_.capacity() && dead_timers_ > 0) {
+            // Live timers never exceed max_behaviors, so dropping the dead makes room
+            // without growing the heap
+            timers_.erase(std::remove_if(timers_.begin(), timers_.end(),
+                                         [this](timer_entry const& entry) {
+                                             return slots_[entry.slot].generation !=
+                                                    entry.generation;
+                                         }),
+                          timers_.end());
+            std::make_heap(timers_.begin(), timers_.end(), timer_later);
+            dead_timers_ = 0;
+        }
+        timer_entry const entry = {due_ms, timer_sequence_++, promise->slot_,
+                                   slots_[promise->slot_].generation};
+        timers_.push_back(entry);
+        std::push_heap(timers_.begin(), timers_.end(), timer_later);
+    }
+
+    // Ready because of a spawn, edge or cue: deadline base is the current frame
+    void make_ready(behavior_promise* promise) {
+        promise->wake_ms_ = now_ms_;
+        push_ready(promise);
+    }
+
+    void push_ready(behavior_promise* promise) {
+        promise->timer_pending_ = false;
+        promise->cue_waiting_ = false;
+        promise->next_ = nullptr;
+        if (ready_tail_ != nullptr) {
+            ready_tail_->next_ = promise;
+        } else {
+            ready_head_ = promise;
+        }
+        ready_tail_ = promise;
+    }
+
+    // Called from the promise destructor: forget a destroyed coroutine
+    void forget(behavior_promise* promise) {
+        if (promise->live_prev_ != nullptr) {
+            promise->live_prev_->live_next_ = promise->live_next_;
+        } else if (live_head_ == promise) {
+            live_head_ = promise->live_next_;
+        } else {
+            return;  // never spawned
+        }
+        if (promise->live_next_ != nullptr) {
+            promise->live_next_->live_prev_ = promise->live_prev_;
+        }
+        --live_count_;
+        timer_slot& slot = slots_[promise->slot_];
+        slot.promise = nullptr;
+        ++slot.generation;
+        free_slots_.push_back(promise->slot_);
+        if (promise->timer_pending_) {
+            ++dead_timers_;
+        }
+        if (!promise->cue_waiting_) {
+            return;
+        }
+        for (size_t cue = 0; cue < cues_.size(); ++cue) {
+            behavior_promise** link = &cues_[cue];
+            while (*link != nullptr && *link != promise) {
+                link = &(*link)->next_;
+            }
+            if (*link == promise) {
+                *link = promise->next_;
+            }
+        }
+    }
+
+    coroutine_frame_pool pool_;
+    std::vector<timer_entry> timers_;
+    std::vector<behavior_promise*> cues_;
+    std::vector<timer_slot> slots_;
+    std::vector<uint32_t> free_slots_;
+    size_t dead_timers_ = 0;
+    behavior_promise* ready_head_ = nullptr;
+    behavior_promise* ready_tail_ = nullptr;
+    behavior_promise* live_head_ = nullptr;
+    size_t live_count_ = 0;
+    size_t resumed_last_update_ = 0;
+    uint32_t now_ms_ = 0;
+    uint32_t timer_sequence_ = 0;
+};
+
+/**
+ * @brief Promise type of a behavior coroutine taking (behavior_scheduler&, args_t...)
+ *
+ * A class template rather than a member template operator new, so the frame's
+ * allocation and deallocation functions are members of one class (GCC's
+ * -Wmismatched-new-delete pairs them by name).
+ */
+template<typename... args_t>
+struct behavior_promise_for : behavior_promise {
+   public:
+    using behavior_promise::behavior_promise;
+
+    /// Frame from the scheduler argument's pool (nullptr if exhausted)
+    static void* operator new(size_t size, behavior_scheduler& scheduler, args_t&...) noexcept {
+        return scheduler.pool().allocate(size);
+    }
+
+    static void operator delete(void* frame, size_t) noexcept {
+        coroutine_frame_pool::release(frame);
+    }
+
+    behavior get_return_object() {
+        frame_ = std::coroutine_handle<behavior_promise_for>::from_promise(*this);
+        return behavior(this);
+    }
+};
+
+template<typename... args_t>
+struct std::coroutine_traits<behavior, behavior_scheduler&, args_t...> {
+    using promise_type = behavior_promise_for<args_t...>;
+};
+
+inline behavior::~behavior() {
+    if (promise_ != nullptr) {
+        promise_->handle().destroy();
+    }
+}
+
+inline behavior_promise::~behavior_promise() {
+    if (waiting_edge_ != nullptr) {
+        waiting_edge_->unlink(this);
+    }
+    scheduler_->forget(this);
+}
+
+inline edge_signal::~edge_signal() {
+    while (waiters_ != nullptr) {
+        behavior_promise* promise = waiters_;
+        waiters_ = promise->next_;
+        promise->next_ = nullptr;
+        promise->waiting_edge_ = nullptr;
+    }
+}
+
+inline void edge_signal::set(bool state) {
+    if (state == state_) {
+        return;
+    }
+    state_ = state;
+    edge_kind const edge = state ? edge_kind::rising : edge_kind::falling;
+    behavior_promise** link = &waiters_;
+    while (*link != nullptr) {
+        behavior_promise* promise = *link;
+        if (promise->edge_filter_ == edge_kind::any || promise->edge_filter_ == edge) {
+            *link = promise->next_;
+            promise->waiting_edge_ = nullptr;
+            promise->scheduler_->make_ready(promise);
+        } else {
+            link = &promise->next_;
+        }
+    }
+}
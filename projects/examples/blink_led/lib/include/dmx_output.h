@@ -0,0 +1,350 @@
+#pragma once
+#include <asm/termbits.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Wired DMX512 output: universes built from controller states, sent with timed break / MAB
+ *
+ * Fog machines and dimmer packs hang off RS-485 DMX lines, one universe per
+ * serial port. The show loop writes levels into each universe's back buffer
+ * and commits once per frame; a sender thread transmits the committed
+ * (front) buffers as DMX packets:
+ *
+ *   dmx_tty_port port(open("/dev/ttyUSB0", O_RDWR | O_NOCTTY));
+ *   port.configure();                                 // 250 kbaud 8N2, raw
+ *   dmx_output<dmx_tty_port> dmx(dmx_timing{});
+ *   size_t const fog = dmx.add_universe(port);
+ *   dmx.start();
+ *   ...
+ *   dmx.apply(patches, patch_count, bank.states());   // or dmx.set_level(fog, 1, 255)
+ *   dmx.commit();
+ *
+ * A packet is a break (line held low), a mark after break, then the start
+ * code and up to 512 slots at 44 us each, so a full universe takes ~22.7 ms.
+ *
+ * Design:
+ * - port_t is duck-typed like blink_controller's output_pin_t: set_break(bool),
+ *   write(data, size) and drain() (wait until the previous packet is out).
+ *   dmx_tty_port is the Linux serial implementation; tests wrap it in a pty.
+ * - Break and MAB are timed by sleeping until shortly before the deadline and
+ *   spinning the rest, so they are microsecond-accurate on an idle core and
+ *   only ever too long, never too short.
+ * - A committed change is sent repeat_frames times at active_hz; unchanged
+ *   universes are refreshed at idle_hz so fixtures do not time out, leaving
+ *   the line (and CPU) free for the ones that are fading.
+ */
+
+/// Slots per universe and their wire time (11 bits at 250 kbaud)
+constexpr uint16_t DMX_SLOTS = 512;
+constexpr uint32_t DMX_SLOT_US = 44;
+
+struct dmx_timing {
+    uint32_t break_us = 176;     // 92 minimum
+    uint32_t mab_us = 12;        // mark after break, 12 minimum
+    uint32_t active_hz = 40;     // refresh of universes that changed
+    uint32_t idle_hz = 1;        // keepalive refresh of unchanged universes
+    uint32_t repeat_frames = 3;  // packets at active_hz after each change
+};
+
+/// Map one controller's on / off state to a slot level
+struct dmx_patch {
+    uint32_t controller;  // index into the states array
+    uint16_t universe;
+    uint16_t channel;  // 1..512
+    uint8_t on_level;
+    uint8_t off_level;
+};
+
+inline uint64_t dmx_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+/// Sleep until shortly before deadline_ns (dmx_now_ns clock), then spin until it
+inline void dmx_wait_until(uint64_t deadline_ns) {
+    uint64_t const SPIN_NS = 200000;
+    uint64_t const now = dmx_now_ns();
+    if (deadline_ns > now + SPIN_NS) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadline_ns - now - SPIN_NS));
+    }
+    while (dmx_now_ns() < deadline_ns) {
+    }
+}
+
+/**
+ * @brief DMX port on a Linux serial device (or pty)
+ */
+struct dmx_tty_port {
+   public:
+    explicit dmx_tty_port(int fd) : fd_(fd) {}
+
+    /**
+     * @brief Raw 250000 baud 8N2 (a non-standard rate, set through termios2)
+     *
+     * @return false if fd is not a terminal or rejects the settings
+     */
+    bool configure() {
+        struct termios2 settings;
+        if (ioctl(fd_, TCGETS2, &settings) != 0) {
+            return false;
+        }
+        settings.c_cflag &= ~static_cast<tcflag_t>(CBAUD | CSIZE | PARENB);
+        settings.c_cflag |= BOTHER | CS8 | CSTOPB | CLOCAL | CREAD;
+        settings.c_iflag = 0;
+        settings.c_oflag = 0;
+        settings.c_lflag = 0;
+        settings.c_ispeed = 250000;
+        settings.c_ospeed = 250000;
+        return ioctl(fd_, TCSETS2, &settings) == 0;
+    }
+
+    /// Hold the line low (break) or release it
+    bool set_break(bool on) { return ioctl(fd_, on ? TIOCSBRK : TIOCCBRK) == 0; }
+
+    bool write(uint8_t const* data, size_t size) {
+        while (size > 0) {
+            ssize_t const n = ::write(fd_, data, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    /// Wait until everything written has left the UART (tcdrain)
+    bool drain() { return ioctl(fd_, TCSBRK, 1) == 0; }
+
+    int fd() const { return fd_; }
+
+   private:
+    int fd_;
+};
+
+template<typename port_t>
+struct dmx_output {
+   public:
+    explicit dmx_output(dmx_timing const& timing)
+        : timing_(timing), running_(false), committed_(false) {}
+
+    ~dmx_output() { stop(); }
+
+    dmx_output(dmx_output const&) = delete;
+    dmx_output& operator=(dmx_output const&) = delete;
+
+    /**
+     * @brief Add a universe on its own port (before start())
+     *
+     * @param slots 1..512; a shorter universe has a shorter packet
+     * @return Universe index
+     */
+    size_t add_universe(port_t& port, uint16_t slots = DMX_SLOTS) {
+        universe u;
+        u.port = &port;
+        u.slots = std::min<uint16_t>(std::max<uint16_t>(slots, 1), DMX_SLOTS);
+        u.back.assign(u.slots + 1u, 0);  // start code 0, then the slots
+        u.front = u.back;
+        u.transmit = u.back;
+        u.repeats_left = timing_.repeat_frames;
+        u.sent = false;
+        u.last_sent_ns = 0;
+        u.frames = 0;
+        u.errors = 0;
+        universes_.push_back(u);
+        return universes_.size() - 1;
+    }
+
+    /// Set a slot level in the back buffer (show loop thread)
+    void set_level(size_t universe_index, uint16_t channel, uint8_t level) {
+        universe& u = universes_[universe_index];
+        if (channel >= 1 && channel <= u.slots) {
+            u.back[channel] = level;
+        }
+    }
+
+    /// Set patched slots from controller states (nonzero is on, e.g. blink_bank::states())
+    void apply(dmx_patch const* patches, size_t count, uint32_t const* states) {
+        for (size_t i = 0; i < count; ++i) {
+            dmx_patch const& patch = patches[i];
+            set_level(patch.universe, patch.channel,
+                      states[patch.controller] != 0 ? patch.on_level : patch.off_level);
+        }
+    }
+
+    /**
+     * @brief Publish the back buffers; changed universes go to the active rate
+     *
+     * @return Universes whose contents changed
+     */
+    size_t commit() {
+        size_t changed = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = 0; i < universes_.size(); ++i) {
+                universe& u = universes_[i];
+                if (u.back != u.front) {
+                    u.front = u.back;
+                    u.repeats_left = timing_.repeat_frames;
+                    ++changed;
+                }
+            }
+            committed_ = committed_ || changed != 0;
+        }
+        if (changed != 0) {
+            wake_.notify_one();
+        }
+        return changed;
+    }
+
+    /**
+     * @brief Send every universe that is due at now_ns (dmx_now_ns clock)
+     *
+     * Blocks for the break and MAB of each packet sent. start() calls this
+     * from the sender thread; tests may call it directly.
+     *
+     * @return Time the next universe becomes due
+     */
+    uint64_t service(uint64_t now_ns) {
+        uint64_t next_ns = UINT64_MAX;
+        for (size_t i = 0; i < universes_.size(); ++i) {
+            universe& u = universes_[i];
+            bool due = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                due = !u.sent || now_ns >= u.last_sent_ns + period_ns(u);
+                if (due) {
+                    u.transmit = u.front;
+                    u.repeats_left -= u.repeats_left > 0 ? 1 : 0;
+                }
+            }
+            if (due) {
+                bool const ok = send(u);
+                std::lock_guard<std::mutex> lock(mutex_);
+                u.sent = true;
+                u.last_sent_ns = now_ns;
+                u.frames += 1;
+                u.errors += ok ? 0 : 1;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            next_ns = std::min(next_ns, u.last_sent_ns + period_ns(u));
+        }
+        return next_ns;
+    }
+
+    /// Transmit from a sender thread until stop()
+    void start() {
+        if (running_) {
+            return;
+        }
+        running_ = true;
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /// Packet time of a universe: break + MAB + start code and slots
+    uint64_t packet_ns(size_t universe_index) const {
+        return packet_ns(universes_[universe_index]);
+    }
+
+    /// Packets sent (or attempted) on a universe
+    uint64_t frames(size_t universe_index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return universes_[universe_index].frames;
+    }
+
+    /// Packets the port rejected (break or write failed)
+    uint64_t errors(size_t universe_index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return universes_[universe_index].errors;
+    }
+
+    size_t universes() const { return universes_.size(); }
+    dmx_timing const& timing() const { return timing_; }
+
+   private:
+    struct universe {
+        port_t* port;
+        uint16_t slots;
+        std::vector<uint8_t> back;      // show loop
+        std::vector<uint8_t> front;     // last commit (mutex)
+        std::vector<uint8_t> transmit;  // sender's copy of front
+        uint32_t repeats_left;
+        bool sent;
+        uint64_t last_sent_ns;
+        uint64_t frames;
+        uint64_t errors;
+    };
+
+    uint64_t packet_ns(universe const& u) const {
+        return (timing_.break_us + timing_.mab_us + (u.slots + 1u) * uint64_t(DMX_SLOT_US)) * 1000u;
+    }
+
+    // Refresh period, never shorter than the packet itself (mutex held)
+    uint64_t period_ns(universe const& u) const {
+        uint32_t const hz = u.repeats_left > 0 ? timing_.active_hz : timing_.idle_hz;
+        return std::max<uint64_t>(1000000000ull / std::max<uint32_t>(hz, 1), packet_ns(u));
+    }
+
+    // Break, MAB, then the packet (the UART paces the slots)
+    bool send(universe& u) {
+        // Each interval starts once its edge has been set, so it is never short
+        bool ok = u.port->drain();
+        ok = u.port->set_break(true) && ok;
+        dmx_wait_until(dmx_now_ns() + timing_.break_us * 1000ull);
+        ok = u.port->set_break(false) && ok;
+        dmx_wait_until(dmx_now_ns() + timing_.mab_us * 1000ull);
+        return u.port->write(u.transmit.data(), u.transmit.size()) && ok;
+    }
+
+    // A commit() during service() finds the sender not yet waiting, so its notify is lost;
+    // committed_ makes the wait return at once for it instead of sleeping the idle period
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (running_) {
+            committed_ = false;
+            lock.unlock();
+            uint64_t const next_ns = service(dmx_now_ns());
+            lock.lock();
+            uint64_t const now_ns = dmx_now_ns();
+            if (running_ && next_ns > now_ns) {
+                wake_.wait_for(lock, std::chrono::nanoseconds(next_ns - now_ns),
+                               [this]() { return !running_ || committed_; });
+            }
+        }
+    }
+
+    dmx_timing timing_;
+    std::vector<universe> universes_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool running_;
+    bool committed_;  // commit() changed a universe since the sender last started service()
+    std::thread thread_;
+};
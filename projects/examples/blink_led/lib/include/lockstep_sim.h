@@ -0,0 +1,428 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+#include "show_partition.h"
+
+/**
+ * @brief Parallel discrete-event simulation of large shows in lockstep windows
+ *
+ * Nightly validation simulates the largest shows to the millisecond. Rather
+ * than stepping every controller every millisecond, each controller is an
+ * event source: a blink_controller is only updated at its edge times, and
+ * links make one controller's rising edge trigger (restart) another after a
+ * latency:
+ *
+ *   lockstep_show show;
+ *   show.controllers.push_back(blink_timing{100, 50});   // id 0
+ *   show.controllers.push_back(blink_timing{30, 70});    // id 1
+ *   show.links.push_back(sim_link{0, 1, 5});            // 0 on -> restart 1 at +5 ms
+ *   sim_result reference, parallel;
+ *   simulate_show(show, 60000, reference);
+ *   simulate_show_parallel(show, 60000, 8, parallel);   // reference == parallel
+ *
+ * The parallel mode shards controllers into contiguous id ranges (the same
+ * split as show_partition), one thread and one event queue per shard.
+ * Threads advance in windows no longer than the smallest latency of a link
+ * between shards: nothing sent inside a window can land inside it, so
+ * shards only exchange triggers at the barrier between windows. Empty
+ * stretches are skipped by starting each window at the earliest pending
+ * event of any shard.
+ *
+ * Design:
+ * - Events at the same millisecond are applied in a fixed order (toggles,
+ *   then triggers by source id and source edge number) that does not depend
+ *   on which thread produced them, so results are bit-identical to the
+ *   single-threaded run for any shard count.
+ * - A trigger re-phases its target; the target's pending toggle is then
+ *   stale and is skipped by generation number instead of being removed.
+ * - Results are per-controller edge counts and a digest of every
+ *   (time, state) edge, cheap to compare for millions of controllers.
+ * - Durations and link latencies must be at least 1 ms.
+ */
+
+/// A rising edge of source restarts target latency_ms later
+struct sim_link {
+    uint32_t source;
+    uint32_t target;
+    uint32_t latency_ms;
+};
+
+struct lockstep_show {
+    std::vector<blink_timing> controllers;
+    std::vector<sim_link> links;
+};
+
+struct sim_result {
+    std::vector<uint32_t> edges;    // per controller
+    std::vector<uint64_t> digests;  // per controller, hash of its (time, state) edges
+    uint64_t events;                // processed events, including stale toggles
+
+    bool operator==(sim_result const& other) const {
+        return edges == other.edges && digests == other.digests && events == other.events;
+    }
+    bool operator!=(sim_result const& other) const { return !(*this == other); }
+};
+
+struct lockstep_stats {
+    uint64_t windows;         // lockstep windows run
+    uint64_t cross_messages;  // triggers exchanged between shards
+    uint32_t window_ms;       // lookahead: smallest cross-shard link latency
+};
+
+namespace lockstep_detail {
+
+constexpr uint64_t FOREVER = UINT64_MAX;
+
+enum class event_kind : uint8_t { toggle = 0, trigger = 1 };
+
+struct sim_event {
+    uint64_t time;
+    event_kind kind;
+    uint32_t target;
+    uint32_t source;      // trigger: source controller; toggle: target's generation
+    uint32_t source_edge;  // trigger: source's edge number
+
+    // Later events compare greater (std::priority_queue pops the greatest)
+    bool operator<(sim_event const& other) const {
+        if (time != other.time) {
+            return time > other.time;
+        }
+        if (kind != other.kind) {
+            return kind > other.kind;
+        }
+        if (target != other.target) {
+            return target > other.target;
+        }
+        if (source != other.source) {
+            return source > other.source;
+        }
+        return source_edge > other.source_edge;
+    }
+};
+
+struct null_pin {
+    void set(bool) {}
+};
+
+/// Links grouped by source (compressed rows)
+struct link_table {
+    explicit link_table(lockstep_show const& show) : first(show.controllers.size() + 1, 0) {
+        for (size_t i = 0; i < show.links.size(); ++i) {
+            ++first[show.links[i].source + 1];
+        }
+        for (size_t i = 1; i < first.size(); ++i) {
+            first[i] += first[i - 1];
+        }
+        links.resize(show.links.size());
+        std::vector<uint32_t> fill(first.begin(), first.end() - 1);
+        for (size_t i = 0; i < show.links.size(); ++i) {
+            links[fill[show.links[i].source]++] = show.links[i];
+        }
+    }
+
+    std::vector<uint32_t> first;
+    std::vector<sim_link> links;
+};
+
+/**
+ * @brief Controllers [begin, end) and their event queue
+ */
+struct sim_shard {
+    sim_shard(lockstep_show const& show, link_table const& table, show_partition const& partition,
+              uint16_t index)
+        : table_(table),
+          partition_(partition),
+          begin_(partition.first_controller(index)),
+          end_(begin_ + partition.controllers_on(index)),
+          generation_(end_ - begin_, 0),
+          outbox_(partition.node_count()),
+          events_(0) {
+        controllers_.reserve(end_ - begin_);
+        for (uint32_t id = begin_; id < end_; ++id) {
+            blink_timing const& timing = show.controllers[id];
+            controllers_.push_back(blink_controller<null_pin>(pin_, timing.on_ms, timing.off_ms));
+            queue_.push(sim_event{timing.off_ms, event_kind::toggle, id, 0, 0});
+        }
+        edges_.assign(end_ - begin_, 0);
+        digests_.assign(end_ - begin_, 14695981039346656037ull);
+    }
+
+    /**
+     * @brief Apply every event before until; triggers for other shards go to outbox()
+     */
+    void run(uint64_t until) {
+        while (!queue_.empty() && queue_.top().time < until) {
+            sim_event const event = queue_.top();
+            queue_.pop();
+            ++events_;
+            uint32_t const local = event.target - begin_;
+            blink_controller<null_pin>& controller = controllers_[local];
+            uint32_t const now = static_cast<uint32_t>(event.time);
+            if (event.kind == event_kind::trigger) {
+                bool const was_on = controller.is_on();
+                controller.restart(now);
+                if (was_on) {
+                    record_edge(local, event.time, false);
+                }
+                ++generation_[local];
+                schedule_toggle(event.target, event.time + controller.get_off_duration());
+                continue;
+            }
+            if (event.source != generation_[local]) {
+                continue;  // re-phased by a trigger since this toggle was scheduled
+            }
+            controller.update(now);
+            bool const on = controller.is_on();
+            uint32_t const edge = record_edge(local, event.time, on);
+            schedule_toggle(event.target, event.time + (on ? controller.get_on_duration()
+                                                           : controller.get_off_duration()));
+            if (on) {
+                send_triggers(event.target, edge, event.time);
+            }
+        }
+    }
+
+    /// Earliest pending event (FOREVER if none)
+    uint64_t next_time() const { return queue_.empty() ? FOREVER : queue_.top().time; }
+
+    /// Deliver a trigger produced by another shard
+    void deliver(sim_event const& event) { queue_.push(event); }
+
+    /// Triggers waiting for each destination shard
+    std::vector<std::vector<sim_event>>& outbox() { return outbox_; }
+
+    void collect(sim_result& result) const {
+        std::copy(edges_.begin(), edges_.end(), result.edges.begin() + begin_);
+        std::copy(digests_.begin(), digests_.end(), result.digests.begin() + begin_);
+        result.events += events_;
+    }
+
+   private:
+    uint32_t record_edge(uint32_t local, uint64_t time, bool on) {
+        uint64_t digest = digests_[local];
+        digest = (digest ^ time) * 1099511628211ull;
+        digest = (digest ^ (on ? 1u : 0u)) * 1099511628211ull;
+        digests_[local] = digest;
+        return edges_[local]++;
+    }
+
+    void schedule_toggle(uint32_t id, uint64_t time) {
+        queue_.push(sim_event{time, event_kind::toggle, id, generation_[id - begin_], 0});
+    }
+
+    void send_triggers(uint32_t source, uint32_t edge, uint64_t time) {
+        for (uint32_t i = table_.first[source]; i < table_.first[source + 1]; ++i) {
+            sim_link const& link = table_.links[i];
+            sim_event const trigger{time + link.latency_ms, event_kind::trigger, link.target,
+                                    source, edge};
+            if (link.target >= begin_ && link.target < end_) {
+                queue_.push(trigger);
+            } else {
+                outbox_[partition_.node_of(link.target)].push_back(trigger);
+            }
+        }
+    }
+
+    link_table const& table_;
+    show_partition const& partition_;
+    uint32_t begin_;
+    uint32_t end_;
+    null_pin pin_;
+    std::vector<blink_controller<null_pin>> controllers_;
+    std::vector<uint32_t> generation_;
+    std::vector<uint32_t> edges_;
+    std::vector<uint64_t> digests_;
+    std::priority_queue<sim_event> queue_;
+    std::vector<std::vector<sim_event>> outbox_;
+    uint64_t events_;
+};
+
+/**
+ * @brief Reusable thread barrier (blocking, so oversubscribed runs do not spin)
+ */
+struct window_barrier {
+   public:
+    explicit window_barrier(size_t threads) : threads_(threads), waiting_(0), round_(0) {}
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        uint64_t const round = round_;
+        if (++waiting_ == threads_) {
+            waiting_ = 0;
+            ++round_;
+            wake_.notify_all();
+            return;
+        }
+        wake_.wait(lock, [&] { return round_ != round; });
+    }
+
+   private:
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    size_t threads_;
+    size_t waiting_;
+    uint64_t round_;
+};
+
+inline bool valid_show(lockstep_show const& show) {
+    for (size_t i = 0; i < show.controllers.size(); ++i) {
+        if (show.controllers[i].on_ms == 0 || show.controllers[i].off_ms == 0) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < show.links.size(); ++i) {
+        sim_link const& link = show.links[i];
+        if (link.latency_ms == 0 || link.source >= show.controllers.size() ||
+            link.target >= show.controllers.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void reset_result(lockstep_show const& show, sim_result& result) {
+    result.edges.assign(show.controllers.size(), 0);
+    result.digests.assign(show.controllers.size(), 0);
+    result.events = 0;
+}
+
+}  // namespace lockstep_detail
+
+/**
+ * @brief Single-threaded reference run: every event before end_ms, one queue
+ *
+ * @return false if a duration or link latency is 0 or a link id is out of range
+ */
+inline bool simulate_show(lockstep_show const& show, uint64_t end_ms, sim_result& result) {
+    using namespace lockstep_detail;
+    if (!valid_show(show)) {
+        return false;
+    }
+    reset_result(show, result);
+    if (show.controllers.empty()) {
+        return true;
+    }
+    link_table const table(show);
+    show_partition const partition =
+        show_partition::balanced(static_cast<uint32_t>(show.controllers.size()), 1);
+    sim_shard shard(show, table, partition, 0);
+    shard.run(end_ms);
+    shard.collect(result);
+    return true;
+}
+
+/**
+ * @brief Sharded run on threads, bit-identical to simulate_show()
+ *
+ * @param threads Shards / threads (clamped to the controller count)
+ * @param stats Optional window and message counts
+ * @return false on the same invalid shows as simulate_show()
+ */
+inline bool simulate_show_parallel(lockstep_show const& show, uint64_t end_ms, uint16_t threads,
+                                   sim_result& result, lockstep_stats* stats = nullptr) {
+    using namespace lockstep_detail;
+    if (!valid_show(show)) {
+        return false;
+    }
+    reset_result(show, result);
+    size_t const count = show.controllers.size();
+    if (count == 0) {
+        return true;
+    }
+    uint16_t const shards = static_cast<uint16_t>(
+        std::max<size_t>(1, std::min<size_t>(threads == 0 ? 1 : threads, count)));
+    link_table const table(show);
+    show_partition const partition =
+        show_partition::balanced(static_cast<uint32_t>(count), shards);
+
+    // Lookahead: the soonest one shard can affect another
+    uint64_t window = FOREVER;
+    for (size_t i = 0; i < show.links.size(); ++i) {
+        sim_link const& link = show.links[i];
+        if (partition.node_of(link.source) != partition.node_of(link.target)) {
+            window = std::min<uint64_t>(window, link.latency_ms);
+        }
+    }
+
+    std::vector<std::unique_ptr<sim_shard>> shard;
+    for (uint16_t i = 0; i < shards; ++i) {
+        shard.emplace_back(new sim_shard(show, table, partition, i));
+    }
+    uint64_t first_event = FOREVER;
+    for (uint16_t i = 0; i < shards; ++i) {
+        first_event = std::min(first_event, shard[i]->next_time());
+    }
+    // next[i]: shard i's earliest pending event after a window, including what it sent
+    std::vector<uint64_t> next(shards, FOREVER);
+    window_barrier barrier(shards);
+    uint64_t windows = 0;
+    std::atomic<uint64_t> messages(0);
+
+    auto worker = [&](uint16_t self) {
+        uint64_t start = first_event;
+        while (start < end_ms) {
+            uint64_t const until = window == FOREVER ? end_ms : std::min(end_ms, start + window);
+            shard[self]->run(until);
+
+            uint64_t earliest = shard[self]->next_time();
+            std::vector<std::vector<sim_event>> const& outbox = shard[self]->outbox();
+            for (size_t to = 0; to < outbox.size(); ++to) {
+                for (size_t e = 0; e < outbox[to].size(); ++e) {
+                    earliest = std::min(earliest, outbox[to][e].time);
+                }
+            }
+            next[self] = earliest;
+            barrier.wait();
+
+            // Every shard has finished the window: take this shard's mail, agree on the next start
+            uint64_t received = 0;
+            for (uint16_t from = 0; from < shards; ++from) {
+                std::vector<sim_event>& mail = shard[from]->outbox()[self];
+                for (size_t e = 0; e < mail.size(); ++e) {
+                    shard[self]->deliver(mail[e]);
+                }
+                received += mail.size();
+                mail.clear();
+            }
+            messages.fetch_add(received, std::memory_order_relaxed);
+            start = FOREVER;
+            for (uint16_t i = 0; i < shards; ++i) {
+                start = std::min(start, next[i]);
+            }
+            if (self == 0) {
+                ++windows;
+            }
+            // Mail is emptied and next[] read everywhere before the next window refills them
+            barrier.wait();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (uint16_t i = 1; i < shards; ++i) {
+        pool.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+
+    for (uint16_t i = 0; i < shards; ++i) {
+        shard[i]->collect(result);
+    }
+    if (stats != nullptr) {
+        stats->windows = windows;
+        stats->cross_messages = messages.load();
+        stats->window_ms = window == FOREVER ? 0 : static_cast<uint32_t>(window);
+    }
+    return true;
+}
@@ -0,0 +1,381 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief SMPTE linear timecode (LTC) decoding and show-clock chase
+ *
+ * The soundtrack player outputs LTC on an audio channel. ltc_decoder recovers
+ * the bit clock from that channel's PCM samples and emits one ltc_frame per
+ * decoded 80-bit frame; ltc_chase_clock turns those frames into a millis()
+ * show clock that blink_controllers (and show_node) can read directly:
+ *
+ *   ltc_chase_clock clock(48000, 2000);
+ *   clock.process(block, 480, 2);       // every audio block, LTC on the left channel
+ *   controller.update(clock.millis());
+ *
+ * Design:
+ * - Streaming, sample by sample: no buffers beyond the caller's PCM block
+ * - Zero crossings with amplitude-tracking hysteresis, so level and polarity
+ *   don't matter and silence doesn't chatter
+ * - Biphase-mark bit clock recovered from crossing intervals with an
+ *   adaptive bit period (tracks 24/25/30 fps and varispeed around them)
+ * - Frames only accepted on the sync word with valid BCD fields
+ *
+ * Forward playback only; reverse LTC (sync word mirrored) is ignored.
+ */
+
+/// Decoded SMPTE time address
+struct ltc_timecode {
+    uint8_t hours;
+    uint8_t minutes;
+    uint8_t seconds;
+    uint8_t frames;
+    bool drop_frame;
+};
+
+/// One decoded frame: its time address and where it ended in the stream
+struct ltc_frame {
+    ltc_timecode timecode;
+    uint32_t fps;         // nominal rate: 24, 25 or 30 (30 + drop_frame = 29.97)
+    uint64_t end_sample;  // index of the sample just after the frame's last bit
+};
+
+/**
+ * @brief Frames since 00:00:00:00 (drop-frame numbering skips frames 0 and 1
+ *        of each minute except every tenth)
+ */
+inline uint32_t ltc_frame_number(ltc_timecode const& timecode, uint32_t fps) {
+    uint32_t const total_minutes = timecode.hours * 60u + timecode.minutes;
+    uint32_t number = (total_minutes * 60u + timecode.seconds) * fps + timecode.frames;
+    if (timecode.drop_frame) {
+        number -= 2 * (total_minutes - total_minutes / 10);
+    }
+    return number;
+}
+
+/**
+ * @brief Start time of frame number (ms since 00:00:00:00)
+ */
+inline uint32_t ltc_frame_ms(uint32_t frame_number, uint32_t fps, bool drop_frame) {
+    if (drop_frame) {
+        return static_cast<uint32_t>(static_cast<uint64_t>(frame_number) * 1001 / 30);
+    }
+    return static_cast<uint32_t>(static_cast<uint64_t>(frame_number) * 1000 / fps);
+}
+
+/**
+ * @brief Streaming LTC decoder (biphase-mark bit clock recovery)
+ */
+struct ltc_decoder {
+   public:
+    /// Bits 64-79 of a forward frame, bit 64 in the least significant bit
+    static constexpr uint16_t SYNC_WORD = 0xBFFC;
+    /// Hysteresis floor: quieter input is treated as silence
+    static constexpr int32_t MIN_THRESHOLD = 256;
+
+    /**
+     * @param sample_rate PCM sample rate; the bit period starts at the 25 fps value
+     */
+    explicit ltc_decoder(uint32_t sample_rate)
+        : sample_rate_(sample_rate),
+          bit_period_(static_cast<float>(sample_rate) / 2000.0f),
+          position_(0),
+          since_edge_(0),
+          envelope_(0),
+          level_(false),
+          half_pending_(false),
+          half_interval_(0),
+          bits_(0),
+          low_bits_(0),
+          high_bits_(0),
+          max_frame_seen_(0),
+          last_frame_(0),
+          last_seconds_(0),
+          rollover_fps_(0),
+          frames_(0),
+          rejected_frames_(0),
+          sync_losses_(0) {}
+
+    /**
+     * @brief Decode a block of PCM samples
+     *
+     * @param samples First sample of the LTC channel
+     * @param count Number of sample frames
+     * @param stride Distance between consecutive samples (channel count when interleaved)
+     * @param handler Called as handler(ltc_frame const&) for every decoded frame
+     */
+    template<typename handler_t>
+    void process(int16_t const* samples, size_t count, size_t stride, handler_t& handler) {
+        for (size_t i = 0; i < count; ++i) {
+            int32_t const sample = samples[i * stride];
+            int32_t const magnitude = sample < 0 ? -sample : sample;
+            envelope_ = magnitude > envelope_ ? magnitude : envelope_ - (envelope_ >> 10);
+            int32_t const threshold = (envelope_ >> 2) > MIN_THRESHOLD ? envelope_ >> 2
+                                                                       : MIN_THRESHOLD;
+            ++position_;
+            ++since_edge_;
+            if (level_ ? sample < -threshold : sample > threshold) {
+                level_ = !level_;
+                on_edge(handler);
+            }
+        }
+    }
+
+    /// Samples consumed so far
+    uint64_t position() const { return position_; }
+    uint32_t sample_rate() const { return sample_rate_; }
+    /// Current bit period estimate in samples
+    float bit_period() const { return bit_period_; }
+    /**
+     * @brief Nominal frame rate (24, 25 or 30)
+     *
+     * Taken from the frame count at the last seconds rollover once one has
+     * been seen; until then, guessed from the bit period and the highest
+     * frame number so far (varispeed makes the period alone ambiguous).
+     */
+    uint32_t fps() const {
+        if (rollover_fps_ != 0) {
+            return rollover_fps_;
+        }
+        float const rate = static_cast<float>(sample_rate_) / (80.0f * bit_period_);
+        uint32_t const guess = rate < 24.5f ? 24 : (rate < 27.5f ? 25 : 30);
+        uint32_t const seen = max_frame_seen_ >= 25 ? 30 : (max_frame_seen_ >= 24 ? 25 : 24);
+        return guess > seen ? guess : seen;
+    }
+    uint64_t frames() const { return frames_; }
+    uint64_t rejected_frames() const { return rejected_frames_; }
+    uint64_t sync_losses() const { return sync_losses_; }
+
+   private:
+    template<typename handler_t>
+    void on_edge(handler_t& handler) {
+        float const interval = static_cast<float>(since_edge_);
+        since_edge_ = 0;
+        if (interval > bit_period_ * 1.6f || interval < bit_period_ * 0.25f) {
+            // Gap or glitch: bit alignment is lost, the period estimate is kept
+            lose_sync();
+            return;
+        }
+        if (interval < bit_period_ * 0.75f) {
+            if (!half_pending_) {
+                half_pending_ = true;
+                half_interval_ = interval;
+                return;
+            }
+            half_pending_ = false;
+            adapt(half_interval_ + interval);
+            push_bit(1, handler);
+            return;
+        }
+        if (half_pending_) {
+            // A lone half bit: we paired the halves of a '1' wrongly
+            half_pending_ = false;
+            lose_sync();
+        }
+        adapt(interval);
+        push_bit(0, handler);
+    }
+
+    void adapt(float measured) { bit_period_ += (measured - bit_period_) * 0.125f; }
+
+    void lose_sync() {
+        if (bits_ > 0) {
+            ++sync_losses_;
+        }
+        bits_ = 0;
+        half_pending_ = false;
+    }
+
+    template<typename handler_t>
+    void push_bit(uint32_t bit, handler_t& handler) {
+        low_bits_ = (low_bits_ >> 1) | (static_cast<uint64_t>(high_bits_ & 1) << 63);
+        high_bits_ = static_cast<uint16_t>((high_bits_ >> 1) | (bit << 15));
+        if (bits_ < 80) {
+            ++bits_;
+        }
+        if (bits_ == 80 && high_bits_ == SYNC_WORD) {
+            bits_ = 0;
+            decode_frame(handler);
+        }
+    }
+
+    uint32_t field(int offset, int width) const {
+        return static_cast<uint32_t>(low_bits_ >> offset) & ((1u << width) - 1);
+    }
+
+    template<typename handler_t>
+    void decode_frame(handler_t& handler) {
+        uint32_t const units[] = {field(0, 4), field(16, 4), field(32, 4), field(48, 4)};
+        ltc_frame frame;
+        frame.timecode.frames = static_cast<uint8_t>(units[0] + 10 * field(8, 2));
+        frame.timecode.drop_frame = field(10, 1) != 0;
+        frame.timecode.seconds = static_cast<uint8_t>(units[1] + 10 * field(24, 3));
+        frame.timecode.minutes = static_cast<uint8_t>(units[2] + 10 * field(40, 3));
+        frame.timecode.hours = static_cast<uint8_t>(units[3] + 10 * field(56, 2));
+        frame.end_sample = position_;
+        if (units[0] > 9 || units[1] > 9 || units[2] > 9 || units[3] > 9 ||
+            frame.timecode.frames >= 30 || frame.timecode.seconds > 59 ||
+            frame.timecode.minutes > 59 || frame.timecode.hours > 23) {
+            ++rejected_frames_;
+            return;
+        }
+        bool const rolled_over = frames_ > 0 && frame.timecode.seconds != last_seconds_ &&
+                                 last_frame_ >= 23 && frame.timecode.frames <= 2;
+        if (rolled_over && !frame.timecode.drop_frame) {
+            rollover_fps_ = last_frame_ + 1u;
+        }
+        if (frame.timecode.frames > max_frame_seen_) {
+            max_frame_seen_ = frame.timecode.frames;
+        }
+        last_frame_ = frame.timecode.frames;
+        last_seconds_ = frame.timecode.seconds;
+        frame.fps = frame.timecode.drop_frame ? 30 : fps();
+        if (frame.timecode.frames >= frame.fps) {
+            ++rejected_frames_;
+            return;
+        }
+        ++frames_;
+        handler(frame);
+    }
+
+    uint32_t sample_rate_;
+    float bit_period_;
+    uint64_t position_;
+    uint32_t since_edge_;
+    int32_t envelope_;
+    bool level_;
+    bool half_pending_;
+    float half_interval_;
+    uint32_t bits_;         // aligned bits received since sync was lost (saturates at 80)
+    uint64_t low_bits_;     // frame bits 0-63 once 80 bits are in
+    uint16_t high_bits_;    // frame bits 64-79
+    uint8_t max_frame_seen_;
+    uint8_t last_frame_;
+    uint8_t last_seconds_;
+    uint32_t rollover_fps_;
+    uint64_t frames_;
+    uint64_t rejected_frames_;
+    uint64_t sync_losses_;
+};
+
+enum class ltc_chase_state : uint8_t { searching, locked, freewheel, stopped };
+
+/**
+ * @brief Show clock chasing LTC, with freewheel through dropouts
+ *
+ * Each decoded frame anchors the clock (time at the frame's end = start of the
+ * next frame); between frames it advances with the sample count. If frames
+ * stop arriving it freewheels on the sample count for freewheel_ms, then
+ * stops and holds. Small backward corrections (re-anchoring jitter) are held
+ * off so millis() never steps back by less than a frame, which would look
+ * like a 49-day elapsed time to blink_controller; real jumps in the source
+ * (seek, restart) are followed and counted.
+ */
+struct ltc_chase_clock {
+   public:
+    /// Frames must keep arriving this often to stay locked
+    static constexpr uint32_t LOCK_TIMEOUT_MS = 100;
+
+    /**
+     * @param sample_rate PCM sample rate of the LTC channel
+     * @param freewheel_ms How long to keep running after the last frame
+     */
+    ltc_chase_clock(uint32_t sample_rate, uint32_t freewheel_ms)
+        : decoder_(sample_rate),
+          freewheel_ms_(freewheel_ms),
+          state_(ltc_chase_state::searching),
+          anchored_(false),
+          anchor_ms_(0),
+          anchor_sample_(0),
+          frame_ms_(40),
+          now_ms_(0),
+          jumps_(0),
+          dropouts_(0) {}
+
+    /**
+     * @brief Consume a block of PCM samples and advance the clock to its end
+     */
+    void process(int16_t const* samples, size_t count, size_t stride = 1) {
+        frame_handler handler = {this};
+        decoder_.process(samples, count, stride, handler);
+        if (anchored_) {
+            update_state();
+            advance(extrapolate_to(decoder_.position()), false);
+        }
+    }
+
+    /**
+     * @brief Show time at the end of the last processed block
+     */
+    uint32_t millis() const { return now_ms_; }
+
+    ltc_chase_state state() const { return state_; }
+    uint64_t jumps() const { return jumps_; }
+    uint64_t dropouts() const { return dropouts_; }
+    ltc_decoder const& decoder() const { return decoder_; }
+
+   private:
+    struct frame_handler {
+        ltc_chase_clock* clock;
+        void operator()(ltc_frame const& frame) { clock->on_frame(frame); }
+    };
+
+    void on_frame(ltc_frame const& frame) {
+        bool const drop = frame.timecode.drop_frame;
+        uint32_t const next = ltc_frame_number(frame.timecode, frame.fps) + 1;
+        uint32_t const end_ms = ltc_frame_ms(next, frame.fps, drop);
+        frame_ms_ = end_ms - ltc_frame_ms(next - 1, frame.fps, drop);
+        bool const was_anchored = anchored_;
+        uint32_t const predicted = extrapolate_to(frame.end_sample);
+        anchored_ = true;
+        anchor_ms_ = end_ms;
+        anchor_sample_ = frame.end_sample;
+        uint32_t const error = end_ms > predicted ? end_ms - predicted : predicted - end_ms;
+        bool const jumped = was_anchored && error > 2 * frame_ms_;
+        if (jumped) {
+            ++jumps_;
+        }
+        advance(end_ms, jumped);
+    }
+
+    uint32_t extrapolate_to(uint64_t sample) const {
+        uint64_t const elapsed_ms = (sample - anchor_sample_) * 1000 / decoder_.sample_rate();
+        uint64_t const capped = elapsed_ms < freewheel_ms_ ? elapsed_ms : freewheel_ms_;
+        return anchor_ms_ + static_cast<uint32_t>(capped);
+    }
+
+    void update_state() {
+        uint64_t const since_ms =
+            (decoder_.position() - anchor_sample_) * 1000 / decoder_.sample_rate();
+        ltc_chase_state next = ltc_chase_state::stopped;
+        if (since_ms <= LOCK_TIMEOUT_MS) {
+            next = ltc_chase_state::locked;
+        } else if (since_ms <= freewheel_ms_) {
+            next = ltc_chase_state::freewheel;
+        }
+        if (next != ltc_chase_state::locked && state_ == ltc_chase_state::locked) {
+            ++dropouts_;
+        }
+        state_ = next;
+    }
+
+    void advance(uint32_t candidate_ms, bool jumped) {
+        uint32_t const behind = now_ms_ - candidate_ms;
+        if (!jumped && anchored_ && behind > 0 && behind <= 2 * frame_ms_) {
+            return;  // hold: re-anchoring jitter
+        }
+        now_ms_ = candidate_ms;
+    }
+
+    ltc_decoder decoder_;
+    uint32_t freewheel_ms_;
+    ltc_chase_state state_;
+    bool anchored_;
+    uint32_t anchor_ms_;
+    uint64_t anchor_sample_;
+    uint32_t frame_ms_;
+    uint32_t now_ms_;
+    uint64_t jumps_;
+    uint64_t dropouts_;
+};
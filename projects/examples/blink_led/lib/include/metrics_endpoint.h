@@ -0,0 +1,433 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief Local HTTP endpoint with Prometheus metrics and a JSON status
+ *
+ * The control loop publishes a show_metrics snapshot once per frame into a
+ * seqlock; a server thread answers scrapes from the latest snapshot:
+ *
+ *   metrics_seqlock<show_metrics> published;
+ *   metrics_server server(published);
+ *   server.open(9100);                        // 127.0.0.1 unless loopback_only is false
+ *   server.start();
+ *
+ *   control loop:  metrics.add_frame(frame_us, budget_us, edges);
+ *                  published.publish(metrics);
+ *
+ *   curl http://127.0.0.1:9100/metrics         # Prometheus text format
+ *   curl http://127.0.0.1:9100/status          # JSON
+ *
+ * Design:
+ * - publish() is wait-free: two sequence increments around a word-wise copy.
+ *   Readers retry on a torn copy; the writer never waits for a scrape.
+ * - The server thread owns its request and response buffers, sized once in
+ *   the constructor; formatting appends digits into them, so serving a
+ *   scrape does not allocate.
+ * - One connection at a time with HTTP/1.0 semantics (Connection: close);
+ *   a client that sends nothing is dropped after REQUEST_TIMEOUT_MS.
+ */
+
+/**
+ * @brief Single-writer seqlock over a trivially copyable snapshot of 64-bit words
+ */
+template<typename snapshot_t>
+struct metrics_seqlock {
+    static_assert(std::is_trivially_copyable<snapshot_t>::value, "snapshot must be a plain struct");
+    static_assert(sizeof(snapshot_t) % sizeof(uint64_t) == 0, "snapshot must be whole words");
+
+   public:
+    metrics_seqlock() : sequence_(0) {
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Replace the snapshot (single writer: the control loop)
+    void publish(snapshot_t const& snapshot) {
+        uint64_t words[WORDS];
+        std::memcpy(words, &snapshot, sizeof(snapshot));
+        uint64_t const sequence = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(sequence + 1, std::memory_order_relaxed);  // odd: writing
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; ++i) {
+            words_[i].store(words[i], std::memory_order_relaxed);
+        }
+        sequence_.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy the latest snapshot, retrying while a publish is in progress
+     *
+     * @return Publishes so far (0 if none: snapshot is all zero)
+     */
+    uint64_t read(snapshot_t& snapshot) const {
+        uint64_t words[WORDS];
+        for (;;) {
+            uint64_t const before = sequence_.load(std::memory_order_acquire);
+            if (before % 2 != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            for (size_t i = 0; i < WORDS; ++i) {
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence_.load(std::memory_order_relaxed) == before) {
+                std::memcpy(&snapshot, words, sizeof(snapshot));
+                return before / 2;
+            }
+        }
+    }
+
+   private:
+    static constexpr size_t WORDS = sizeof(snapshot_t) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> sequence_;
+    std::atomic<uint64_t> words_[WORDS];
+};
+
+/**
+ * @brief What operators watch on site, kept by the control loop
+ */
+struct show_metrics {
+    uint64_t show_time_ms;
+    uint64_t frames;
+    uint64_t edges;          // controller toggles
+    uint64_t overruns;       // frames longer than their budget
+    uint64_t frame_us_last;
+    uint64_t frame_us_max;
+    uint64_t frame_us_sum;
+    uint64_t controllers;
+    uint64_t controllers_on;
+    uint64_t published_ns;   // metrics_now_ns() of the publish, for the snapshot age
+
+    /// Count one frame of the control loop
+    void add_frame(uint64_t frame_us, uint64_t budget_us, uint64_t frame_edges) {
+        frames += 1;
+        edges += frame_edges;
+        overruns += frame_us > budget_us ? 1 : 0;
+        frame_us_last = frame_us;
+        frame_us_max = frame_us > frame_us_max ? frame_us : frame_us_max;
+        frame_us_sum += frame_us;
+    }
+};
+
+inline uint64_t metrics_now_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+/**
+ * @brief Appends text and numbers into a fixed buffer; truncates, never allocates
+ */
+struct metrics_text {
+   public:
+    metrics_text(char* buffer, size_t capacity) : buffer_(buffer), capacity_(capacity), size_(0) {}
+
+    metrics_text& operator<<(char const* text) {
+        while (*text != '\0') {
+            put(*text++);
+        }
+        return *this;
+    }
+
+    metrics_text& operator<<(uint64_t value) {
+        char digits[20];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count > 0) {
+            put(digits[--count]);
+        }
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool truncated() const { return size_ > capacity_; }
+    char const* data() const { return buffer_; }
+
+   private:
+    void put(char c) {
+        if (size_ < capacity_) {
+            buffer_[size_] = c;
+        }
+        ++size_;
+    }
+
+    char* buffer_;
+    size_t capacity_;
+    size_t size_;
+};
+
+/// Prometheus text exposition (format 0.0.4) of a snapshot
+inline void format_prometheus(metrics_text& out, show_metrics const& m, uint64_t now_ns,
+                              uint64_t scrapes) {
+    struct metric {
+        char const* name;
+        char const* type;
+        char const* help;
+        uint64_t value;
+    };
+    metric const metrics[] = {
+        {"blink_show_time_ms", "gauge", "Show clock in milliseconds.", m.show_time_ms},
+        {"blink_frames_total", "counter", "Control loop frames run.", m.frames},
+        {"blink_edges_total", "counter", "Controller toggles.", m.edges},
+        {"blink_overruns_total", "counter", "Frames longer than their budget.", m.overruns},
+        {"blink_frame_time_us", "gauge", "Duration of the last frame.", m.frame_us_last},
+        {"blink_frame_time_max_us", "gauge", "Longest frame so far.", m.frame_us_max},
+        {"blink_frame_time_us_sum", "counter", "Total frame time.", m.frame_us_sum},
+        {"blink_controllers", "gauge", "Controllers in the show.", m.controllers},
+        {"blink_controllers_on", "gauge", "Controllers currently on.", m.controllers_on},
+        {"blink_snapshot_age_ms", "gauge", "Time since the control loop last published.",
+         m.published_ns != 0 && now_ns > m.published_ns ? (now_ns - m.published_ns) / 1000000
+                                                         : 0},
+        {"blink_scrapes_total", "counter", "Requests served by this endpoint.", scrapes},
+    };
+    for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i) {
+        out << "# HELP " << metrics[i].name << " " << metrics[i].help << "\n"
+            << "# TYPE " << metrics[i].name << " " << metrics[i].type << "\n"
+            << metrics[i].name << " " << metrics[i].value << "\n";
+    }
+}
+
+/// JSON status of a snapshot
+inline void format_status_json(metrics_text& out, show_metrics const& m, uint64_t now_ns) {
+    uint64_t const age_ms =
+        m.published_ns != 0 && now_ns > m.published_ns ? (now_ns - m.published_ns) / 1000000 : 0;
+    out << "{\"show_time_ms\":" << m.show_time_ms << ",\"frames\":" << m.frames
+        << ",\"edges\":" << m.edges << ",\"overruns\":" << m.overruns
+        << ",\"frame_us\":{\"last\":" << m.frame_us_last << ",\"max\":" << m.frame_us_max
+        << ",\"avg\":" << (m.frames != 0 ? m.frame_us_sum / m.frames : 0)
+        << "},\"controllers\":" << m.controllers << ",\"controllers_on\":" << m.controllers_on
+        << ",\"snapshot_age_ms\":" << age_ms << "}\n";
+}
+
+/**
+ * @brief HTTP server thread answering GET /metrics and GET /status
+ */
+struct metrics_server {
+   public:
+    static constexpr size_t MAX_REQUEST = 2048;
+    static constexpr size_t MAX_BODY = 4096;
+    static constexpr int REQUEST_TIMEOUT_MS = 1000;
+
+    explicit metrics_server(metrics_seqlock<show_metrics> const& source)
+        : source_(source),
+          request_(MAX_REQUEST),
+          body_(MAX_BODY),
+          response_(MAX_BODY + 256),
+          fd_(-1),
+          running_(false),
+          scrapes_(0),
+          bad_requests_(0) {}
+
+    ~metrics_server() {
+        stop();
+        close();
+    }
+
+    metrics_server(metrics_server const&) = delete;
+    metrics_server& operator=(metrics_server const&) = delete;
+
+    /**
+     * @brief Bind and listen on a TCP port
+     *
+     * @param port Port to bind, 0 for ephemeral (see port())
+     * @param loopback_only Bind 127.0.0.1 instead of all interfaces
+     */
+    bool open(uint16_t port, bool loopback_only = true) {
+        close();
+        fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        int const reuse = 1;
+        ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(fd_, 8) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    uint16_t port() const {
+        sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (fd_ < 0 || ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return 0;
+        }
+        return ntohs(addr.sin_port);
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    /// Serve from a dedicated thread until stop()
+    void start() {
+        if (running_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        running_.store(true, std::memory_order_relaxed);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        running_.store(false, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /**
+     * @brief Wait up to timeout_ms for a connection and answer it (start() loops on this)
+     *
+     * @return false if no connection arrived
+     */
+    bool serve_one(int timeout_ms) {
+        pollfd pfd = {fd_, POLLIN, 0};
+        if (fd_ < 0 || ::poll(&pfd, 1, timeout_ms) <= 0) {
+            return false;
+        }
+        int const client = ::accept(fd_, nullptr, nullptr);
+        if (client < 0) {
+            return false;
+        }
+        size_t const size = read_request(client);
+        size_t const response_size = respond(request_.data(), size);
+        write_all(client, response_.data(), response_size);
+        ::close(client);
+        return true;
+    }
+
+    /**
+     * @brief Build the response to one request into the response buffer (exposed for tests)
+     *
+     * @return Response size in bytes
+     */
+    size_t respond(char const* request, size_t size) {
+        char const* status = "200 OK";
+        char const* content_type = "text/plain; version=0.0.4; charset=utf-8";
+        metrics_text body(body_.data(), body_.size());
+        show_metrics snapshot;
+        if (starts_with(request, size, "GET /metrics ")) {
+            source_.read(snapshot);
+            format_prometheus(body, snapshot, metrics_now_ns(),
+                              scrapes_.fetch_add(1, std::memory_order_relaxed) + 1);
+        } else if (starts_with(request, size, "GET /status ")) {
+            source_.read(snapshot);
+            scrapes_.fetch_add(1, std::memory_order_relaxed);
+            content_type = "application/json";
+            format_status_json(body, snapshot, metrics_now_ns());
+        } else if (starts_with(request, size, "GET ")) {
+            status = "404 Not Found";
+            body << "not found\n";
+        } else {
+            bad_requests_.fetch_add(1, std::memory_order_relaxed);
+            status = starts_with(request, size, "HEAD ") || starts_with(request, size, "POST ")
+                         ? "405 Method Not Allowed"
+                         : "400 Bad Request";
+            body << status << "\n";
+        }
+        size_t const body_size = body.truncated() ? body_.size() : body.size();
+        metrics_text head(response_.data(), response_.size() - body_size);
+        head << "HTTP/1.0 " << status << "\r\nContent-Type: " << content_type
+             << "\r\nContent-Length: " << static_cast<uint64_t>(body_size)
+             << "\r\nConnection: close\r\n\r\n";
+        std::memcpy(response_.data() + head.size(), body_.data(), body_size);
+        return head.size() + body_size;
+    }
+
+    char const* response() const { return response_.data(); }
+
+    uint64_t scrapes() const { return scrapes_.load(std::memory_order_relaxed); }
+    uint64_t bad_requests() const { return bad_requests_.load(std::memory_order_relaxed); }
+
+   private:
+    void run() {
+        while (running_.load(std::memory_order_relaxed)) {
+            serve_one(50);
+        }
+    }
+
+    // Read until the end of the headers, the buffer is full, or the client goes quiet
+    size_t read_request(int client) {
+        size_t size = 0;
+        while (size < request_.size()) {
+            pollfd pfd = {client, POLLIN, 0};
+            if (::poll(&pfd, 1, REQUEST_TIMEOUT_MS) <= 0) {
+                break;
+            }
+            ssize_t const n = ::recv(client, request_.data() + size, request_.size() - size, 0);
+            if (n <= 0) {
+                break;
+            }
+            size += static_cast<size_t>(n);
+            if (headers_complete(request_.data(), size)) {
+                break;
+            }
+        }
+        return size;
+    }
+
+    static bool headers_complete(char const* data, size_t size) {
+        for (size_t i = 3; i < size; ++i) {
+            if (data[i - 3] == '\r' && data[i - 2] == '\n' && data[i - 1] == '\r' &&
+                data[i] == '\n') {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool starts_with(char const* data, size_t size, char const* prefix) {
+        size_t const length = std::strlen(prefix);
+        return size >= length && std::memcmp(data, prefix, length) == 0;
+    }
+
+    static void write_all(int client, char const* data, size_t size) {
+        while (size > 0) {
+            ssize_t const n = ::send(client, data, size, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    metrics_seqlock<show_metrics> const& source_;
+    std::vector<char> request_;
+    std::vector<char> body_;
+    std::vector<char> response_;
+    int fd_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> scrapes_;
+    std::atomic<uint64_t> bad_requests_;
+    std::thread thread_;
+};
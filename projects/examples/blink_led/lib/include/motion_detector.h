@@ -0,0 +1,318 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "show_command.h"
+
+/**
+ * @brief Camera triggers: frame-differencing motion detection
+ *
+ * Each frame's luma plane is compared with the previous frame's in 8x8
+ * cells: the cell's sum of absolute differences (one PSADBW per 8 pixels on
+ * SSE2) is the downsampled difference image. A cell whose mean difference is
+ * above the noise threshold is active; a region's activity is its fraction
+ * of active cells. A region crossing its trigger level emits a trigger
+ * command for its controller, then must fall below its re-arm level (and
+ * wait out its hold-off) before it can fire again:
+ *
+ *   raw_video_reader video("hallway.yuv", 640, 480, raw_video_format::yuv420p);
+ *   motion_detector detector(640, 480, 12);
+ *   detector.add_region(motion_region{0, 0, 320, 480, 0.05f, 0.01f, 30, 17});
+ *   while (video.read(frame)) detector.process(frame.data(), handler);
+ *
+ * Frames come from raw files standing in for a camera: 8-bit grayscale or
+ * planar YUV 4:2:0 (only the Y plane is used). Pixels beyond the last whole
+ * cell on the right or bottom are ignored.
+ */
+
+/// Cell edge length in pixels
+constexpr uint32_t MOTION_CELL = 8;
+
+enum class raw_video_format : uint8_t { gray8 = 1, yuv420p = 2 };
+
+/**
+ * @brief Reads fixed-size raw frames from a file
+ *
+ * read() returns the luma plane; chroma planes are skipped.
+ */
+struct raw_video_reader {
+   public:
+    raw_video_reader(char const* path, uint32_t width, uint32_t height, raw_video_format format)
+        : file_(std::fopen(path, "rb")),
+          luma_size_(static_cast<size_t>(width) * height),
+          skip_size_(format == raw_video_format::yuv420p
+                         ? static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2) * 2
+                         : 0),
+          frames_(0) {}
+
+    ~raw_video_reader() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+
+    raw_video_reader(raw_video_reader const&) = delete;
+    raw_video_reader& operator=(raw_video_reader const&) = delete;
+
+    bool ok() const { return file_ != nullptr; }
+
+    /**
+     * @brief Read the next frame's luma plane
+     *
+     * @return false at end of file (or a truncated last frame)
+     */
+    bool read(std::vector<uint8_t>& luma) {
+        luma.resize(luma_size_);
+        if (file_ == nullptr || std::fread(luma.data(), 1, luma_size_, file_) != luma_size_) {
+            return false;
+        }
+        if (skip_size_ != 0 && std::fseek(file_, static_cast<long>(skip_size_), SEEK_CUR) != 0) {
+            return false;
+        }
+        ++frames_;
+        return true;
+    }
+
+    uint64_t frames() const { return frames_; }
+
+   private:
+    std::FILE* file_;
+    size_t luma_size_;
+    size_t skip_size_;
+    uint64_t frames_;
+};
+
+/**
+ * @brief Per-cell sum of absolute differences, portable version
+ *
+ * @param sad One entry per cell, row-major, (width / 8) x (height / 8)
+ */
+inline void motion_cell_sad_scalar(uint8_t const* current, uint8_t const* previous,
+                                   uint32_t width, uint32_t height, uint32_t stride,
+                                   uint16_t* sad) {
+    uint32_t const columns = width / MOTION_CELL;
+    uint32_t const rows = height / MOTION_CELL;
+    for (uint32_t row = 0; row < rows; ++row) {
+        uint16_t* const out = sad + static_cast<size_t>(row) * columns;
+        for (uint32_t column = 0; column < columns; ++column) {
+            out[column] = 0;
+        }
+        for (uint32_t y = 0; y < MOTION_CELL; ++y) {
+            size_t const line = static_cast<size_t>(row * MOTION_CELL + y) * stride;
+            for (uint32_t x = 0; x < columns * MOTION_CELL; ++x) {
+                int const diff = current[line + x] - previous[line + x];
+                out[x / MOTION_CELL] =
+                    static_cast<uint16_t>(out[x / MOTION_CELL] + (diff < 0 ? -diff : diff));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Per-cell sum of absolute differences, SIMD where available
+ *
+ * SSE2: PSADBW sums |a - b| over each 8-byte half of a 16-byte load, which
+ * is one cell row of two cells, so a cell is 8 instructions. Odd trailing
+ * cells and non-SSE2 targets use the scalar version.
+ */
+inline void motion_cell_sad(uint8_t const* current, uint8_t const* previous, uint32_t width,
+                            uint32_t height, uint32_t stride, uint16_t* sad) {
+#if defined(__SSE2__)
+    uint32_t const columns = width / MOTION_CELL;
+    uint32_t const rows = height / MOTION_CELL;
+    uint32_t const pairs = columns / 2;
+    for (uint32_t row = 0; row < rows; ++row) {
+        uint16_t* const out = sad + static_cast<size_t>(row) * columns;
+        size_t const top = static_cast<size_t>(row) * MOTION_CELL * stride;
+        for (uint32_t pair = 0; pair < pairs; ++pair) {
+            __m128i sum = _mm_setzero_si128();
+            size_t offset = top + static_cast<size_t>(pair) * 2 * MOTION_CELL;
+            for (uint32_t y = 0; y < MOTION_CELL; ++y, offset += stride) {
+                __m128i const a =
+                    _mm_loadu_si128(reinterpret_cast<__m128i const*>(current + offset));
+                __m128i const b =
+                    _mm_loadu_si128(reinterpret_cast<__m128i const*>(previous + offset));
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(a, b));
+            }
+            out[pair * 2] = static_cast<uint16_t>(_mm_cvtsi128_si32(sum));
+            out[pair * 2 + 1] = static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+        }
+        if (columns % 2 != 0) {
+            uint32_t const x = (columns - 1) * MOTION_CELL;
+            motion_cell_sad_scalar(current + top + x, previous + top + x, MOTION_CELL,
+                                   MOTION_CELL, stride, out + columns - 1);
+        }
+    }
+#else
+    motion_cell_sad_scalar(current, previous, width, height, stride, sad);
+#endif
+}
+
+/**
+ * @brief Watched rectangle (pixels) and the controller it triggers
+ *
+ * Cells are counted if their top-left corner lies inside the rectangle.
+ */
+struct motion_region {
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    float trigger_level;   // fraction of active cells that fires
+    float rearm_level;     // fraction the region must fall below before firing again
+    uint32_t hold_frames;  // minimum frames between triggers
+    uint32_t controller_id;
+};
+
+/// One trigger, ready for a show_node / command queue
+struct motion_event {
+    show_command command;
+    uint32_t region;
+    uint64_t frame;
+    float activity;
+};
+
+/**
+ * @brief Frame-differencing motion detector with per-region triggers
+ */
+struct motion_detector {
+   public:
+    /**
+     * @param width Frame width in pixels (row stride of process() frames)
+     * @param height Frame height in pixels
+     * @param noise_threshold Mean absolute difference per pixel that makes a cell active
+     */
+    motion_detector(uint32_t width, uint32_t height, uint32_t noise_threshold)
+        : width_(width),
+          height_(height),
+          columns_(width / MOTION_CELL),
+          rows_(height / MOTION_CELL),
+          cell_threshold_(noise_threshold * MOTION_CELL * MOTION_CELL),
+          previous_(static_cast<size_t>(width) * height, 0),
+          sad_(static_cast<size_t>(columns_) * rows_, 0),
+          frames_(0),
+          triggers_(0) {}
+
+    /**
+     * @brief Watch a region
+     *
+     * @return Region index (reported in motion_event::region)
+     */
+    uint32_t add_region(motion_region const& region) {
+        region_state state;
+        state.region = region;
+        state.cells = 0;
+        state.armed = true;
+        state.last_trigger = 0;
+        state.activity = 0.0f;
+        for (uint32_t row = 0; row < rows_; ++row) {
+            for (uint32_t column = 0; column < columns_; ++column) {
+                state.cells += contains(region, column, row) ? 1 : 0;
+            }
+        }
+        regions_.push_back(state);
+        return static_cast<uint32_t>(regions_.size() - 1);
+    }
+
+    /**
+     * @brief Compare a frame with the previous one and fire region triggers
+     *
+     * The first frame only becomes the reference.
+     *
+     * @param luma width x height bytes, row-major
+     * @param handler Called as handler(motion_event const&) for each trigger
+     * @return Number of triggers fired
+     */
+    template<typename handler_t>
+    size_t process(uint8_t const* luma, handler_t& handler) {
+        size_t fired = 0;
+        if (frames_ > 0) {
+            motion_cell_sad(luma, previous_.data(), width_, height_, width_, sad_.data());
+            for (size_t i = 0; i < regions_.size(); ++i) {
+                fired += update_region(static_cast<uint32_t>(i), handler) ? 1 : 0;
+            }
+        }
+        std::copy(luma, luma + previous_.size(), previous_.begin());
+        ++frames_;
+        return fired;
+    }
+
+    /// Cell SADs of the last processed frame, (width / 8) x (height / 8) row-major
+    std::vector<uint16_t> const& cell_sad() const { return sad_; }
+    float activity(uint32_t region) const { return regions_[region].activity; }
+    uint32_t columns() const { return columns_; }
+    uint32_t rows() const { return rows_; }
+    uint64_t frames() const { return frames_; }
+    uint64_t triggers() const { return triggers_; }
+
+   private:
+    struct region_state {
+        motion_region region;
+        uint32_t cells;
+        bool armed;
+        uint64_t last_trigger;
+        float activity;
+    };
+
+    static bool contains(motion_region const& region, uint32_t column, uint32_t row) {
+        uint32_t const x = column * MOTION_CELL;
+        uint32_t const y = row * MOTION_CELL;
+        return x >= region.x && x - region.x < region.width && y >= region.y &&
+               y - region.y < region.height;
+    }
+
+    template<typename handler_t>
+    bool update_region(uint32_t index, handler_t& handler) {
+        region_state& state = regions_[index];
+        motion_region const& region = state.region;
+        uint32_t const first_column = (region.x + MOTION_CELL - 1) / MOTION_CELL;
+        uint32_t const first_row = (region.y + MOTION_CELL - 1) / MOTION_CELL;
+        uint32_t active = 0;
+        for (uint32_t row = first_row; row < rows_ && contains(region, first_column, row);
+             ++row) {
+            uint16_t const* const line = sad_.data() + static_cast<size_t>(row) * columns_;
+            for (uint32_t column = first_column;
+                 column < columns_ && contains(region, column, row); ++column) {
+                active += line[column] > cell_threshold_ ? 1 : 0;
+            }
+        }
+        state.activity = state.cells == 0 ? 0.0f : static_cast<float>(active) / state.cells;
+
+        if (!state.armed) {
+            state.armed = state.activity < region.rearm_level;
+            return false;
+        }
+        if (state.activity < region.trigger_level ||
+            (state.last_trigger != 0 && frames_ - state.last_trigger < region.hold_frames)) {
+            return false;
+        }
+        state.armed = false;
+        state.last_trigger = frames_;
+        ++triggers_;
+        motion_event event;
+        event.command = show_command{show_command_type::trigger, region.controller_id, 0};
+        event.region = index;
+        event.frame = frames_;
+        event.activity = state.activity;
+        handler(event);
+        return true;
+    }
+
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t columns_;
+    uint32_t rows_;
+    uint32_t cell_threshold_;
+    std::vector<uint8_t> previous_;
+    std::vector<uint16_t> sad_;
+    std::vector<region_state> regions_;
+    uint64_t frames_;
+    uint64_t triggers_;
+};
@@ -0,0 +1,663 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "show_command.h"
+#include "spsc_queue.h"
+
+/**
+ * @brief Live control input: OSC and RTP-MIDI over UDP
+ *
+ * Operators' control surfaces send OSC messages (or RTP-MIDI note-ons); each
+ * datagram is parsed in place in the receive buffer, its address resolved
+ * through a table built once at setup, and the resulting show_command handed
+ * to the control loop through a lock-free SPSC queue:
+ *
+ *   receiver thread:  input.poll(10);           // recv -> parse -> queue.push
+ *   control loop:     while (queue.pop(cmd)) node.apply(cmd.command, cmd.received_ns);
+ *
+ * Design:
+ * - No allocation after setup: fixed receive buffer, views into it, fixed queue
+ * - Address routing is an exact-match open-addressing hash table (OSC pattern
+ *   wildcards are not expanded; surfaces send concrete addresses)
+ * - A full queue drops the command and counts it; the receiver never blocks
+ */
+
+/// OSC arguments are big-endian 32-bit words
+inline uint32_t osc_read_be32(uint8_t const* data) {
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) |
+           (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+}
+
+/**
+ * @brief Zero-copy view of one OSC message inside a receive buffer
+ */
+struct osc_message_view {
+   public:
+    char const* address = nullptr;
+    size_t address_length = 0;
+    char const* type_tags = nullptr;  // tags after the ',' (not terminated by the view)
+    size_t arg_count = 0;
+    uint8_t const* args = nullptr;
+    size_t args_size = 0;
+
+    /**
+     * @brief Numeric value of argument index (i, f, d, T, F)
+     *
+     * @return false if the argument is missing, not numeric, or truncated
+     */
+    bool numeric_arg(size_t index, float& value) const {
+        char tag = 0;
+        uint8_t const* data = nullptr;
+        if (!find_arg(index, tag, data)) {
+            return false;
+        }
+        if (tag == 'T' || tag == 'F') {
+            value = tag == 'T' ? 1.0f : 0.0f;
+        } else if (tag == 'i') {
+            value = static_cast<float>(static_cast<int32_t>(osc_read_be32(data)));
+        } else if (tag == 'f') {
+            uint32_t const word = osc_read_be32(data);
+            std::memcpy(&value, &word, sizeof(value));
+        } else if (tag == 'd') {
+            value = static_cast<float>(read_double(data));
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Argument index as a show time in milliseconds, clamped to [0, UINT32_MAX]
+     *
+     * Integers (i, h) are exact; only f is rounded by its 24-bit mantissa,
+     * so seeks past 2^24 ms (4.66 h) should be sent as i or d.
+     *
+     * @return false if the argument is missing, not i / h / f / d, truncated, or NaN
+     */
+    bool time_arg(size_t index, uint32_t& time_ms) const {
+        char tag = 0;
+        uint8_t const* data = nullptr;
+        if (!find_arg(index, tag, data)) {
+            return false;
+        }
+        if (tag == 'i' || tag == 'h') {
+            int64_t const value = tag == 'i' ? static_cast<int32_t>(osc_read_be32(data))
+                                             : static_cast<int64_t>(read_be64(data));
+            time_ms = value <= 0                                    ? 0
+                      : value >= static_cast<int64_t>(UINT32_MAX) ? UINT32_MAX
+                                                                  : static_cast<uint32_t>(value);
+            return true;
+        }
+        double value = 0.0;
+        if (tag == 'f') {
+            float single = 0.0f;
+            uint32_t const word = osc_read_be32(data);
+            std::memcpy(&single, &word, sizeof(single));
+            value = single;
+        } else if (tag == 'd') {
+            value = read_double(data);
+        } else {
+            return false;
+        }
+        if (value != value) {
+            return false;
+        }
+        // Clamped before the cast: double -> uint32_t is undefined beyond its range
+        time_ms = value <= 0.0            ? 0
+                  : value >= 4294967295.0 ? UINT32_MAX
+                                          : static_cast<uint32_t>(value);
+        return true;
+    }
+
+    static size_t padded(size_t size) { return (size + 3) & ~static_cast<size_t>(3); }
+
+   private:
+    // Tag and data of argument index, whose fixed-size payload is all inside args
+    bool find_arg(size_t index, char& tag, uint8_t const*& data) const {
+        size_t offset = 0;
+        for (size_t i = 0; i < arg_count; ++i) {
+            tag = type_tags[i];
+            size_t size = 0;
+            if (tag == 'i' || tag == 'f' || tag == 'c' || tag == 'r' || tag == 'm') {
+                size = 4;
+            } else if (tag == 'T' || tag == 'F' || tag == 'N' || tag == 'I' || tag == '[' ||
+                       tag == ']') {
+                size = 0;
+            } else if (tag == 's' || tag == 'S') {
+                size_t length = 0;
+                while (offset + length < args_size && args[offset + length] != 0) {
+                    ++length;
+                }
+                size = padded(length + 1);
+            } else if (tag == 'b') {
+                if (offset + 4 > args_size) {
+                    return false;
+                }
+                size = 4 + padded(osc_read_be32(args + offset));
+            } else if (tag == 'h' || tag == 'd' || tag == 't') {
+                size = 8;
+            } else {
+                return false;  // unknown size: every later offset would be a guess
+            }
+            if (i == index) {
+                data = args + offset;
+                return offset + size <= args_size;
+            }
+            offset += size;
+        }
+        return false;
+    }
+
+    static uint64_t read_be64(uint8_t const* data) {
+        return (static_cast<uint64_t>(osc_read_be32(data)) << 32) | osc_read_be32(data + 4);
+    }
+
+    static double read_double(uint8_t const* data) {
+        uint64_t const bits = read_be64(data);
+        double value = 0.0;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+/**
+ * @brief Parse one OSC message in place
+ *
+ * @return false if the data is not a well-formed message
+ */
+inline bool parse_osc_message(uint8_t const* data, size_t size, osc_message_view& message) {
+    if (size < 4 || data[0] != '/' || size % 4 != 0) {
+        return false;
+    }
+    char const* text = reinterpret_cast<char const*>(data);
+    size_t length = 0;
+    while (length < size && text[length] != 0) {
+        ++length;
+    }
+    size_t const tags_at = osc_message_view::padded(length + 1);
+    if (length == size || tags_at >= size || text[tags_at] != ',') {
+        return false;
+    }
+    size_t tag_count = 0;
+    while (tags_at + 1 + tag_count < size && text[tags_at + 1 + tag_count] != 0) {
+        ++tag_count;
+    }
+    size_t const args_at = tags_at + osc_message_view::padded(tag_count + 2);
+    if (tags_at + 1 + tag_count == size || args_at > size) {
+        return false;
+    }
+    message.address = text;
+    message.address_length = length;
+    message.type_tags = text + tags_at + 1;
+    message.arg_count = tag_count;
+    message.args = data + args_at;
+    message.args_size = size - args_at;
+    return true;
+}
+
+/**
+ * @brief Visit every message in an OSC packet (a message or nested bundles)
+ *
+ * @param handler Called as handler(osc_message_view const&)
+ * @return false if any part of the packet is malformed (earlier messages were visited)
+ */
+template<typename handler_t>
+bool for_each_osc_message(uint8_t const* data, size_t size, handler_t& handler, int depth = 0) {
+    static char const BUNDLE[8] = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0};
+    if (size >= 16 && std::memcmp(data, BUNDLE, 8) == 0) {
+        if (depth >= 4) {
+            return false;
+        }
+        size_t offset = 16;  // tag + 64-bit time tag (executed immediately)
+        while (offset + 4 <= size) {
+            size_t const element = osc_read_be32(data + offset);
+            offset += 4;
+            if (element > size - offset ||
+                !for_each_osc_message(data + offset, element, handler, depth + 1)) {
+                return false;
+            }
+            offset += element;
+        }
+        return offset == size;
+    }
+    osc_message_view message;
+    if (!parse_osc_message(data, size, message)) {
+        return false;
+    }
+    handler(message);
+    return true;
+}
+
+/// One OSC address and the command it produces
+struct osc_route {
+    char const* address;
+    show_command_type type;
+    uint32_t controller_id;
+};
+
+/**
+ * @brief Exact-match OSC address lookup, built once at setup
+ *
+ * Addresses are copied into one arena; lookups hash the address in the
+ * receive buffer (FNV-1a) and probe linearly, with no allocation.
+ */
+struct osc_address_table {
+   public:
+    explicit osc_address_table(std::vector<osc_route> const& routes) {
+        size_t capacity = 16;
+        while (capacity < routes.size() * 2) {
+            capacity <<= 1;
+        }
+        slots_.assign(capacity, slot());
+        mask_ = capacity - 1;
+        for (size_t i = 0; i < routes.size(); ++i) {
+            size_t const length = std::strlen(routes[i].address);
+            uint32_t const hash = fnv1a(routes[i].address, length);
+            size_t index = hash & mask_;
+            while (slots_[index].used && !matches(slots_[index], routes[i].address, length)) {
+                index = (index + 1) & mask_;
+            }
+            slot& entry = slots_[index];
+            if (!entry.used) {
+                entry.offset = static_cast<uint32_t>(arena_.size());
+                entry.length = static_cast<uint32_t>(length);
+                arena_.insert(arena_.end(), routes[i].address, routes[i].address + length);
+            }
+            entry.used = true;
+            entry.hash = hash;
+            entry.type = routes[i].type;
+            entry.controller_id = routes[i].controller_id;
+        }
+    }
+
+    /**
+     * @brief Resolve an address (not necessarily terminated)
+     *
+     * @return false if the address is not routed
+     */
+    bool lookup(char const* address, size_t length, show_command_type& type,
+                uint32_t& controller_id) const {
+        uint32_t const hash = fnv1a(address, length);
+        for (size_t index = hash & mask_; slots_[index].used; index = (index + 1) & mask_) {
+            slot const& entry = slots_[index];
+            if (entry.hash == hash && matches(entry, address, length)) {
+                type = entry.type;
+                controller_id = entry.controller_id;
+                return true;
+            }
+        }
+        return false;
+    }
+
+   private:
+    struct slot {
+        bool used = false;
+        uint32_t hash = 0;
+        uint32_t offset = 0;
+        uint32_t length = 0;
+        show_command_type type = show_command_type::trigger;
+        uint32_t controller_id = 0;
+    };
+
+    static uint32_t fnv1a(char const* text, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(text[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    bool matches(slot const& entry, char const* address, size_t length) const {
+        return entry.length == length &&
+               std::memcmp(arena_.data() + entry.offset, address, length) == 0;
+    }
+
+    std::vector<slot> slots_;
+    std::vector<char> arena_;
+    size_t mask_;
+};
+
+/**
+ * @brief MIDI (channel, note) to controller id map for note-on triggers
+ */
+struct midi_note_map {
+   public:
+    static constexpr uint32_t UNMAPPED = UINT32_MAX;
+
+    midi_note_map() : ids_(16 * 128, static_cast<uint32_t>(UNMAPPED)) {}
+
+    /// channel 0-15, note 0-127
+    void map(uint8_t channel, uint8_t note, uint32_t controller_id) {
+        ids_[(channel & 0x0F) * 128 + (note & 0x7F)] = controller_id;
+    }
+
+    uint32_t lookup(uint8_t channel, uint8_t note) const {
+        return ids_[(channel & 0x0F) * 128 + (note & 0x7F)];
+    }
+
+   private:
+    std::vector<uint32_t> ids_;
+};
+
+/// Data bytes after a system status byte (0xF1-0xFF; SysEx is handled by the caller)
+inline size_t system_data_bytes(uint8_t status) {
+    switch (status) {
+        case 0xF1:  // MTC quarter frame
+        case 0xF3:  // song select
+            return 1;
+        case 0xF2:  // song position pointer
+            return 2;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Visit note-on events in an RTP-MIDI (RFC 6295) payload
+ *
+ * Parses the RTP header (skipping CSRCs and any header extension, stripping
+ * padding) and the MIDI command section in place, including delta times and
+ * running status. The recovery journal is ignored (UDP loss
+ * just loses the trigger). SysEx aborts the walk.
+ *
+ * @param handler Called as handler(channel, note, velocity) for note-ons with velocity > 0
+ * @return false if the packet is malformed
+ */
+template<typename handler_t>
+bool for_each_rtp_midi_note_on(uint8_t const* data, size_t size, handler_t& handler) {
+    if (size < 13 || (data[0] >> 6) != 2) {
+        return false;
+    }
+    if (data[0] & 0x20) {  // P: the last byte counts padding bytes to strip
+        size_t const padding = data[size - 1];
+        if (padding == 0 || padding > size - 12) {
+            return false;
+        }
+        size -= padding;
+    }
+    size_t offset = 12 + 4 * static_cast<size_t>(data[0] & 0x0F);  // CSRC list
+    if (data[0] & 0x10) {  // X: u16 profile | u16 length in words | extension
+        if (offset + 4 > size) {
+            return false;
+        }
+        offset += 4 + 4 * ((static_cast<size_t>(data[offset + 2]) << 8) | data[offset + 3]);
+    }
+    if (offset >= size) {
+        return false;
+    }
+    uint8_t const flags = data[offset++];
+    size_t length = flags & 0x0F;
+    if (flags & 0x80) {  // B: 12-bit length
+        if (offset >= size) {
+            return false;
+        }
+        length = (length << 8) | data[offset++];
+    }
+    if (length > size - offset) {
+        return false;
+    }
+    size_t const end = offset + length;
+    bool has_delta = (flags & 0x20) != 0;  // Z: first command has a delta time
+    uint8_t status = 0;
+    while (offset < end) {
+        if (has_delta) {
+            int bytes = 0;
+            while (offset < end && (data[offset] & 0x80) && bytes < 3) {
+                ++offset;
+                ++bytes;
+            }
+            ++offset;
+        }
+        has_delta = true;
+        if (offset >= end) {
+            return offset == end;
+        }
+        uint8_t command = status;
+        if (data[offset] & 0x80) {
+            command = data[offset++];
+        }
+        if (command == 0 || command == 0xF0) {
+            return false;
+        }
+        size_t data_bytes = 2;
+        switch (command & 0xF0) {
+            case 0xC0:
+            case 0xD0:
+                data_bytes = 1;
+                break;
+            case 0xF0:
+                data_bytes = system_data_bytes(command);
+                break;
+        }
+        // Channel messages set running status, system common clears it,
+        // real-time leaves it alone
+        if (command < 0xF0) {
+            status = command;
+        } else if (command < 0xF8) {
+            status = 0;
+        }
+        if (data_bytes > end - offset) {
+            return false;
+        }
+        if ((command & 0xF0) == 0x90 && data[offset + 1] > 0) {
+            handler(static_cast<uint8_t>(command & 0x0F), data[offset], data[offset + 1]);
+        }
+        offset += data_bytes;
+    }
+    return true;
+}
+
+/// Command plus the monotonic time its datagram was received
+struct timed_show_command {
+    show_command command;
+    uint64_t received_ns;
+};
+
+enum class control_protocol : uint8_t { osc, rtp_midi };
+
+/**
+ * @brief UDP receiver feeding show commands into an SPSC queue
+ *
+ * Run poll() on a dedicated thread; the control loop pops the queue.
+ */
+struct udp_control_input {
+   public:
+    static constexpr size_t MAX_DATAGRAM = 65536;
+
+    /**
+     * @param protocol Wire format expected on this socket
+     * @param osc_routes Address table (used for OSC)
+     * @param notes Note map (used for RTP-MIDI, may be nullptr for OSC)
+     * @param queue Destination for parsed commands
+     */
+    udp_control_input(control_protocol protocol, osc_address_table const* osc_routes,
+                      midi_note_map const* notes, spsc_queue<timed_show_command>& queue)
+        : protocol_(protocol),
+          osc_routes_(osc_routes),
+          notes_(notes),
+          queue_(queue),
+          buffer_(MAX_DATAGRAM),
+          fd_(-1),
+          packets_(0),
+          commands_(0),
+          malformed_(0),
+          unrouted_(0),
+          dropped_(0) {}
+
+    ~udp_control_input() { close(); }
+
+    udp_control_input(udp_control_input const&) = delete;
+    udp_control_input& operator=(udp_control_input const&) = delete;
+
+    /**
+     * @brief Bind the UDP socket
+     *
+     * @param port Port to bind, 0 for ephemeral (see port())
+     * @param loopback_only Bind 127.0.0.1 instead of all interfaces
+     */
+    bool open(uint16_t port, bool loopback_only = true) {
+        close();
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) {
+            return false;
+        }
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+        if (::bind(fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    uint16_t port() const {
+        sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (fd_ < 0 || ::getsockname(fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            return 0;
+        }
+        return ntohs(addr.sin_port);
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    /**
+     * @brief Wait up to timeout_ms for datagrams and process all that are pending
+     *
+     * @return Number of commands queued
+     */
+    size_t poll(int timeout_ms) {
+        pollfd pfd = {fd_, POLLIN, 0};
+        if (fd_ < 0 || ::poll(&pfd, 1, timeout_ms) <= 0) {
+            return 0;
+        }
+        size_t queued = 0;
+        for (;;) {
+            ssize_t const n = ::recv(fd_, buffer_.data(), buffer_.size(), MSG_DONTWAIT);
+            if (n < 0) {
+                break;
+            }
+            queued += process(buffer_.data(), static_cast<size_t>(n));
+        }
+        return queued;
+    }
+
+    /**
+     * @brief Parse one datagram and queue its commands (exposed for tests)
+     *
+     * @return Number of commands queued
+     */
+    size_t process(uint8_t const* data, size_t size) {
+        packets_.fetch_add(1, std::memory_order_relaxed);
+        received_ns_ = monotonic_ns();
+        queued_in_packet_ = 0;
+        bool ok = false;
+        if (protocol_ == control_protocol::osc) {
+            osc_handler handler = {this};
+            ok = for_each_osc_message(data, size, handler);
+        } else {
+            note_handler handler = {this};
+            ok = for_each_rtp_midi_note_on(data, size, handler);
+        }
+        if (!ok) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return queued_in_packet_;
+    }
+
+    uint64_t packets() const { return packets_.load(std::memory_order_relaxed); }
+    uint64_t commands() const { return commands_.load(std::memory_order_relaxed); }
+    uint64_t malformed() const { return malformed_.load(std::memory_order_relaxed); }
+    uint64_t unrouted() const { return unrouted_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+   private:
+    struct osc_handler {
+        udp_control_input* input;
+        void operator()(osc_message_view const& message) { input->on_osc(message); }
+    };
+
+    struct note_handler {
+        udp_control_input* input;
+        void operator()(uint8_t channel, uint8_t note, uint8_t) { input->on_note(channel, note); }
+    };
+
+    // Buttons send 1 on press and 0 on release: only non-zero values fire.
+    // start/seek take the show time (ms) from the first argument (time_arg(), exact for
+    // integers), clamped to uint32; a NaN argument counts as malformed.
+    void on_osc(osc_message_view const& message) {
+        show_command command = {show_command_type::trigger, 0, 0};
+        if (osc_routes_ == nullptr || !osc_routes_->lookup(message.address, message.address_length,
+                                                           command.type, command.controller_id)) {
+            unrouted_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        float value = 0.0f;
+        bool const has_value = message.numeric_arg(0, value);
+        if (has_value && value != value) {
+            malformed_.fetch_add(1, std::memory_order_relaxed);  // NaN
+            return;
+        }
+        if (command.type == show_command_type::start || command.type == show_command_type::seek) {
+            // Read again exactly: the float above rounds show times past 2^24 ms
+            if (!message.time_arg(0, command.show_time_ms)) {
+                command.show_time_ms = 0;
+            }
+        } else if (has_value && value == 0.0f) {
+            return;
+        }
+        enqueue(command);
+    }
+
+    void on_note(uint8_t channel, uint8_t note) {
+        uint32_t const id = notes_ != nullptr ? notes_->lookup(channel, note)
+                                              : midi_note_map::UNMAPPED;
+        if (id == midi_note_map::UNMAPPED) {
+            unrouted_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        show_command const command = {show_command_type::trigger, id, 0};
+        enqueue(command);
+    }
+
+    void enqueue(show_command const& command) {
+        timed_show_command const item = {command, received_ns_};
+        if (queue_.push(item)) {
+            commands_.fetch_add(1, std::memory_order_relaxed);
+            ++queued_in_packet_;
+        } else {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    control_protocol protocol_;
+    osc_address_table const* osc_routes_;
+    midi_note_map const* notes_;
+    spsc_queue<timed_show_command>& queue_;
+    std::vector<uint8_t> buffer_;
+    int fd_;
+    uint64_t received_ns_ = 0;
+    size_t queued_in_packet_ = 0;
+    std::atomic<uint64_t> packets_;
+    std::atomic<uint64_t> commands_;
+    std::atomic<uint64_t> malformed_;
+    std::atomic<uint64_t> unrouted_;
+    std::atomic<uint64_t> dropped_;
+};
@@ -0,0 +1,214 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define PALETTE_FRAME_AVX2 1
+#endif
+
+/**
+ * @brief Palette-indexed framebuffer for large pixel installations
+ *
+ * A frame stores a 4- or 8-bit palette index per pixel instead of 3-4 bytes
+ * of color. Against packed 24-bit RGB each buffered frame (and every copy of
+ * it) is just under 3x smaller in 8-bit mode (the palette costs 1 KB) and
+ * over 5x smaller in 4-bit mode with 1024-pixel segments.
+ * Colors live in palettes of 16 or 256 entries, one per segment of pixels
+ * (or one for the whole frame), and are expanded to RGB only at output
+ * time:
+ *
+ *   palette_frame frame(100000, palette_depth::bits4, 1024);
+ *   frame.set_color(0, 1, 0xFF8000);        // segment 0, entry 1: amber
+ *   frame.set_pixel(17, 1);
+ *   frame.expand_rgb(dmx_bytes);           // 3 bytes per pixel, R G B
+ *
+ * Palette animation changes set_color() entries (or rotates them with
+ * rotate_colors()) and never touches the pixels.
+ *
+ * Design:
+ * - Palette entries are 32-bit 0x00RRGGBB so expansion is a 32-bit gather:
+ *   on CPUs with AVX2 (checked at runtime, since the build targets baseline
+ *   x86-64) eight pixels are one VPGATHERDD plus a shuffle to packed RGB;
+ *   otherwise a scalar loop.
+ * - 4-bit indices are packed two per byte, even pixel in the low nibble.
+ * - Segment length is rounded up to a multiple of 16 pixels, so a SIMD
+ *   block never straddles two palettes.
+ */
+
+enum class palette_depth : uint8_t { bits4 = 4, bits8 = 8 };
+
+struct palette_frame {
+   public:
+    /**
+     * @param pixels Pixel count
+     * @param depth Bits per index (16 or 256 palette entries)
+     * @param segment_pixels Pixels sharing a palette; 0 for one palette per frame
+     */
+    palette_frame(size_t pixels, palette_depth depth, size_t segment_pixels = 0)
+        : pixels_(pixels),
+          depth_(depth),
+          segment_pixels_(segment_length(pixels, segment_pixels)),
+          palette_size_(depth == palette_depth::bits4 ? 16 : 256),
+          indices_(depth == palette_depth::bits4 ? (pixels + 1) / 2 : pixels, 0),
+          palettes_(segments() * palette_size_, 0) {}
+
+    void set_pixel(size_t pixel, uint8_t index) {
+        if (depth_ == palette_depth::bits8) {
+            indices_[pixel] = index;
+            return;
+        }
+        uint8_t& pair = indices_[pixel / 2];
+        pair = pixel % 2 == 0 ? static_cast<uint8_t>((pair & 0xF0) | (index & 0x0F))
+                              : static_cast<uint8_t>((pair & 0x0F) | (index << 4));
+    }
+
+    uint8_t pixel(size_t pixel) const {
+        if (depth_ == palette_depth::bits8) {
+            return indices_[pixel];
+        }
+        return static_cast<uint8_t>((indices_[pixel / 2] >> (pixel % 2 * 4)) & 0x0F);
+    }
+
+    /// Segment holding a pixel (its palette)
+    size_t segment(size_t pixel) const { return pixel / segment_pixels_; }
+
+    /// Set a palette entry to 0xRRGGBB; every pixel using it changes color
+    void set_color(size_t segment, uint8_t index, uint32_t rgb) {
+        palettes_[segment * palette_size_ + index % palette_size_] = rgb & 0xFFFFFF;
+    }
+
+    uint32_t color(size_t segment, uint8_t index) const {
+        return palettes_[segment * palette_size_ + index % palette_size_];
+    }
+
+    /// Color cycling: entries first..first+count-1 move up one, the last wraps to first.
+    /// The range is clamped to the palette; a first entry past its end does nothing.
+    void rotate_colors(size_t segment, uint8_t first, uint8_t count) {
+        if (first >= palette_size_) {
+            return;
+        }
+        count = static_cast<uint8_t>(std::min<size_t>(count, palette_size_ - first));
+        if (count < 2) {
+            return;
+        }
+        uint32_t* const begin = &palettes_[segment * palette_size_ + first];
+        std::rotate(begin, begin + count - 1, begin + count);
+    }
+
+    /// Color of one pixel, 0xRRGGBB
+    uint32_t rgb(size_t pixel) const {
+        return palettes_[segment(pixel) * palette_size_ + this->pixel(pixel)];
+    }
+
+    /**
+     * @brief Expand to packed RGB, gathering with AVX2 when the CPU has it
+     *
+     * @param out pixels() * 3 bytes
+     */
+    void expand_rgb(uint8_t* out) const {
+#if defined(PALETTE_FRAME_AVX2)
+        if (has_avx2()) {
+            expand_rgb_avx2(out);
+            return;
+        }
+#endif
+        expand_rgb_scalar(out);
+    }
+
+    /// Portable expansion (reference for tests and benchmarks)
+    void expand_rgb_scalar(uint8_t* out) const { expand_scalar(0, out); }
+
+    /// True if expand_rgb() takes the gather path on this CPU
+    static bool gather_available() {
+#if defined(PALETTE_FRAME_AVX2)
+        return has_avx2();
+#else
+        return false;
+#endif
+    }
+
+    /// Packed indices for bulk writers and frame copies
+    uint8_t* indices() { return indices_.data(); }
+    uint8_t const* indices() const { return indices_.data(); }
+    size_t index_bytes() const { return indices_.size(); }
+
+    /// Bytes held by the frame: indices plus palettes
+    size_t memory_bytes() const {
+        return indices_.size() + palettes_.size() * sizeof(palettes_[0]);
+    }
+
+    size_t pixels() const { return pixels_; }
+    size_t segments() const { return (pixels_ + segment_pixels_ - 1) / segment_pixels_; }
+    size_t segment_pixels() const { return segment_pixels_; }
+    size_t palette_size() const { return palette_size_; }
+    palette_depth depth() const { return depth_; }
+
+   private:
+    static size_t segment_length(size_t pixels, size_t segment_pixels) {
+        size_t const length = segment_pixels == 0 ? pixels : segment_pixels;
+        return std::max<size_t>((length + 15) / 16 * 16, 16);
+    }
+
+    void expand_scalar(size_t pixel, uint8_t* out) const {
+        for (; pixel < pixels_; ++pixel) {
+            uint32_t const color = rgb(pixel);
+            out[pixel * 3] = static_cast<uint8_t>(color >> 16);
+            out[pixel * 3 + 1] = static_cast<uint8_t>(color >> 8);
+            out[pixel * 3 + 2] = static_cast<uint8_t>(color);
+        }
+    }
+
+#if defined(PALETTE_FRAME_AVX2)
+    static bool has_avx2() {
+        static bool const available = [] {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+        return available;
+    }
+
+    __attribute__((target("avx2"))) void expand_rgb_avx2(uint8_t* out) const {
+        // Per 128-bit lane: four 0x00RRGGBB words -> 12 bytes R G B, 4 spare at the end
+        __m256i const to_rgb = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        __m256i const nibble_shift = _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28);
+        __m256i const nibble = _mm256_set1_epi32(0x0F);
+        // A block stores 28 bytes for its 24, so the last few pixels go through the scalar loop
+        size_t pixel = 0;
+        for (; pixel + 10 <= pixels_; pixel += 8) {
+            int const* const palette =
+                reinterpret_cast<int const*>(&palettes_[segment(pixel) * palette_size_]);
+            __m256i index;
+            if (depth_ == palette_depth::bits8) {
+                index = _mm256_cvtepu8_epi32(
+                    _mm_loadl_epi64(reinterpret_cast<__m128i const*>(&indices_[pixel])));
+            } else {
+                uint32_t packed;
+                std::memcpy(&packed, &indices_[pixel / 2], sizeof(packed));
+                index = _mm256_and_si256(
+                    _mm256_srlv_epi32(_mm256_set1_epi32(static_cast<int>(packed)), nibble_shift),
+                    nibble);
+            }
+            __m256i const rgb = _mm256_shuffle_epi8(_mm256_i32gather_epi32(palette, index, 4),
+                                                    to_rgb);
+            uint8_t* const dest = out + pixel * 3;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm256_castsi256_si128(rgb));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + 12),
+                             _mm256_extracti128_si256(rgb, 1));
+        }
+        expand_scalar(pixel, out);
+    }
+#endif
+
+    size_t pixels_;
+    palette_depth depth_;
+    size_t segment_pixels_;
+    size_t palette_size_;
+    std::vector<uint8_t> indices_;
+    std::vector<uint32_t> palettes_;
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "blink_controller.h"
+
+/**
+ * @brief Compile-time pre-rendered periodic patterns (requires C++14)
+ *
+ * A blink_controller updated once per frame (at t = frame * frame_ms) is a
+ * periodic function of the frame number: an initial off run, then on/off
+ * phases of whole frames. pattern_table renders a set of such channels into
+ * a constexpr bit table, so at runtime a channel's state is one lookup:
+ *
+ *   constexpr blink_timing EYES[] = {{100, 100}, {40, 120}, {20, 20}};
+ *   constexpr uint32_t FRAME_MS = 20;
+ *   constexpr auto TABLE =
+ *       make_pattern_table<pattern_table_frames(EYES, FRAME_MS)>(EYES, FRAME_MS);
+ *   static_assert(pattern_table_matches_controllers(TABLE, EYES, FRAME_MS), "");
+ *   pin.set(TABLE.state(channel, frame));
+ *
+ * Layout: frame-major, 64 channels per word, so one frame's states for all
+ * channels are WORDS consecutive words (frame_bits()).
+ *
+ * Rendering uses the closed-form phase math; pattern_table_matches_controllers()
+ * runs the real blink_controller at compile time for the table's frames plus
+ * one more period, so a static_assert proves the two agree.
+ */
+
+/// Frames in one phase of duration_ms when updated every frame_ms (at least one)
+constexpr uint32_t pattern_phase_frames(uint32_t duration_ms, uint32_t frame_ms) {
+    return duration_ms == 0 ? 1 : (duration_ms + frame_ms - 1) / frame_ms;
+}
+
+/// Frames before the first ON edge (a zero off time turns on at frame 0)
+constexpr uint32_t pattern_prefix_frames(blink_timing const& timing, uint32_t frame_ms) {
+    return (timing.off_ms + frame_ms - 1) / frame_ms;
+}
+
+constexpr uint32_t pattern_period_frames(blink_timing const& timing, uint32_t frame_ms) {
+    return pattern_phase_frames(timing.on_ms, frame_ms) +
+           pattern_phase_frames(timing.off_ms, frame_ms);
+}
+
+constexpr uint64_t pattern_gcd(uint64_t a, uint64_t b) {
+    return b == 0 ? a : pattern_gcd(b, a % b);
+}
+
+/// Common prefix of all channels (the longest)
+template<size_t CHANNELS>
+constexpr uint32_t pattern_common_prefix(blink_timing const (&timings)[CHANNELS],
+                                         uint32_t frame_ms) {
+    uint32_t prefix = 0;
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        uint32_t const channel = pattern_prefix_frames(timings[i], frame_ms);
+        prefix = channel > prefix ? channel : prefix;
+    }
+    return prefix;
+}
+
+/// Common period of all channels (least common multiple)
+template<size_t CHANNELS>
+constexpr uint64_t pattern_common_period(blink_timing const (&timings)[CHANNELS],
+                                         uint32_t frame_ms) {
+    uint64_t period = 1;
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        uint64_t const channel = pattern_period_frames(timings[i], frame_ms);
+        period = period / pattern_gcd(period, channel) * channel;
+    }
+    return period;
+}
+
+/**
+ * @brief Frames a table needs for these channels: common prefix + common period
+ */
+template<size_t CHANNELS>
+constexpr size_t pattern_table_frames(blink_timing const (&timings)[CHANNELS], uint32_t frame_ms) {
+    return static_cast<size_t>(pattern_common_prefix(timings, frame_ms) +
+                               pattern_common_period(timings, frame_ms));
+}
+
+/**
+ * @brief One bit per frame per channel for frames [0, prefix + period)
+ *
+ * @tparam CHANNELS Number of channels
+ * @tparam FRAMES Rendered frames (pattern_table_frames())
+ */
+template<size_t CHANNELS, size_t FRAMES>
+struct pattern_table {
+   public:
+    static constexpr size_t WORDS = (CHANNELS + 63) / 64;
+
+    constexpr pattern_table(blink_timing const (&timings)[CHANNELS], uint32_t frame_ms)
+        : prefix_(pattern_common_prefix(timings, frame_ms)),
+          period_(static_cast<uint32_t>(pattern_common_period(timings, frame_ms))) {
+        for (size_t channel = 0; channel < CHANNELS; ++channel) {
+            uint32_t const start = pattern_prefix_frames(timings[channel], frame_ms);
+            uint32_t const on = pattern_phase_frames(timings[channel].on_ms, frame_ms);
+            uint32_t const period = pattern_period_frames(timings[channel], frame_ms);
+            for (size_t frame = start; frame < FRAMES; ++frame) {
+                if ((frame - start) % period < on) {
+                    bits_[frame][channel / 64] |= uint64_t(1) << (channel % 64);
+                }
+            }
+        }
+    }
+
+    /// Row of the table that holds frame's states
+    constexpr size_t row(uint64_t frame) const {
+        return static_cast<size_t>(frame < prefix_ ? frame : prefix_ + (frame - prefix_) % period_);
+    }
+
+    /// State of channel at frame (any frame number, the table repeats)
+    constexpr bool state(size_t channel, uint64_t frame) const {
+        return ((bits_[row(frame)][channel / 64] >> (channel % 64)) & 1) != 0;
+    }
+
+    /// All channels' states at frame: WORDS words, channel c at bit c % 64 of word c / 64
+    constexpr uint64_t const* frame_bits(uint64_t frame) const { return bits_[row(frame)]; }
+
+    constexpr uint32_t prefix() const { return prefix_; }
+    constexpr uint32_t period() const { return period_; }
+    static constexpr size_t channels() { return CHANNELS; }
+    static constexpr size_t frames() { return FRAMES; }
+
+   private:
+    uint32_t prefix_;
+    uint32_t period_;
+    uint64_t bits_[FRAMES][WORDS] = {};
+};
+
+/**
+ * @brief Render timings into a pattern table
+ *
+ * @tparam FRAMES pattern_table_frames(timings, frame_ms)
+ */
+template<size_t FRAMES, size_t CHANNELS>
+constexpr pattern_table<CHANNELS, FRAMES> make_pattern_table(
+    blink_timing const (&timings)[CHANNELS], uint32_t frame_ms) {
+    return pattern_table<CHANNELS, FRAMES>(timings, frame_ms);
+}
+
+/// Output pin usable in constant expressions
+struct pattern_probe_pin {
+    bool state = false;
+    constexpr void set(bool value) { state = value; }
+};
+
+/**
+ * @brief Check a table against blink_controller, frame by frame
+ *
+ * Runs one controller per channel (updated at frame * frame_ms) over the
+ * table's frames plus another full period, which also checks the wrap from
+ * the last row back to the start of the period. Usable in static_assert.
+ */
+template<size_t CHANNELS, size_t FRAMES>
+constexpr bool pattern_table_matches_controllers(pattern_table<CHANNELS, FRAMES> const& table,
+                                                 blink_timing const (&timings)[CHANNELS],
+                                                 uint32_t frame_ms) {
+    if (FRAMES != pattern_table_frames(timings, frame_ms)) {
+        return false;
+    }
+    for (size_t channel = 0; channel < CHANNELS; ++channel) {
+        pattern_probe_pin pin;
+        blink_controller<pattern_probe_pin> controller(pin, timings[channel].on_ms,
+                                                       timings[channel].off_ms);
+        for (uint64_t frame = 0; frame < FRAMES + table.period(); ++frame) {
+            controller.update(static_cast<uint32_t>(frame * frame_ms));
+            if (pin.state != table.state(channel, frame)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
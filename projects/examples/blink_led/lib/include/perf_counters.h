@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * @brief Hardware performance counters for benchmarks (Linux perf_event_open)
+ *
+ * Wall-clock time alone does not say whether a layout change helped the
+ * cache or the branch predictor. perf_counters counts the calling thread's
+ * user-space cycles, instructions, cache misses and branch misses (plus the
+ * software task clock) between start() and stop():
+ *
+ *   perf_counters counters;
+ *   counters.start();
+ *   for (...) bank.update(now);
+ *   perf_counter_values const v = counters.stop();
+ *   if (v.has(perf_counter::cache_misses)) ... v.per(perf_counter::cache_misses, updates)
+ *
+ * Each counter is opened on its own, so a kernel, VM or container that
+ * lacks some of them (or forbids perf_event_open altogether) just reports
+ * those as missing; benchmarks print "n/a" instead of failing. Counts are
+ * scaled by enabled / running time when the kernel multiplexes counters.
+ */
+
+enum class perf_counter : uint8_t {
+    cycles = 0,
+    instructions = 1,
+    cache_misses = 2,
+    branch_misses = 3,
+    task_clock_ns = 4,
+};
+
+constexpr size_t PERF_COUNTER_KINDS = 5;
+
+/// Counts from one start() / stop() interval
+struct perf_counter_values {
+    uint64_t counts[PERF_COUNTER_KINDS];
+    bool valid[PERF_COUNTER_KINDS];
+
+    bool has(perf_counter kind) const { return valid[static_cast<size_t>(kind)]; }
+    uint64_t get(perf_counter kind) const { return counts[static_cast<size_t>(kind)]; }
+
+    /// Count per iteration (0 if the counter is missing)
+    double per(perf_counter kind, uint64_t iterations) const {
+        return has(kind) && iterations != 0
+                   ? static_cast<double>(get(kind)) / static_cast<double>(iterations)
+                   : 0.0;
+    }
+};
+
+struct perf_counters {
+   public:
+    perf_counters() {
+        uint32_t const types[PERF_COUNTER_KINDS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                    PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                    PERF_TYPE_SOFTWARE};
+        uint64_t const configs[PERF_COUNTER_KINDS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_TASK_CLOCK};
+        for (size_t i = 0; i < PERF_COUNTER_KINDS; ++i) {
+            struct perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = types[i];
+            attr.config = configs[i];
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds_[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+    }
+
+    ~perf_counters() {
+        for (size_t i = 0; i < PERF_COUNTER_KINDS; ++i) {
+            if (fds_[i] >= 0) {
+                close(fds_[i]);
+            }
+        }
+    }
+
+    perf_counters(perf_counters const&) = delete;
+    perf_counters& operator=(perf_counters const&) = delete;
+
+    /// True if the counter could be opened on this machine
+    bool has(perf_counter kind) const { return fds_[static_cast<size_t>(kind)] >= 0; }
+
+    /// True if any hardware counter (cycles .. branch misses) is available
+    bool hardware_available() const {
+        return has(perf_counter::cycles) || has(perf_counter::instructions) ||
+               has(perf_counter::cache_misses) || has(perf_counter::branch_misses);
+    }
+
+    /// Reset and enable every open counter
+    void start() {
+        for (size_t i = 0; i < PERF_COUNTER_KINDS; ++i) {
+            if (fds_[i] >= 0) {
+                ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    /// Disable the counters and read them
+    perf_counter_values stop() {
+        perf_counter_values values;
+        for (size_t i = 0; i < PERF_COUNTER_KINDS; ++i) {
+            values.counts[i] = 0;
+            values.valid[i] = false;
+            if (fds_[i] < 0) {
+                continue;
+            }
+            ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+            uint64_t data[3] = {0, 0, 0};  // value, time enabled, time running
+            if (read(fds_[i], data, sizeof(data)) != static_cast<ssize_t>(sizeof(data)) ||
+                data[2] == 0) {
+                continue;
+            }
+            values.counts[i] = data[2] == data[1]
+                                   ? data[0]
+                                   : static_cast<uint64_t>(static_cast<double>(data[0]) *
+                                                           static_cast<double>(data[1]) /
+                                                           static_cast<double>(data[2]));
+            values.valid[i] = true;
+        }
+        return values;
+    }
+
+   private:
+    int fds_[PERF_COUNTER_KINDS];
+};
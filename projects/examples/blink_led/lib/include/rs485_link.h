@@ -0,0 +1,600 @@
+#pragma once
+#include <poll.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief RS-485 multi-drop link from the master to slave boards, sending only changed outputs
+ *
+ * Props on a shared half-duplex bus get their outputs as one bitmap per
+ * slave. The master sends each slave a CRC-protected frame with the outputs
+ * that changed since the slave last acknowledged (run-length coded), the
+ * slave applies it and answers with an ACK, and the next slave is polled:
+ *
+ *   rs485_master master(uart_fd, 250000);
+ *   size_t porch = 0;
+ *   master.add_slave(0x10, 64, porch);
+ *   ...
+ *   bank.update(now);
+ *   master.set_outputs(porch, bank.states(), 64);   // or set_output(porch, i, on)
+ *   master.cycle(15000);                            // <= 15 ms of bus time this frame
+ *
+ *   slave board, per received byte:
+ *   size_t const n = slave.receive(byte, reply);    // then transmit reply[0..n)
+ *
+ * Wire format (CRC-16/MODBUS low byte first over address..payload):
+ *
+ *   0x7E | address | type | sequence | length | payload[length] | crc16
+ *
+ * After the flag, 0x7E and 0x7D are sent as 0x7D, byte ^ 0x20 (HDLC style).
+ *
+ * - keyframe: payload is the whole bitmap (output i is bit i % 8 of byte i / 8)
+ * - delta: payload is the base sequence, then (unchanged, changed) run lengths
+ *   as LEB128 varints; the changed outputs flip relative to the base state
+ * - ack / nak: empty payload, sequence of the frame answered
+ *
+ * Design:
+ * - Deltas are against the last state the master saw acknowledged, so a lost
+ *   ACK costs nothing: the slave keeps its last RS485_HISTORY applied states
+ *   and answers NAK (the master falls back to a keyframe) only when the base
+ *   is gone. A delta longer than the bitmap is sent as a keyframe instead.
+ * - The flag never occurs inside a frame and the parser restarts at every
+ *   flag, so a corrupted byte (even in the length) drops one frame, never
+ *   the next one or the link.
+ * - cycle() visits slaves round-robin from where the previous cycle stopped,
+ *   skipping those already in sync, and stops before a frame (plus its ACK
+ *   and two bus turnarounds) would exceed the bus-time budget, so a busy
+ *   frame defers the remaining slaves instead of stretching the frame.
+ */
+
+constexpr uint8_t RS485_FLAG = 0x7E;
+constexpr uint8_t RS485_ESCAPE = 0x7D;
+constexpr size_t RS485_HEADER_BYTES = 5;  // flag, address, type, sequence, length
+constexpr size_t RS485_CRC_BYTES = 2;
+constexpr size_t RS485_MAX_PAYLOAD = 255;
+
+/// Unescaped frame after the flag
+constexpr size_t RS485_MAX_BODY = RS485_HEADER_BYTES - 1 + RS485_MAX_PAYLOAD + RS485_CRC_BYTES;
+
+/// Encoded size limits (every byte after the flag may need escaping)
+constexpr size_t RS485_MAX_WIRE = 1 + 2 * RS485_MAX_BODY;
+constexpr size_t RS485_MAX_REPLY = 1 + 2 * (RS485_HEADER_BYTES - 1 + RS485_CRC_BYTES);
+
+/// Outputs per slave (a keyframe bitmap fits one frame)
+constexpr size_t RS485_MAX_OUTPUTS = 1024;
+
+/// Applied states a slave keeps as delta bases
+constexpr size_t RS485_HISTORY = 4;
+
+enum class rs485_type : uint8_t { keyframe = 1, delta = 2, ack = 3, nak = 4 };
+
+/// CRC-16/MODBUS lookup table (reflected polynomial 0xA001)
+struct rs485_crc_table {
+    rs485_crc_table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint16_t crc = static_cast<uint16_t>(i);
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) != 0 ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+
+    uint16_t entries[256];
+};
+
+inline uint16_t rs485_crc16(uint8_t const* data, size_t size) {
+    static rs485_crc_table const table;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = static_cast<uint16_t>((crc >> 8) ^ table.entries[(crc ^ data[i]) & 0xFF]);
+    }
+    return crc;
+}
+
+struct rs485_frame {
+    uint8_t address;
+    rs485_type type;
+    uint8_t sequence;
+    uint8_t length;
+    uint8_t payload[RS485_MAX_PAYLOAD];
+};
+
+/**
+ * @brief Serialize a frame
+ *
+ * @param out At least RS485_MAX_WIRE bytes (RS485_MAX_REPLY for an empty payload)
+ * @return Bytes written
+ */
+inline size_t rs485_encode(rs485_frame const& frame, uint8_t* out) {
+    uint8_t body[RS485_MAX_BODY];
+    body[0] = frame.address;
+    body[1] = static_cast<uint8_t>(frame.type);
+    body[2] = frame.sequence;
+    body[3] = frame.length;
+    std::memcpy(body + RS485_HEADER_BYTES - 1, frame.payload, frame.length);
+    size_t const size = RS485_HEADER_BYTES - 1 + frame.length;
+    uint16_t const crc = rs485_crc16(body, size);
+    body[size] = static_cast<uint8_t>(crc);
+    body[size + 1] = static_cast<uint8_t>(crc >> 8);
+
+    size_t written = 0;
+    out[written++] = RS485_FLAG;
+    for (size_t i = 0; i < size + RS485_CRC_BYTES; ++i) {
+        if (body[i] == RS485_FLAG || body[i] == RS485_ESCAPE) {
+            out[written++] = RS485_ESCAPE;
+            out[written++] = static_cast<uint8_t>(body[i] ^ 0x20);
+        } else {
+            out[written++] = body[i];
+        }
+    }
+    return written;
+}
+
+/**
+ * @brief Byte-at-a-time frame parser (suits a UART receive interrupt)
+ */
+struct rs485_parser {
+   public:
+    rs485_parser() : size_(0), in_frame_(false), escaped_(false), crc_errors_(0) {}
+
+    /**
+     * @brief Add one received byte
+     *
+     * Bytes outside a frame are ignored; a flag inside one restarts it.
+     *
+     * @return true if it completed a valid frame (copied into frame)
+     */
+    bool push(uint8_t byte, rs485_frame& frame) {
+        if (byte == RS485_FLAG) {
+            crc_errors_ += in_frame_ && size_ > 0 ? 1 : 0;  // cut short
+            in_frame_ = true;
+            escaped_ = false;
+            size_ = 0;
+            return false;
+        }
+        if (!in_frame_) {
+            return false;
+        }
+        if (byte == RS485_ESCAPE) {
+            escaped_ = true;
+            return false;
+        }
+        buffer_[size_++] = escaped_ ? static_cast<uint8_t>(byte ^ 0x20) : byte;
+        escaped_ = false;
+        if (size_ < RS485_HEADER_BYTES - 1 ||
+            size_ < RS485_HEADER_BYTES - 1 + buffer_[3] + RS485_CRC_BYTES) {
+            return false;
+        }
+        in_frame_ = false;
+        size_t const body = size_ - RS485_CRC_BYTES;
+        if (rs485_crc16(buffer_, body) !=
+            static_cast<uint16_t>(buffer_[body] | (buffer_[body + 1] << 8))) {
+            ++crc_errors_;
+            return false;
+        }
+        frame.address = buffer_[0];
+        frame.type = static_cast<rs485_type>(buffer_[1]);
+        frame.sequence = buffer_[2];
+        frame.length = buffer_[3];
+        std::memcpy(frame.payload, buffer_ + RS485_HEADER_BYTES - 1, frame.length);
+        return true;
+    }
+
+    uint32_t crc_errors() const { return crc_errors_; }
+
+   private:
+    uint8_t buffer_[RS485_MAX_BODY];
+    size_t size_;
+    bool in_frame_;
+    bool escaped_;
+    uint32_t crc_errors_;
+};
+
+inline size_t rs485_bitmap_bytes(size_t outputs) { return (outputs + 7) / 8; }
+
+/**
+ * @brief Run-length code the outputs that differ between two bitmaps
+ *
+ * @return Bytes written, or 0 if the runs would need more than limit bytes
+ */
+inline size_t rs485_encode_delta(uint8_t const* base, uint8_t const* current, size_t outputs,
+                                 uint8_t* out, size_t limit) {
+    size_t size = 0;
+    size_t run_end = 0;
+    size_t i = 0;
+    while (i < outputs) {
+        if ((i & 7) == 0 && base[i >> 3] == current[i >> 3]) {
+            i += 8;  // unchanged byte
+            continue;
+        }
+        if (((base[i >> 3] ^ current[i >> 3]) >> (i & 7) & 1) == 0) {
+            ++i;
+            continue;
+        }
+        size_t const start = i;
+        while (i < outputs && ((base[i >> 3] ^ current[i >> 3]) >> (i & 7) & 1) != 0) {
+            ++i;
+        }
+        size_t const lengths[2] = {start - run_end, i - start};
+        for (size_t l = 0; l < 2; ++l) {
+            size_t value = lengths[l];
+            do {
+                if (size == limit) {
+                    return 0;
+                }
+                out[size++] = static_cast<uint8_t>((value & 0x7F) | (value > 0x7F ? 0x80 : 0));
+                value >>= 7;
+            } while (value != 0);
+        }
+        run_end = i;
+    }
+    return size;
+}
+
+/**
+ * @brief Flip the runs of a delta in a bitmap
+ *
+ * @return false if the runs are malformed or exceed outputs
+ */
+inline bool rs485_apply_delta(uint8_t const* data, size_t size, uint8_t* bitmap, size_t outputs) {
+    size_t offset = 0;
+    size_t position = 0;
+    while (offset < size) {
+        size_t lengths[2] = {0, 0};
+        for (size_t l = 0; l < 2; ++l) {
+            for (int shift = 0;; shift += 7) {
+                if (offset == size || shift > 14) {
+                    return false;
+                }
+                uint8_t const byte = data[offset++];
+                lengths[l] |= static_cast<size_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    break;
+                }
+            }
+        }
+        position += lengths[0];
+        if (lengths[1] == 0 || lengths[1] > outputs || position > outputs - lengths[1]) {
+            return false;
+        }
+        for (size_t end = position + lengths[1]; position < end; ++position) {
+            bitmap[position >> 3] ^= static_cast<uint8_t>(1u << (position & 7));
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Slave board end of the link
+ */
+struct rs485_slave {
+   public:
+    /// outputs up to RS485_MAX_OUTPUTS
+    rs485_slave(uint8_t address, size_t outputs)
+        : address_(address),
+          outputs_(outputs),
+          bytes_(rs485_bitmap_bytes(outputs)),
+          current_(0),
+          applied_(0),
+          naks_(0) {
+        for (size_t i = 0; i < RS485_HISTORY; ++i) {
+            history_[i].valid = false;
+            history_[i].sequence = 0;
+            history_[i].bitmap.assign(bytes_, 0);
+        }
+    }
+
+    /**
+     * @brief Feed one received bus byte
+     *
+     * @param reply At least RS485_MAX_REPLY bytes
+     * @return Bytes of the reply to transmit (0 if none)
+     */
+    size_t receive(uint8_t byte, uint8_t* reply) {
+        rs485_frame frame;
+        if (!parser_.push(byte, frame) || frame.address != address_) {
+            return 0;
+        }
+        rs485_frame answer;
+        answer.address = address_;
+        answer.type = handle(frame) ? rs485_type::ack : rs485_type::nak;
+        answer.sequence = frame.sequence;
+        answer.length = 0;
+        return rs485_encode(answer, reply);
+    }
+
+    bool output(size_t index) const {
+        return (history_[current_].bitmap[index >> 3] >> (index & 7) & 1) != 0;
+    }
+
+    uint8_t const* bitmap() const { return history_[current_].bitmap.data(); }
+    uint32_t applied() const { return applied_; }
+    uint32_t naks() const { return naks_; }
+    uint32_t crc_errors() const { return parser_.crc_errors(); }
+
+   private:
+    struct state {
+        bool valid;
+        uint8_t sequence;
+        std::vector<uint8_t> bitmap;
+    };
+
+    // Apply a keyframe or delta into the oldest history slot
+    bool handle(rs485_frame const& frame) {
+        size_t const next = (current_ + 1) % RS485_HISTORY;
+        state& target = history_[next];
+        if (frame.type == rs485_type::keyframe && frame.length == bytes_) {
+            target.valid = false;
+            std::memcpy(target.bitmap.data(), frame.payload, bytes_);
+        } else if (frame.type == rs485_type::delta && frame.length >= 1) {
+            size_t base = RS485_HISTORY;
+            for (size_t i = 0; i < RS485_HISTORY; ++i) {
+                if (history_[i].valid && history_[i].sequence == frame.payload[0]) {
+                    base = i;
+                }
+            }
+            if (base == RS485_HISTORY) {
+                ++naks_;
+                return false;
+            }
+            target.valid = false;
+            if (base != next) {
+                std::memcpy(target.bitmap.data(), history_[base].bitmap.data(), bytes_);
+            }
+            if (!rs485_apply_delta(frame.payload + 1, frame.length - 1u, target.bitmap.data(),
+                                   outputs_)) {
+                ++naks_;
+                return false;
+            }
+        } else {
+            ++naks_;
+            return false;
+        }
+        for (size_t i = 0; i < RS485_HISTORY; ++i) {
+            history_[i].valid = history_[i].valid && history_[i].sequence != frame.sequence;
+        }
+        target.valid = true;
+        target.sequence = frame.sequence;
+        current_ = next;
+        ++applied_;
+        return true;
+    }
+
+    uint8_t address_;
+    size_t outputs_;
+    size_t bytes_;
+    rs485_parser parser_;
+    state history_[RS485_HISTORY];
+    size_t current_;
+    uint32_t applied_;
+    uint32_t naks_;
+};
+
+struct rs485_master_stats {
+    uint64_t frames = 0;     // frames sent
+    uint64_t keyframes = 0;  // of which keyframes
+    uint64_t bytes = 0;      // both directions
+    uint64_t changes = 0;    // output changes acknowledged by slaves
+    uint64_t acks = 0;
+    uint64_t naks = 0;
+    uint64_t timeouts = 0;  // no valid reply in time (retried next cycle)
+    double bus_us = 0.0;    // modelled bus time of everything sent
+};
+
+/**
+ * @brief Master end of the link
+ */
+struct rs485_master {
+   public:
+    /**
+     * @param fd Bus (UART, pty or socket); replies are awaited with poll()
+     * @param baud Bit rate, 8N1 (10 bit times per byte)
+     * @param turnaround_us Line turnaround each time the direction changes
+     * @param reply_timeout_ms Wait for an ACK before moving on to the next slave
+     */
+    rs485_master(int fd, uint32_t baud, uint32_t turnaround_us = 100, int reply_timeout_ms = 20)
+        : fd_(fd),
+          baud_(baud),
+          turnaround_us_(turnaround_us),
+          reply_timeout_ms_(reply_timeout_ms),
+          cursor_(0) {}
+
+    /**
+     * @brief Add a slave with outputs up to RS485_MAX_OUTPUTS, all off
+     *
+     * Its first frame is a keyframe.
+     *
+     * @param index Set to the slave's index for set_output()
+     * @return false if outputs is over RS485_MAX_OUTPUTS (its bitmap would not fit a frame)
+     */
+    bool add_slave(uint8_t address, size_t outputs, size_t& index) {
+        if (outputs > RS485_MAX_OUTPUTS) {
+            return false;
+        }
+        slave_link slave;
+        slave.address = address;
+        slave.outputs = outputs;
+        slave.current.assign(rs485_bitmap_bytes(outputs), 0);
+        slave.acked = slave.current;
+        slave.acked_sequence = 0;
+        slave.next_sequence = 1;
+        slave.needs_keyframe = true;
+        slaves_.push_back(slave);
+        index = slaves_.size() - 1;
+        return true;
+    }
+
+    void set_output(size_t slave, size_t index, bool on) {
+        uint8_t& byte = slaves_[slave].current[index >> 3];
+        uint8_t const mask = static_cast<uint8_t>(1u << (index & 7));
+        byte = on ? static_cast<uint8_t>(byte | mask) : static_cast<uint8_t>(byte & ~mask);
+    }
+
+    /// Set the first count outputs from nonzero / zero words (blink_bank::states())
+    void set_outputs(size_t slave, uint32_t const* states, size_t count) {
+        std::vector<uint8_t>& bitmap = slaves_[slave].current;
+        for (size_t byte = 0; byte * 8 < count; ++byte) {
+            uint8_t bits = 0;
+            for (size_t bit = 0; bit < 8 && byte * 8 + bit < count; ++bit) {
+                bits |= static_cast<uint8_t>((states[byte * 8 + bit] != 0 ? 1u : 0u) << bit);
+            }
+            bitmap[byte] = bits;
+        }
+    }
+
+    /**
+     * @brief Send pending changes round-robin within a bus-time budget
+     *
+     * The budget must fit the largest keyframe exchange, or that slave
+     * never gets a turn.
+     *
+     * @return Slaves that acknowledged a new state in this cycle
+     */
+    size_t cycle(uint32_t budget_us) {
+        double spent = 0.0;
+        size_t acked = 0;
+        for (size_t visited = 0; visited < slaves_.size(); ++visited) {
+            slave_link& slave = slaves_[cursor_];
+            if (!slave.needs_keyframe && slave.current == slave.acked) {
+                cursor_ = (cursor_ + 1) % slaves_.size();
+                continue;
+            }
+            rs485_frame frame;
+            frame.address = slave.address;
+            frame.sequence = slave.next_sequence;
+            size_t const bytes = slave.current.size();
+            size_t delta = 0;
+            if (!slave.needs_keyframe) {
+                frame.payload[0] = slave.acked_sequence;
+                delta = rs485_encode_delta(slave.acked.data(), slave.current.data(),
+                                           slave.outputs, frame.payload + 1,
+                                           bytes > 1 ? bytes - 1 : 0);
+            }
+            if (delta != 0) {
+                frame.type = rs485_type::delta;
+                frame.length = static_cast<uint8_t>(delta + 1);
+            } else {
+                frame.type = rs485_type::keyframe;
+                frame.length = static_cast<uint8_t>(bytes);
+                std::memcpy(frame.payload, slave.current.data(), bytes);
+            }
+            uint8_t wire[RS485_MAX_WIRE];
+            size_t const size = rs485_encode(frame, wire);
+            double const cost = wire_us(size + RS485_HEADER_BYTES + RS485_CRC_BYTES) +
+                                2.0 * turnaround_us_;
+            if (spent + cost > budget_us) {
+                break;  // this slave goes first next cycle
+            }
+            spent += cost;
+            stats_.frames += 1;
+            stats_.keyframes += frame.type == rs485_type::keyframe ? 1 : 0;
+            stats_.bytes += size;
+            slave.next_sequence = static_cast<uint8_t>(slave.next_sequence + 1);
+
+            rs485_type reply;
+            if (!send(wire, size) || !await_reply(slave.address, frame.sequence, reply)) {
+                stats_.timeouts += 1;
+            } else if (reply == rs485_type::ack) {
+                stats_.bytes += RS485_HEADER_BYTES + RS485_CRC_BYTES;
+                stats_.acks += 1;
+                for (size_t i = 0; i < bytes; ++i) {
+                    stats_.changes += static_cast<uint64_t>(
+                        __builtin_popcount(slave.acked[i] ^ slave.current[i]));
+                }
+                slave.acked = slave.current;
+                slave.acked_sequence = frame.sequence;
+                slave.needs_keyframe = false;
+                ++acked;
+            } else {
+                stats_.bytes += RS485_HEADER_BYTES + RS485_CRC_BYTES;
+                stats_.naks += 1;
+                slave.needs_keyframe = true;
+            }
+            cursor_ = (cursor_ + 1) % slaves_.size();
+        }
+        stats_.bus_us += spent;
+        return acked;
+    }
+
+    /// True if the slave has acknowledged the current outputs
+    bool in_sync(size_t slave) const {
+        return !slaves_[slave].needs_keyframe && slaves_[slave].current == slaves_[slave].acked;
+    }
+
+    /// Time to transmit bytes at the bus rate
+    double wire_us(size_t bytes) const { return bytes * 10.0 * 1e6 / baud_; }
+
+    rs485_master_stats const& stats() const { return stats_; }
+    size_t slaves() const { return slaves_.size(); }
+
+   private:
+    struct slave_link {
+        uint8_t address;
+        size_t outputs;
+        std::vector<uint8_t> current;
+        std::vector<uint8_t> acked;
+        uint8_t acked_sequence;
+        uint8_t next_sequence;
+        bool needs_keyframe;
+    };
+
+    bool send(uint8_t const* data, size_t size) {
+        while (size > 0) {
+            ssize_t const n = ::write(fd_, data, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // Wait for this slave's ACK / NAK of sequence; other frames and noise are skipped
+    bool await_reply(uint8_t address, uint8_t sequence, rs485_type& reply) {
+        auto const deadline =
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(reply_timeout_ms_);
+        for (;;) {
+            auto const left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  deadline - std::chrono::steady_clock::now())
+                                  .count();
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            if (left < 0 || ::poll(&pfd, 1, static_cast<int>(left)) <= 0) {
+                return false;
+            }
+            uint8_t buffer[64];
+            ssize_t const n = ::read(fd_, buffer, sizeof(buffer));
+            if (n <= 0) {
+                return false;
+            }
+            rs485_frame frame;
+            for (ssize_t i = 0; i < n; ++i) {
+                if (parser_.push(buffer[i], frame) && frame.address == address &&
+                    frame.sequence == sequence &&
+                    (frame.type == rs485_type::ack || frame.type == rs485_type::nak)) {
+                    reply = frame.type;
+                    return true;
+                }
+            }
+        }
+    }
+
+    int fd_;
+    uint32_t baud_;
+    uint32_t turnaround_us_;
+    int reply_timeout_ms_;
+    std::vector<slave_link> slaves_;
+    size_t cursor_;
+    rs485_parser parser_;
+    rs485_master_stats stats_;
+};
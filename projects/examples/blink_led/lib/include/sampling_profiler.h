@@ -0,0 +1,334 @@
+#pragma once
+#include <atomic>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <sys/time.h>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Built-in sampling profiler that attributes loop CPU time to phases and groups
+ *
+ * When a frame gets slow on site, the question is which part of the loop is
+ * responsible: flicker banks, pixel encoding, output flushes. The loop marks
+ * what it is doing with profile_scope; a SIGPROF timer samples the marker of
+ * whichever thread is on the CPU, and the samples aggregate into a table
+ * that dumps as folded stacks for flamegraph.pl / speedscope:
+ *
+ *   sampling_profiler profiler;
+ *   uint16_t const flicker = profiler.add_phase("flicker");
+ *   uint16_t const encode = profiler.add_phase("encode");
+ *   profiler.start(997);                       // opt-in, samples per CPU second
+ *   ...
+ *   { profile_scope scope(flicker, bank_id); bank.update(now); }
+ *   { profile_scope scope(encode); encode_pixels(); }
+ *   ...
+ *   profiler.stop();
+ *   profiler.write_folded("loop.folded");      // "loop;flicker/3 57" lines
+ *
+ * Design:
+ * - The marker is a small per-thread stack of (phase, group) written only by
+ *   its own thread. The signal handler runs on that same thread, so signal
+ *   fences are the only ordering needed and scopes cost two plain stores.
+ * - The table is open addressing keyed by a hash of the stack. Slots are
+ *   claimed with a CAS and counts are atomic adds, so handlers on several
+ *   threads never block or allocate. A full table counts dropped samples.
+ * - ITIMER_PROF counts process CPU time, so idle waits are not sampled.
+ *   Only one profiler can be started at a time.
+ */
+
+/// Group id of a scope that is not about one controller group
+constexpr uint32_t PROFILE_NO_GROUP = 0xFFFFFFFF;
+
+/// Deepest scope nesting that is recorded (deeper scopes count as their parent)
+constexpr uint8_t PROFILE_MAX_DEPTH = 8;
+
+/// One level of a sampled stack
+struct profile_frame {
+    uint16_t phase;
+    uint32_t group;
+};
+
+/**
+ * @brief Per-thread record of what the loop is doing
+ *
+ * depth can exceed PROFILE_MAX_DEPTH; only the outer frames are kept.
+ */
+struct profile_marker {
+    uint8_t depth;
+    profile_frame frames[PROFILE_MAX_DEPTH];
+};
+
+/// The calling thread's marker (constant-initialized, safe to read from a signal handler)
+inline profile_marker& profile_thread_marker() {
+    static thread_local profile_marker marker = {0, {}};
+    return marker;
+}
+
+/**
+ * @brief Marks the calling thread as inside a phase (and group) until destroyed
+ */
+struct profile_scope {
+   public:
+    explicit profile_scope(uint16_t phase, uint32_t group = PROFILE_NO_GROUP)
+        : marker_(profile_thread_marker()) {
+        if (marker_.depth < PROFILE_MAX_DEPTH) {
+            marker_.frames[marker_.depth].phase = phase;
+            marker_.frames[marker_.depth].group = group;
+        }
+        std::atomic_signal_fence(std::memory_order_release);
+        ++marker_.depth;
+        std::atomic_signal_fence(std::memory_order_release);
+    }
+
+    ~profile_scope() {
+        std::atomic_signal_fence(std::memory_order_release);
+        --marker_.depth;
+    }
+
+    profile_scope(profile_scope const&) = delete;
+    profile_scope& operator=(profile_scope const&) = delete;
+
+   private:
+    profile_marker& marker_;
+};
+
+struct sampling_profiler {
+   public:
+    /**
+     * @param root First frame of every folded stack (e.g. the program or loop name)
+     * @param capacity Distinct stacks the table can hold (rounded up to a power of two)
+     */
+    explicit sampling_profiler(char const* root = "loop", size_t capacity = 1024)
+        : root_(root), slots_(round_up(capacity)), samples_(0), dropped_(0), running_(false) {}
+
+    ~sampling_profiler() { stop(); }
+
+    sampling_profiler(sampling_profiler const&) = delete;
+    sampling_profiler& operator=(sampling_profiler const&) = delete;
+
+    /**
+     * @brief Register a phase name (must outlive the profiler)
+     *
+     * @return Phase id for profile_scope
+     */
+    uint16_t add_phase(char const* name) {
+        phases_.push_back(name);
+        return static_cast<uint16_t>(phases_.size() - 1);
+    }
+
+    /**
+     * @brief Start sampling: SIGPROF every 1/hz seconds of process CPU time
+     *
+     * @return false if another profiler is running or the timer cannot be set
+     */
+    bool start(uint32_t hz) {
+        sampling_profiler* expected = nullptr;
+        if (running_ || hz == 0 || !active().compare_exchange_strong(expected, this)) {
+            return false;
+        }
+        struct sigaction action = {};
+        action.sa_handler = &sampling_profiler::on_signal;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        if (sigaction(SIGPROF, &action, &previous_action_) != 0) {
+            release();
+            return false;
+        }
+        struct itimerval timer = {};
+        uint32_t const period_us = hz >= 1000000 ? 1 : 1000000 / hz;
+        timer.it_interval.tv_sec = static_cast<time_t>(period_us / 1000000);
+        timer.it_interval.tv_usec = static_cast<suseconds_t>(period_us % 1000000);
+        timer.it_value = timer.it_interval;
+        if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+            sigaction(SIGPROF, &previous_action_, nullptr);
+            release();
+            return false;
+        }
+        running_ = true;
+        return true;
+    }
+
+    /**
+     * @brief Stop sampling and restore the previous SIGPROF handler
+     *
+     * Returns once no handler (on any thread) is still recording into this profiler.
+     */
+    void stop() {
+        if (!running_) {
+            return;
+        }
+        struct itimerval timer = {};
+        setitimer(ITIMER_PROF, &timer, nullptr);
+        sigaction(SIGPROF, &previous_action_, nullptr);
+        release();
+        running_ = false;
+    }
+
+    /**
+     * @brief Add one sample of a thread's marker (what the signal handler does)
+     *
+     * Lock-free and allocation-free; callable from signal handlers and tests.
+     */
+    void record(profile_marker const& marker) {
+        std::atomic_signal_fence(std::memory_order_acquire);
+        uint8_t const depth = marker.depth < PROFILE_MAX_DEPTH ? marker.depth : PROFILE_MAX_DEPTH;
+        uint64_t key = 1469598103934665603ull ^ depth;
+        for (uint8_t i = 0; i < depth; ++i) {
+            key = (key ^ marker.frames[i].phase) * 1099511628211ull;
+            key = (key ^ marker.frames[i].group) * 1099511628211ull;
+        }
+        key |= 1;  // 0 marks an empty slot
+
+        samples_.fetch_add(1, std::memory_order_relaxed);
+        size_t const mask = slots_.size() - 1;
+        for (size_t probe = 0; probe < slots_.size(); ++probe) {
+            slot& entry = slots_[(key + probe) & mask];
+            uint64_t current = entry.key.load(std::memory_order_acquire);
+            if (current == 0) {
+                if (entry.key.compare_exchange_strong(current, key, std::memory_order_acq_rel)) {
+                    entry.depth = depth;
+                    for (uint8_t i = 0; i < depth; ++i) {
+                        entry.frames[i] = marker.frames[i];
+                    }
+                    entry.ready.store(true, std::memory_order_release);
+                    entry.count.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                // Lost the race; current now holds the winner's key
+            }
+            if (current == key) {
+                entry.count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Aggregated samples as folded stacks, one "root;phase/group;... count" per line
+     *
+     * Frames are the phase name, with "/group" when the scope has a group;
+     * samples outside any scope are "root;(untagged)".
+     */
+    std::string folded() const {
+        std::string text;
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slot const& entry = slots_[i];
+            uint64_t const count = entry.count.load(std::memory_order_relaxed);
+            if (!entry.ready.load(std::memory_order_acquire) || count == 0) {
+                continue;
+            }
+            text += root_;
+            if (entry.depth == 0) {
+                text += ";(untagged)";
+            }
+            for (uint8_t level = 0; level < entry.depth; ++level) {
+                profile_frame const& frame = entry.frames[level];
+                text += ';';
+                text += frame.phase < phases_.size() ? phases_[frame.phase] : "(unknown)";
+                if (frame.group != PROFILE_NO_GROUP) {
+                    text += '/';
+                    text += std::to_string(frame.group);
+                }
+            }
+            text += ' ';
+            text += std::to_string(count);
+            text += '\n';
+        }
+        return text;
+    }
+
+    /// Write folded() to a file for flamegraph.pl
+    bool write_folded(char const* path) const {
+        std::FILE* file = std::fopen(path, "w");
+        if (file == nullptr) {
+            return false;
+        }
+        std::string const text = folded();
+        bool const ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    /// Samples of one exact stack, outermost frame first (0 if never seen)
+    uint64_t count(profile_frame const* frames, uint8_t depth) const {
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            slot const& entry = slots_[i];
+            if (!entry.ready.load(std::memory_order_acquire) || entry.depth != depth) {
+                continue;
+            }
+            bool same = true;
+            for (uint8_t level = 0; level < depth && same; ++level) {
+                same = entry.frames[level].phase == frames[level].phase &&
+                       entry.frames[level].group == frames[level].group;
+            }
+            if (same) {
+                return entry.count.load(std::memory_order_relaxed);
+            }
+        }
+        return 0;
+    }
+
+    uint64_t samples() const { return samples_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    bool running() const { return running_; }
+
+   private:
+    struct slot {
+        slot() : key(0), ready(false), count(0), depth(0), frames() {}
+
+        std::atomic<uint64_t> key;
+        std::atomic<bool> ready;
+        std::atomic<uint64_t> count;
+        uint8_t depth;
+        profile_frame frames[PROFILE_MAX_DEPTH];
+    };
+
+    static std::atomic<sampling_profiler*>& active() {
+        static std::atomic<sampling_profiler*> profiler(nullptr);
+        return profiler;
+    }
+
+    /// Handlers between picking up active() and leaving record()
+    static std::atomic<uint32_t>& in_handler() {
+        static std::atomic<uint32_t> count(0);
+        return count;
+    }
+
+    // Counted before active() is read, so release() cannot miss a handler that saw this profiler
+    static void on_signal(int) {
+        in_handler().fetch_add(1);
+        sampling_profiler* const profiler = active().load();
+        if (profiler != nullptr) {
+            profiler->record(profile_thread_marker());
+        }
+        in_handler().fetch_sub(1);
+    }
+
+    /// Unpublish this profiler and wait out handlers already inside record()
+    void release() {
+        active().store(nullptr);
+        while (in_handler().load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    static size_t round_up(size_t capacity) {
+        size_t size = 16;
+        while (size < capacity) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    char const* root_;
+    std::vector<char const*> phases_;
+    std::vector<slot> slots_;
+    std::atomic<uint64_t> samples_;
+    std::atomic<uint64_t> dropped_;
+    bool running_;
+    struct sigaction previous_action_;
+};
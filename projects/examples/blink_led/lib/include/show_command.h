@@ -0,0 +1,120 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Commands that drive a running show
+ *
+ * Shared vocabulary between everything that feeds external control into
+ * controllers (coordinator fan-out, live control surfaces, ...).
+ *
+ * - start:   run the show clock from show_time_ms
+ * - stop:    freeze the show clock and drive all outputs off
+ * - seek:    jump the show clock to show_time_ms
+ * - trigger: restart one controller's blink cycle at the current show time
+ */
+enum class show_command_type : uint8_t { start = 1, stop = 2, seek = 3, trigger = 4 };
+
+/// controller_id value for commands that address every controller
+constexpr uint32_t ALL_CONTROLLERS = UINT32_MAX;
+
+struct show_command {
+    show_command_type type;
+    uint32_t controller_id;
+    uint32_t show_time_ms;
+};
+
+/**
+ * @brief Monotonic clock in nanoseconds (shared by processes on one host)
+ */
+inline uint64_t monotonic_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+/**
+ * @brief Little-endian byte writer for wire messages
+ *
+ * Appends fixed-width integers to a caller-owned buffer. Explicit byte
+ * order keeps messages portable between hosts of different endianness.
+ */
+struct wire_writer {
+   public:
+    explicit wire_writer(std::vector<uint8_t>& buffer) : buffer_(buffer) {}
+
+    void put_u8(uint8_t value) { buffer_.push_back(value); }
+
+    void put_u16(uint16_t value) {
+        put_u8(static_cast<uint8_t>(value));
+        put_u8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void put_u32(uint32_t value) {
+        put_u16(static_cast<uint16_t>(value));
+        put_u16(static_cast<uint16_t>(value >> 16));
+    }
+
+    void put_u64(uint64_t value) {
+        put_u32(static_cast<uint32_t>(value));
+        put_u32(static_cast<uint32_t>(value >> 32));
+    }
+
+   private:
+    std::vector<uint8_t>& buffer_;
+};
+
+/**
+ * @brief Bounds-checked little-endian byte reader for wire messages
+ *
+ * Reads past the end return 0 and latch ok() to false, so a decoder can
+ * read a whole message and check for truncation once at the end.
+ */
+struct wire_reader {
+   public:
+    wire_reader(uint8_t const* data, size_t size) : data_(data), size_(size), pos_(0), ok_(true) {}
+
+    uint8_t get_u8() {
+        if (pos_ >= size_) {
+            ok_ = false;
+            return 0;
+        }
+        return data_[pos_++];
+    }
+
+    uint16_t get_u16() {
+        uint16_t const lo = get_u8();
+        return static_cast<uint16_t>(lo | (get_u8() << 8));
+    }
+
+    uint32_t get_u32() {
+        uint32_t const lo = get_u16();
+        return lo | (static_cast<uint32_t>(get_u16()) << 16);
+    }
+
+    uint64_t get_u64() {
+        uint64_t const lo = get_u32();
+        return lo | (static_cast<uint64_t>(get_u32()) << 32);
+    }
+
+    /// Advance past count bytes (fails like a read if fewer remain)
+    void skip(size_t count) {
+        if (count > size_ - pos_) {
+            ok_ = false;
+            pos_ = size_;
+            return;
+        }
+        pos_ += count;
+    }
+
+    bool ok() const { return ok_; }
+    size_t remaining() const { return size_ - pos_; }
+
+   private:
+    uint8_t const* data_;
+    size_t size_;
+    size_t pos_;
+    bool ok_;
+};
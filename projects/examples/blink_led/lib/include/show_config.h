@@ -0,0 +1,591 @@
+#pragma once
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "blink_controller.h"
+
+/**
+ * @brief Show configuration files with incremental hot reload
+ *
+ * A show is described by one or more text files, one controller per line:
+ *
+ *   # name      on_ms  off_ms
+ *   eyes_left   100    100
+ *   jaw         40     120
+ *
+ * Names identify controllers across edits (they are unique within a file;
+ * blank lines and '#' comments are ignored). While the show runs, a watcher
+ * notices saved files and each changed file is diffed against what is live:
+ *
+ *   show_hot_reload<led_pin> reload(show);
+ *   reload.add_file("props.show", timer.millis());
+ *   for (;;) {
+ *       reload.poll(0, timer.millis());   // between frames
+ *       show.update(timer.millis());
+ *   }
+ *
+ * Design:
+ * - Only the changed file is read, and only the lines between its longest
+ *   unchanged prefix and suffix are parsed, so a one-line edit of a large
+ *   show costs a memcmp of the file plus a few lines of parsing
+ * - Changes are applied between frames: added controllers start their off
+ *   period at that time, retimed ones keep their phase (set_durations()),
+ *   removed ones are driven off; every other controller is untouched
+ * - A file that fails to parse changes nothing; the show keeps running the
+ *   last good version and the error line is reported
+ */
+
+/// One controller line of a show file
+struct show_config_entry {
+    std::string name;
+    blink_timing timing;
+};
+
+/**
+ * @brief Parse show file text
+ *
+ * @param entries Parsed controllers, in file order (appended)
+ * @param error_line 1-based line of the first malformed line (0 if none)
+ * @return false if a line is malformed (entries then holds the lines before it)
+ */
+inline bool parse_show_config(char const* text, size_t size,
+                              std::vector<show_config_entry>& entries, size_t& error_line) {
+    error_line = 0;
+    size_t line = 0;
+    size_t pos = 0;
+    while (pos < size) {
+        ++line;
+        char const* const end_of_line =
+            static_cast<char const*>(std::memchr(text + pos, '\n', size - pos));
+        size_t const end = end_of_line == nullptr ? size : end_of_line - text;
+
+        // Up to three whitespace-separated fields, ignoring comments
+        char const* fields[3] = {nullptr, nullptr, nullptr};
+        size_t lengths[3] = {0, 0, 0};
+        size_t count = 0;
+        size_t i = pos;
+        while (i < end && text[i] != '#') {
+            if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') {
+                ++i;
+                continue;
+            }
+            size_t const start = i;
+            while (i < end && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' &&
+                   text[i] != '#') {
+                ++i;
+            }
+            if (count == 3) {
+                error_line = line;
+                return false;
+            }
+            fields[count] = text + start;
+            lengths[count] = i - start;
+            ++count;
+        }
+        pos = end + 1;
+        if (count == 0) {
+            continue;
+        }
+        if (count != 3) {
+            error_line = line;
+            return false;
+        }
+
+        uint32_t durations[2] = {0, 0};
+        for (size_t f = 0; f < 2; ++f) {
+            uint64_t value = 0;
+            for (size_t c = 0; c < lengths[f + 1]; ++c) {
+                char const digit = fields[f + 1][c];
+                if (digit < '0' || digit > '9' || value > UINT32_MAX / 10) {
+                    error_line = line;
+                    return false;
+                }
+                value = value * 10 + static_cast<uint64_t>(digit - '0');
+            }
+            if (value > UINT32_MAX) {
+                error_line = line;
+                return false;
+            }
+            durations[f] = static_cast<uint32_t>(value);
+        }
+        show_config_entry entry;
+        entry.name.assign(fields[0], lengths[0]);
+        entry.timing.on_ms = durations[0];
+        entry.timing.off_ms = durations[1];
+        entries.push_back(entry);
+    }
+    return true;
+}
+
+/**
+ * @brief Read a whole file into text
+ *
+ * @return false if the file cannot be read
+ */
+inline bool read_show_config_file(char const* path, std::string& text) {
+    std::FILE* file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    text.clear();
+    char buffer[65536];
+    size_t count = 0;
+    while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        text.append(buffer, count);
+    }
+    bool const ok = std::ferror(file) == 0;
+    std::fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Controllers of a running show, addressed by stable slot
+ *
+ * Slots freed by removals are reused by later additions, so a long-running
+ * show with many reloads does not grow. Pins live in a deque so controllers
+ * keep valid references while slots are added.
+ *
+ * @tparam output_pin_t Default-constructible type that implements set(bool)
+ */
+template<typename output_pin_t>
+struct live_show {
+   public:
+    live_show() : active_count_(0) {}
+
+    live_show(live_show const&) = delete;
+    live_show& operator=(live_show const&) = delete;
+
+    /**
+     * @brief Add a controller whose off period starts at now_ms
+     *
+     * @return Slot of the new controller
+     */
+    uint32_t add(blink_timing const& timing, uint32_t now_ms) {
+        uint32_t slot = 0;
+        if (!free_slots_.empty()) {
+            slot = free_slots_.back();
+            free_slots_.pop_back();
+            controllers_[slot].set_durations(timing.on_ms, timing.off_ms);
+            active_[slot] = 1;
+        } else {
+            slot = static_cast<uint32_t>(controllers_.size());
+            pins_.emplace_back();
+            controllers_.emplace_back(pins_.back(), timing.on_ms, timing.off_ms);
+            active_.push_back(1);
+        }
+        controllers_[slot].restart(now_ms);
+        ++active_count_;
+        return slot;
+    }
+
+    /**
+     * @brief Drive a controller's output off and free its slot
+     */
+    void remove(uint32_t slot) {
+        controllers_[slot].restart(0);
+        active_[slot] = 0;
+        free_slots_.push_back(slot);
+        --active_count_;
+    }
+
+    /**
+     * @brief Change a controller's timing, keeping its phase
+     */
+    void retime(uint32_t slot, blink_timing const& timing) {
+        controllers_[slot].set_durations(timing.on_ms, timing.off_ms);
+    }
+
+    /**
+     * @brief Run one frame: update every active controller
+     */
+    void update(uint32_t now_ms) {
+        for (size_t i = 0; i < controllers_.size(); ++i) {
+            if (active_[i] != 0) {
+                controllers_[i].update(now_ms);
+            }
+        }
+    }
+
+    bool is_active(uint32_t slot) const { return slot < active_.size() && active_[slot] != 0; }
+    size_t size() const { return active_count_; }
+    size_t slot_count() const { return controllers_.size(); }
+    blink_controller<output_pin_t> const& controller(uint32_t slot) const {
+        return controllers_[slot];
+    }
+    output_pin_t const& pin(uint32_t slot) const { return pins_[slot]; }
+
+   private:
+    std::deque<output_pin_t> pins_;
+    std::vector<blink_controller<output_pin_t>> controllers_;
+    std::vector<uint8_t> active_;
+    std::vector<uint32_t> free_slots_;
+    size_t active_count_;
+};
+
+/// What one reload changed
+struct show_reload_stats {
+    size_t added;
+    size_t removed;
+    size_t retimed;
+    size_t parsed_lines;  // lines actually parsed (changed region only)
+};
+
+/**
+ * @brief One show file's contribution to a live show
+ *
+ * Keeps the text of the last good version and the slot of each of its
+ * controllers, so a reload only parses the region that differs.
+ */
+struct show_config_file {
+   public:
+    explicit show_config_file(std::string path) : path_(path), error_line_(0) {}
+
+    /**
+     * @brief Bring the live show in line with new file text
+     *
+     * @param now_ms Show time the change takes effect (start of added controllers)
+     * @return false if the changed region does not parse or repeats a name
+     *         (nothing is applied)
+     */
+    template<typename output_pin_t>
+    bool reload(std::string const& text, live_show<output_pin_t>& show, uint32_t now_ms,
+                show_reload_stats& stats) {
+        stats = show_reload_stats{0, 0, 0, 0};
+        error_line_ = 0;
+
+        // Changed region: between the longest common prefix and suffix, whole lines only
+        size_t const old_size = text_.size();
+        size_t const new_size = text.size();
+        size_t const shorter = old_size < new_size ? old_size : new_size;
+        size_t prefix = 0;
+        while (prefix < shorter && text_[prefix] == text[prefix]) {
+            ++prefix;
+        }
+        if (prefix == old_size && prefix == new_size) {
+            return true;
+        }
+        while (prefix > 0 && text_[prefix - 1] != '\n') {
+            --prefix;
+        }
+        size_t suffix = 0;
+        while (suffix < shorter - prefix &&
+               text_[old_size - 1 - suffix] == text[new_size - 1 - suffix]) {
+            ++suffix;
+        }
+        while (suffix > 0 && !(line_start(text_, old_size - suffix, prefix) &&
+                               line_start(text, new_size - suffix, prefix))) {
+            --suffix;
+        }
+
+        std::vector<show_config_entry> old_entries;
+        std::vector<show_config_entry> new_entries;
+        size_t error_line = 0;
+        parse_show_config(text_.data() + prefix, old_size - suffix - prefix, old_entries,
+                          error_line);
+        if (!parse_show_config(text.data() + prefix, new_size - suffix - prefix, new_entries,
+                               error_line)) {
+            error_line_ = first_line(text, prefix) + error_line - 1;
+            return false;
+        }
+
+        // Diff the region; validate everything before touching the show
+        std::unordered_map<std::string, blink_timing> removed;
+        for (size_t i = 0; i < old_entries.size(); ++i) {
+            removed[old_entries[i].name] = old_entries[i].timing;
+        }
+        std::unordered_set<std::string> seen;
+        for (size_t i = 0; i < new_entries.size(); ++i) {
+            std::string const& name = new_entries[i].name;
+            bool const repeated = !seen.insert(name).second;
+            if (repeated ||
+                (removed.find(name) == removed.end() && slots_.find(name) != slots_.end())) {
+                error_line_ =
+                    definition_line(text, prefix, new_size - suffix, name, repeated ? 2 : 1);
+                return false;
+            }
+        }
+
+        // Retime in place; removals go before additions so their slots are reused
+        std::vector<show_config_entry const*> added;
+        for (size_t i = 0; i < new_entries.size(); ++i) {
+            show_config_entry const& entry = new_entries[i];
+            std::unordered_map<std::string, blink_timing>::iterator const old =
+                removed.find(entry.name);
+            if (old == removed.end()) {
+                added.push_back(&entry);
+                continue;
+            }
+            if (old->second.on_ms != entry.timing.on_ms ||
+                old->second.off_ms != entry.timing.off_ms) {
+                show.retime(slots_[entry.name], entry.timing);
+                ++stats.retimed;
+            }
+            removed.erase(old);
+        }
+        for (std::unordered_map<std::string, blink_timing>::const_iterator it = removed.begin();
+             it != removed.end(); ++it) {
+            std::unordered_map<std::string, uint32_t>::iterator const slot = slots_.find(it->first);
+            show.remove(slot->second);
+            slots_.erase(slot);
+            ++stats.removed;
+        }
+        for (size_t i = 0; i < added.size(); ++i) {
+            slots_[added[i]->name] = show.add(added[i]->timing, now_ms);
+            ++stats.added;
+        }
+        stats.parsed_lines = count_lines(text, prefix, new_size - suffix);
+        text_ = text;
+        return true;
+    }
+
+    /**
+     * @brief Slot of a controller defined by this file
+     *
+     * @return false if the file does not define name
+     */
+    bool find(std::string const& name, uint32_t& slot) const {
+        std::unordered_map<std::string, uint32_t>::const_iterator const it = slots_.find(name);
+        if (it == slots_.end()) {
+            return false;
+        }
+        slot = it->second;
+        return true;
+    }
+
+    std::string const& path() const { return path_; }
+    size_t size() const { return slots_.size(); }
+    /// 1-based line of the last reload's error (0 if it succeeded)
+    size_t error_line() const { return error_line_; }
+
+   private:
+    // True if pos starts a line (or is the start of the changed region)
+    static bool line_start(std::string const& text, size_t pos, size_t region_start) {
+        return pos == region_start || text[pos - 1] == '\n';
+    }
+
+    static size_t count_lines(std::string const& text, size_t begin, size_t end) {
+        size_t lines = 0;
+        for (size_t i = begin; i < end; ++i) {
+            lines += text[i] == '\n' ? 1 : 0;
+        }
+        return lines + (end > begin && text[end - 1] != '\n' ? 1 : 0);
+    }
+
+    // 1-based line number of offset pos
+    static size_t first_line(std::string const& text, size_t pos) {
+        return count_lines(text, 0, pos) + 1;
+    }
+
+    // Line of the occurrence-th definition of name inside the changed region
+    static size_t definition_line(std::string const& text, size_t begin, size_t end,
+                                  std::string const& name, size_t occurrence) {
+        std::vector<show_config_entry> entries;
+        size_t error_line = 0;
+        size_t line = first_line(text, begin);
+        size_t pos = begin;
+        while (pos < end) {
+            size_t next = text.find('\n', pos);
+            next = next == std::string::npos || next > end ? end : next + 1;
+            entries.clear();
+            parse_show_config(text.data() + pos, next - pos, entries, error_line);
+            if (!entries.empty() && entries[0].name == name && --occurrence == 0) {
+                return line;
+            }
+            pos = next;
+            ++line;
+        }
+        return line;
+    }
+
+    std::string path_;
+    std::string text_;
+    std::unordered_map<std::string, uint32_t> slots_;
+    size_t error_line_;
+};
+
+/**
+ * @brief Notifies which watched files were saved (Linux inotify)
+ *
+ * Watches each file's directory rather than the file, so editors that save
+ * by writing a temporary file and renaming it over the original are seen
+ * too. Reports a file after it is closed for writing or renamed into place,
+ * never in the middle of a write.
+ */
+struct show_config_watcher {
+   public:
+    show_config_watcher() : fd_(::inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+
+    ~show_config_watcher() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    show_config_watcher(show_config_watcher const&) = delete;
+    show_config_watcher& operator=(show_config_watcher const&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+
+    /**
+     * @brief Start watching a file
+     *
+     * @param index Set to the file's index in poll() results
+     * @return false if its directory cannot be watched
+     */
+    bool add(std::string const& path, size_t& index) {
+        size_t const slash = path.rfind('/');
+        std::string const directory =
+            slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int const wd = ::inotify_add_watch(fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if (wd < 0) {
+            return false;
+        }
+        watched_file file;
+        file.wd = wd;
+        file.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        index = files_.size();
+        files_.push_back(file);
+        return true;
+    }
+
+    /**
+     * @brief Wait up to timeout_ms for saves and collect the files that changed
+     *
+     * @param changed Indices of changed files, each once (cleared first)
+     * @return Number of changed files
+     */
+    size_t poll(int timeout_ms, std::vector<size_t>& changed) {
+        changed.clear();
+        pollfd pfd = {fd_, POLLIN, 0};
+        if (fd_ < 0 || ::poll(&pfd, 1, timeout_ms) <= 0) {
+            return 0;
+        }
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length = 0;
+        while ((length = ::read(fd_, buffer, sizeof(buffer))) > 0) {
+            for (ssize_t pos = 0; pos < length;) {
+                inotify_event const* event = reinterpret_cast<inotify_event const*>(buffer + pos);
+                pos += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                if (event->len == 0) {
+                    continue;
+                }
+                for (size_t i = 0; i < files_.size(); ++i) {
+                    if (files_[i].wd == event->wd && files_[i].name == event->name) {
+                        note_changed(i, changed);
+                    }
+                }
+            }
+        }
+        return changed.size();
+    }
+
+   private:
+    struct watched_file {
+        int wd;
+        std::string name;
+    };
+
+    static void note_changed(size_t index, std::vector<size_t>& changed) {
+        for (size_t i = 0; i < changed.size(); ++i) {
+            if (changed[i] == index) {
+                return;
+            }
+        }
+        changed.push_back(index);
+    }
+
+    int fd_;
+    std::vector<watched_file> files_;
+};
+
+/**
+ * @brief Keeps a live show in step with its files while it runs
+ *
+ * Call poll() between frames; every change it applies lands on that frame
+ * boundary.
+ *
+ * @tparam output_pin_t Pin type of the live show
+ */
+template<typename output_pin_t>
+struct show_hot_reload {
+   public:
+    explicit show_hot_reload(live_show<output_pin_t>& show)
+        : show_(show), last_(show_reload_stats{0, 0, 0, 0}), reloads_(0), failed_reloads_(0) {}
+
+    /**
+     * @brief Load a file into the show and watch it
+     *
+     * @return false if it cannot be read, parsed or watched. A file that failed to parse
+     *         is still watched as file(file_count() - 1), whose error_line() tells which line
+     */
+    bool add_file(std::string const& path, uint32_t now_ms) {
+        std::string text;
+        size_t index = 0;
+        if (!watcher_.ok() || !read_show_config_file(path.c_str(), text) ||
+            !watcher_.add(path, index)) {
+            return false;
+        }
+        files_.push_back(show_config_file(path));
+        show_reload_stats stats;
+        return files_.back().reload(text, show_, now_ms, stats);
+    }
+
+    /**
+     * @brief Apply every file saved since the last call
+     *
+     * @param timeout_ms Longest wait for a save (0 to just check)
+     * @param now_ms Show time the changes take effect
+     * @return Number of files reloaded successfully
+     */
+    size_t poll(int timeout_ms, uint32_t now_ms) {
+        size_t reloaded = 0;
+        last_ = show_reload_stats{0, 0, 0, 0};
+        if (watcher_.poll(timeout_ms, changed_) == 0) {
+            return 0;
+        }
+        for (size_t i = 0; i < changed_.size(); ++i) {
+            show_config_file& file = files_[changed_[i]];
+            show_reload_stats stats;
+            std::string text;
+            if (!read_show_config_file(file.path().c_str(), text) ||
+                !file.reload(text, show_, now_ms, stats)) {
+                ++failed_reloads_;
+                continue;
+            }
+            ++reloads_;
+            ++reloaded;
+            last_.added += stats.added;
+            last_.removed += stats.removed;
+            last_.retimed += stats.retimed;
+            last_.parsed_lines += stats.parsed_lines;
+        }
+        return reloaded;
+    }
+
+    show_config_file const& file(size_t index) const { return files_[index]; }
+    size_t file_count() const { return files_.size(); }
+    /// Combined changes of the last poll()
+    show_reload_stats const& last_reload() const { return last_; }
+    uint64_t reloads() const { return reloads_; }
+    uint64_t failed_reloads() const { return failed_reloads_; }
+
+   private:
+    live_show<output_pin_t>& show_;
+    show_config_watcher watcher_;
+    std::vector<show_config_file> files_;
+    std::vector<size_t> changed_;
+    show_reload_stats last_;
+    uint64_t reloads_;
+    uint64_t failed_reloads_;
+};
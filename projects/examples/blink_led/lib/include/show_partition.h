@@ -0,0 +1,747 @@
+#pragma once
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "blink_controller.h"
+#include "show_command.h"
+
+/**
+ * @brief Partitioned multi-process show runtime
+ *
+ * A show too large for one process is split into contiguous ranges of
+ * controller ids, one range per worker node. A coordinator fans start,
+ * stop, seek and trigger commands out to the nodes in batched,
+ * sequence-numbered messages and gathers per-node health reports.
+ *
+ * Transport is any connected stream socket (socketpair for workers on the
+ * same host, TCP for workers on other hosts). Messages are length-prefixed
+ * frames with an explicit little-endian layout:
+ *
+ *   u16 magic | u8 kind | u8 reserved | u16 node_id | u16 count
+ *   u32 sequence | u64 sent_ns | payload
+ *
+ * sent_ns is the coordinator's monotonic clock at send time. Nodes on the
+ * same host share that clock, so they can report command-to-trigger latency
+ * (send until the restart drives the output); across hosts the figure is
+ * only meaningful with synchronized clocks.
+ *
+ * Design:
+ * - Nodes own their controllers and pins, the coordinator owns only routing
+ * - Commands are buffered per node and sent as one message per flush()
+ * - Sequence gaps are counted by the node, not retried (commands are idempotent
+ *   at the show level; the next seek/start re-establishes state)
+ */
+
+/// Health counters reported by each node on request
+struct node_health {
+    uint16_t node_id;
+    uint32_t controller_count;
+    uint32_t last_sequence;
+    uint32_t sequence_gaps;
+    uint32_t commands_applied;
+    uint32_t show_time_ms;
+    uint64_t frames;
+    uint64_t edges;
+    uint64_t max_frame_ns;
+    uint64_t last_trigger_latency_ns;
+    uint64_t max_trigger_latency_ns;
+};
+
+enum class show_message_kind : uint8_t { command_batch = 1, health_request = 2, health_report = 3 };
+
+struct show_message_header {
+    show_message_kind kind;
+    uint16_t node_id;
+    uint16_t count;
+    uint32_t sequence;
+    uint64_t sent_ns;
+};
+
+constexpr uint16_t SHOW_MESSAGE_MAGIC = 0x5348;  // "SH"
+constexpr size_t SHOW_MESSAGE_HEADER_SIZE = 20;
+constexpr size_t SHOW_COMMAND_WIRE_SIZE = 9;
+
+inline void encode_show_header(std::vector<uint8_t>& out, show_message_header const& header) {
+    wire_writer writer(out);
+    writer.put_u16(SHOW_MESSAGE_MAGIC);
+    writer.put_u8(static_cast<uint8_t>(header.kind));
+    writer.put_u8(0);
+    writer.put_u16(header.node_id);
+    writer.put_u16(header.count);
+    writer.put_u32(header.sequence);
+    writer.put_u64(header.sent_ns);
+}
+
+/**
+ * @brief Decode and validate a message header
+ *
+ * @return false if the message is truncated or not a show message
+ */
+inline bool decode_show_header(wire_reader& reader, show_message_header& header) {
+    uint16_t const magic = reader.get_u16();
+    uint8_t const kind = reader.get_u8();
+    reader.get_u8();
+    header.node_id = reader.get_u16();
+    header.count = reader.get_u16();
+    header.sequence = reader.get_u32();
+    header.sent_ns = reader.get_u64();
+    if (!reader.ok() || magic != SHOW_MESSAGE_MAGIC || kind < 1 || kind > 3) {
+        return false;
+    }
+    header.kind = static_cast<show_message_kind>(kind);
+    return true;
+}
+
+inline void encode_show_command(std::vector<uint8_t>& out, show_command const& command) {
+    wire_writer writer(out);
+    writer.put_u8(static_cast<uint8_t>(command.type));
+    writer.put_u32(command.controller_id);
+    writer.put_u32(command.show_time_ms);
+}
+
+inline bool decode_show_command(wire_reader& reader, show_command& command) {
+    uint8_t const type = reader.get_u8();
+    command.controller_id = reader.get_u32();
+    command.show_time_ms = reader.get_u32();
+    if (!reader.ok() || type < 1 || type > 4) {
+        return false;
+    }
+    command.type = static_cast<show_command_type>(type);
+    return true;
+}
+
+inline void encode_node_health(std::vector<uint8_t>& out, node_health const& health) {
+    show_message_header const header = {show_message_kind::health_report, health.node_id, 0,
+                                        health.last_sequence, monotonic_ns()};
+    encode_show_header(out, header);
+    wire_writer writer(out);
+    writer.put_u32(health.controller_count);
+    writer.put_u32(health.sequence_gaps);
+    writer.put_u32(health.commands_applied);
+    writer.put_u32(health.show_time_ms);
+    writer.put_u64(health.frames);
+    writer.put_u64(health.edges);
+    writer.put_u64(health.max_frame_ns);
+    writer.put_u64(health.last_trigger_latency_ns);
+    writer.put_u64(health.max_trigger_latency_ns);
+}
+
+/**
+ * @brief Decode a health report payload (header already consumed)
+ */
+inline bool decode_node_health(wire_reader& reader, show_message_header const& header,
+                               node_health& health) {
+    health.node_id = header.node_id;
+    health.last_sequence = header.sequence;
+    health.controller_count = reader.get_u32();
+    health.sequence_gaps = reader.get_u32();
+    health.commands_applied = reader.get_u32();
+    health.show_time_ms = reader.get_u32();
+    health.frames = reader.get_u64();
+    health.edges = reader.get_u64();
+    health.max_frame_ns = reader.get_u64();
+    health.last_trigger_latency_ns = reader.get_u64();
+    health.max_trigger_latency_ns = reader.get_u64();
+    return reader.ok();
+}
+
+/**
+ * @brief Length-prefixed message framing over a connected stream socket
+ *
+ * Does not own the file descriptor; close() is explicit so a coordinator can
+ * signal shutdown to a worker by hanging up.
+ */
+struct frame_channel {
+   public:
+    static constexpr uint32_t MAX_FRAME_SIZE = 1u << 20;
+
+    explicit frame_channel(int fd) : fd_(fd) {}
+
+    /**
+     * @brief Send one frame (blocking until fully written)
+     *
+     * @return false if the peer has gone away
+     */
+    bool send(std::vector<uint8_t> const& frame) {
+        uint8_t prefix[4];
+        uint32_t const size = static_cast<uint32_t>(frame.size());
+        for (int i = 0; i < 4; ++i) {
+            prefix[i] = static_cast<uint8_t>(size >> (8 * i));
+        }
+        return write_all(prefix, sizeof(prefix)) && write_all(frame.data(), frame.size());
+    }
+
+    /**
+     * @brief Receive one frame (blocking)
+     *
+     * @return false on EOF, error or oversized frame
+     */
+    bool receive(std::vector<uint8_t>& frame) {
+        uint8_t prefix[4];
+        if (!read_all(prefix, sizeof(prefix))) {
+            return false;
+        }
+        uint32_t size = 0;
+        for (int i = 0; i < 4; ++i) {
+            size |= static_cast<uint32_t>(prefix[i]) << (8 * i);
+        }
+        if (size > MAX_FRAME_SIZE) {
+            return false;
+        }
+        frame.resize(size);
+        return read_all(frame.data(), size);
+    }
+
+    /**
+     * @brief Wait until a frame (or EOF) is available
+     *
+     * @param timeout_ms Maximum wait, 0 to poll
+     */
+    bool wait_readable(int timeout_ms) const {
+        pollfd pfd = {fd_, POLLIN, 0};
+        return ::poll(&pfd, 1, timeout_ms) > 0;
+    }
+
+    void close() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    int fd() const { return fd_; }
+
+   private:
+    bool write_all(uint8_t const* data, size_t size) {
+        while (size > 0) {
+            // MSG_NOSIGNAL: a hung-up peer fails the send instead of raising SIGPIPE
+            ssize_t const n = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool read_all(uint8_t* data, size_t size) {
+        while (size > 0) {
+            ssize_t const n = ::read(fd_, data, size);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int fd_;
+};
+
+/**
+ * @brief Listen for worker connections on a TCP port
+ *
+ * @param port Port to bind, 0 for an ephemeral port (see tcp_local_port())
+ * @param loopback_only Bind 127.0.0.1 instead of all interfaces
+ * @return Listening socket, or -1 on error
+ */
+inline int tcp_listen(uint16_t port, bool loopback_only) {
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    int const yes = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, 16) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Port a bound socket is listening on
+ */
+inline uint16_t tcp_local_port(int fd) {
+    sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        return 0;
+    }
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief Connect to a listening peer (IPv4 dotted address)
+ *
+ * Disables Nagle so small command batches go out immediately.
+ *
+ * @return Connected socket, or -1 on error
+ */
+inline int tcp_connect(char const* address, uint16_t port) {
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    int const yes = 1;
+    if (::inet_pton(AF_INET, address, &addr.sin_addr) != 1 ||
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    return fd;
+}
+
+/**
+ * @brief Accept one connection with Nagle disabled
+ *
+ * @return Connected socket, or -1 on error
+ */
+inline int tcp_accept(int listen_fd) {
+    int const fd = ::accept(listen_fd, nullptr, nullptr);
+    if (fd >= 0) {
+        int const yes = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    return fd;
+}
+
+/**
+ * @brief Assignment of controller ids to nodes as contiguous ranges
+ *
+ * Contiguous ranges keep the mapping to two comparisons and make the
+ * node-local index a subtraction.
+ */
+struct show_partition {
+   public:
+    /**
+     * @brief Split controller_count ids as evenly as possible over node_count nodes (0 as 1)
+     */
+    static show_partition balanced(uint32_t controller_count, uint16_t node_count) {
+        node_count = std::max<uint16_t>(node_count, 1);
+        show_partition partition;
+        for (uint32_t node = 0; node <= node_count; ++node) {
+            partition.first_ids_.push_back(static_cast<uint32_t>(
+                static_cast<uint64_t>(controller_count) * node / node_count));
+        }
+        return partition;
+    }
+
+    uint16_t node_count() const { return static_cast<uint16_t>(first_ids_.size() - 1); }
+    uint32_t controller_count() const { return first_ids_.back(); }
+    uint32_t first_controller(uint16_t node) const { return first_ids_[node]; }
+
+    uint32_t controllers_on(uint16_t node) const {
+        return first_ids_[node + 1] - first_ids_[node];
+    }
+
+    /**
+     * @brief Node owning a controller id (id must be < controller_count())
+     */
+    uint16_t node_of(uint32_t controller_id) const {
+        auto const it = std::upper_bound(first_ids_.begin(), first_ids_.end(), controller_id);
+        return static_cast<uint16_t>(it - first_ids_.begin() - 1);
+    }
+
+   private:
+    std::vector<uint32_t> first_ids_;
+};
+
+/**
+ * @brief One worker's share of the show
+ *
+ * Owns a contiguous range of controllers and the show clock that drives them.
+ *
+ * @tparam output_pin_t Default-constructible type that implements set(bool)
+ * @tparam timer_t Type that implements millis() (real_time_timer, mock_timer)
+ */
+template<typename output_pin_t, typename timer_t>
+struct show_node {
+   public:
+    /**
+     * @param node_id This node's index in the partition
+     * @param first_controller_id Global id of the first owned controller
+     * @param timer Local clock the show clock is derived from
+     * @param timings Timing of each owned controller, in id order
+     */
+    show_node(uint16_t node_id, uint32_t first_controller_id, timer_t& timer,
+              std::vector<blink_timing> const& timings)
+        : node_id_(node_id),
+          first_controller_id_(first_controller_id),
+          timer_(timer),
+          pins_(timings.size()),
+          last_state_(timings.size(), 0),
+          running_(false),
+          show_base_ms_(0),
+          local_base_ms_(0),
+          last_sequence_(0),
+          sequence_gaps_(0),
+          commands_applied_(0),
+          frames_(0),
+          edges_(0),
+          max_frame_ns_(0),
+          last_trigger_latency_ns_(0),
+          max_trigger_latency_ns_(0) {
+        controllers_.reserve(timings.size());
+        for (size_t i = 0; i < timings.size(); ++i) {
+            controllers_.emplace_back(pins_[i], timings[i].on_ms, timings[i].off_ms);
+        }
+    }
+
+    /**
+     * @brief Current show time (frozen while stopped)
+     */
+    uint32_t show_time_ms() const {
+        if (!running_) {
+            return show_base_ms_;
+        }
+        return show_base_ms_ + (timer_.millis() - local_base_ms_);
+    }
+
+    /**
+     * @brief Apply one command addressed by global controller id
+     *
+     * @param sent_ns Coordinator send time, used for trigger latency (0 to skip)
+     */
+    void apply(show_command const& command, uint64_t sent_ns) {
+        ++commands_applied_;
+        switch (command.type) {
+            case show_command_type::start:
+                running_ = true;
+                rebase(command.show_time_ms);
+                break;
+            case show_command_type::stop:
+                show_base_ms_ = show_time_ms();
+                running_ = false;
+                for (size_t i = 0; i < controllers_.size(); ++i) {
+                    controllers_[i].restart(show_base_ms_);
+                    note_output(i);
+                }
+                break;
+            case show_command_type::seek:
+                rebase(command.show_time_ms);
+                break;
+            case show_command_type::trigger: {
+                uint32_t const index = command.controller_id - first_controller_id_;
+                if (index < controllers_.size()) {
+                    controllers_[index].restart(show_time_ms());
+                    note_output(index);
+                    note_trigger_latency(sent_ns);
+                }
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Apply a decoded command batch and track its sequence number
+     *
+     * @return false if the payload is malformed (already-applied commands stay applied)
+     */
+    bool apply_batch(show_message_header const& header, wire_reader& reader) {
+        if (header.sequence != last_sequence_ + 1) {
+            ++sequence_gaps_;
+        }
+        last_sequence_ = header.sequence;
+        for (uint16_t i = 0; i < header.count; ++i) {
+            show_command command;
+            if (!decode_show_command(reader, command)) {
+                return false;
+            }
+            apply(command, header.sent_ns);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Run one frame: update every owned controller at the show time
+     */
+    void update() {
+        if (!running_) {
+            return;
+        }
+        uint64_t const start_ns = monotonic_ns();
+        uint32_t const now_ms = show_time_ms();
+        for (size_t i = 0; i < controllers_.size(); ++i) {
+            controllers_[i].update(now_ms);
+            note_output(i);
+        }
+        ++frames_;
+        max_frame_ns_ = std::max(max_frame_ns_, monotonic_ns() - start_ns);
+    }
+
+    node_health health() const {
+        node_health health;
+        health.node_id = node_id_;
+        health.controller_count = static_cast<uint32_t>(controllers_.size());
+        health.last_sequence = last_sequence_;
+        health.sequence_gaps = sequence_gaps_;
+        health.commands_applied = commands_applied_;
+        health.show_time_ms = show_time_ms();
+        health.frames = frames_;
+        health.edges = edges_;
+        health.max_frame_ns = max_frame_ns_;
+        health.last_trigger_latency_ns = last_trigger_latency_ns_;
+        health.max_trigger_latency_ns = max_trigger_latency_ns_;
+        return health;
+    }
+
+    bool is_running() const { return running_; }
+    size_t size() const { return controllers_.size(); }
+    blink_controller<output_pin_t> const& controller(size_t index) const {
+        return controllers_[index];
+    }
+
+   private:
+    // Move the show clock and give every controller the phase it has at that show time
+    // had the show played through from 0 (triggers are live events and not replayed).
+    // While stopped only the clock moves: outputs stay off until start rebases again.
+    void rebase(uint32_t show_time_ms) {
+        show_base_ms_ = show_time_ms;
+        local_base_ms_ = timer_.millis();
+        if (!running_) {
+            return;
+        }
+        for (size_t i = 0; i < controllers_.size(); ++i) {
+            controllers_[i].align(show_time_ms);
+            note_output(i);
+        }
+    }
+
+    // Count output edges
+    void note_output(size_t index) {
+        uint8_t const state = controllers_[index].is_on() ? 1 : 0;
+        if (state != last_state_[index]) {
+            last_state_[index] = state;
+            ++edges_;
+        }
+    }
+
+    // restart() has just driven the output: the trigger is live now, whatever
+    // the controller's blink timing does next
+    void note_trigger_latency(uint64_t sent_ns) {
+        if (sent_ns != 0) {
+            last_trigger_latency_ns_ = monotonic_ns() - sent_ns;
+            max_trigger_latency_ns_ = std::max(max_trigger_latency_ns_, last_trigger_latency_ns_);
+        }
+    }
+
+    uint16_t node_id_;
+    uint32_t first_controller_id_;
+    timer_t& timer_;
+    std::vector<output_pin_t> pins_;
+    std::vector<blink_controller<output_pin_t>> controllers_;
+    std::vector<uint8_t> last_state_;
+    bool running_;
+    uint32_t show_base_ms_;
+    uint32_t local_base_ms_;
+    uint32_t last_sequence_;
+    uint32_t sequence_gaps_;
+    uint32_t commands_applied_;
+    uint64_t frames_;
+    uint64_t edges_;
+    uint64_t max_frame_ns_;
+    uint64_t last_trigger_latency_ns_;
+    uint64_t max_trigger_latency_ns_;
+};
+
+/**
+ * @brief Worker main loop: serve coordinator messages and run frames
+ *
+ * Returns when the coordinator hangs up.
+ *
+ * @param frame_period_ms Longest wait for a message before running a frame
+ */
+template<typename node_t>
+void run_show_worker(node_t& node, frame_channel& channel, int frame_period_ms) {
+    std::vector<uint8_t> frame;
+    std::vector<uint8_t> reply;
+    for (;;) {
+        if (channel.wait_readable(frame_period_ms)) {
+            if (!channel.receive(frame)) {
+                return;
+            }
+            wire_reader reader(frame.data(), frame.size());
+            show_message_header header;
+            if (decode_show_header(reader, header)) {
+                if (header.kind == show_message_kind::command_batch) {
+                    node.apply_batch(header, reader);
+                } else if (header.kind == show_message_kind::health_request) {
+                    reply.clear();
+                    encode_node_health(reply, node.health());
+                    if (!channel.send(reply)) {
+                        return;
+                    }
+                }
+            }
+        }
+        node.update();
+    }
+}
+
+/**
+ * @brief Routes commands to nodes and collects their health
+ *
+ * Commands are buffered per node until flush(); a node's buffer is flushed
+ * early when it reaches max_batch_commands.
+ */
+struct show_coordinator {
+   public:
+    /**
+     * @param partition Controller-to-node assignment
+     * @param channels One connected channel per node, in node order
+     * @param max_batch_commands Commands per message before an early flush
+     */
+    show_coordinator(show_partition const& partition, std::vector<frame_channel> const& channels,
+                     size_t max_batch_commands = 256)
+        : partition_(partition),
+          channels_(channels),
+          pending_(channels.size()),
+          sequences_(channels.size(), 0),
+          max_batch_commands_(std::min<size_t>(max_batch_commands, UINT16_MAX)),
+          batches_sent_(0) {}
+
+    /**
+     * @brief Queue a command; ALL_CONTROLLERS and non-trigger commands go to every node
+     *
+     * @return false if a node connection failed during an early flush
+     */
+    bool queue(show_command const& command) {
+        if (command.type == show_command_type::trigger &&
+            command.controller_id != ALL_CONTROLLERS) {
+            if (command.controller_id >= partition_.controller_count()) {
+                return true;
+            }
+            return queue_for(partition_.node_of(command.controller_id), command);
+        }
+        bool ok = true;
+        for (uint16_t node = 0; node < partition_.node_count(); ++node) {
+            if (command.type == show_command_type::trigger) {
+                // Expand a trigger-all into the node's own ids
+                uint32_t const first = partition_.first_controller(node);
+                for (uint32_t i = 0; i < partition_.controllers_on(node); ++i) {
+                    show_command const each = {command.type, first + i, command.show_time_ms};
+                    ok = queue_for(node, each) && ok;
+                }
+            } else {
+                ok = queue_for(node, command) && ok;
+            }
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Send every non-empty per-node batch
+     *
+     * @return false if any node connection failed
+     */
+    bool flush() {
+        bool ok = true;
+        for (uint16_t node = 0; node < partition_.node_count(); ++node) {
+            ok = flush_node(node) && ok;
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Ask every node for its health and wait for all replies
+     *
+     * @param health Filled with one report per node, in node order
+     * @return false if any node failed to answer
+     */
+    bool collect_health(std::vector<node_health>& health) {
+        health.assign(partition_.node_count(), node_health());
+        std::vector<uint8_t> message;
+        for (uint16_t node = 0; node < partition_.node_count(); ++node) {
+            message.clear();
+            show_message_header const header = {show_message_kind::health_request, node, 0,
+                                                sequences_[node], monotonic_ns()};
+            encode_show_header(message, header);
+            if (!channels_[node].send(message)) {
+                return false;
+            }
+        }
+        for (uint16_t node = 0; node < partition_.node_count(); ++node) {
+            if (!channels_[node].receive(message)) {
+                return false;
+            }
+            wire_reader reader(message.data(), message.size());
+            show_message_header header;
+            if (!decode_show_header(reader, header) ||
+                header.kind != show_message_kind::health_report ||
+                !decode_node_health(reader, header, health[node])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t sequence(uint16_t node) const { return sequences_[node]; }
+    uint64_t batches_sent() const { return batches_sent_; }
+
+   private:
+    bool queue_for(uint16_t node, show_command const& command) {
+        pending_[node].push_back(command);
+        if (pending_[node].size() >= max_batch_commands_) {
+            return flush_node(node);
+        }
+        return true;
+    }
+
+    bool flush_node(uint16_t node) {
+        std::vector<show_command>& commands = pending_[node];
+        if (commands.empty()) {
+            return true;
+        }
+        message_.clear();
+        show_message_header const header = {show_message_kind::command_batch, node,
+                                            static_cast<uint16_t>(commands.size()),
+                                            sequences_[node] + 1, monotonic_ns()};
+        encode_show_header(message_, header);
+        for (size_t i = 0; i < commands.size(); ++i) {
+            encode_show_command(message_, commands[i]);
+        }
+        commands.clear();
+        if (!channels_[node].send(message_)) {
+            return false;
+        }
+        ++sequences_[node];
+        ++batches_sent_;
+        return true;
+    }
+
+    show_partition partition_;
+    std::vector<frame_channel> channels_;
+    std::vector<std::vector<show_command>> pending_;
+    std::vector<uint32_t> sequences_;
+    std::vector<uint8_t> message_;
+    size_t max_batch_commands_;
+    uint64_t batches_sent_;
+};
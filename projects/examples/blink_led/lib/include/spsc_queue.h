@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer queue
+ *
+ * Hands items from one thread (e.g. a network receiver) to another (the
+ * control loop) without locks or allocation after construction. push() and
+ * pop() never block; a full queue rejects the item and the producer decides
+ * what to count or drop.
+ *
+ * Design:
+ * - Capacity rounded up to a power of two; indices wrap with a mask
+ * - Head and tail on separate cache lines to avoid false sharing
+ * - Acquire/release ordering only (no seq_cst fences)
+ *
+ * @tparam item_t Copyable item type
+ */
+template<typename item_t>
+struct spsc_queue {
+   public:
+    /**
+     * @param capacity Minimum number of items the queue can hold
+     */
+    explicit spsc_queue(size_t capacity)
+        : items_(round_up_pow2(capacity)), mask_(items_.size() - 1), head_(0), tail_(0) {}
+
+    spsc_queue(spsc_queue const&) = delete;
+    spsc_queue& operator=(spsc_queue const&) = delete;
+
+    /**
+     * @brief Producer side: enqueue an item
+     *
+     * @return false if the queue is full
+     */
+    bool push(item_t const& item) {
+        size_t const tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side: dequeue an item
+     *
+     * @return false if the queue is empty
+     */
+    bool pop(item_t& item) {
+        size_t const head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Approximate number of queued items (exact when called from either end while idle)
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return items_.size(); }
+
+   private:
+    static size_t round_up_pow2(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<item_t> items_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+};
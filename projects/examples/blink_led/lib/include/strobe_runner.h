@@ -0,0 +1,158 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__has_include)
+#if __has_include(<thread>)
+#include <atomic>
+#include <chrono>
+#include <thread>
+#define STROBE_HOST_THREAD 1
+#endif
+#endif
+
+/**
+ * @brief Fast loop for microsecond strobes, separate from the millisecond show logic
+ *
+ * A strobe above ~100 Hz has half-periods of a few milliseconds or less, so
+ * millisecond updates alias and jitter. Strobe controllers are ordinary
+ * blink_controllers with microsecond durations, fed a micros() clock by a
+ * runner that does nothing else:
+ *
+ *   blink_controller<led_pin> strobes[2] = {{pin_a, 500, 1500}, {pin_b, 100, 100}};
+ *   strobe_runner<real_time_timer, blink_controller<led_pin>> runner(timer, strobes, 2);
+ *   strobe_thread<real_time_timer, blink_controller<led_pin>> fast(runner);
+ *   fast.start();                                   // show logic keeps its millis() loop
+ *
+ * On an MCU, loop() calls runner.service() between the millisecond work.
+ *
+ * The timer (duck-typed like blink_controller's output_pin_t) provides
+ * uint32_t micros(), wrapping like Arduino's.
+ *
+ * Design:
+ * - A due controller is updated with its scheduled edge time, not the time
+ *   the loop got to it, so service latency delays that one edge but never
+ *   accumulates into the period. Beyond resync_us late (e.g. the thread was
+ *   descheduled) it restarts from now instead of replaying missed edges.
+ * - strobe_thread sleeps until spin_us before the next edge, then polls
+ *   service() until it is due: microsecond edges at the cost of spinning
+ *   that long per edge.
+ * - The controllers belong to the fast loop; the show logic must not touch them.
+ */
+template<typename timer_t, typename controller_t>
+struct strobe_runner {
+   public:
+    /**
+     * @param controllers Array of count controllers with microsecond durations (not owned)
+     * @param resync_us Lateness beyond which an edge restarts from now
+     */
+    strobe_runner(timer_t& timer, controller_t* controllers, size_t count,
+                  uint32_t resync_us = 1000)
+        : timer_(timer),
+          controllers_(controllers),
+          count_(count),
+          resync_us_(resync_us),
+          edges_(0),
+          resyncs_(0),
+          max_late_us_(0) {}
+
+    /**
+     * @brief Toggle every controller whose edge is due
+     *
+     * @return Microseconds until the next edge (0 if one is already due)
+     */
+    uint32_t service() {
+        uint32_t const now = timer_.micros();
+        uint32_t next = UINT32_MAX;
+        for (size_t i = 0; i < count_; ++i) {
+            controller_t& controller = controllers_[i];
+            if (controller.until_toggle(now) == 0) {
+                uint32_t const deadline =
+                    controller.get_last_toggle_time() +
+                    (controller.is_on() ? controller.get_on_duration()
+                                        : controller.get_off_duration());
+                uint32_t const late = now - deadline;
+                max_late_us_ = late > max_late_us_ ? late : max_late_us_;
+                ++edges_;
+                if (late <= resync_us_) {
+                    controller.update(deadline);
+                } else {
+                    controller.update(now);
+                    ++resyncs_;
+                }
+            }
+            uint32_t const until = controller.until_toggle(now);
+            next = until < next ? until : next;
+        }
+        return next;
+    }
+
+    uint64_t edges() const { return edges_; }
+    uint64_t resyncs() const { return resyncs_; }
+
+    /// Longest time an edge waited past its deadline for service()
+    uint32_t max_late_us() const { return max_late_us_; }
+
+   private:
+    timer_t& timer_;
+    controller_t* controllers_;
+    size_t count_;
+    uint32_t resync_us_;
+    uint64_t edges_;
+    uint64_t resyncs_;
+    uint32_t max_late_us_;
+};
+
+#if defined(STROBE_HOST_THREAD)
+/**
+ * @brief Host fast loop: runs a strobe_runner on its own thread until stop()
+ */
+template<typename timer_t, typename controller_t>
+struct strobe_thread {
+   public:
+    explicit strobe_thread(strobe_runner<timer_t, controller_t>& runner, uint32_t spin_us = 200)
+        : runner_(runner), spin_us_(spin_us), running_(false), passes_(0) {}
+
+    ~strobe_thread() { stop(); }
+
+    strobe_thread(strobe_thread const&) = delete;
+    strobe_thread& operator=(strobe_thread const&) = delete;
+
+    void start() {
+        if (running_.load(std::memory_order_relaxed)) {
+            return;
+        }
+        running_.store(true, std::memory_order_relaxed);
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        running_.store(false, std::memory_order_relaxed);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    /// service() calls so far (sleeps plus spin polls)
+    uint64_t passes() const { return passes_.load(std::memory_order_relaxed); }
+
+   private:
+    void run() {
+        while (running_.load(std::memory_order_relaxed)) {
+            uint32_t const until = runner_.service();
+            passes_.fetch_add(1, std::memory_order_relaxed);
+            if (until > spin_us_) {
+                // Never sleep long, so stop() is prompt with idle controllers
+                uint32_t const nap = until - spin_us_ < 100000 ? until - spin_us_ : 100000;
+                std::this_thread::sleep_for(std::chrono::microseconds(nap));
+            }
+        }
+    }
+
+    strobe_runner<timer_t, controller_t>& runner_;
+    uint32_t spin_us_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> passes_;
+    std::thread thread_;
+};
+#endif
@@ -0,0 +1,239 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Tempo map and beat-timed controller banks for music-synced shows
+ *
+ * Controllers are given on / off lengths in ticks (TEMPO_PPQ per beat, as
+ * in MIDI) instead of milliseconds. A tempo_map lists the tempo changes of
+ * the song; a tempo_bank follows it, tracking the song position in ticks at
+ * the tempo in force:
+ *
+ *   tempo_map map(tempo_us_per_beat(120));
+ *   map.add(32000, tempo_us_per_beat(140));         // faster from 32 s in
+ *   tempo_bank bank(map);
+ *   bank.add(TEMPO_PPQ / 2, TEMPO_PPQ / 2);          // eighth on, eighth off
+ *   bank.update(show_ms);
+ *   encode(bank.states(), bank.size());
+ *
+ * Design:
+ * - Each controller's next edge is a song tick, advanced by whole on / off
+ *   lengths, so edges sit on the beat grid: an edge toggles at the first
+ *   update at or after its tick's time, and rounding to milliseconds never
+ *   carries into the next period (a 142.86 ms triplet at 140 bpm stays one).
+ * - The position is kept in Q16 ticks and re-anchored at each tempo change,
+ *   so a change is O(1): the running on or off period keeps its phase (its
+ *   remaining ticks play at the new tempo) and nothing restarts or glitches.
+ * - update() compares every next edge with the position in one branch-free
+ *   pass, four controllers per SSE2 instruction (scalar fallback).
+ * - update() first moves the position to each due change, so ticks before
+ *   the change run at the old tempo even if updates are sparse. A controller
+ *   left whole lengths behind by a sparse update takes its state from the
+ *   grid instead of replaying the missed edges.
+ * - Map times are show milliseconds from 0 (no wraparound).
+ */
+
+/// Ticks per beat (quarter note)
+constexpr uint32_t TEMPO_PPQ = 960;
+
+/// Microseconds per beat of a tempo in beats per minute
+constexpr uint32_t tempo_us_per_beat(uint32_t bpm) {
+    return bpm == 0 ? 0 : 60000000u / bpm;
+}
+
+struct tempo_change {
+    uint32_t time_ms;
+    uint32_t us_per_beat;
+};
+
+/**
+ * @brief Piecewise-constant tempo over show time
+ */
+struct tempo_map {
+   public:
+    explicit tempo_map(uint32_t initial_us_per_beat) {
+        changes_.push_back(tempo_change{0, initial_us_per_beat});
+    }
+
+    /**
+     * @brief Append a tempo change
+     *
+     * @return false if time_ms is not after the last change or the tempo is 0
+     */
+    bool add(uint32_t time_ms, uint32_t us_per_beat) {
+        if (us_per_beat == 0 || time_ms <= changes_.back().time_ms) {
+            return false;
+        }
+        changes_.push_back(tempo_change{time_ms, us_per_beat});
+        return true;
+    }
+
+    /// Tempo in force at time_ms
+    uint32_t us_per_beat_at(uint32_t time_ms) const {
+        size_t low = 0;
+        size_t high = changes_.size();
+        while (high - low > 1) {
+            size_t const mid = (low + high) / 2;
+            (changes_[mid].time_ms <= time_ms ? low : high) = mid;
+        }
+        return changes_[low].us_per_beat;
+    }
+
+    size_t size() const { return changes_.size(); }
+    tempo_change const& operator[](size_t index) const { return changes_[index]; }
+
+   private:
+    std::vector<tempo_change> changes_;
+};
+
+/**
+ * @brief Bank of controllers whose on / off lengths are in ticks and follow a tempo map
+ */
+struct tempo_bank {
+   public:
+    /// The map is not owned and may grow while the bank runs (live tempo input)
+    explicit tempo_bank(tempo_map const& map)
+        : map_(map),
+          next_change_(1),
+          us_per_beat_(map[0].us_per_beat),
+          anchor_ms_(0),
+          anchor_q16_(0),
+          ticks_(0) {}
+
+    /**
+     * @brief Add a controller with on / off lengths in ticks
+     *
+     * Its pattern starts off at song tick 0, so a controller added mid-song
+     * joins in the state and phase it would have had from the start. A
+     * 0-tick on length (or pattern) never lights.
+     *
+     * @return Index of the controller
+     */
+    size_t add(uint32_t on_ticks, uint32_t off_ticks) {
+        on_ticks_.push_back(on_ticks);
+        off_ticks_.push_back(off_ticks);
+        next_edge_.push_back(0);
+        on_.push_back(0);
+        align(on_.size() - 1);
+        return on_.size() - 1;
+    }
+
+    /**
+     * @brief Apply the tempo changes due by current_time_ms, then update every controller
+     */
+    void update(uint32_t current_time_ms) {
+        while (next_change_ < map_.size() && map_[next_change_].time_ms <= current_time_ms) {
+            tempo_change const& change = map_[next_change_++];
+            toggle_due(position_q16(change.time_ms));
+            set_tempo(change.time_ms, change.us_per_beat);
+        }
+        toggle_due(position_q16(current_time_ms));
+    }
+
+    /**
+     * @brief Change the tempo now, outside the map (e.g. tap tempo)
+     *
+     * Call after update(current_time_ms) so toggles due before the change
+     * happen at the old tempo.
+     */
+    void set_tempo(uint32_t current_time_ms, uint32_t us_per_beat) {
+        if (us_per_beat == 0 || us_per_beat == us_per_beat_) {
+            return;
+        }
+        anchor_q16_ = position_q16(current_time_ms);
+        anchor_ms_ = current_time_ms;
+        us_per_beat_ = us_per_beat;
+    }
+
+    uint32_t us_per_beat() const { return us_per_beat_; }
+
+    /// Song position at the last update, in whole ticks
+    uint32_t ticks() const { return ticks_; }
+
+    /// Song tick of a controller's next toggle
+    uint32_t next_edge(size_t index) const { return next_edge_[index]; }
+
+    bool is_on(size_t index) const { return on_[index] != 0; }
+
+    /// One word per controller, 1 while on
+    uint32_t const* states() const { return on_.data(); }
+
+    size_t size() const { return on_.size(); }
+
+   private:
+    // Ticks since song start at time_ms, Q16; time_ms is not before the anchor
+    uint64_t position_q16(uint32_t time_ms) const {
+        uint64_t const scaled = static_cast<uint64_t>(time_ms - anchor_ms_) * (TEMPO_PPQ * 1000u);
+        uint64_t const whole = scaled / us_per_beat_;
+        uint64_t const fraction = ((scaled % us_per_beat_) << 16) / us_per_beat_;
+        return anchor_q16_ + (whole << 16) + fraction;
+    }
+
+    void toggle_due(uint64_t position_q16) {
+        ticks_ = static_cast<uint32_t>(position_q16 >> 16);
+        size_t const count = on_.size();
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128i const now = _mm_set1_epi32(static_cast<int>(ticks_));
+        __m128i const one = _mm_set1_epi32(1);
+        for (; i + 4 <= count; i += 4) {
+            __m128i const on = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&on_[i]));
+            __m128i const next = _mm_loadu_si128(reinterpret_cast<__m128i const*>(&next_edge_[i]));
+            // Not due while the edge is ahead of the position (signed, so ticks may wrap)
+            __m128i const keep = _mm_cmpgt_epi32(_mm_sub_epi32(next, now), _mm_setzero_si128());
+            __m128i const on_mask = _mm_sub_epi32(_mm_setzero_si128(), on);
+            __m128i const length = _mm_or_si128(
+                _mm_and_si128(on_mask,
+                              _mm_loadu_si128(reinterpret_cast<__m128i const*>(&off_ticks_[i]))),
+                _mm_andnot_si128(on_mask,
+                                 _mm_loadu_si128(reinterpret_cast<__m128i const*>(&on_ticks_[i]))));
+            __m128i const next_edge = _mm_add_epi32(next, _mm_andnot_si128(keep, length));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&on_[i]),
+                             _mm_xor_si128(on, _mm_andnot_si128(keep, one)));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&next_edge_[i]), next_edge);
+            int behind = _mm_movemask_ps(
+                _mm_castsi128_ps(_mm_cmpgt_epi32(one, _mm_sub_epi32(next_edge, now))));
+            for (size_t lane = 0; behind != 0; ++lane, behind >>= 1) {
+                if ((behind & 1) != 0) {
+                    align(i + lane);
+                }
+            }
+        }
+#endif
+        for (; i < count; ++i) {
+            // Leaving on starts the off length and vice versa
+            uint32_t const length = on_[i] != 0 ? off_ticks_[i] : on_ticks_[i];
+            uint32_t const toggle = static_cast<int32_t>(next_edge_[i] - ticks_) > 0 ? 0u : 1u;
+            on_[i] ^= toggle;
+            next_edge_[i] += length & (0u - toggle);
+            if (static_cast<int32_t>(next_edge_[i] - ticks_) <= 0) {
+                align(i);
+            }
+        }
+    }
+
+    // State and next edge of a controller's pattern (off first, from song tick 0) at ticks_
+    void align(size_t index) {
+        uint32_t const period = on_ticks_[index] + off_ticks_[index];
+        uint32_t const phase = period == 0 ? 0 : ticks_ % period;
+        on_[index] = period != 0 && phase >= off_ticks_[index] ? 1u : 0u;
+        next_edge_[index] = ticks_ - phase + (on_[index] != 0 ? period : off_ticks_[index]);
+    }
+
+    tempo_map const& map_;
+    size_t next_change_;
+    uint32_t us_per_beat_;
+    uint32_t anchor_ms_;
+    uint64_t anchor_q16_;
+    uint32_t ticks_;
+    std::vector<uint32_t> on_ticks_;
+    std::vector<uint32_t> off_ticks_;
+    std::vector<uint32_t> next_edge_;
+    std::vector<uint32_t> on_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @brief Temporal dithering of 16-bit levels onto 8-bit outputs
+ *
+ * An 8-bit PWM output has only a handful of steps at low brightness, so a
+ * slow fade visibly stairsteps. The show keeps 16-bit target levels instead,
+ * and once per frame, before the output backend, this pass turns them into
+ * 8-bit values whose average over frames equals the 16-bit level:
+ *
+ *   temporal_dither dither(channels);
+ *   dither.set_level(fog_glow, 300);             // 1.17 of 255, not 1
+ *   uint8_t const* duty = dither.render();       // per frame
+ *   for (c...) pwm.write(c, duty[c]);
+ *
+ * Each channel is a first-order error accumulator: the level in 8.8 fixed
+ * point plus the fraction carried from the previous frame, output the
+ * integer part, carry the fraction. Levels map as level * 255 / 65535
+ * (65535 is exactly 255, 257 * k is exactly k), computed as
+ * level - (level >> 8) so the whole pass is 16-bit adds and shifts, eight
+ * channels per SSE2 instruction (scalar fallback). The average is exact to
+ * 1/256 of an output step.
+ *
+ * Accumulators start at staggered values so channels at the same level do
+ * not flicker in step.
+ */
+struct temporal_dither {
+   public:
+    explicit temporal_dither(size_t channels)
+        : levels_(padded(channels), 0), error_(padded(channels), 0), out_(padded(channels), 0),
+          channels_(channels) {
+        for (size_t i = 0; i < error_.size(); ++i) {
+            error_[i] = static_cast<uint16_t>((i * 167) & 0xFF);
+        }
+    }
+
+    void set_level(size_t channel, uint16_t level) { levels_[channel] = level; }
+    uint16_t level(size_t channel) const { return levels_[channel]; }
+
+    /// Target levels for bulk writers (channels() entries, padding after)
+    uint16_t* levels() { return levels_.data(); }
+
+    /**
+     * @brief Dither one frame
+     *
+     * @return channels() 8-bit outputs, valid until the next render()
+     */
+    uint8_t const* render() {
+        size_t i = 0;
+#if defined(__SSE2__)
+        __m128i const fraction = _mm_set1_epi16(0xFF);
+        for (; i < levels_.size(); i += 16) {
+            __m128i const level_lo =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(&levels_[i]));
+            __m128i const level_hi =
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(&levels_[i + 8]));
+            __m128i const sum_lo = _mm_add_epi16(
+                _mm_sub_epi16(level_lo, _mm_srli_epi16(level_lo, 8)),
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(&error_[i])));
+            __m128i const sum_hi = _mm_add_epi16(
+                _mm_sub_epi16(level_hi, _mm_srli_epi16(level_hi, 8)),
+                _mm_loadu_si128(reinterpret_cast<__m128i const*>(&error_[i + 8])));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&error_[i]),
+                             _mm_and_si128(sum_lo, fraction));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&error_[i + 8]),
+                             _mm_and_si128(sum_hi, fraction));
+            __m128i const out =
+                _mm_packus_epi16(_mm_srli_epi16(sum_lo, 8), _mm_srli_epi16(sum_hi, 8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&out_[i]), out);
+        }
+#endif
+        dither_from(i);
+        return out_.data();
+    }
+
+    /**
+     * @brief Same pass without SIMD (reference for tests and benchmarks)
+     */
+    uint8_t const* render_scalar() {
+        dither_from(0);
+        return out_.data();
+    }
+
+    size_t channels() const { return channels_; }
+
+   private:
+    // Whole SIMD blocks of 16 channels
+    static size_t padded(size_t channels) { return (channels + 15) / 16 * 16; }
+
+    void dither_from(size_t i) {
+        for (; i < levels_.size(); ++i) {
+            uint16_t const sum =
+                static_cast<uint16_t>(levels_[i] - (levels_[i] >> 8) + error_[i]);
+            error_[i] = sum & 0xFF;
+            out_[i] = static_cast<uint8_t>(sum >> 8);
+        }
+    }
+
+    std::vector<uint16_t> levels_;
+    std::vector<uint16_t> error_;
+    std::vector<uint8_t> out_;
+    size_t channels_;
+};
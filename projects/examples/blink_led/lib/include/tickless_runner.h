@@ -0,0 +1,189 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Tickless main loop for battery-powered props: sleep until the next controller edge
+ *
+ * loop() that spins on controller.update(millis()) keeps the CPU awake
+ * between toggles that are hundreds of milliseconds apart. The runner
+ * updates every controller, asks each how long until its next toggle,
+ * and sleeps until the earliest one in the deepest mode the platform allows
+ * for that long:
+ *
+ *   tickless_runner<avr_sleep_platform, blink_controller<led_pin>> runner(sleep, controllers, 4);
+ *   void loop() { runner.step(); }
+ *
+ * avr_sleep_platform.h is the AVR platform (idle until the millis()
+ * deadline, watchdog power-down for long gaps); arduino/blink_led.ino runs on
+ * it. AVR builds need -D__STDC_LIMIT_MACROS: older avr-libc hides UINT32_MAX
+ * from C++ without it.
+ *
+ * The platform (duck-typed like blink_controller's output_pin_t) provides:
+ * - uint32_t millis()
+ * - uint32_t sleep_step_ms(sleep_depth): wake timer resolution, 0 if the depth is unavailable
+ * - bool millis_runs_during(sleep_depth): false if the millis() timer stops
+ * - uint32_t sleep(sleep_depth, ms): sleep up to ms (a multiple of the step),
+ *   return the ms actually slept by the wake timer; in idle, wake on the
+ *   millis() tick that completes ms, so edges stay on the tick
+ *
+ * Design:
+ * - A deep sleep with a coarse wake timer (the AVR watchdog counts in 16 ms
+ *   steps) is rounded down, never past the deadline; the remainder is slept
+ *   in the next shallower mode on the following step.
+ * - Time slept while millis() is stopped is added to a correction, so the
+ *   controllers see a clock that kept running.
+ * - simulated_sleep_platform runs the same loop on the host against a
+ *   virtual clock and a current model, giving average current and battery
+ *   life for a show.
+ */
+
+enum class sleep_depth : uint8_t { none = 0, idle = 1, power_save = 2, power_down = 3 };
+
+template<typename platform_t, typename controller_t>
+struct tickless_runner {
+   public:
+    /**
+     * @param controllers Array of count controllers (not owned)
+     * @param deepest Deepest depth allowed (e.g. idle when PWM timers must keep running)
+     */
+    tickless_runner(platform_t& platform, controller_t* controllers, size_t count,
+                    sleep_depth deepest = sleep_depth::power_down)
+        : platform_(platform),
+          controllers_(controllers),
+          count_(count),
+          deepest_(deepest),
+          correction_ms_(0),
+          wakes_(0) {}
+
+    /// Milliseconds since start, including time millis() missed while asleep
+    uint32_t now() const { return platform_.millis() + correction_ms_; }
+
+    /**
+     * @brief One loop() iteration: update every controller, then sleep until the next edge
+     *
+     * @return Milliseconds slept (0 if an edge is due now or no mode fits)
+     */
+    uint32_t step() {
+        uint32_t const time = now();
+        uint32_t wait = UINT32_MAX;
+        for (size_t i = 0; i < count_; ++i) {
+            controllers_[i].update(time);
+            uint32_t const until = controllers_[i].until_toggle(time);
+            wait = until < wait ? until : wait;
+        }
+        // The updates took time too; the deadline does not move
+        uint32_t const spent = now() - time;
+        wait = wait > spent ? wait - spent : 0;
+        for (uint8_t d = static_cast<uint8_t>(deepest_); d > 0 && wait > 0; --d) {
+            sleep_depth const depth = static_cast<sleep_depth>(d);
+            uint32_t const step_ms = platform_.sleep_step_ms(depth);
+            if (step_ms == 0 || wait < step_ms) {
+                continue;
+            }
+            uint32_t const slept = platform_.sleep(depth, wait - wait % step_ms);
+            if (!platform_.millis_runs_during(depth)) {
+                correction_ms_ += slept;
+            }
+            ++wakes_;
+            return slept;
+        }
+        return 0;
+    }
+
+    uint32_t correction_ms() const { return correction_ms_; }
+    uint32_t wakes() const { return wakes_; }
+
+   private:
+    platform_t& platform_;
+    controller_t* controllers_;
+    size_t count_;
+    sleep_depth deepest_;
+    uint32_t correction_ms_;
+    uint32_t wakes_;
+};
+
+/// Supply current of the board in each state (defaults: ATmega328P at 16 MHz, 5 V)
+struct sleep_power_model {
+    double active_ma = 12.0;
+    double idle_ma = 3.5;
+    double power_save_ma = 0.0;   // needs a Timer2 watch crystal; unused if step is 0
+    double power_down_ma = 0.006;  // watchdog running
+    uint32_t wake_us = 150;        // awake per wake: wake-up latency and the updates
+    uint32_t power_save_step_ms = 0;
+    uint32_t power_down_step_ms = 16;
+};
+
+/**
+ * @brief Host stand-in for the MCU: virtual clock, sleep accounting and battery estimate
+ *
+ * Each sleep() first spends wake_us awake (the step that led to it), then
+ * sleeps. millis() only advances while awake or in idle, as on an AVR whose
+ * Timer0 stops in the deeper modes, and idle ends on a millis() tick.
+ */
+struct simulated_sleep_platform {
+   public:
+    explicit simulated_sleep_platform(sleep_power_model const& model = sleep_power_model())
+        : model_(model), true_us_(0), millis_us_(0), charge_ma_us_(0.0) {
+        for (size_t i = 0; i < 4; ++i) {
+            depth_us_[i] = 0;
+        }
+    }
+
+    uint32_t millis() const { return static_cast<uint32_t>(millis_us_ / 1000); }
+
+    uint32_t sleep_step_ms(sleep_depth depth) const {
+        return depth == sleep_depth::idle         ? 1
+               : depth == sleep_depth::power_save ? model_.power_save_step_ms
+               : depth == sleep_depth::power_down ? model_.power_down_step_ms
+                                                  : 0;
+    }
+
+    bool millis_runs_during(sleep_depth depth) const { return depth == sleep_depth::idle; }
+
+    uint32_t sleep(sleep_depth depth, uint32_t ms) {
+        run(sleep_depth::none, model_.wake_us);
+        uint64_t const us = static_cast<uint64_t>(ms) * 1000;
+        run(depth, depth == sleep_depth::idle ? (millis_us_ / 1000) * 1000 + us - millis_us_ : us);
+        return ms;
+    }
+
+    /// Spend time in a state without sleeping (e.g. awake work outside the runner)
+    void run(sleep_depth depth, uint64_t us) {
+        true_us_ += us;
+        millis_us_ += depth == sleep_depth::none || depth == sleep_depth::idle ? us : 0;
+        depth_us_[static_cast<size_t>(depth)] += us;
+        charge_ma_us_ += current_ma(depth) * static_cast<double>(us);
+    }
+
+    /// Real elapsed time (the reference the corrected clock is checked against)
+    uint64_t true_us() const { return true_us_; }
+
+    uint64_t time_in_us(sleep_depth depth) const { return depth_us_[static_cast<size_t>(depth)]; }
+
+    double average_ma() const {
+        return true_us_ == 0 ? 0.0 : charge_ma_us_ / static_cast<double>(true_us_);
+    }
+
+    /// Hours a battery of capacity_mah lasts at the average current so far
+    double battery_hours(double capacity_mah) const {
+        double const average = average_ma();
+        return average > 0.0 ? capacity_mah / average : 0.0;
+    }
+
+    sleep_power_model const& model() const { return model_; }
+
+   private:
+    double current_ma(sleep_depth depth) const {
+        return depth == sleep_depth::idle         ? model_.idle_ma
+               : depth == sleep_depth::power_save ? model_.power_save_ma
+               : depth == sleep_depth::power_down ? model_.power_down_ma
+                                                  : model_.active_ma;
+    }
+
+    sleep_power_model model_;
+    uint64_t true_us_;
+    uint64_t millis_us_;
+    uint64_t depth_us_[4];
+    double charge_ma_us_;
+};
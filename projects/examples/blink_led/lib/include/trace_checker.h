@@ -0,0 +1,426 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Safety rules checked over simulated show traces
+ *
+ * A simulated run records every output edge (trace_pin into a pin_trace).
+ * The trace is turned into one sorted list of ON intervals per channel
+ * (interval_index), and declarative rules are evaluated over it:
+ *
+ *   max_on   fog 10000               # fog never on for more than 10 s
+ *   exclusive relay_a relay_b        # at most one of these on at a time
+ *   duty     strobe 60000 20000      # strobe on at most 20 s in any 60 s
+ *
+ *   std::vector<trace_violation> violations;
+ *   check_trace_rules(interval_index(trace), rules, violations);
+ *
+ * Every rule is a sweep over sorted intervals: max_on is one pass per
+ * channel, exclusive merges its channels' interval ends in time order, and
+ * duty slides a window whose maximum is only reached where the window
+ * starts at an ON edge or ends at an OFF edge, so it checks those 2n
+ * windows with prefix sums. A night of millions of edges checks in about a
+ * second, even in an unoptimized build.
+ */
+
+/// Output edges of every channel of a simulated run, in time order per channel
+struct pin_trace {
+   public:
+    explicit pin_trace(size_t channels = 0)
+        : edges_(channels), state_(channels, 0), time_ms_(0), end_ms_(0) {}
+
+    /// Time stamped on the following record() calls (call before each frame)
+    void set_time(uint64_t time_ms) {
+        time_ms_ = time_ms;
+        end_ms_ = std::max(end_ms_, time_ms);
+    }
+
+    /**
+     * @brief Note a channel's output at the current time (only changes are kept)
+     */
+    void record(size_t channel, bool on) {
+        uint8_t const state = on ? 1 : 0;
+        if (state_[channel] == state) {
+            return;
+        }
+        state_[channel] = state;
+        edges_[channel].push_back(time_ms_);
+    }
+
+    /// Trace end: intervals still open are closed here
+    void finish(uint64_t end_ms) { end_ms_ = std::max(end_ms_, end_ms); }
+
+    size_t channels() const { return edges_.size(); }
+    /// Edge times of one channel: ON, OFF, ON, ... (outputs start off)
+    std::vector<uint64_t> const& edges(size_t channel) const { return edges_[channel]; }
+    uint64_t end_ms() const { return end_ms_; }
+
+   private:
+    std::vector<std::vector<uint64_t>> edges_;
+    std::vector<uint8_t> state_;
+    uint64_t time_ms_;
+    uint64_t end_ms_;
+};
+
+/**
+ * @brief Output pin that records into a pin_trace
+ *
+ * Drop-in for any pin type: blink_controller<trace_pin> works unchanged.
+ */
+struct trace_pin {
+   public:
+    trace_pin() : trace_(nullptr), channel_(0) {}
+    trace_pin(pin_trace& trace, size_t channel) : trace_(&trace), channel_(channel) {}
+
+    void set(bool state) { trace_->record(channel_, state); }
+
+   private:
+    pin_trace* trace_;
+    size_t channel_;
+};
+
+/// Half-open ON interval [start_ms, end_ms)
+struct on_interval {
+    uint64_t start_ms;
+    uint64_t end_ms;
+};
+
+/**
+ * @brief Sorted ON intervals per channel with prefix sums of ON time
+ *
+ * Zero-length pulses (on and off in the same frame) are dropped: they never
+ * drive an output.
+ */
+struct interval_index {
+   public:
+    explicit interval_index(pin_trace const& trace)
+        : intervals_(trace.channels()), prefix_on_ms_(trace.channels()), end_ms_(trace.end_ms()) {
+        for (size_t channel = 0; channel < trace.channels(); ++channel) {
+            std::vector<uint64_t> const& edges = trace.edges(channel);
+            std::vector<on_interval>& intervals = intervals_[channel];
+            intervals.reserve(edges.size() / 2 + 1);
+            for (size_t i = 0; i < edges.size(); i += 2) {
+                uint64_t const end = i + 1 < edges.size() ? edges[i + 1] : end_ms_;
+                if (end > edges[i]) {
+                    intervals.push_back(on_interval{edges[i], end});
+                }
+            }
+            std::vector<uint64_t>& prefix = prefix_on_ms_[channel];
+            prefix.resize(intervals.size() + 1, 0);
+            for (size_t i = 0; i < intervals.size(); ++i) {
+                prefix[i + 1] = prefix[i] + (intervals[i].end_ms - intervals[i].start_ms);
+            }
+        }
+    }
+
+    size_t channels() const { return intervals_.size(); }
+    std::vector<on_interval> const& intervals(size_t channel) const { return intervals_[channel]; }
+    uint64_t end_ms() const { return end_ms_; }
+
+    /// Whether channel is on at time_ms
+    bool on_at(size_t channel, uint64_t time_ms) const {
+        std::vector<on_interval> const& intervals = intervals_[channel];
+        size_t const i = first_ending_after(intervals, time_ms);
+        return i < intervals.size() && intervals[i].start_ms <= time_ms;
+    }
+
+    /// Total ON time of channel within [from_ms, to_ms)
+    uint64_t on_time(size_t channel, uint64_t from_ms, uint64_t to_ms) const {
+        std::vector<on_interval> const& intervals = intervals_[channel];
+        std::vector<uint64_t> const& prefix = prefix_on_ms_[channel];
+        if (to_ms <= from_ms) {
+            return 0;
+        }
+        size_t const first = first_ending_after(intervals, from_ms);
+        size_t const last = first_ending_after(intervals, to_ms);  // may overlap to_ms
+        uint64_t total = prefix[last] - prefix[first];
+        if (first < last && intervals[first].start_ms < from_ms) {
+            total -= from_ms - intervals[first].start_ms;
+        }
+        if (last < intervals.size() && intervals[last].start_ms < to_ms) {
+            uint64_t const start = std::max(intervals[last].start_ms, from_ms);
+            total += to_ms - start;
+        }
+        return total;
+    }
+
+   private:
+    // First interval with end_ms > time_ms
+    static size_t first_ending_after(std::vector<on_interval> const& intervals, uint64_t time_ms) {
+        size_t low = 0;
+        size_t high = intervals.size();
+        while (low < high) {
+            size_t const mid = low + (high - low) / 2;
+            if (intervals[mid].end_ms <= time_ms) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    std::vector<std::vector<on_interval>> intervals_;
+    std::vector<std::vector<uint64_t>> prefix_on_ms_;
+    uint64_t end_ms_;
+};
+
+enum class trace_rule_kind : uint8_t { max_on = 1, exclusive = 2, duty = 3 };
+
+/**
+ * @brief One declarative safety rule
+ *
+ * - max_on:    no ON interval of channels[0] longer than limit_ms
+ * - exclusive: at most limit_count of channels on at any time
+ * - duty:      channels[0] on for at most limit_ms in any window_ms window
+ */
+struct trace_rule {
+    trace_rule_kind kind;
+    std::vector<size_t> channels;
+    uint64_t limit_ms;
+    uint64_t window_ms;
+    size_t limit_count;
+
+    static trace_rule max_on(size_t channel, uint64_t limit_ms) {
+        return trace_rule{trace_rule_kind::max_on, std::vector<size_t>(1, channel), limit_ms, 0,
+                          0};
+    }
+
+    static trace_rule exclusive(std::vector<size_t> const& channels, size_t limit_count = 1) {
+        return trace_rule{trace_rule_kind::exclusive, channels, 0, 0, limit_count};
+    }
+
+    static trace_rule duty(size_t channel, uint64_t window_ms, uint64_t limit_ms) {
+        return trace_rule{trace_rule_kind::duty, std::vector<size_t>(1, channel), limit_ms,
+                          window_ms, 0};
+    }
+};
+
+/**
+ * @brief A rule broken over [start_ms, end_ms)
+ *
+ * value is the measured quantity: ON time for max_on, the number of channels
+ * on for exclusive (its peak within the span), ON time in the window for duty.
+ * channel is the offending channel (the first of the rule for exclusive).
+ */
+struct trace_violation {
+    size_t rule;
+    size_t channel;
+    uint64_t start_ms;
+    uint64_t end_ms;
+    uint64_t value;
+};
+
+// Unsigned decimal small enough for std::stoull
+inline bool is_number(std::string const& word) {
+    return !word.empty() && word.find_first_not_of("0123456789") == std::string::npos &&
+           word.size() < 19;
+}
+
+/**
+ * @brief Parse rules, one per line ('#' comments, blank lines ignored)
+ *
+ *   max_on    NAME LIMIT_MS
+ *   exclusive NAME NAME... [max COUNT]
+ *   duty      NAME WINDOW_MS LIMIT_MS
+ *
+ * @param channel_names Name of each trace channel (e.g. show_config names)
+ * @param error_line 1-based line of the first malformed rule (0 if none)
+ * @return false on an unknown rule, unknown channel or bad number
+ */
+inline bool parse_trace_rules(std::string const& text,
+                              std::vector<std::string> const& channel_names,
+                              std::vector<trace_rule>& rules, size_t& error_line) {
+    error_line = 0;
+    size_t line = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        ++line;
+        size_t end = text.find('\n', pos);
+        end = end == std::string::npos ? text.size() : end;
+        std::vector<std::string> words;
+        size_t i = pos;
+        while (i < end && text[i] != '#') {
+            if (text[i] == ' ' || text[i] == '\t' || text[i] == '\r') {
+                ++i;
+                continue;
+            }
+            size_t const start = i;
+            while (i < end && text[i] != ' ' && text[i] != '\t' && text[i] != '\r' &&
+                   text[i] != '#') {
+                ++i;
+            }
+            words.push_back(text.substr(start, i - start));
+        }
+        pos = end + 1;
+        if (words.empty()) {
+            continue;
+        }
+
+        // exclusive's "max COUNT" suffix; "max" anywhere else is a channel name
+        size_t max_word = 0;
+        if (words[0] == "exclusive" && words.size() >= 4 && words[words.size() - 2] == "max" &&
+            is_number(words.back())) {
+            max_word = words.size() - 2;
+        }
+        bool ok = true;
+        std::vector<size_t> channels;
+        std::vector<uint64_t> numbers;
+        for (size_t w = 1; w < words.size(); ++w) {
+            std::string const& word = words[w];
+            if (w == max_word) {
+                continue;
+            }
+            if (is_number(word)) {
+                numbers.push_back(std::stoull(word));
+                continue;
+            }
+            std::vector<std::string>::const_iterator const name =
+                std::find(channel_names.begin(), channel_names.end(), word);
+            ok = ok && name != channel_names.end() && numbers.empty();
+            channels.push_back(static_cast<size_t>(name - channel_names.begin()));
+        }
+
+        if (ok && words[0] == "max_on" && channels.size() == 1 && numbers.size() == 1) {
+            rules.push_back(trace_rule::max_on(channels[0], numbers[0]));
+        } else if (ok && words[0] == "exclusive" && channels.size() >= 2 &&
+                   (numbers.empty() || (numbers.size() == 1 && max_word > 0 && numbers[0] > 0))) {
+            rules.push_back(trace_rule::exclusive(
+                channels, numbers.empty() ? 1 : static_cast<size_t>(numbers[0])));
+        } else if (ok && words[0] == "duty" && channels.size() == 1 && numbers.size() == 2 &&
+                   numbers[0] > 0) {
+            rules.push_back(trace_rule::duty(channels[0], numbers[0], numbers[1]));
+        } else {
+            error_line = line;
+            return false;
+        }
+    }
+    return true;
+}
+
+// ON intervals longer than the limit
+inline void check_max_on(interval_index const& index, size_t rule_index, trace_rule const& rule,
+                         std::vector<trace_violation>& violations) {
+    size_t const channel = rule.channels[0];
+    std::vector<on_interval> const& intervals = index.intervals(channel);
+    for (size_t i = 0; i < intervals.size(); ++i) {
+        uint64_t const length = intervals[i].end_ms - intervals[i].start_ms;
+        if (length > rule.limit_ms) {
+            violations.push_back(trace_violation{rule_index, channel, intervals[i].start_ms,
+                                                 intervals[i].end_ms, length});
+        }
+    }
+}
+
+// Sweep the group's edges in time order, reporting spans with too many channels on
+inline void check_exclusive(interval_index const& index, size_t rule_index,
+                            trace_rule const& rule, std::vector<trace_violation>& violations) {
+    struct event {
+        uint64_t time_ms;
+        int delta;
+        bool operator<(event const& other) const {
+            // Offs before ons at the same instant: handing over is not an overlap
+            return time_ms != other.time_ms ? time_ms < other.time_ms : delta < other.delta;
+        }
+    };
+    std::vector<event> events;
+    for (size_t c = 0; c < rule.channels.size(); ++c) {
+        std::vector<on_interval> const& intervals = index.intervals(rule.channels[c]);
+        for (size_t i = 0; i < intervals.size(); ++i) {
+            events.push_back(event{intervals[i].start_ms, 1});
+            events.push_back(event{intervals[i].end_ms, -1});
+        }
+    }
+    std::sort(events.begin(), events.end());
+
+    size_t on = 0;
+    size_t peak = 0;
+    uint64_t start_ms = 0;
+    for (size_t i = 0; i < events.size(); ++i) {
+        on = events[i].delta > 0 ? on + 1 : on - 1;
+        if (on > rule.limit_count) {
+            if (peak == 0) {
+                start_ms = events[i].time_ms;
+            }
+            peak = std::max(peak, on);
+        } else if (peak != 0) {
+            violations.push_back(
+                trace_violation{rule_index, rule.channels[0], start_ms, events[i].time_ms, peak});
+            peak = 0;
+        }
+    }
+}
+
+// Windows starting at an ON edge or ending at an OFF edge, merged into spans
+inline void check_duty(interval_index const& index, size_t rule_index, trace_rule const& rule,
+                       std::vector<trace_violation>& violations) {
+    size_t const channel = rule.channels[0];
+    std::vector<on_interval> const& intervals = index.intervals(channel);
+    uint64_t const window = rule.window_ms;
+    bool open = false;
+    trace_violation current = trace_violation{rule_index, channel, 0, 0, 0};
+
+    // Both candidate sequences are sorted; merge them so spans grow in time order
+    size_t on_edge = 0;
+    size_t off_edge = 0;
+    while (on_edge < intervals.size() || off_edge < intervals.size()) {
+        uint64_t const ending = intervals[std::min(off_edge, intervals.size() - 1)].end_ms;
+        uint64_t const before_off = ending > window ? ending - window : 0;
+        uint64_t from = 0;
+        if (off_edge == intervals.size() ||
+            (on_edge < intervals.size() && intervals[on_edge].start_ms <= before_off)) {
+            from = intervals[on_edge++].start_ms;
+        } else {
+            from = before_off;
+            ++off_edge;
+        }
+        uint64_t const on = index.on_time(channel, from, from + window);
+        if (on <= rule.limit_ms) {
+            continue;
+        }
+        if (open && from <= current.end_ms) {
+            current.end_ms = std::max(current.end_ms, from + window);
+            current.value = std::max(current.value, on);
+            continue;
+        }
+        if (open) {
+            violations.push_back(current);
+        }
+        open = true;
+        current = trace_violation{rule_index, channel, from, from + window, on};
+    }
+    if (open) {
+        violations.push_back(current);
+    }
+}
+
+/**
+ * @brief Evaluate every rule over the trace
+ *
+ * Violations are appended rule by rule, each rule's in time order.
+ * Overlapping duty windows are merged into one span reporting the worst window.
+ *
+ * @return true if no rule is broken
+ */
+inline bool check_trace_rules(interval_index const& index, std::vector<trace_rule> const& rules,
+                              std::vector<trace_violation>& violations) {
+    size_t const before = violations.size();
+    for (size_t r = 0; r < rules.size(); ++r) {
+        switch (rules[r].kind) {
+            case trace_rule_kind::max_on:
+                check_max_on(index, r, rules[r], violations);
+                break;
+            case trace_rule_kind::exclusive:
+                check_exclusive(index, r, rules[r], violations);
+                break;
+            case trace_rule_kind::duty:
+                check_duty(index, r, rules[r], violations);
+                break;
+        }
+    }
+    return violations.size() == before;
+}
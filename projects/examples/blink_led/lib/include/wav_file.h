@@ -0,0 +1,165 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "show_command.h"
+
+/// Where a 16-bit PCM WAV image keeps its samples
+struct wav_layout {
+    uint32_t sample_rate;
+    uint16_t channels;
+    size_t data_offset;  // byte offset of the first sample
+    size_t data_size;    // bytes of sample data
+};
+
+/**
+ * @brief Walk a WAV image's chunks up to its sample data
+ *
+ * @return false if the image is malformed or not 16-bit PCM
+ */
+inline bool parse_wav_layout(uint8_t const* data, size_t size, wav_layout& layout) {
+    wire_reader reader(data, size);
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    reader.skip(12);
+    uint32_t rate = 0;
+    uint16_t channels = 0;
+    bool have_format = false;
+    while (reader.ok() && reader.remaining() >= 8) {
+        uint8_t const* id = data + (size - reader.remaining());
+        reader.skip(4);
+        uint32_t const chunk_size = reader.get_u32();
+        if (chunk_size > reader.remaining()) {
+            return false;
+        }
+        if (std::memcmp(id, "fmt ", 4) == 0 && chunk_size >= 16) {
+            uint16_t const format = reader.get_u16();
+            channels = reader.get_u16();
+            rate = reader.get_u32();
+            reader.skip(6);  // byte rate, block align
+            uint16_t const bits = reader.get_u16();
+            if ((format != 1 && format != 0xFFFE) || bits != 16 || channels == 0) {
+                return false;
+            }
+            have_format = true;
+            reader.skip(chunk_size - 16);
+        } else if (std::memcmp(id, "data", 4) == 0 && have_format) {
+            layout.sample_rate = rate;
+            layout.channels = channels;
+            layout.data_offset = size - reader.remaining();
+            layout.data_size = chunk_size & ~static_cast<size_t>(1);
+            return true;
+        } else {
+            reader.skip(chunk_size);
+        }
+        reader.skip(chunk_size & 1);  // chunks are word aligned
+    }
+    return false;
+}
+
+/**
+ * @brief 16-bit PCM WAV file, loaded whole into interleaved samples
+ *
+ * Covers what show tooling needs: soundtracks and LTC tracks exported from a
+ * DAW as 16-bit PCM (plain or WAVE_FORMAT_EXTENSIBLE). Other sample formats
+ * are rejected rather than converted.
+ */
+struct wav_file {
+   public:
+    wav_file() : sample_rate_(0), channels_(0) {}
+    wav_file(uint32_t sample_rate, uint16_t channels)
+        : sample_rate_(sample_rate), channels_(channels) {}
+
+    /**
+     * @brief Replace this file's contents with a WAV read from disk
+     *
+     * @return false if the file is missing, malformed or not 16-bit PCM
+     */
+    bool load(char const* path) {
+        std::FILE* file = std::fopen(path, "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        std::vector<uint8_t> bytes;
+        uint8_t chunk[65536];
+        size_t n = 0;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            bytes.insert(bytes.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        return parse(bytes.data(), bytes.size());
+    }
+
+    /**
+     * @brief Replace this file's contents with a WAV image in memory
+     *
+     * @return false if the image is malformed or not 16-bit PCM
+     */
+    bool parse(uint8_t const* data, size_t size) {
+        wav_layout layout;
+        if (!parse_wav_layout(data, size, layout)) {
+            return false;
+        }
+        wire_reader reader(data + layout.data_offset, layout.data_size);
+        samples_.resize(layout.data_size / 2);
+        for (size_t i = 0; i < samples_.size(); ++i) {
+            samples_[i] = static_cast<int16_t>(reader.get_u16());
+        }
+        sample_rate_ = layout.sample_rate;
+        channels_ = layout.channels;
+        return true;
+    }
+
+    /**
+     * @brief Write the samples as a 16-bit PCM WAV
+     *
+     * @return false on I/O error
+     */
+    bool save(char const* path) const {
+        uint32_t const data_size = static_cast<uint32_t>(samples_.size() * 2);
+        std::vector<uint8_t> bytes;
+        bytes.reserve(44 + data_size);
+        wire_writer writer(bytes);
+        bytes.insert(bytes.end(), {'R', 'I', 'F', 'F'});
+        writer.put_u32(36 + data_size);
+        bytes.insert(bytes.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+        writer.put_u32(16);
+        writer.put_u16(1);
+        writer.put_u16(channels_);
+        writer.put_u32(sample_rate_);
+        writer.put_u32(sample_rate_ * channels_ * 2);
+        writer.put_u16(static_cast<uint16_t>(channels_ * 2));
+        writer.put_u16(16);
+        bytes.insert(bytes.end(), {'d', 'a', 't', 'a'});
+        writer.put_u32(data_size);
+        for (size_t i = 0; i < samples_.size(); ++i) {
+            writer.put_u16(static_cast<uint16_t>(samples_[i]));
+        }
+
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        bool const ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    uint32_t sample_rate() const { return sample_rate_; }
+    uint16_t channels() const { return channels_; }
+
+    /// Number of sample frames (samples per channel)
+    size_t frames() const { return channels_ == 0 ? 0 : samples_.size() / channels_; }
+
+    /// Interleaved samples
+    std::vector<int16_t>& samples() { return samples_; }
+    std::vector<int16_t> const& samples() const { return samples_; }
+
+   private:
+    uint32_t sample_rate_;
+    uint16_t channels_;
+    std::vector<int16_t> samples_;
+};
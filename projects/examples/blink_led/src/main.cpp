@@ -1,11 +1,54 @@
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <thread>
 
+#include "async_writer.h"
 #include "blink_controller.h"
+#include "clock_recording.h"
 #include "console_simulator.h"
 
+// Configuration
+constexpr uint32_t ON_DURATION_MS = 1000;
+constexpr uint32_t OFF_DURATION_MS = 500;
+constexpr uint32_t SIMULATION_DURATION_MS = 10000;
+constexpr uint32_t UPDATE_INTERVAL_MS = 50;
+
+// Only a replayed clock can run out of readings
+template<typename timer_t>
+bool clock_exhausted(timer_t const&) {
+    return false;
+}
+
+bool clock_exhausted(replay_timer const& timer) { return timer.exhausted(); }
+
+// Nothing to do between frames unless recording
+struct no_frame_hook {
+    void operator()() const {}
+};
+
+/**
+ * @brief Demo main loop, shared by live, recording and replay runs
+ *
+ * Reads the clock in the same order in every mode, so a replay feeds the
+ * controller exactly the readings of the recorded run. frame_done runs after
+ * each frame's output.
+ */
+template<typename timer_t, typename frame_hook_t>
+void run_loop(timer_t& timer, blink_controller<console_led_pin>& controller,
+              console_led_pin const& console_pin, bool real_time, frame_hook_t frame_done) {
+    while (timer.millis() < SIMULATION_DURATION_MS && !clock_exhausted(timer)) {
+        uint32_t const now = timer.millis();
+        controller.update(now);
+        std::cout << console_led_pin::format_output(now, console_pin.get_state()) << std::endl;
+        frame_done();
+        if (real_time) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(UPDATE_INTERVAL_MS));
+        }
+    }
+}
+
 /**
  * @brief Run blink controller demo with console output
  *
@@ -13,15 +56,13 @@
  * to visualize the blink_controller in action.
  *
  * This function is kept as a thin wrapper - all testable logic is in
- * console_simulator.h and blink_controller.h libraries.
+ * console_simulator.h, clock_recording.h and blink_controller.h libraries.
+ *
+ * @param record_path Stream every clock reading to this file (nullptr to skip)
+ * @param replay_path Replay clock readings from this file at full speed (nullptr for live)
+ * @return false if a recording could not be read or written
  */
-void run_demo() {
-    // Configuration
-    constexpr uint32_t ON_DURATION_MS = 1000;
-    constexpr uint32_t OFF_DURATION_MS = 500;
-    constexpr uint32_t SIMULATION_DURATION_MS = 10000;
-    constexpr uint32_t UPDATE_INTERVAL_MS = 50;
-
+bool run_demo(char const* record_path, char const* replay_path) {
     // Create components (all from libraries)
     console_led_pin console_pin;
     real_time_timer timer;
@@ -34,17 +75,42 @@ void run_demo() {
     std::cout << "  ON duration:  " << ON_DURATION_MS << "ms" << std::endl;
     std::cout << "  OFF duration: " << OFF_DURATION_MS << "ms" << std::endl;
     std::cout << "  Total cycle:  " << (ON_DURATION_MS + OFF_DURATION_MS) << "ms" << std::endl;
-    std::cout << "\nRunning for 10 seconds...\n" << std::endl;
 
-    // Synchronize timers
-    timer.reset();
-    console_pin.reset_time();
+    clock_recording recording;
+    if (replay_path != nullptr) {
+        if (!recording.load(replay_path)) {
+            std::cerr << "Cannot read clock recording " << replay_path << std::endl;
+            return false;
+        }
+        std::cout << "\nReplaying " << recording.size() << " clock readings...\n" << std::endl;
+        replay_timer replay(recording);
+        run_loop(replay, controller, console_pin, false, no_frame_hook());
+    } else {
+        std::cout << "\nRunning for 10 seconds...\n" << std::endl;
 
-    // Main demo loop
-    while (timer.millis() < SIMULATION_DURATION_MS) {
-        controller.update(timer.millis());
-        std::cout << console_pin.get_last_output() << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(UPDATE_INTERVAL_MS));
+        // Synchronize timers
+        timer.reset();
+        console_pin.reset_time();
+
+        if (record_path != nullptr) {
+            // Stream readings to the file as the run goes; the loop only copies bytes
+            async_write_service writer;
+            async_file file(writer, async_file::ALIGNMENT, 4, overflow_policy::block);
+            if (!file.open(record_path) || !clock_recording::write_header(file)) {
+                std::cerr << "Cannot write clock recording " << record_path << std::endl;
+                return false;
+            }
+            recording_timer<real_time_timer> recorder(timer, recording);
+            bool streamed = true;
+            run_loop(recorder, controller, console_pin, true,
+                     [&]() { streamed = recording.drain_to(file) && streamed; });
+            if (!file.close() || !streamed) {
+                std::cerr << "Cannot write clock recording " << record_path << std::endl;
+                return false;
+            }
+        } else {
+            run_loop(timer, controller, console_pin, true, no_frame_hook());
+        }
     }
 
     // Print footer
@@ -57,9 +123,23 @@ void run_demo() {
               << std::endl;
     std::cout << "  - Zero runtime overhead (template-based static polymorphism)" << std::endl;
     std::cout << "  - 100% testable business logic\n" << std::endl;
+    return true;
 }
 
-int main() {
-    run_demo();
-    return 0;
+/**
+ * Usage: blink_demo [--record FILE | --replay FILE]
+ * Exit status is 1 if a recording could not be read or written, 2 on bad arguments.
+ */
+int main(int argc, char** argv) {
+    char const* record_path = nullptr;
+    char const* replay_path = nullptr;
+    if (argc == 3 && std::strcmp(argv[1], "--record") == 0) {
+        record_path = argv[2];
+    } else if (argc == 3 && std::strcmp(argv[1], "--replay") == 0) {
+        replay_path = argv[2];
+    } else if (argc != 1) {
+        std::cerr << "usage: " << argv[0] << " [--record FILE | --replay FILE]" << std::endl;
+        return 2;
+    }
+    return run_demo(record_path, replay_path) ? 0 : 1;
 }
@@ -0,0 +1,201 @@
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/sleep.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "avr_mcu_section.h"
+#include "blink_controller.h"
+
+/**
+ * @brief Cycle benchmark of blink_controller on an ATmega328P under simavr
+ *
+ * Built once per AVR_BENCH_VARIANT by avr_bench.sh. Each variant wraps one
+ * controller update in a non-inlined bench_update(), and Timer1 (no
+ * prescaler, so one count per CPU cycle) times every call over a simulated
+ * minute of 1 ms updates. The cost of calling an empty bench_update() is
+ * measured the same way and subtracted, so the numbers are the update body
+ * itself. Results go to the simavr console register as one line:
+ *
+ *   bench <variant> min <cycles> avg <cycles> max <cycles> ram <bytes per controller>
+ *
+ * Variants:
+ * - empty: no controller (flash / RAM baseline for the others)
+ * - port_pin: blink_controller with a pin that writes PORTB directly
+ * - call_pin: blink_controller with a non-inlined set(), like digitalWrite()
+ * - hand_written: the same timing logic on globals, no template, the
+ *   "zero overhead" reference for port_pin
+ * - bank8: eight port_pin controllers per call (cycles are per controller)
+ */
+
+AVR_MCU(F_CPU, "atmega328p");
+AVR_MCU_SIMAVR_CONSOLE(&GPIOR0);
+
+#define AVR_BENCH_EMPTY 0
+#define AVR_BENCH_PORT_PIN 1
+#define AVR_BENCH_CALL_PIN 2
+#define AVR_BENCH_HAND_WRITTEN 3
+#define AVR_BENCH_BANK8 4
+
+#ifndef AVR_BENCH_VARIANT
+#define AVR_BENCH_VARIANT AVR_BENCH_PORT_PIN
+#endif
+
+namespace {
+
+uint32_t const UPDATES = 60000;
+uint32_t const ON_MS = 1000;
+uint32_t const OFF_MS = 500;
+
+void console(char const* text) {
+    while (*text != '\0') {
+        GPIOR0 = static_cast<uint8_t>(*text++);
+    }
+}
+
+void console(uint32_t value) {
+    char digits[11];
+    uint8_t count = 0;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count != 0) {
+        GPIOR0 = static_cast<uint8_t>(digits[--count]);
+    }
+}
+
+struct port_pin {
+    void set(bool state) {
+        if (state) {
+            PORTB |= _BV(PORTB5);
+        } else {
+            PORTB &= static_cast<uint8_t>(~_BV(PORTB5));
+        }
+    }
+};
+
+struct call_pin {
+    __attribute__((noinline)) void set(bool state) {
+        if (state) {
+            PORTB |= _BV(PORTB5);
+        } else {
+            PORTB &= static_cast<uint8_t>(~_BV(PORTB5));
+        }
+    }
+};
+
+#if AVR_BENCH_VARIANT == AVR_BENCH_PORT_PIN
+char const VARIANT[] = "port_pin";
+uint8_t const CONTROLLERS = 1;
+port_pin pin;
+blink_controller<port_pin> controller(pin, ON_MS, OFF_MS);
+size_t const CONTROLLER_BYTES = sizeof(controller);
+
+__attribute__((noinline)) void bench_update(uint32_t now) { controller.update(now); }
+#elif AVR_BENCH_VARIANT == AVR_BENCH_CALL_PIN
+char const VARIANT[] = "call_pin";
+uint8_t const CONTROLLERS = 1;
+call_pin pin;
+blink_controller<call_pin> controller(pin, ON_MS, OFF_MS);
+size_t const CONTROLLER_BYTES = sizeof(controller);
+
+__attribute__((noinline)) void bench_update(uint32_t now) { controller.update(now); }
+#elif AVR_BENCH_VARIANT == AVR_BENCH_HAND_WRITTEN
+char const VARIANT[] = "hand_written";
+uint8_t const CONTROLLERS = 1;
+uint32_t last_toggle_ms = 0;
+bool led_on = false;
+size_t const CONTROLLER_BYTES = sizeof(last_toggle_ms) + sizeof(led_on);
+
+__attribute__((noinline)) void bench_update(uint32_t now) {
+    if (now - last_toggle_ms >= (led_on ? ON_MS : OFF_MS)) {
+        led_on = !led_on;
+        last_toggle_ms = now;
+    }
+    port_pin().set(led_on);
+}
+#elif AVR_BENCH_VARIANT == AVR_BENCH_BANK8
+char const VARIANT[] = "bank8";
+uint8_t const CONTROLLERS = 8;
+port_pin pin;
+blink_controller<port_pin> bank[CONTROLLERS] = {
+    blink_controller<port_pin>(pin, ON_MS, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 10, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 20, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 30, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 40, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 50, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 60, OFF_MS),
+    blink_controller<port_pin>(pin, ON_MS + 70, OFF_MS),
+};
+size_t const CONTROLLER_BYTES = sizeof(bank[0]);
+
+__attribute__((noinline)) void bench_update(uint32_t now) {
+    for (uint8_t i = 0; i < CONTROLLERS; ++i) {
+        bank[i].update(now);
+    }
+}
+#else
+char const VARIANT[] = "empty";
+uint8_t const CONTROLLERS = 1;
+size_t const CONTROLLER_BYTES = 0;
+
+__attribute__((noinline)) void bench_update(uint32_t now) { asm volatile("" ::"r"(now)); }
+#endif
+
+__attribute__((noinline)) void empty_update(uint32_t now) { asm volatile("" ::"r"(now)); }
+
+// Timer1 counts of one call to update(now)
+template<typename update_t>
+uint16_t time_call(update_t update, uint32_t now) {
+    uint16_t const start = TCNT1;
+    asm volatile("" ::: "memory");
+    update(now);
+    asm volatile("" ::: "memory");
+    return static_cast<uint16_t>(TCNT1 - start);
+}
+
+}  // namespace
+
+int main() {
+    cli();
+    DDRB |= _BV(DDB5);
+    TCCR1A = 0;
+    TCCR1B = _BV(CS10);  // clk/1
+
+    uint16_t overhead = UINT16_MAX;
+    for (uint8_t i = 0; i < 32; ++i) {
+        uint16_t const cycles = time_call(empty_update, i);
+        overhead = cycles < overhead ? cycles : overhead;
+    }
+
+    uint16_t min_cycles = UINT16_MAX;
+    uint16_t max_cycles = 0;
+    uint32_t total = 0;
+    for (uint32_t now = 0; now < UPDATES; ++now) {
+        uint16_t const measured = time_call(bench_update, now);
+        uint16_t const cycles =
+            measured > overhead ? static_cast<uint16_t>(measured - overhead) : 0;
+        min_cycles = cycles < min_cycles ? cycles : min_cycles;
+        max_cycles = cycles > max_cycles ? cycles : max_cycles;
+        total += cycles;
+    }
+
+    console("bench ");
+    console(VARIANT);
+    console(" min ");
+    console(static_cast<uint32_t>(min_cycles / CONTROLLERS));
+    console(" avg ");
+    console(static_cast<uint32_t>((total / UPDATES + CONTROLLERS / 2) / CONTROLLERS));
+    console(" max ");
+    console(static_cast<uint32_t>(max_cycles / CONTROLLERS));
+    console(" ram ");
+    console(static_cast<uint32_t>(CONTROLLER_BYTES));
+    console("\n");
+
+    // Sleeping with interrupts off ends the simulation
+    sleep_enable();
+    sleep_cpu();
+    return 0;
+}
@@ -0,0 +1,78 @@
+#!/bin/sh
+# AVR benchmark of blink_controller: cycles per update(), flash and RAM on an
+# ATmega328P under simavr. Builds test/avr/avr_bench.cpp once per variant,
+# runs each in the simulator and prints a markdown table for the current
+# commit, which is also appended to the history file for comparison.
+#
+# Usage: avr_bench.sh <source dir> <output dir> [history file]
+# Tools: AVR_GXX, AVR_SIZE, SIMAVR, SIMAVR_INCLUDE_DIR (defaults from PATH)
+#
+# Run through the avr_bench target (cmake -DBUILD_AVR_BENCH=ON), which finds
+# the tools at configure time.
+set -eu
+
+SOURCE_DIR=$1
+OUTPUT_DIR=$2
+HISTORY=${3:-$OUTPUT_DIR/avr_bench_history.md}
+AVR_GXX=${AVR_GXX:-avr-g++}
+AVR_SIZE=${AVR_SIZE:-avr-size}
+SIMAVR=${SIMAVR:-simavr}
+SIMAVR_INCLUDE_DIR=${SIMAVR_INCLUDE_DIR:-/usr/include/simavr/avr}
+MCU=atmega328p
+F_CPU=16000000UL
+
+mkdir -p "$OUTPUT_DIR"
+COMMIT=$(git -C "$SOURCE_DIR" rev-parse --short HEAD 2>/dev/null || echo unknown)
+if ! git -C "$SOURCE_DIR" diff --quiet HEAD -- 2>/dev/null; then
+    COMMIT="$COMMIT+dirty"
+fi
+
+# Section sizes of an ELF: flash is .text + .data, RAM is .data + .bss
+section() {
+    "$AVR_SIZE" -A "$1" |
+        awk -v name="$2" '$1 == name { print $2; found = 1 } END { if (!found) print 0 }'
+}
+
+TABLE=$OUTPUT_DIR/avr_bench_table.md
+{
+    echo "### $COMMIT ($MCU, avr-g++ -Os, $("$AVR_GXX" -dumpversion))"
+    echo
+    echo "| variant | cycles min | cycles avg | cycles max | flash (+B) | RAM (+B)" \
+        "| B / controller |"
+    echo "|---|---:|---:|---:|---:|---:|---:|"
+} > "$TABLE"
+
+BASE_FLASH=0
+BASE_RAM=0
+VARIANT=0
+for NAME in empty port_pin call_pin hand_written bank8; do
+    ELF=$OUTPUT_DIR/avr_bench_$NAME.elf
+    "$AVR_GXX" -mmcu=$MCU -DF_CPU=$F_CPU -DAVR_BENCH_VARIANT=$VARIANT -D__STDC_LIMIT_MACROS \
+        -Os -std=gnu++11 -fno-threadsafe-statics \
+        -Wl,--undefined=_mmcu,--section-start=.mmcu=0x910000 \
+        -I"$SOURCE_DIR/test/avr" -I"$SOURCE_DIR/lib/include" -I"$SIMAVR_INCLUDE_DIR" \
+        "$SOURCE_DIR/test/avr/avr_bench.cpp" -o "$ELF"
+
+    FLASH=$(( $(section "$ELF" .text) + $(section "$ELF" .data) ))
+    RAM=$(( $(section "$ELF" .data) + $(section "$ELF" .bss) ))
+    if [ "$NAME" = empty ]; then
+        BASE_FLASH=$FLASH
+        BASE_RAM=$RAM
+    fi
+
+    # simavr echoes console lines to stderr; the firmware ends itself by sleeping
+    LINE=$(timeout 120 "$SIMAVR" "$ELF" 2>&1 | grep -o 'bench .*' | head -n 1 || true)
+    if [ -z "$LINE" ]; then
+        echo "avr_bench: no result from $NAME under $SIMAVR" >&2
+        exit 1
+    fi
+    echo "$LINE" | awk -v flash=$((FLASH - BASE_FLASH)) -v ram=$((RAM - BASE_RAM)) \
+        '{ printf "| %s | %s | %s | %s | %d | %d | %s |\n", $2, $4, $6, $8, flash, ram, $10 }' \
+        >> "$TABLE"
+    VARIANT=$((VARIANT + 1))
+done
+
+echo >> "$TABLE"
+cat "$TABLE"
+cat "$TABLE" >> "$HISTORY"
+echo "Appended to $HISTORY"
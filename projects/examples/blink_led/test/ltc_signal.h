@@ -0,0 +1,118 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "ltc_decoder.h"
+
+/**
+ * @brief LTC generator for tests (stands in for the media player's output)
+ *
+ * Emits biphase-mark square waves at any sample rate and frame rate,
+ * including non-integer samples per bit, so decoder tests can cover 24/25/30
+ * fps, 29.97 drop-frame and varispeed.
+ */
+struct ltc_signal {
+   public:
+    /**
+     * @param sample_rate Output sample rate
+     * @param frames_per_second Actual frame rate (e.g. 25, 29.97, 25 * 1.05 for varispeed)
+     * @param amplitude Peak sample value
+     */
+    ltc_signal(uint32_t sample_rate, double frames_per_second, int16_t amplitude)
+        : samples_per_half_bit_(sample_rate / frames_per_second / 160.0),
+          amplitude_(amplitude),
+          level_(false),
+          time_(0.0),
+          emitted_(0) {}
+
+    /**
+     * @brief Append one 80-bit frame
+     */
+    void append_frame(ltc_timecode const& timecode, std::vector<int16_t>& out) {
+        uint8_t bits[80] = {};
+        put(bits, 0, 4, timecode.frames % 10);
+        put(bits, 8, 2, timecode.frames / 10);
+        put(bits, 10, 1, timecode.drop_frame ? 1 : 0);
+        put(bits, 16, 4, timecode.seconds % 10);
+        put(bits, 24, 3, timecode.seconds / 10);
+        put(bits, 32, 4, timecode.minutes % 10);
+        put(bits, 40, 3, timecode.minutes / 10);
+        put(bits, 48, 4, timecode.hours % 10);
+        put(bits, 56, 2, timecode.hours / 10);
+        put(bits, 64, 16, ltc_decoder::SYNC_WORD);
+        for (int i = 0; i < 80; ++i) {
+            level_ = !level_;  // every bit starts with a transition
+            half(out);
+            if (bits[i]) {
+                level_ = !level_;  // ones have a second transition mid-bit
+            }
+            half(out);
+        }
+    }
+
+    /**
+     * @brief Append count consecutive frames starting at timecode
+     *
+     * @return The timecode following the last appended frame
+     */
+    ltc_timecode append_frames(ltc_timecode timecode, uint32_t fps, size_t count,
+                               std::vector<int16_t>& out) {
+        for (size_t i = 0; i < count; ++i) {
+            append_frame(timecode, out);
+            timecode = next(timecode, fps);
+        }
+        return timecode;
+    }
+
+    /**
+     * @brief Append silence (keeps the sample clock running)
+     */
+    void append_silence(size_t count, std::vector<int16_t>& out) {
+        out.insert(out.end(), count, 0);
+        emitted_ += count;
+        time_ = static_cast<double>(emitted_);
+    }
+
+    /**
+     * @brief Timecode of the frame after timecode (drop-frame aware)
+     */
+    static ltc_timecode next(ltc_timecode timecode, uint32_t fps) {
+        if (++timecode.frames < fps) {
+            return timecode;
+        }
+        timecode.frames = 0;
+        if (++timecode.seconds == 60) {
+            timecode.seconds = 0;
+            if (++timecode.minutes == 60) {
+                timecode.minutes = 0;
+                timecode.hours = static_cast<uint8_t>((timecode.hours + 1) % 24);
+            }
+            if (timecode.drop_frame && timecode.minutes % 10 != 0) {
+                timecode.frames = 2;
+            }
+        }
+        return timecode;
+    }
+
+   private:
+    static void put(uint8_t* bits, int offset, int width, uint32_t value) {
+        for (int i = 0; i < width; ++i) {
+            bits[offset + i] = (value >> i) & 1;
+        }
+    }
+
+    void half(std::vector<int16_t>& out) {
+        time_ += samples_per_half_bit_;
+        int16_t const value = level_ ? amplitude_ : static_cast<int16_t>(-amplitude_);
+        while (static_cast<double>(emitted_) < time_) {
+            out.push_back(value);
+            ++emitted_;
+        }
+    }
+
+    double samples_per_half_bit_;
+    int16_t amplitude_;
+    bool level_;
+    double time_;
+    uint64_t emitted_;
+};
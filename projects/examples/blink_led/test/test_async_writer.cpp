@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "async_writer.h"
+#include "clock_recording.h"
+
+namespace {
+
+std::vector<uint8_t> read_file(char const* path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(in),
+                                std::istreambuf_iterator<char>());
+}
+
+// Self-checking record: sequence number, length, payload derived from both
+std::vector<uint8_t> make_record(uint32_t sequence, uint32_t payload) {
+    std::vector<uint8_t> record(8 + payload);
+    std::memcpy(record.data(), &sequence, 4);
+    std::memcpy(record.data() + 4, &payload, 4);
+    for (uint32_t i = 0; i < payload; ++i) {
+        record[8 + i] = static_cast<uint8_t>(sequence * 31 + i);
+    }
+    return record;
+}
+
+// Walks a file of records; false if any record is torn or out of order
+bool records_intact(std::vector<uint8_t> const& bytes, size_t& count) {
+    size_t pos = 0;
+    uint32_t last = 0;
+    count = 0;
+    while (pos < bytes.size()) {
+        uint32_t sequence = 0;
+        uint32_t payload = 0;
+        if (bytes.size() - pos < 8) {
+            return false;
+        }
+        std::memcpy(&sequence, bytes.data() + pos, 4);
+        std::memcpy(&payload, bytes.data() + pos + 4, 4);
+        if (bytes.size() - pos - 8 < payload || (count > 0 && sequence <= last)) {
+            return false;
+        }
+        for (uint32_t i = 0; i < payload; ++i) {
+            if (bytes[pos + 8 + i] != static_cast<uint8_t>(sequence * 31 + i)) {
+                return false;
+            }
+        }
+        last = sequence;
+        pos += 8 + payload;
+        ++count;
+    }
+    return true;
+}
+
+class async_writer_test : public ::testing::TestWithParam<async_backend> {};
+
+}  // namespace
+
+// Test every byte arrives in order with block policy, whichever backend is active
+TEST_P(async_writer_test, writes_everything_in_order) {
+    async_write_service service(GetParam(), 2);
+    std::printf("backend: %s\n",
+                service.backend() == async_backend::io_uring ? "io_uring" : "thread_pool");
+    char const* path = "test_async_writer_order.bin";
+    std::vector<uint8_t> expected;
+    {
+        async_file file(service, 4096, 4, overflow_policy::block);
+        ASSERT_TRUE(file.open(path));
+        for (uint32_t i = 0; i < 5000; ++i) {
+            std::vector<uint8_t> const record = make_record(i + 1, i % 300);
+            ASSERT_TRUE(file.write(record.data(), record.size()));
+            expected.insert(expected.end(), record.begin(), record.end());
+        }
+        EXPECT_TRUE(file.close());
+        EXPECT_EQ(file.bytes_written(), expected.size());
+        EXPECT_EQ(file.drops(), 0u);
+        EXPECT_LE(file.max_in_flight(), 4u);
+    }
+    EXPECT_EQ(read_file(path), expected);
+    std::remove(path);
+}
+
+// Test several files share the service concurrently from their own threads
+TEST_P(async_writer_test, concurrent_producers) {
+    async_write_service service(GetParam(), 2);
+    size_t const FILES = 4;
+    std::vector<std::thread> producers;
+    std::vector<uint64_t> sizes(FILES, 0);
+    for (size_t f = 0; f < FILES; ++f) {
+        producers.emplace_back([&service, &sizes, f]() {
+            char path[64];
+            std::snprintf(path, sizeof(path), "test_async_writer_%zu.bin", f);
+            async_file file(service, 8192, 4, overflow_policy::block);
+            if (!file.open(path)) {
+                return;
+            }
+            for (uint32_t i = 0; i < 2000; ++i) {
+                std::vector<uint8_t> const record = make_record(i + 1, (i * 7 + f) % 500);
+                file.write(record.data(), record.size());
+            }
+            file.close();
+            sizes[f] = file.bytes_written();
+        });
+    }
+    for (size_t f = 0; f < FILES; ++f) {
+        producers[f].join();
+    }
+    for (size_t f = 0; f < FILES; ++f) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "test_async_writer_%zu.bin", f);
+        std::vector<uint8_t> const bytes = read_file(path);
+        size_t count = 0;
+        EXPECT_TRUE(records_intact(bytes, count)) << f;
+        EXPECT_EQ(count, 2000u);
+        EXPECT_EQ(bytes.size(), sizes[f]);
+        std::remove(path);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(backends, async_writer_test,
+                         ::testing::Values(async_backend::thread_pool, async_backend::io_uring));
+
+// Test a clock recording streamed through the writer matches save()
+TEST(async_writer_policy_test, streams_clock_recording) {
+    async_write_service service;
+    char const* streamed_path = "test_async_writer_streamed.clkr";
+    char const* saved_path = "test_async_writer_saved.clkr";
+    clock_recording streamed;
+    clock_recording whole;
+    async_file file(service, 4096, 4, overflow_policy::block);
+    ASSERT_TRUE(file.open(streamed_path));
+    ASSERT_TRUE(clock_recording::write_header(file));
+    for (uint32_t i = 0; i < 10000; ++i) {
+        uint32_t const reading = i * 50 + i % 7;
+        streamed.append(reading);
+        whole.append(reading);
+        if (i % 16 == 15) {
+            ASSERT_TRUE(streamed.drain_to(file));
+        }
+    }
+    ASSERT_TRUE(streamed.drain_to(file));
+    EXPECT_TRUE(streamed.bytes().empty());
+    EXPECT_TRUE(file.close());
+    ASSERT_TRUE(whole.save(saved_path));
+    EXPECT_EQ(read_file(streamed_path), read_file(saved_path));
+    std::remove(streamed_path);
+    std::remove(saved_path);
+}
+
+// Test records larger than every free buffer are dropped whole, never torn
+TEST(async_writer_policy_test, drop_is_all_or_nothing) {
+    async_write_service service(async_backend::thread_pool, 1);
+    char const* path = "test_async_writer_drop.bin";
+    async_file file(service, 4096, 2, overflow_policy::drop);
+    ASSERT_TRUE(file.open(path));
+    std::vector<uint8_t> const huge = make_record(1, 3 * 4096);
+    EXPECT_FALSE(file.write(huge.data(), huge.size()));
+    EXPECT_EQ(file.drops(), 1u);
+    EXPECT_EQ(file.bytes_dropped(), huge.size());
+
+    // Flood: whatever is kept must be whole records in order
+    uint64_t offered = 0;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        std::vector<uint8_t> const record = make_record(i + 2, 1000 + i % 2000);
+        file.write(record.data(), record.size());
+        offered += record.size();
+    }
+    EXPECT_TRUE(file.close());
+    EXPECT_EQ(file.bytes_written() + file.bytes_dropped(), offered + huge.size());
+    std::vector<uint8_t> const bytes = read_file(path);
+    size_t count = 0;
+    EXPECT_TRUE(records_intact(bytes, count));
+    std::printf("flood: kept %zu of 5000 records, %llu drops\n", count,
+                static_cast<unsigned long long>(file.drops()));
+    std::remove(path);
+}
+
+// Test failed writes are counted and reported by close()
+TEST(async_writer_policy_test, write_errors) {
+    async_write_service service(async_backend::thread_pool, 1);
+    async_file missing(service, 4096, 2);
+    EXPECT_FALSE(missing.open("no_such_directory/trace.bin"));
+    EXPECT_FALSE(missing.write("x", 1));
+
+    // No buffers: open() fails and leaves the file closed, so write() can't wait for one
+    async_file unbuffered(service, 4096, 0, overflow_policy::block);
+    EXPECT_FALSE(unbuffered.open("unbuffered.bin"));
+    EXPECT_FALSE(unbuffered.write("x", 1));
+    EXPECT_TRUE(unbuffered.close());
+
+    async_file full(service, 4096, 2, overflow_policy::block);
+    ASSERT_TRUE(full.open("/dev/full"));
+    std::vector<uint8_t> const block(8192, 0x55);
+    EXPECT_TRUE(full.write(block.data(), block.size()));
+    EXPECT_FALSE(full.close());
+    EXPECT_EQ(full.write_errors(), 2u);
+    EXPECT_EQ(full.bytes_written(), 0u);
+
+    // A reopened file starts with a clean error count
+    char const* path = "test_async_writer_reopen.bin";
+    ASSERT_TRUE(full.open(path));
+    EXPECT_EQ(full.write_errors(), 0u);
+    EXPECT_TRUE(full.write(block.data(), block.size()));
+    EXPECT_TRUE(full.close());
+    std::remove(path);
+}
+
+// Test only fetches that actually block count as backpressure waits
+TEST(async_writer_policy_test, backpressure_counts_blocking_waits) {
+    async_write_service service(async_backend::thread_pool, 1);
+    char const* path = "test_async_writer_backpressure.bin";
+    async_file file(service, 4096, 2, overflow_policy::block);
+    ASSERT_TRUE(file.open(path));
+    std::vector<uint8_t> const block(4096, 0x33);
+
+    // Paced writes: each completes before the next, so nobody waits for its post
+    for (uint64_t i = 1; i <= 100; ++i) {
+        ASSERT_TRUE(file.write(block.data(), block.size()));
+        while (file.buffers_written() < i) {
+            std::this_thread::yield();
+        }
+    }
+    EXPECT_EQ(file.backpressure_waits(), 0u);
+
+    // Burst: at most one wait per buffer fetched, however many posts piled up before
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(file.write(block.data(), block.size()));
+    }
+    EXPECT_LE(file.backpressure_waits(), 10u);
+    EXPECT_TRUE(file.close());
+    EXPECT_EQ(file.bytes_written(), 110u * 4096);
+    std::remove(path);
+}
+
+// Test buffer sizes are page multiples
+TEST(async_writer_policy_test, buffer_size_alignment) {
+    async_write_service service(async_backend::thread_pool, 1);
+    async_file small(service, 100, 1);
+    EXPECT_EQ(small.buffer_size(), 4096u);
+    async_file odd(service, 70000, 1);
+    EXPECT_EQ(odd.buffer_size(), 73728u);
+}
+
+// Test the producer's cost per record stays at memcpy level
+TEST(async_writer_policy_test, producer_latency) {
+    async_write_service service;
+    char const* path = "test_async_writer_latency.bin";
+    async_file file(service, 1 << 16, 8, overflow_policy::drop);
+    ASSERT_TRUE(file.open(path));
+    std::vector<uint8_t> const record = make_record(1, 56);
+    std::vector<double> samples;
+    samples.reserve(100000);
+    for (int i = 0; i < 100000; ++i) {
+        auto const start = std::chrono::steady_clock::now();
+        file.write(record.data(), record.size());
+        samples.push_back(
+            std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                .count());
+    }
+    EXPECT_TRUE(file.close());
+    std::sort(samples.begin(), samples.end());
+    std::printf("write(64 B): p50 %.0f ns, p99 %.0f ns, max %.0f ns, %llu drops\n",
+                samples[samples.size() / 2], samples[samples.size() * 99 / 100],
+                samples.back(), static_cast<unsigned long long>(file.drops()));
+    EXPECT_EQ(file.bytes_written() + file.bytes_dropped(), 100000u * record.size());
+    std::remove(path);
+}
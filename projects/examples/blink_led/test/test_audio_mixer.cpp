@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "audio_mixer.h"
+#include "blink_controller.h"
+#include "mock_hardware.h"
+
+namespace {
+
+uint32_t const RATE = 48000;
+
+// Track whose first frame is a full-scale click, then silence
+std::vector<int16_t> click_track(uint16_t channels, size_t frames) {
+    std::vector<int16_t> samples(frames * channels, 0);
+    for (uint16_t c = 0; c < channels; ++c) {
+        samples[c] = 16384;
+    }
+    return samples;
+}
+
+// Sample positions where the left or right channel jumps above half of level
+std::vector<size_t> clicks(std::vector<float> const& stereo, size_t side, float level) {
+    std::vector<size_t> found;
+    for (size_t i = 0; i * 2 + side < stereo.size(); ++i) {
+        if (stereo[i * 2 + side] > level / 2) {
+            found.push_back(i);
+        }
+    }
+    return found;
+}
+
+struct capture_sink {
+    std::vector<float> samples;
+    void operator()(float const* block, size_t frames) {
+        samples.insert(samples.end(), block, block + 2 * frames);
+    }
+};
+
+struct null_sink {
+    void operator()(float const*, size_t) {}
+};
+
+}  // namespace
+
+// Test the SIMD mix equals the scalar mix for mono and stereo, any length
+TEST(audio_mixer_test, simd_matches_scalar) {
+    std::mt19937 rng(87);
+    for (uint16_t channels = 1; channels <= 2; ++channels) {
+        for (size_t frames = 0; frames < 40; ++frames) {
+            std::vector<int16_t> source(frames * channels);
+            for (size_t i = 0; i < source.size(); ++i) {
+                source[i] = static_cast<int16_t>(rng());
+            }
+            std::vector<float> simd(2 * frames + 2, 1.5f);
+            std::vector<float> scalar(simd);
+            audio_mix_add(source.data(), channels, frames, 0.25f, -0.75f, simd.data());
+            audio_mix_add_scalar(source.data(), channels, frames, 0.25f, -0.75f, scalar.data());
+            ASSERT_EQ(simd, scalar) << channels << "ch " << frames;
+        }
+    }
+    int16_t const extremes[] = {-32768, 32767, -1, 0};
+    std::vector<float> out(8, 0.0f);
+    audio_mix_add(extremes, 1, 4, 1.0f, 2.0f, out.data());
+    EXPECT_EQ(out[0], -32768.0f);
+    EXPECT_EQ(out[1], -65536.0f);
+    EXPECT_EQ(out[3], 65534.0f);
+}
+
+// Test WAV files are used in place through a memory mapping
+TEST(audio_mixer_test, mapped_wav) {
+    char const* path = "test_audio_mixer_effect.wav";
+    wav_file wav(RATE, 2);
+    for (int i = 0; i < 1000; ++i) {
+        wav.samples().push_back(static_cast<int16_t>(i));
+        wav.samples().push_back(static_cast<int16_t>(-i));
+    }
+    ASSERT_TRUE(wav.save(path));
+
+    mapped_wav mapped;
+    ASSERT_TRUE(mapped.open(path));
+    EXPECT_EQ(mapped.frames(), 1000u);
+    EXPECT_EQ(mapped.channels(), 2u);
+    EXPECT_EQ(mapped.sample_rate(), RATE);
+    EXPECT_EQ(mapped.samples()[2 * 999], 999);
+    EXPECT_EQ(mapped.samples()[2 * 999 + 1], -999);
+
+    audio_mixer mixer(RATE);
+    audio_mixer::track_id id = 0;
+    EXPECT_TRUE(mixer.add_track(mapped, id));
+    audio_mixer other_rate(44100);
+    EXPECT_FALSE(other_rate.add_track(mapped, id));
+
+    EXPECT_FALSE(mapped.open("no_such_effect.wav"));
+    std::FILE* file = std::fopen(path, "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("RIFF....WAVEjunk", file);
+    std::fclose(file);
+    EXPECT_FALSE(mapped.open(path));
+    EXPECT_EQ(mapped.samples(), nullptr);
+    std::remove(path);
+}
+
+// Test cues start on their exact sample, with gain and constant-power pan
+TEST(audio_mixer_test, sample_accurate_cues) {
+    std::vector<int16_t> const mono = click_track(1, 100);
+    std::vector<int16_t> const stereo = click_track(2, 100);
+    audio_mixer mixer(RATE);
+    audio_mixer::track_id mono_id = 0;
+    audio_mixer::track_id stereo_id = 0;
+    ASSERT_TRUE(mixer.add_track(mono.data(), 1, 100, RATE, mono_id));
+    ASSERT_TRUE(mixer.add_track(stereo.data(), 2, 100, RATE, stereo_id));
+
+    EXPECT_EQ(mixer.sample_at(1234), 59232u);
+    ASSERT_TRUE(mixer.cue(mono_id, 1234, 1.0f, -1.0f));  // hard left
+    ASSERT_TRUE(mixer.cue(stereo_id, 1500, 0.5f, 0.0f));
+    ASSERT_TRUE(mixer.cue_at_sample(mono_id, 72001, 1.0f, 1.0f));  // hard right
+
+    std::vector<float> output;
+    std::vector<float> block(2 * 256);
+    while (mixer.position() < 80000) {
+        mixer.render(block.data(), 256);
+        output.insert(output.end(), block.begin(), block.end());
+    }
+    std::vector<size_t> const left = clicks(output, 0, 16384.0f * 0.5f * 0.7071f);
+    std::vector<size_t> const right = clicks(output, 1, 16384.0f * 0.5f * 0.7071f);
+    EXPECT_EQ(left, (std::vector<size_t>{59232, 72000}));
+    EXPECT_EQ(right, (std::vector<size_t>{72000, 72001}));
+    EXPECT_NEAR(output[2 * 59232], 16384.0f, 0.5f);
+    EXPECT_NEAR(output[2 * 59232 + 1], 0.0f, 0.01f);
+    EXPECT_NEAR(output[2 * 72000], 16384.0f * 0.5f * 0.70710678f, 0.5f);
+    EXPECT_EQ(mixer.active_voices(), 0u);
+    EXPECT_EQ(mixer.cues_late(), 0u);
+}
+
+// Test start_at() ties the device stream to the show clock, output latency included
+TEST(audio_mixer_test, start_at_anchors_show_time) {
+    std::vector<int16_t> const click = click_track(1, 16);
+    audio_mixer mixer(RATE);
+    audio_mixer::track_id id = 0;
+    ASSERT_TRUE(mixer.add_track(click.data(), 1, 16, RATE, id));
+
+    // Device starts at show time 10 s and is heard 5 ms (240 frames) after each pull
+    uint32_t const LATENCY = 240;
+    mixer.start_at(10000, LATENCY);
+    EXPECT_EQ(mixer.position(), mixer.sample_at(10000) + LATENCY);
+    ASSERT_TRUE(mixer.cue(id, 10100, 1.0f, -1.0f));
+    ASSERT_TRUE(mixer.cue(id, 10001, 1.0f, -1.0f));  // heard before the device can play it
+
+    std::vector<float> stream;  // what the device pulls, from its first frame
+    std::vector<float> block(2 * 256);
+    for (int i = 0; i < 30; ++i) {
+        mixer.render(block.data(), 256);
+        stream.insert(stream.end(), block.begin(), block.end());
+    }
+    std::vector<size_t> const found = clicks(stream, 0, 16384.0f);
+    ASSERT_EQ(found.size(), 1u);
+    // Pulled frame k is heard at 10 s + (k + LATENCY) / RATE: exactly 10.1 s
+    EXPECT_EQ(found[0] + LATENCY, mixer.sample_at(10100) - mixer.sample_at(10000));
+    EXPECT_EQ(mixer.cues_late(), 1u);
+}
+
+// Test a late cue joins at the current sample with its opening skipped
+TEST(audio_mixer_test, late_cues_stay_aligned) {
+    std::vector<int16_t> ramp(1000);
+    for (size_t i = 0; i < ramp.size(); ++i) {
+        ramp[i] = static_cast<int16_t>(i + 1);
+    }
+    audio_mixer mixer(RATE, 1);
+    audio_mixer::track_id id = 0;
+    ASSERT_TRUE(mixer.add_track(ramp.data(), 1, ramp.size(), RATE, id));
+    std::vector<float> block(2 * 128);
+    mixer.render(block.data(), 128);
+    mixer.render(block.data(), 128);
+
+    // Cued for sample 200, but 256 samples have been mixed already
+    ASSERT_TRUE(mixer.cue_at_sample(id, 200, 1.0f, -1.0f));
+    ASSERT_TRUE(mixer.cue_at_sample(id, 300));  // no free voice
+    mixer.render(block.data(), 128);
+    EXPECT_EQ(mixer.cues_late(), 1u);
+    EXPECT_EQ(mixer.voices_dropped(), 1u);
+    EXPECT_FLOAT_EQ(block[0], 57.0f);  // sample 256 is frame 56 of the track
+    EXPECT_FLOAT_EQ(block[2 * 127], 184.0f);
+}
+
+// Test the ring wraps and never hands out more than was written
+TEST(audio_mixer_test, ring_wraps) {
+    audio_ring ring(100);
+    EXPECT_EQ(ring.capacity(), 128u);
+    std::vector<float> in(2 * 300);
+    for (size_t i = 0; i < in.size(); ++i) {
+        in[i] = static_cast<float>(i);
+    }
+    std::vector<float> out(2 * 300, -1.0f);
+    size_t written = 0;
+    size_t read = 0;
+    size_t const steps[] = {70, 50, 90, 30, 128, 1};
+    for (int round = 0; round < 12; ++round) {
+        size_t const step = steps[round % 6];
+        written += ring.write(in.data() + 2 * (written % 200), std::min<size_t>(step, 100));
+        read += ring.read(out.data(), step / 2 + 1);
+        EXPECT_LE(ring.available(), ring.capacity());
+    }
+    EXPECT_EQ(written - read, ring.available());
+
+    audio_ring exact(4);
+    float const frames[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    EXPECT_EQ(exact.write(frames, 4), 4u);
+    EXPECT_EQ(exact.write(frames, 1), 0u);
+    float two[4];
+    EXPECT_EQ(exact.read(two, 2), 2u);
+    EXPECT_EQ(exact.write(frames + 4, 2), 2u);
+    float all[8];
+    EXPECT_EQ(exact.read(all, 4), 4u);
+    EXPECT_EQ(all[0], 5.0f);
+    EXPECT_EQ(all[4], 5.0f);
+    EXPECT_EQ(all[7], 8.0f);
+}
+
+// Test real-time playback keeps cues in sync with no underruns while the control loop is busy
+TEST(audio_mixer_test, no_glitches_under_controller_load) {
+    size_t const BLOCK = 256;  // 5.3 ms at 48 kHz
+    std::vector<int16_t> const click = click_track(2, 64);
+    audio_mixer mixer(RATE);
+    audio_mixer::track_id id = 0;
+    ASSERT_TRUE(mixer.add_track(click.data(), 2, click.size() / 2, RATE, id));
+    audio_ring ring(RATE / 10);  // 100 ms of audio
+    capture_sink capture;
+    capture.samples.reserve(2 * RATE * 2);
+
+    // Cues for the whole run, as a show would schedule ahead of time
+    uint32_t const cue_ms[] = {150, 333, 500, 777, 901};
+    for (size_t i = 0; i < sizeof(cue_ms) / sizeof(cue_ms[0]); ++i) {
+        ASSERT_TRUE(mixer.cue(id, cue_ms[i]));
+    }
+
+    // A second busy control loop next to this one
+    std::atomic<bool> loaded(true);
+    std::thread other_loop([&loaded]() {
+        std::vector<mock_pin> pins(20000);
+        std::vector<blink_controller<mock_pin>> controllers;
+        for (size_t i = 0; i < pins.size(); ++i) {
+            controllers.emplace_back(pins[i], 10 + i % 90, 10 + i % 70);
+        }
+        for (uint32_t now = 0; loaded.load(std::memory_order_relaxed); ++now) {
+            for (size_t i = 0; i < controllers.size(); ++i) {
+                controllers[i].update(now);
+            }
+        }
+    });
+
+    uint64_t updates = 0;
+    {
+        // Device opened at show time 0 (the default anchor) once the mix thread has filled the
+        // ring, so its first frame is show sample 0
+        audio_render_thread render(mixer, ring, BLOCK);
+        while (ring.space() >= BLOCK) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        paced_audio_sink<capture_sink> device(ring, RATE, BLOCK, capture);
+        std::vector<mock_pin> pins(50000);
+        std::vector<blink_controller<mock_pin>> controllers;
+        for (size_t i = 0; i < pins.size(); ++i) {
+            controllers.emplace_back(pins[i], 5 + i % 50, 5 + i % 30);
+        }
+        while (device.blocks() * BLOCK < RATE * 6 / 5) {
+            for (size_t i = 0; i < controllers.size(); ++i) {
+                controllers[i].update(static_cast<uint32_t>(updates));
+            }
+            ++updates;
+        }
+        device.stop();
+        render.stop();
+        std::printf("%llu blocks, %llu underruns, %llu x 50k controller frames\n",
+                    static_cast<unsigned long long>(device.blocks()),
+                    static_cast<unsigned long long>(device.underruns()),
+                    static_cast<unsigned long long>(updates));
+        EXPECT_EQ(device.underruns(), 0u);
+    }
+    loaded.store(false);
+    other_loop.join();
+    EXPECT_GT(updates, 0u);
+
+    // Every click is heard on the exact sample of its show time
+    std::vector<size_t> found = clicks(capture.samples, 0, 16384.0f * 0.7071f);
+    ASSERT_EQ(found.size(), sizeof(cue_ms) / sizeof(cue_ms[0]));
+    for (size_t i = 0; i < found.size(); ++i) {
+        EXPECT_EQ(found[i], mixer.sample_at(cue_ms[i]));
+    }
+
+    // File sink: what the device played, as a WAV
+    wav_file out(RATE, 2);
+    out.samples().resize(capture.samples.size());
+    audio_float_to_s16(capture.samples.data(), capture.samples.size(), out.samples().data());
+    EXPECT_TRUE(out.save("test_audio_mixer_output.wav"));
+    std::remove("test_audio_mixer_output.wav");
+
+    // Null sink runs the same way
+    null_sink discard;
+    audio_ring idle_ring(1024);
+    audio_render_thread idle_render(mixer, idle_ring, BLOCK);
+    paced_audio_sink<null_sink> idle_device(idle_ring, RATE, BLOCK, discard);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    idle_device.stop();
+    EXPECT_GT(idle_device.blocks(), 0u);
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "blink_bank.h"
+#include "blink_controller.h"
+#include "mock_hardware.h"
+
+namespace {
+
+// Run a bank and an array of blink_controller side by side from start_ms, 1 ms per update
+void expect_same_as_controllers(uint32_t start_ms, uint32_t max_duration, uint32_t updates) {
+    std::mt19937 rng(start_ms ^ max_duration);
+    size_t const COUNT = 203;  // not a multiple of the SIMD width
+    std::vector<mock_pin> pins(COUNT);
+    std::vector<blink_controller<mock_pin>> controllers;
+    controllers.reserve(COUNT);
+    blink_bank bank;
+    for (size_t i = 0; i < COUNT; ++i) {
+        uint32_t const on = rng() % max_duration;  // includes 0 ms phases
+        uint32_t const off = rng() % max_duration;
+        controllers.emplace_back(pins[i], on, off);
+        EXPECT_EQ(bank.add(on, off), i);
+    }
+    for (uint32_t step = 0; step < updates; ++step) {
+        uint32_t const now = start_ms + step;
+        bank.update(now);
+        for (size_t i = 0; i < COUNT; ++i) {
+            controllers[i].update(now);
+            ASSERT_EQ(bank.is_on(i), controllers[i].is_on()) << "t=" << now << " #" << i;
+            ASSERT_EQ(bank.last_toggle(i), controllers[i].get_last_toggle_time());
+            ASSERT_EQ(bank.states()[i] != 0, pins[i].get_state());
+        }
+    }
+}
+
+}  // namespace
+
+// Test the batched bank matches blink_controller toggle for toggle
+TEST(blink_bank_test, matches_controllers) {
+    expect_same_as_controllers(0, 50, 5000);
+    expect_same_as_controllers(12345, 3000, 20000);
+}
+
+// Test the bank handles uint32 wraparound like blink_controller
+TEST(blink_bank_test, matches_controllers_across_wraparound) {
+    expect_same_as_controllers(UINT32_MAX - 2500, 700, 5000);
+}
+
+// Test a fresh bank is empty and a fresh entry starts off
+TEST(blink_bank_test, starts_off) {
+    blink_bank bank;
+    EXPECT_EQ(bank.size(), 0u);
+    bank.update(100);
+    bank.add(10, 1000);
+    EXPECT_FALSE(bank.is_on(0));
+    bank.update(999);
+    EXPECT_FALSE(bank.is_on(0));
+    bank.update(1000);
+    EXPECT_TRUE(bank.is_on(0));
+    EXPECT_EQ(bank.last_toggle(0), 1000u);
+}
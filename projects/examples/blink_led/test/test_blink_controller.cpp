@@ -257,3 +257,115 @@ TEST_F(blink_controller_test, output_pin_updated_every_call) {
     controller.update(timer.millis());
     EXPECT_GT(pin.get_toggle_count(), count_after_first);
 }
+
+// Test restart re-phases the cycle from the given time
+TEST_F(blink_controller_test, restart_starts_off_period_at_given_time) {
+    blink_controller<mock_pin> controller(pin, 1000, 500);
+
+    // Get to ON state
+    timer.advance(500);
+    controller.update(timer.millis());
+    EXPECT_TRUE(pin.get_state());
+
+    // Restart mid-cycle: LED off, off period counts from now
+    timer.advance(200);
+    controller.restart(timer.millis());
+    EXPECT_FALSE(controller.is_on());
+    EXPECT_FALSE(pin.get_state());
+    EXPECT_EQ(controller.get_last_toggle_time(), 700);
+
+    timer.advance(499);
+    controller.update(timer.millis());
+    EXPECT_FALSE(pin.get_state());
+    timer.advance(1);
+    controller.update(timer.millis());
+    EXPECT_TRUE(pin.get_state());
+}
+
+// Test align puts the controller at its played-through phase
+TEST_F(blink_controller_test, align_derives_phase_from_time) {
+    blink_controller<mock_pin> controller(pin, 1000, 500);
+
+    // 3 cycles of 1500 ms plus 700: on since 4500 + 500
+    controller.align(5200);
+    EXPECT_TRUE(controller.is_on());
+    EXPECT_TRUE(pin.get_state());
+    EXPECT_EQ(controller.get_last_toggle_time(), 5000);
+    EXPECT_EQ(controller.until_toggle(5200), 800);
+
+    // In the off period: off since the cycle start
+    controller.align(6100);
+    EXPECT_FALSE(controller.is_on());
+    EXPECT_FALSE(pin.get_state());
+    EXPECT_EQ(controller.get_last_toggle_time(), 6000);
+
+    // Zero durations never divide by zero
+    blink_controller<mock_pin> idle(pin, 0, 0);
+    idle.align(1234);
+    EXPECT_FALSE(idle.is_on());
+    EXPECT_EQ(idle.get_last_toggle_time(), 1234);
+}
+
+// Test set_durations keeps the running period's start and only moves the next edge
+TEST_F(blink_controller_test, set_durations_keeps_phase) {
+    blink_controller<mock_pin> controller(pin, 1000, 500);
+
+    // ON at 500
+    timer.advance(500);
+    controller.update(timer.millis());
+    EXPECT_TRUE(pin.get_state());
+
+    // Shorten the on period mid-way: edge moves from 1500 to 800
+    timer.advance(200);
+    controller.set_durations(300, 500);
+    EXPECT_EQ(controller.get_on_duration(), 300);
+    EXPECT_EQ(controller.get_last_toggle_time(), 500);
+    controller.update(timer.millis());
+    EXPECT_TRUE(pin.get_state());
+    timer.advance(100);
+    controller.update(timer.millis());
+    EXPECT_FALSE(pin.get_state());
+
+    // Shrinking below the time already spent toggles on the next update
+    controller.set_durations(300, 0);
+    controller.update(timer.millis());
+    EXPECT_TRUE(pin.get_state());
+}
+
+// Test until_toggle counts down to each edge, including across the 2^32 wrap
+TEST_F(blink_controller_test, until_toggle_matches_edges) {
+    blink_controller<mock_pin> controller(pin, 1000, 500);
+    EXPECT_EQ(controller.until_toggle(0), 500u);
+    EXPECT_EQ(controller.until_toggle(499), 1u);
+    EXPECT_EQ(controller.until_toggle(500), 0u);
+    controller.update(500);
+    EXPECT_EQ(controller.until_toggle(500), 1000u);
+    EXPECT_EQ(controller.until_toggle(1200), 300u);
+
+    controller.restart(UINT32_MAX - 99);
+    EXPECT_EQ(controller.until_toggle(UINT32_MAX), 401u);
+    EXPECT_EQ(controller.until_toggle(399), 1u);
+    EXPECT_EQ(controller.until_toggle(400), 0u);
+}
+
+// Test microsecond durations fed from a micros() clock, across its 71.6 minute wrap
+TEST_F(blink_controller_test, microsecond_durations) {
+    blink_controller<mock_pin> controller(pin, 150, 350);  // 2 kHz strobe, 30% duty
+    uint32_t const start_us = UINT32_MAX - 1000;
+    controller.restart(start_us);
+
+    uint32_t edges = 0;
+    bool on = false;
+    for (uint32_t step = 0; step <= 5000; ++step) {
+        uint32_t const now_us = start_us + step;  // wraps after 1000 us
+        controller.update(now_us);
+        if (pin.get_state() != on) {
+            on = pin.get_state();
+            // On at 350 + 500k, off at 500 + 500k microseconds after the start
+            EXPECT_EQ(step % 500, on ? 350u : 0u) << step;
+            ++edges;
+        }
+    }
+    EXPECT_EQ(edges, 20u);
+    EXPECT_EQ(controller.until_toggle(start_us + 5000), 350u);
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "capacity_planner.h"
+
+namespace {
+
+// Layout of identical boards sharing controllers evenly, 3 SPI bytes per controller
+show_layout even_layout(size_t boards, uint32_t controllers) {
+    show_layout layout;
+    layout.frame_rate_hz = 50.0;
+    layout.max_utilization = 0.8;
+    for (size_t b = 0; b < boards; ++b) {
+        board_load load;
+        load.model = 0;
+        load.controllers = static_cast<uint32_t>(controllers / boards + (b < controllers % boards));
+        load.loads.push_back(bus_load{0, load.controllers * 3, 1});
+        layout.boards.push_back(load);
+    }
+    return layout;
+}
+
+}  // namespace
+
+// Test bus time is overhead per transaction plus wire bits per byte
+TEST(capacity_planner_test, bus_timing) {
+    board_model model = board_model::avr("porch");
+    model.buses.push_back(peripheral_model::i2c(400000));
+    model.buses.push_back(peripheral_model::dmx());
+    show_layout layout;
+    layout.frame_rate_hz = 50.0;
+    layout.max_utilization = 0.8;
+    board_load load;
+    load.model = 0;
+    load.controllers = 48;
+    load.loads.push_back(bus_load{0, 96, 16});
+    board_report report;
+
+    // 16 x (20 bit times) + 96 x 9 bit times at 400 kHz
+    plan_board(model, load, layout, report);
+    EXPECT_NEAR(report.bus_us[0], 800.0 + 2160.0, 1e-6);
+    EXPECT_NEAR(report.bus_utilization[0], 2960.0 / 20000.0, 1e-9);
+    // 600 frame + 48 x 90 update + 96 x 40 byte cycles at 16 MHz
+    EXPECT_NEAR(report.cpu_us, 8760.0 / 16.0, 1e-6);
+    EXPECT_EQ(report.bottleneck, planner_bottleneck::bus);
+    EXPECT_EQ(report.bottleneck_bus, 0u);
+    EXPECT_TRUE(report.fits);
+
+    // A full DMX universe takes ~22.7 ms: at most ~44 frames per second
+    load.loads.push_back(bus_load{1, 512, 1});
+    plan_board(model, load, layout, report);
+    EXPECT_NEAR(report.bus_us[1], 148.0 + 512 * 44.0, 1e-6);
+    EXPECT_EQ(report.bottleneck_bus, 1u);
+    EXPECT_NEAR(report.max_frame_rate_hz, 1e6 / 22676.0, 1e-9);
+    EXPECT_GT(report.utilization, 1.0);
+    EXPECT_FALSE(report.fits);
+    layout.frame_rate_hz = 40.0;
+    plan_board(model, load, layout, report);
+    EXPECT_FALSE(report.fits);  // 91% is over the 80% headroom limit
+    layout.max_utilization = 0.95;
+    plan_board(model, load, layout, report);
+    EXPECT_TRUE(report.fits);
+}
+
+// Test the CPU is the bottleneck when buses are idle, and bad loads are invalid
+TEST(capacity_planner_test, bottleneck_and_invalid) {
+    std::vector<board_model> models;
+    models.push_back(board_model::avr("attic"));
+    models.back().buses.push_back(peripheral_model::dmx());
+    show_layout layout;
+    layout.frame_rate_hz = 50.0;
+    layout.max_utilization = 0.8;
+    layout.boards.push_back(board_load{0, 2000, std::vector<bus_load>()});
+    layout.boards.push_back(board_load{0, 10, std::vector<bus_load>(1, bus_load{1, 10, 1})});
+    layout.boards.push_back(board_load{0, 10, std::vector<bus_load>(1, bus_load{0, 513, 1})});
+    layout.boards.push_back(board_load{0, 10, std::vector<bus_load>(1, bus_load{0, 1024, 2})});
+    layout.boards.push_back(board_load{7, 10, std::vector<bus_load>()});
+    std::vector<board_report> reports;
+
+    EXPECT_EQ(plan_layout(models, layout, reports), 4u);
+    ASSERT_EQ(reports.size(), 5u);
+    EXPECT_EQ(reports[0].bottleneck, planner_bottleneck::cpu);
+    EXPECT_NEAR(reports[0].cpu_us, 180600.0 / 16.0, 1e-6);
+    EXPECT_NEAR(reports[0].max_frame_rate_hz, 16e6 / 180600.0, 1e-9);
+    EXPECT_TRUE(reports[0].fits);
+    EXPECT_EQ(reports[1].bottleneck, planner_bottleneck::invalid);  // no bus 1
+    EXPECT_EQ(reports[2].bottleneck, planner_bottleneck::invalid);  // 513 slots
+    EXPECT_EQ(reports[3].bottleneck, planner_bottleneck::bus);  // two universes, too slow
+    EXPECT_FALSE(reports[3].fits);
+    EXPECT_EQ(reports[4].bottleneck, planner_bottleneck::invalid);  // no model 7
+}
+
+// Test the description format and its error lines
+TEST(capacity_planner_test, parse) {
+    std::string const text =
+        "# porch and garage\n"
+        "board porch avr\n"
+        "board garage rp2040 mhz 125 update_cycles 50\n"
+        "bus porch i2c\n"
+        "bus garage spi 4000000\n"
+        "bus garage dmx   # spot lights\n"
+        "controllers porch 48\n"
+        "controllers garage 300\n"
+        "load porch 0 96 16\n"
+        "load garage 1 512\n"
+        "fps 40\n"
+        "headroom 95\n";
+    std::vector<board_model> models;
+    show_layout layout;
+    size_t error_line = 99;
+    ASSERT_TRUE(parse_capacity_plan(text, models, layout, error_line));
+    EXPECT_EQ(error_line, 0u);
+    ASSERT_EQ(models.size(), 2u);
+    ASSERT_EQ(layout.boards.size(), 2u);
+    EXPECT_EQ(models[1].name, "garage");
+    EXPECT_EQ(models[1].cpu_hz, 125000000u);
+    EXPECT_EQ(models[1].cycles_per_update, 50.0);
+    ASSERT_EQ(models[1].buses.size(), 2u);
+    EXPECT_EQ(models[1].buses[0].bit_rate, 4000000u);
+    EXPECT_EQ(models[1].buses[1].kind, bus_kind::dmx);
+    EXPECT_EQ(layout.boards[0].controllers, 48u);
+    ASSERT_EQ(layout.boards[1].loads.size(), 1u);
+    EXPECT_EQ(layout.boards[1].loads[0].bus, 1u);
+    EXPECT_EQ(layout.boards[1].loads[0].transactions, 1u);
+    EXPECT_EQ(layout.frame_rate_hz, 40.0);
+    EXPECT_EQ(layout.max_utilization, 0.95);
+
+    // The DMX universe takes 91% of a 40 fps frame
+    std::vector<board_report> reports;
+    EXPECT_EQ(plan_layout(models, layout, reports), 0u);
+    EXPECT_EQ(reports[1].bottleneck, planner_bottleneck::bus);
+
+    char const* const bad[] = {
+        "board a avr\nboard a avr\n",          // duplicate
+        "board a pic\n",                       // unknown preset
+        "board a avr\nbus a can\n",            // unknown bus
+        "board a avr\nbus b i2c\n",            // unknown board
+        "board a avr mhz\n",                   // missing value
+        "board a avr\nload a 0 10\n",          // no bus 0
+        "board a avr\ncontrollers a -3\n",     // not a number
+        "board a avr\nbus a dmx 500000\n",     // DMX has a fixed rate
+        "fps 0\n",                             // no frame rate
+    };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        models.clear();
+        layout.boards.clear();
+        EXPECT_FALSE(parse_capacity_plan(bad[i], models, layout, error_line)) << bad[i];
+        EXPECT_EQ(error_line, i == 1 || i == 4 || i == 8 ? 1u : 2u) << bad[i];
+    }
+}
+
+// Test an automated search finds the fewest boards, and report its speed
+TEST(capacity_planner_test, partition_search) {
+    std::vector<board_model> models;
+    models.push_back(board_model::avr("node"));
+    models.back().buses.push_back(peripheral_model::spi(4000000));
+    std::vector<board_report> reports;
+
+    // 600 + 210 cycles per controller at 16 MHz: 1500 per board is 99% of a 50 fps
+    // frame, 1000 is 66%
+    size_t boards = 1;
+    while (plan_layout(models, even_layout(boards, 3000), reports) != 0) {
+        ++boards;
+    }
+    EXPECT_EQ(boards, 3u);
+    EXPECT_EQ(reports[0].bottleneck, planner_bottleneck::cpu);
+
+    // Random candidate layouts, as a partitioning search would try them
+    std::mt19937 rng(7);
+    std::vector<show_layout> candidates;
+    for (size_t c = 0; c < 64; ++c) {
+        candidates.push_back(even_layout(1 + rng() % 32, 1000 + rng() % 20000));
+    }
+    size_t evaluated = 0;
+    size_t fitting = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < 200; ++round) {
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            fitting += plan_layout(models, candidates[c], reports) == 0 ? 1 : 0;
+            ++evaluated;
+        }
+    }
+    double const seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double const per_second = evaluated / seconds;
+    std::printf("capacity planner: %zu layouts (%zu fit) in %.1f ms, %.0f layouts/s\n", evaluated,
+                fitting, seconds * 1e3, per_second);
+    EXPECT_GT(per_second, 1000.0);
+}
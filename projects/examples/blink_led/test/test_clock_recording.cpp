@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+#include "clock_recording.h"
+#include "console_simulator.h"
+#include "mock_hardware.h"
+
+namespace {
+
+std::string temp_path(char const* name) {
+    return std::string(::testing::TempDir()) + name;
+}
+
+}  // namespace
+
+// Test readings are delta-encoded compactly
+TEST(clock_recording_test, small_deltas_use_one_byte) {
+    clock_recording recording;
+    for (uint32_t t = 0; t < 1000; t += 5) {
+        recording.append(t);
+    }
+    EXPECT_EQ(recording.size(), 200u);
+    EXPECT_EQ(recording.bytes().size(), 200u);
+    EXPECT_EQ(recording.last_reading(), 995u);
+}
+
+// Test large and wrapping deltas round trip
+TEST(clock_recording_test, wraparound_and_large_deltas) {
+    uint32_t const readings[] = {0, 127, 128, 100000, UINT32_MAX - 5, UINT32_MAX, 3, 3, 70000};
+    clock_recording recording;
+    for (uint32_t reading : readings) {
+        recording.append(reading);
+    }
+    // Wrapping from UINT32_MAX to 3 is a 4 ms delta: one byte
+    replay_timer replay(recording);
+    for (uint32_t reading : readings) {
+        EXPECT_EQ(replay.millis(), reading);
+    }
+    EXPECT_TRUE(replay.exhausted());
+}
+
+// Test replay holds the last reading once exhausted, and rewinds
+TEST(clock_recording_test, replay_exhaustion_and_rewind) {
+    clock_recording recording;
+    recording.append(10);
+    recording.append(20);
+    replay_timer replay(recording);
+
+    EXPECT_FALSE(replay.exhausted());
+    EXPECT_EQ(replay.millis(), 10u);
+    EXPECT_EQ(replay.millis(), 20u);
+    EXPECT_TRUE(replay.exhausted());
+    EXPECT_EQ(replay.millis(), 20u);
+    EXPECT_EQ(replay.served(), 2u);
+
+    replay.rewind();
+    EXPECT_EQ(replay.millis(), 10u);
+}
+
+// Test recording_timer logs every reading of the wrapped timer
+TEST(clock_recording_test, recording_timer_logs_each_read) {
+    mock_timer clock;
+    clock_recording recording;
+    recording_timer<mock_timer> timer(clock, recording);
+
+    clock.set_time(100);
+    EXPECT_EQ(timer.millis(), 100u);
+    EXPECT_EQ(timer.millis(), 100u);
+    clock.advance(7);
+    EXPECT_EQ(timer.millis(), 107u);
+    EXPECT_EQ(recording.size(), 3u);
+}
+
+// Test file round trip
+TEST(clock_recording_test, save_and_load) {
+    std::string const path = temp_path("clock_recording_roundtrip.clk");
+    clock_recording recording;
+    for (uint32_t t = 0; t < 100000; t += 333) {
+        recording.append(t);
+    }
+    ASSERT_TRUE(recording.save(path.c_str()));
+
+    clock_recording loaded;
+    ASSERT_TRUE(loaded.load(path.c_str()));
+    EXPECT_EQ(loaded.size(), recording.size());
+    EXPECT_EQ(loaded.bytes(), recording.bytes());
+    EXPECT_EQ(loaded.last_reading(), recording.last_reading());
+    std::remove(path.c_str());
+}
+
+// Test malformed input is rejected
+TEST(clock_recording_test, rejects_bad_files) {
+    clock_recording recording;
+    EXPECT_FALSE(recording.load("/nonexistent/clock.clk"));
+
+    std::string const path = temp_path("clock_recording_bad.clk");
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(file, nullptr);
+    std::fputs("NOPE", file);
+    std::fclose(file);
+    EXPECT_FALSE(recording.load(path.c_str()));
+    std::remove(path.c_str());
+
+    std::vector<uint8_t> const truncated(1, 0x80);
+    EXPECT_FALSE(recording.assign(truncated));
+    std::vector<uint8_t> const too_long(6, 0xFF);
+    EXPECT_FALSE(recording.assign(too_long));
+}
+
+// Test a real-clock run is reproduced exactly by replay
+TEST(clock_recording_test, replay_reproduces_real_run) {
+    clock_recording recording;
+    std::vector<uint8_t> live_states;
+    {
+        real_time_timer clock;
+        recording_timer<real_time_timer> timer(clock, recording);
+        mock_pin pin;
+        blink_controller<mock_pin> controller(pin, 3, 2);
+        while (timer.millis() < 60) {
+            controller.update(timer.millis());
+            live_states.push_back(pin.get_state() ? 1 : 0);
+            std::this_thread::sleep_for(std::chrono::microseconds(300));
+        }
+    }
+
+    replay_timer timer(recording);
+    mock_pin pin;
+    blink_controller<mock_pin> controller(pin, 3, 2);
+    std::vector<uint8_t> replay_states;
+    while (timer.millis() < 60 && !timer.exhausted()) {
+        controller.update(timer.millis());
+        replay_states.push_back(pin.get_state() ? 1 : 0);
+    }
+    EXPECT_EQ(replay_states, live_states);
+    EXPECT_TRUE(timer.exhausted());
+}
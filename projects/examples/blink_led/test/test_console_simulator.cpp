@@ -235,6 +235,19 @@ TEST_F(real_time_timer_test, reset_returns_to_zero) {
     EXPECT_LT(t2, 10);
 }
 
+// Test micros() runs on the same clock as millis(), a thousand times finer
+TEST_F(real_time_timer_test, micros_tracks_millis) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    uint32_t const ms_before = timer.millis();
+    uint32_t const us = timer.micros();
+    uint32_t const ms_after = timer.millis();
+
+    EXPECT_GE(us, ms_before * 1000);
+    EXPECT_LT(us, (ms_after + 1) * 1000);
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    EXPECT_GE(timer.micros(), us + 50);
+}
+
 // Test multiple resets
 TEST_F(real_time_timer_test, multiple_resets) {
     timer.reset();
@@ -0,0 +1,257 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "blink_bank.h"
+#include "dmx_output.h"
+
+namespace {
+
+// Port that keeps the last packet, for scheduling tests without a device
+struct counting_port {
+    bool set_break(bool on) {
+        breaks += on ? 1 : 0;
+        return true;
+    }
+
+    bool write(uint8_t const* data, size_t size) {
+        packet.assign(data, data + size);
+        return true;
+    }
+
+    bool drain() { return true; }
+
+    size_t breaks = 0;
+    std::vector<uint8_t> packet;
+};
+
+// dmx_tty_port that timestamps the break edges and packet writes
+struct recording_port {
+    explicit recording_port(int fd) : tty(fd) {}
+
+    bool set_break(bool on) {
+        (on ? break_on : break_off).push_back(dmx_now_ns());
+        return tty.set_break(on);
+    }
+
+    bool write(uint8_t const* data, size_t size) {
+        writes.push_back(dmx_now_ns());
+        return tty.write(data, size);
+    }
+
+    bool drain() { return tty.drain(); }
+
+    dmx_tty_port tty;
+    std::vector<uint64_t> break_on;
+    std::vector<uint64_t> break_off;
+    std::vector<uint64_t> writes;
+};
+
+// A pty pair: the device side (raw, 250 kbaud 8N2) and the master side the test reads
+bool open_pty(int& master, int& device) {
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        return false;
+    }
+    device = open(ptsname(master), O_RDWR | O_NOCTTY);
+    return device >= 0 && dmx_tty_port(device).configure();
+}
+
+// Everything that arrives on fd until stopped
+struct pty_reader {
+   public:
+    explicit pty_reader(int fd) : fd_(fd), running_(true) {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        running_.store(false);
+        thread_.join();
+    }
+
+    std::vector<uint8_t> bytes;
+
+   private:
+    void run() {
+        uint8_t buffer[4096];
+        for (;;) {
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            if (::poll(&pfd, 1, 10) > 0) {
+                ssize_t const n = ::read(fd_, buffer, sizeof(buffer));
+                if (n > 0) {
+                    bytes.insert(bytes.end(), buffer, buffer + n);
+                    continue;
+                }
+            }
+            if (!running_.load()) {
+                return;
+            }
+        }
+    }
+
+    int fd_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
+
+}  // namespace
+
+// Test changed universes refresh at the active rate and unchanged ones at the idle rate
+TEST(dmx_output_test, refresh_scheduling) {
+    dmx_timing timing;
+    counting_port fading_port;
+    counting_port static_port;
+    dmx_output<counting_port> dmx(timing);
+    size_t const fading = dmx.add_universe(fading_port);
+    size_t const still = dmx.add_universe(static_port, 24);
+    dmx.set_level(still, 24, 200);
+    dmx.set_level(still, 25, 99);  // past the universe: ignored
+    dmx.commit();
+
+    // 10 s of synthetic time: a level step every 100 ms on one universe
+    uint64_t const MS = 1000000;
+    for (uint64_t t = 0; t < 10000 * MS; t += 5 * MS) {
+        if (t % (100 * MS) == 0) {
+            dmx.set_level(fading, 1, static_cast<uint8_t>(t / (100 * MS)));
+            dmx.commit();
+        }
+        dmx.service(t);
+    }
+
+    // Every change is sent repeat_frames times 25 ms apart, then waits for the next
+    EXPECT_NEAR(static_cast<double>(dmx.frames(fading)), 300.0, 3.0);
+    // Initial burst, then one keepalive a second
+    EXPECT_GE(dmx.frames(still), 11u);
+    EXPECT_LE(dmx.frames(still), 14u);
+    EXPECT_EQ(static_port.breaks, dmx.frames(still));
+    EXPECT_EQ(dmx.errors(fading), 0u);
+
+    ASSERT_EQ(fading_port.packet.size(), 513u);
+    EXPECT_EQ(fading_port.packet[0], 0);  // start code
+    EXPECT_EQ(fading_port.packet[1], 99);
+    ASSERT_EQ(static_port.packet.size(), 25u);
+    EXPECT_EQ(static_port.packet[24], 200);
+    EXPECT_EQ(dmx.packet_ns(fading), (176u + 12u + 513u * 44u) * 1000u);
+}
+
+// Test a commit wakes the sender promptly even with a 1 Hz idle refresh
+TEST(dmx_output_test, commit_wakes_sender) {
+    dmx_timing timing;
+    timing.repeat_frames = 1;
+    counting_port port;
+    dmx_output<counting_port> dmx(timing);
+    size_t const fog = dmx.add_universe(port, 8);
+    dmx.start();
+    while (dmx.frames(fog) == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Commits land at every point of the sender's loop, including mid-service()
+    double max_ms = 0;
+    for (uint8_t level = 1; level <= 40; ++level) {
+        std::this_thread::sleep_for(std::chrono::microseconds(level * 997 % 30000));
+        uint64_t const before = dmx.frames(fog);
+        auto const committed = std::chrono::steady_clock::now();
+        dmx.set_level(fog, 1, level);
+        ASSERT_EQ(dmx.commit(), 1u);
+        while (dmx.frames(fog) == before) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        max_ms = std::max(max_ms, std::chrono::duration<double, std::milli>(
+                                      std::chrono::steady_clock::now() - committed)
+                                      .count());
+    }
+    dmx.stop();
+    // One active period (25 ms) plus scheduling slack; a lost wakeup sleeps up to 1 s
+    EXPECT_LT(max_ms, 500.0);
+}
+
+// Test packets over a pty: contents match the controllers, break / MAB / rate hold
+TEST(dmx_output_test, pty_packets) {
+    int masters[2];
+    int devices[2];
+    ASSERT_TRUE(open_pty(masters[0], devices[0]));
+    ASSERT_TRUE(open_pty(masters[1], devices[1]));
+    recording_port fog_port(devices[0]);
+    recording_port dimmer_port(devices[1]);
+    pty_reader fog_reader(masters[0]);
+    pty_reader dimmer_reader(masters[1]);
+
+    dmx_timing timing;
+    dmx_output<recording_port> dmx(timing);
+    size_t const fog = dmx.add_universe(fog_port);
+    size_t const dimmers = dmx.add_universe(dimmer_port, 64);
+    blink_bank bank;
+    std::vector<dmx_patch> patches;
+    for (uint16_t i = 0; i < 16; ++i) {
+        bank.add(60 + 17u * i, 90 + 11u * i);
+        patches.push_back(dmx_patch{i, static_cast<uint16_t>(fog), static_cast<uint16_t>(i + 1),
+                                    static_cast<uint8_t>(255 - i), 0});
+    }
+    dmx.set_level(dimmers, 64, 128);
+    dmx.start();
+
+    auto const begin = std::chrono::steady_clock::now();
+    for (uint32_t ms = 0; ms <= 1000; ms += 10) {
+        bank.update(ms);
+        dmx.apply(patches.data(), patches.size(), bank.states());
+        dmx.commit();
+        std::this_thread::sleep_until(begin + std::chrono::milliseconds(ms + 10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));  // last repeats
+    dmx.stop();
+    fog_reader.stop();
+    dimmer_reader.stop();
+    for (size_t i = 0; i < 2; ++i) {
+        close(devices[i]);
+        close(masters[i]);
+    }
+
+    // Contents: whole packets with start code 0; the last one is the final state
+    uint64_t const packets = dmx.frames(fog);
+    ASSERT_EQ(fog_reader.bytes.size(), packets * 513);
+    for (uint64_t p = 0; p < packets; ++p) {
+        EXPECT_EQ(fog_reader.bytes[p * 513], 0) << p;
+    }
+    for (uint16_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(fog_reader.bytes[(packets - 1) * 513 + 1 + i], bank.is_on(i) ? 255 - i : 0);
+    }
+    ASSERT_EQ(dimmer_reader.bytes.size(), dmx.frames(dimmers) * 65);
+    EXPECT_EQ(dimmer_reader.bytes.back(), 128);
+    EXPECT_LE(dmx.frames(dimmers), timing.repeat_frames + 2);
+
+    // Timing: break and MAB never short; packets no closer than the active period
+    ASSERT_EQ(fog_port.break_on.size(), packets);
+    std::vector<uint64_t> overshoot;
+    for (uint64_t p = 0; p < packets; ++p) {
+        uint64_t const break_ns = fog_port.break_off[p] - fog_port.break_on[p];
+        uint64_t const mab_ns = fog_port.writes[p] - fog_port.break_off[p];
+        EXPECT_GE(break_ns, timing.break_us * 1000u) << p;
+        EXPECT_GE(fog_port.writes[p] - fog_port.break_on[p],
+                  (timing.break_us + timing.mab_us) * 1000u)
+            << p;
+        overshoot.push_back(break_ns + mab_ns - (timing.break_us + timing.mab_us) * 1000u);
+        if (p > 0) {
+            EXPECT_GE(fog_port.break_on[p] - fog_port.break_on[p - 1], 24000000u) << p;
+        }
+    }
+    std::sort(overshoot.begin(), overshoot.end());
+    double const seconds = (fog_port.break_on.back() - fog_port.break_on.front()) / 1e9;
+    std::printf("dmx over pty: %llu packets in %.2f s (%.1f Hz), break+MAB overshoot median %.1f "
+                "us, max %.1f us; idle universe %llu packets\n",
+                static_cast<unsigned long long>(packets), seconds, (packets - 1) / seconds,
+                overshoot[overshoot.size() / 2] / 1e3, overshoot.back() / 1e3,
+                static_cast<unsigned long long>(dmx.frames(dimmers)));
+    EXPECT_LT(overshoot[overshoot.size() / 2], 1000000u);
+    EXPECT_GT(packets, 20u);
+}
@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+#include "lockstep_sim.h"
+#include "mock_hardware.h"
+
+namespace {
+
+// Random show: controllers with 20-200 ms phases, links with 5-50 ms latency
+lockstep_show random_show(uint32_t seed, size_t controllers, size_t links) {
+    std::mt19937 rng(seed);
+    lockstep_show show;
+    for (size_t i = 0; i < controllers; ++i) {
+        uint32_t const on = 20 + rng() % 181;
+        uint32_t const off = 20 + rng() % 181;
+        show.controllers.push_back(blink_timing{on, off});
+    }
+    for (size_t i = 0; i < links; ++i) {
+        uint32_t const source = static_cast<uint32_t>(rng() % controllers);
+        uint32_t const target = static_cast<uint32_t>(rng() % controllers);
+        show.links.push_back(sim_link{source, target, 5 + static_cast<uint32_t>(rng() % 46)});
+    }
+    return show;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+// Test the event-driven run matches stepping blink_controllers every millisecond
+TEST(lockstep_sim_test, matches_millisecond_stepping) {
+    lockstep_show const show = random_show(93, 40, 60);
+    uint64_t const END_MS = 5000;
+    sim_result result;
+    ASSERT_TRUE(simulate_show(show, END_MS, result));
+
+    // Brute force: every controller updated every ms, triggers applied as restarts
+    std::vector<mock_pin> pins(show.controllers.size());
+    std::vector<blink_controller<mock_pin>> controllers;
+    for (size_t i = 0; i < show.controllers.size(); ++i) {
+        controllers.emplace_back(pins[i], show.controllers[i].on_ms, show.controllers[i].off_ms);
+    }
+    std::vector<std::vector<uint32_t>> triggers(END_MS);
+    std::vector<uint32_t> edges(controllers.size(), 0);
+    for (uint32_t now = 0; now < END_MS; ++now) {
+        std::vector<bool> rose(controllers.size(), false);
+        for (size_t i = 0; i < controllers.size(); ++i) {
+            bool const was_on = controllers[i].is_on();
+            controllers[i].update(now);
+            edges[i] += controllers[i].is_on() != was_on ? 1 : 0;
+            rose[i] = !was_on && controllers[i].is_on();
+        }
+        for (size_t t = 0; t < triggers[now].size(); ++t) {
+            uint32_t const target = triggers[now][t];
+            edges[target] += controllers[target].is_on() ? 1 : 0;
+            controllers[target].restart(now);
+        }
+        for (size_t l = 0; l < show.links.size(); ++l) {
+            sim_link const& link = show.links[l];
+            if (rose[link.source] && now + link.latency_ms < END_MS) {
+                triggers[now + link.latency_ms].push_back(link.target);
+            }
+        }
+    }
+    EXPECT_EQ(result.edges, edges);
+    for (size_t i = 0; i < controllers.size(); ++i) {
+        // An even number of edges leaves a controller off
+        EXPECT_EQ(controllers[i].is_on(), result.edges[i] % 2 == 1) << i;
+    }
+}
+
+// Test sharded runs are bit-identical to the single-threaded run for any shard count
+TEST(lockstep_sim_test, parallel_is_bit_identical) {
+    lockstep_show const show = random_show(1093, 2000, 4000);
+    sim_result reference;
+    ASSERT_TRUE(simulate_show(show, 10000, reference));
+    EXPECT_GT(reference.events, 100000u);
+
+    uint16_t const shard_counts[] = {1, 2, 3, 7, 16};
+    for (size_t i = 0; i < sizeof(shard_counts) / sizeof(shard_counts[0]); ++i) {
+        sim_result parallel;
+        lockstep_stats stats;
+        ASSERT_TRUE(simulate_show_parallel(show, 10000, shard_counts[i], parallel, &stats));
+        EXPECT_TRUE(parallel == reference) << shard_counts[i] << " shards";
+        if (shard_counts[i] > 1) {
+            EXPECT_EQ(stats.window_ms, 5u);
+            EXPECT_GT(stats.cross_messages, 0u);
+            EXPECT_LE(stats.windows, 10000u / 5u + 1u);
+        }
+    }
+
+    // A different show differs (the digest is not trivially equal)
+    sim_result other;
+    ASSERT_TRUE(simulate_show(random_show(2093, 2000, 4000), 10000, other));
+    EXPECT_TRUE(other != reference);
+}
+
+// Test shards without cross links run as one window, and invalid shows are rejected
+TEST(lockstep_sim_test, windows_and_validation) {
+    lockstep_show show;
+    for (uint32_t i = 0; i < 8; ++i) {
+        show.controllers.push_back(blink_timing{10 + i, 10});
+    }
+    show.links.push_back(sim_link{0, 1, 3});  // both in shard 0 of 2
+    sim_result reference;
+    sim_result parallel;
+    lockstep_stats stats;
+    ASSERT_TRUE(simulate_show(show, 1000, reference));
+    ASSERT_TRUE(simulate_show_parallel(show, 1000, 2, parallel, &stats));
+    EXPECT_TRUE(parallel == reference);
+    EXPECT_EQ(stats.windows, 1u);
+    EXPECT_EQ(stats.window_ms, 0u);  // no cross-shard lookahead limit
+    EXPECT_EQ(reference.edges[7], 74u);  // on at 10 + 27k, off at 27 + 27k: 37 of each
+
+    // Sparse show: windows jump over quiet stretches instead of stepping every 2 ms
+    lockstep_show sparse;
+    sparse.controllers.push_back(blink_timing{1000, 4000});
+    sparse.controllers.push_back(blink_timing{1000, 4000});
+    sparse.links.push_back(sim_link{0, 1, 2});
+    ASSERT_TRUE(simulate_show_parallel(sparse, 60000, 2, parallel, &stats));
+    EXPECT_LT(stats.windows, 100u);
+    ASSERT_TRUE(simulate_show(sparse, 60000, reference));
+    EXPECT_TRUE(parallel == reference);
+
+    lockstep_show bad = sparse;
+    bad.links[0].latency_ms = 0;
+    EXPECT_FALSE(simulate_show(bad, 100, reference));
+    EXPECT_FALSE(simulate_show_parallel(bad, 100, 2, parallel));
+    bad = sparse;
+    bad.controllers[1].off_ms = 0;
+    EXPECT_FALSE(simulate_show(bad, 100, reference));
+    bad = sparse;
+    bad.links[0].target = 2;
+    EXPECT_FALSE(simulate_show_parallel(bad, 100, 2, parallel));
+
+    lockstep_show empty;
+    EXPECT_TRUE(simulate_show_parallel(empty, 100, 4, parallel));
+    EXPECT_TRUE(parallel.edges.empty());
+}
+
+// Benchmark: speedup of the sharded run with the machine's cores
+TEST(lockstep_sim_test, scaling) {
+    lockstep_show const show = random_show(3093, 20000, 20000);
+    uint64_t const END_MS = 4000;
+    auto const start = std::chrono::steady_clock::now();
+    sim_result reference;
+    ASSERT_TRUE(simulate_show(show, END_MS, reference));
+    double const single = seconds_since(start);
+
+    unsigned const cores = std::max(1u, std::thread::hardware_concurrency());
+    // At least 4 shards so the window exchange is exercised even on small machines
+    uint16_t const threads = static_cast<uint16_t>(std::max(4u, std::min(cores, 16u)));
+    auto const parallel_start = std::chrono::steady_clock::now();
+    sim_result parallel;
+    lockstep_stats stats;
+    ASSERT_TRUE(simulate_show_parallel(show, END_MS, threads, parallel, &stats));
+    double const sharded = seconds_since(parallel_start);
+    EXPECT_TRUE(parallel == reference);
+
+    double const speedup = single / sharded;
+    std::printf("%llu events: 1 thread %.3f s, %u threads %.3f s (%.2fx, %.0f%% of linear), "
+                "%llu windows, %llu cross-shard triggers\n",
+                static_cast<unsigned long long>(reference.events), single, threads, sharded,
+                speedup, 100.0 * speedup / threads,
+                static_cast<unsigned long long>(stats.windows),
+                static_cast<unsigned long long>(stats.cross_messages));
+    if (cores >= 4) {
+        EXPECT_GT(speedup, threads * 0.4);
+    }
+}
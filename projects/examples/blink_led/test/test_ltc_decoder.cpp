@@ -0,0 +1,311 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "blink_controller.h"
+#include "ltc_decoder.h"
+#include "ltc_signal.h"
+#include "mock_hardware.h"
+#include "wav_file.h"
+
+namespace {
+
+struct frame_log {
+    std::vector<ltc_frame> frames;
+    void operator()(ltc_frame const& frame) { frames.push_back(frame); }
+};
+
+bool same_time(ltc_timecode const& a, ltc_timecode const& b) {
+    return a.hours == b.hours && a.minutes == b.minutes && a.seconds == b.seconds &&
+           a.frames == b.frames && a.drop_frame == b.drop_frame;
+}
+
+// Decoded frames must follow each other without gaps
+void expect_consecutive(std::vector<ltc_frame> const& frames, uint32_t fps) {
+    for (size_t i = 1; i < frames.size(); ++i) {
+        ltc_timecode const expected = ltc_signal::next(frames[i - 1].timecode, fps);
+        EXPECT_TRUE(same_time(frames[i].timecode, expected)) << "frame " << i;
+    }
+}
+
+ltc_timecode timecode(uint8_t h, uint8_t m, uint8_t s, uint8_t f, bool drop = false) {
+    ltc_timecode const result = {h, m, s, f, drop};
+    return result;
+}
+
+frame_log decode(std::vector<int16_t> const& samples, uint32_t sample_rate) {
+    ltc_decoder decoder(sample_rate);
+    frame_log log;
+    decoder.process(samples.data(), samples.size(), 1, log);
+    return log;
+}
+
+}  // namespace
+
+// Test frames decode with correct fields, order and position
+TEST(ltc_decoder_test, decodes_consecutive_frames) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, 12000);
+    signal.append_frames(timecode(1, 2, 3, 4), 25, 50, samples);
+
+    ltc_decoder decoder(48000);
+    frame_log log;
+    decoder.process(samples.data(), samples.size(), 1, log);
+    ASSERT_GE(log.frames.size(), 47u);
+    expect_consecutive(log.frames, 25);
+    // The last frame only completes on the next frame's first edge
+    EXPECT_EQ(log.frames.back().timecode.seconds, 5);
+    EXPECT_EQ(log.frames.back().timecode.frames, 2);
+    EXPECT_EQ(log.frames.back().fps, 25u);
+    EXPECT_EQ(log.frames.back().end_sample, 49u * 1920 + 1);
+    EXPECT_NEAR(decoder.bit_period(), 24.0f, 0.1f);
+    EXPECT_EQ(decoder.rejected_frames(), 0u);
+}
+
+// Test every SMPTE rate at common sample rates, including drop frame across a minute
+TEST(ltc_decoder_test, frame_rates) {
+    struct rate_case {
+        double fps;
+        uint32_t nominal;
+        bool drop;
+    };
+    rate_case const cases[] = {{24.0, 24, false}, {25.0, 25, false}, {30.0, 30, false},
+                               {30000.0 / 1001.0, 30, true}};
+    uint32_t const sample_rates[] = {44100, 48000, 96000};
+    for (rate_case const& rate : cases) {
+        for (uint32_t sample_rate : sample_rates) {
+            std::vector<int16_t> samples;
+            ltc_signal signal(sample_rate, rate.fps, 10000);
+            ltc_timecode const start = timecode(0, 0, 59, static_cast<uint8_t>(rate.nominal - 6),
+                                                rate.drop);
+            signal.append_frames(start, rate.nominal, 20, samples);
+            frame_log const log = decode(samples, sample_rate);
+            ASSERT_GE(log.frames.size(), 17u) << rate.fps << " @ " << sample_rate;
+            EXPECT_EQ(log.frames.back().fps, rate.nominal);
+            expect_consecutive(log.frames, rate.nominal);
+            EXPECT_EQ(log.frames.back().timecode.minutes, 1);
+            if (rate.drop) {
+                EXPECT_EQ(log.frames.back().timecode.frames, 14u);  // 00:01:00:02 + 12
+            }
+        }
+    }
+}
+
+// Test drop-frame numbering and times
+TEST(ltc_decoder_test, drop_frame_numbering) {
+    EXPECT_EQ(ltc_frame_number(timecode(0, 0, 59, 29, true), 30), 1799u);
+    EXPECT_EQ(ltc_frame_number(timecode(0, 1, 0, 2, true), 30), 1800u);
+    EXPECT_EQ(ltc_frame_number(timecode(0, 10, 0, 0, true), 30), 17982u);
+    EXPECT_EQ(ltc_frame_ms(17982, 30, true), 599999u);  // 29.97 drift is 0.6 ms per 10 min
+    EXPECT_EQ(ltc_frame_ms(ltc_frame_number(timecode(1, 0, 0, 0), 25), 25, false), 3600000u);
+}
+
+// Test the bit clock follows varispeed playback
+TEST(ltc_decoder_test, varispeed) {
+    double const speeds[] = {0.9, 0.95, 1.05, 1.1};
+    for (double speed : speeds) {
+        std::vector<int16_t> samples;
+        ltc_signal signal(48000, 25.0 * speed, 12000);
+        signal.append_frames(timecode(0, 10, 0, 0), 25, 40, samples);
+        frame_log const log = decode(samples, 48000);
+        ASSERT_GE(log.frames.size(), 37u) << speed;
+        expect_consecutive(log.frames, 25);
+        EXPECT_EQ(log.frames.back().fps, 25u) << speed;
+    }
+}
+
+// Test quiet, inverted and noisy signals still decode
+TEST(ltc_decoder_test, level_polarity_and_noise) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, -1500);
+    signal.append_frames(timecode(23, 59, 59, 20), 25, 30, samples);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        samples[i] = static_cast<int16_t>(samples[i] + static_cast<int32_t>(seed >> 23) - 256);
+    }
+    frame_log const log = decode(samples, 48000);
+    ASSERT_GE(log.frames.size(), 27u);
+    expect_consecutive(log.frames, 25);
+    EXPECT_EQ(log.frames.back().timecode.hours, 0);  // wrapped past midnight
+}
+
+// Test silence and noise below the floor never produce frames
+TEST(ltc_decoder_test, silence_produces_nothing) {
+    std::vector<int16_t> samples(48000, 0);
+    uint32_t seed = 7;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        samples[i] = static_cast<int16_t>(static_cast<int32_t>(seed >> 25) - 64);
+    }
+    ltc_decoder decoder(48000);
+    frame_log log;
+    decoder.process(samples.data(), samples.size(), 1, log);
+    EXPECT_TRUE(log.frames.empty());
+}
+
+// Test the chase clock drives blink_controllers in step with the timecode
+TEST(ltc_decoder_test, chase_clock_drives_controllers) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, 12000);
+    signal.append_frames(timecode(0, 0, 10, 0), 25, 250, samples);  // 10 s from 10000 ms
+
+    ltc_chase_clock clock(48000, 1000);
+    mock_pin pin;
+    blink_controller<mock_pin> controller(pin, 250, 250);
+    size_t const BLOCK = 480;
+    uint32_t last = 0;
+    bool locked = false;
+    uint32_t edges = 0;
+    for (size_t offset = 0; offset + BLOCK <= samples.size(); offset += BLOCK) {
+        clock.process(samples.data() + offset, BLOCK);
+        if (clock.state() != ltc_chase_state::locked) {
+            EXPECT_FALSE(locked) << offset;
+            continue;
+        }
+        if (!locked) {
+            controller.restart(clock.millis());
+            locked = true;
+        }
+        uint32_t const expected = 10000 + static_cast<uint32_t>((offset + BLOCK) / 48);
+        EXPECT_NEAR(clock.millis(), expected, 1.0) << offset;
+        EXPECT_GE(clock.millis(), last);
+        last = clock.millis();
+        bool const before = pin.get_state();
+        controller.update(clock.millis());
+        edges += pin.get_state() != before ? 1 : 0;
+    }
+    EXPECT_TRUE(locked);
+    EXPECT_GE(edges, 38u);
+    EXPECT_LE(edges, 40u);
+    EXPECT_EQ(clock.jumps(), 0u);
+    EXPECT_EQ(clock.dropouts(), 0u);
+}
+
+// Test dropouts freewheel, then stop and hold, then relock
+TEST(ltc_decoder_test, freewheel_through_dropout) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, 12000);
+    ltc_timecode const resume = signal.append_frames(timecode(0, 1, 0, 0), 25, 50, samples);
+    signal.append_silence(48000 * 3, samples);
+    signal.append_frames(ltc_signal::next(resume, 25), 25, 50, samples);  // 3 s gap in LTC
+
+    ltc_chase_clock clock(48000, 1000);
+    size_t const BLOCK = 480;
+    bool saw_freewheel = false;
+    bool saw_stopped = false;
+    uint32_t held = 0;
+    for (size_t offset = 0; offset + BLOCK <= samples.size(); offset += BLOCK) {
+        clock.process(samples.data() + offset, BLOCK);
+        size_t const end = offset + BLOCK;
+        // Last frame of the first burst is decoded at 49 * 1920 (see above)
+        if (end > 49 * 1920 + 4800 && end < 49 * 1920 + 48000) {
+            EXPECT_EQ(clock.state(), ltc_chase_state::freewheel) << end;
+            EXPECT_NEAR(clock.millis(), 60000 + end / 48, 1.0);
+            saw_freewheel = true;
+        } else if (end > 49 * 1920 + 49000 && end < 50 * 1920 + 144000) {
+            EXPECT_EQ(clock.state(), ltc_chase_state::stopped) << end;
+            if (held == 0) {
+                held = clock.millis();
+            }
+            EXPECT_EQ(clock.millis(), held);
+            saw_stopped = true;
+        }
+    }
+    EXPECT_TRUE(saw_freewheel);
+    EXPECT_TRUE(saw_stopped);
+    EXPECT_NEAR(held, 61960 + 1000, 1.0);  // last anchor + freewheel
+    EXPECT_EQ(clock.state(), ltc_chase_state::locked);
+    EXPECT_NEAR(clock.millis(), 62040 + 50 * 40, 1.0);  // resumed at 00:01:02:01
+    EXPECT_EQ(clock.dropouts(), 1u);
+}
+
+// Test the clock follows a seek in the source, backwards included
+TEST(ltc_decoder_test, follows_source_jumps) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, 12000);
+    signal.append_frames(timecode(0, 5, 0, 0), 25, 50, samples);
+    signal.append_frames(timecode(0, 1, 0, 0), 25, 50, samples);
+
+    ltc_chase_clock clock(48000, 1000);
+    clock.process(samples.data(), samples.size());
+    EXPECT_EQ(clock.jumps(), 1u);
+    EXPECT_NEAR(clock.millis(), 62000, 1.0);
+    EXPECT_EQ(clock.state(), ltc_chase_state::locked);
+}
+
+// Test a stereo WAV with LTC on one channel round-trips through disk
+TEST(ltc_decoder_test, wav_file_channel) {
+    wav_file wav(48000, 2);
+    std::vector<int16_t> ltc;
+    ltc_signal signal(48000, 25.0, 8000);
+    signal.append_frames(timecode(0, 0, 0, 0), 25, 30, ltc);
+    for (size_t i = 0; i < ltc.size(); ++i) {
+        wav.samples().push_back(static_cast<int16_t>(20000 * std::sin(i * 0.0576)));  // 440 Hz
+        wav.samples().push_back(ltc[i]);
+    }
+    char const* path = "test_ltc_decoder.wav";
+    ASSERT_TRUE(wav.save(path));
+
+    wav_file loaded;
+    ASSERT_TRUE(loaded.load(path));
+    std::remove(path);
+    EXPECT_EQ(loaded.sample_rate(), 48000u);
+    EXPECT_EQ(loaded.channels(), 2u);
+    EXPECT_EQ(loaded.frames(), ltc.size());
+    EXPECT_EQ(loaded.samples(), wav.samples());
+
+    ltc_decoder decoder(loaded.sample_rate());
+    frame_log log;
+    decoder.process(loaded.samples().data() + 1, loaded.frames(), loaded.channels(), log);
+    ASSERT_GE(log.frames.size(), 27u);
+    expect_consecutive(log.frames, 25);
+}
+
+// Test malformed and unsupported WAVs are rejected
+TEST(ltc_decoder_test, wav_file_rejects) {
+    wav_file wav(48000, 1);
+    wav.samples().assign(100, 0);
+    char const* path = "test_ltc_decoder_reject.wav";
+    ASSERT_TRUE(wav.save(path));
+    std::FILE* file = std::fopen(path, "rb");
+    ASSERT_NE(file, nullptr);
+    std::vector<uint8_t> bytes(44 + 200);
+    ASSERT_EQ(std::fread(bytes.data(), 1, bytes.size(), file), bytes.size());
+    std::fclose(file);
+    std::remove(path);
+
+    wav_file parsed;
+    EXPECT_TRUE(parsed.parse(bytes.data(), bytes.size()));
+    EXPECT_FALSE(parsed.parse(bytes.data(), bytes.size() - 1));  // truncated data chunk
+    std::vector<uint8_t> eight_bit = bytes;
+    eight_bit[34] = 8;
+    EXPECT_FALSE(parsed.parse(eight_bit.data(), eight_bit.size()));
+    std::vector<uint8_t> not_riff = bytes;
+    not_riff[0] = 'X';
+    EXPECT_FALSE(parsed.parse(not_riff.data(), not_riff.size()));
+    EXPECT_FALSE(parsed.load("does_not_exist.wav"));
+}
+
+// Test decoding is a small fraction of real time
+TEST(ltc_decoder_test, realtime_cost) {
+    std::vector<int16_t> samples;
+    ltc_signal signal(48000, 25.0, 12000);
+    signal.append_frames(timecode(0, 0, 0, 0), 25, 60 * 25, samples);  // one minute
+
+    ltc_chase_clock clock(48000, 1000);
+    auto const start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset + 480 <= samples.size(); offset += 480) {
+        clock.process(samples.data() + offset, 480);
+    }
+    double const seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_GE(clock.decoder().frames(), 60u * 25 - 2);
+    double const cpu_fraction = seconds / 60.0;
+    std::printf("60 s of 48 kHz LTC decoded in %.2f ms (%.3f%% of one core)\n", seconds * 1000,
+                cpu_fraction * 100);
+    EXPECT_LT(cpu_fraction, 0.05);
+}
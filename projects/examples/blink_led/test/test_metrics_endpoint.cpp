@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blink_bank.h"
+#include "metrics_endpoint.h"
+
+// Every allocation in the test binary, to check scrapes allocate nothing
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* const p = std::malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Minimal HTTP client: one request, response read into a fixed buffer until close
+size_t http_get(uint16_t port, char const* request, char* response, size_t capacity) {
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    size_t size = 0;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 &&
+        ::send(fd, request, std::strlen(request), MSG_NOSIGNAL) > 0) {
+        ssize_t n = 0;
+        while (size < capacity && (n = ::recv(fd, response + size, capacity - size, 0)) > 0) {
+            size += static_cast<size_t>(n);
+        }
+    }
+    ::close(fd);
+    return size;
+}
+
+// Value of "name <value>" on its own line of a Prometheus response
+uint64_t prometheus_value(std::string const& text, std::string const& name) {
+    size_t const at = text.find("\n" + name + " ");
+    return at == std::string::npos ? UINT64_MAX
+                                   : std::strtoull(text.c_str() + at + name.size() + 2, nullptr,
+                                                   10);
+}
+
+// Control loop stand-in: a bank of controllers at 1 kHz, publishing after every frame
+struct control_loop {
+   public:
+    explicit control_loop(metrics_seqlock<show_metrics>& published)
+        : published_(published), running_(true), max_publish_ns_(0) {
+        for (uint32_t i = 0; i < 1000; ++i) {
+            bank_.add(20 + i % 97, 30 + i % 89);
+        }
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~control_loop() { stop(); }
+
+    void stop() {
+        running_.store(false);
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    uint64_t max_publish_ns() const { return max_publish_ns_.load(); }
+
+   private:
+    void run() {
+        show_metrics metrics = {};
+        metrics.controllers = bank_.size();
+        std::vector<uint32_t> previous(bank_.size(), 0);
+        uint64_t const start_ns = metrics_now_ns();
+        uint32_t ms = 0;
+        while (running_.load()) {
+            uint64_t const frame_start = metrics_now_ns();
+            bank_.update(ms);
+            uint64_t edges = 0;
+            uint64_t on = 0;
+            for (size_t i = 0; i < bank_.size(); ++i) {
+                edges += bank_.states()[i] != previous[i] ? 1 : 0;
+                on += bank_.states()[i];
+                previous[i] = bank_.states()[i];
+            }
+            uint64_t const frame_end = metrics_now_ns();
+            metrics.show_time_ms = ms;
+            metrics.controllers_on = on;
+            metrics.add_frame((frame_end - frame_start) / 1000, 1000, edges);
+            metrics.published_ns = frame_end;
+            published_.publish(metrics);
+            uint64_t const publish_ns = metrics_now_ns() - frame_end;
+            if (publish_ns > max_publish_ns_.load(std::memory_order_relaxed)) {
+                max_publish_ns_.store(publish_ns, std::memory_order_relaxed);
+            }
+            ++ms;
+            std::this_thread::sleep_until(std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(start_ns + ms * 1000000ull)));
+        }
+    }
+
+    metrics_seqlock<show_metrics>& published_;
+    blink_bank bank_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> max_publish_ns_;
+    std::thread thread_;
+};
+
+}  // namespace
+
+// Test readers never see a torn snapshot while the writer publishes flat out
+TEST(metrics_endpoint_test, seqlock_snapshots_are_whole) {
+    metrics_seqlock<show_metrics> published;
+    std::atomic<bool> done(false);
+    std::thread writer([&]() {
+        show_metrics m = {};
+        for (uint64_t i = 1; i <= 200000; ++i) {
+            m.show_time_ms = m.frames = m.edges = m.overruns = m.frame_us_last = i;
+            m.frame_us_max = m.frame_us_sum = m.controllers = m.controllers_on = i;
+            m.published_ns = i;
+            published.publish(m);
+        }
+        done.store(true);
+    });
+    uint64_t reads = 0;
+    uint64_t last_version = 0;
+    while (!done.load()) {
+        show_metrics m;
+        uint64_t const version = published.read(m);
+        ASSERT_GE(version, last_version);
+        last_version = version;
+        ASSERT_EQ(m.frames, version);
+        ASSERT_EQ(m.show_time_ms, m.published_ns);
+        ASSERT_EQ(m.edges, m.controllers_on);
+        ++reads;
+    }
+    writer.join();
+    show_metrics m;
+    EXPECT_EQ(published.read(m), 200000u);
+    EXPECT_EQ(m.controllers, 200000u);
+    EXPECT_GT(reads, 0u);
+}
+
+// Test response formats and error statuses without a socket
+TEST(metrics_endpoint_test, formats) {
+    metrics_seqlock<show_metrics> published;
+    show_metrics m = {};
+    m.controllers = 4;
+    m.add_frame(300, 1000, 2);
+    m.add_frame(1500, 1000, 1);
+    published.publish(m);
+    metrics_server server(published);
+
+    char const get_metrics[] = "GET /metrics HTTP/1.1\r\nHost: x\r\n\r\n";
+    std::string text(server.response(), server.respond(get_metrics, sizeof(get_metrics) - 1));
+    EXPECT_EQ(text.find("HTTP/1.0 200 OK\r\n"), 0u);
+    EXPECT_NE(text.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE blink_frames_total counter\n"), std::string::npos);
+    EXPECT_EQ(prometheus_value(text, "blink_frames_total"), 2u);
+    EXPECT_EQ(prometheus_value(text, "blink_edges_total"), 3u);
+    EXPECT_EQ(prometheus_value(text, "blink_overruns_total"), 1u);
+    EXPECT_EQ(prometheus_value(text, "blink_frame_time_max_us"), 1500u);
+    EXPECT_EQ(prometheus_value(text, "blink_scrapes_total"), 1u);
+    size_t const body = text.find("\r\n\r\n") + 4;
+    EXPECT_NE(text.find("Content-Length: " + std::to_string(text.size() - body) + "\r\n"),
+              std::string::npos);
+
+    char const get_status[] = "GET /status HTTP/1.1\r\n\r\n";
+    text.assign(server.response(), server.respond(get_status, sizeof(get_status) - 1));
+    EXPECT_NE(text.find("Content-Type: application/json"), std::string::npos);
+    EXPECT_NE(text.find("{\"show_time_ms\":0,\"frames\":2,\"edges\":3,\"overruns\":1,"
+                        "\"frame_us\":{\"last\":1500,\"max\":1500,\"avg\":900},"
+                        "\"controllers\":4,\"controllers_on\":0,\"snapshot_age_ms\":0}\n"),
+              std::string::npos);
+
+    char const missing[] = "GET /favicon.ico HTTP/1.1\r\n\r\n";
+    text.assign(server.response(), server.respond(missing, sizeof(missing) - 1));
+    EXPECT_EQ(text.find("HTTP/1.0 404 Not Found\r\n"), 0u);
+    char const post[] = "POST /metrics HTTP/1.1\r\n\r\n";
+    text.assign(server.response(), server.respond(post, sizeof(post) - 1));
+    EXPECT_EQ(text.find("HTTP/1.0 405 Method Not Allowed\r\n"), 0u);
+    text.assign(server.response(), server.respond("", 0));
+    EXPECT_EQ(text.find("HTTP/1.0 400 Bad Request\r\n"), 0u);
+    EXPECT_EQ(server.bad_requests(), 2u);
+}
+
+// Test scraping a running control loop over loopback HTTP
+TEST(metrics_endpoint_test, live_scrapes) {
+    metrics_seqlock<show_metrics> published;
+    metrics_server server(published);
+    ASSERT_TRUE(server.open(0));
+    ASSERT_NE(server.port(), 0);
+    server.start();
+    control_loop loop(published);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Scrape hard for a while: fixed buffers on this side, so any allocation is the server's
+    static char response[16384];
+    char const request[] = "GET /metrics HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n";
+    size_t const SCRAPES = 300;
+    uint64_t frames[SCRAPES];
+    size_t sizes[SCRAPES];
+    uint64_t const allocations_before = g_allocations.load();
+    for (size_t i = 0; i < SCRAPES; ++i) {
+        sizes[i] = http_get(server.port(), request, response, sizeof(response) - 1);
+        response[sizes[i]] = '\0';
+        char const* const at = std::strstr(response, "\nblink_frames_total ");
+        frames[i] = at != nullptr && sizes[i] > 0 ? std::strtoull(at + 20, nullptr, 10) : 0;
+    }
+    uint64_t const allocations = g_allocations.load() - allocations_before;
+    size_t const status_size =
+        http_get(server.port(), "GET /status HTTP/1.1\r\n\r\n", response, sizeof(response));
+    std::string const status(response, status_size);
+    loop.stop();
+    server.stop();
+
+    EXPECT_EQ(allocations, 0u);
+    for (size_t i = 0; i < SCRAPES; ++i) {
+        ASSERT_GT(sizes[i], 0u) << i;
+        ASSERT_GT(frames[i], 0u) << i;
+        if (i > 0) {
+            ASSERT_GE(frames[i], frames[i - 1]) << i;
+        }
+    }
+    EXPECT_EQ(server.scrapes(), SCRAPES + 1);
+    EXPECT_NE(status.find("\"controllers\":1000,"), std::string::npos) << status;
+    std::printf("metrics endpoint: %zu scrapes over %llu frames, %llu allocations, "
+                "longest publish %.1f us\n",
+                SCRAPES, static_cast<unsigned long long>(frames[SCRAPES - 1] - frames[0]),
+                static_cast<unsigned long long>(allocations), loop.max_publish_ns() / 1e3);
+}
@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "motion_detector.h"
+
+namespace {
+
+uint32_t const WIDTH = 640;
+uint32_t const HEIGHT = 480;
+
+// Textured background with sensor noise and an optional bright square
+void render(std::mt19937& rng, std::vector<uint8_t>& luma, int square_x, int square_y) {
+    luma.resize(static_cast<size_t>(WIDTH) * HEIGHT);
+    for (uint32_t y = 0; y < HEIGHT; ++y) {
+        for (uint32_t x = 0; x < WIDTH; ++x) {
+            int const noise = static_cast<int>(rng() % 7) - 3;
+            int value = 60 + static_cast<int>((x * 7 + y * 3) % 40) + noise;
+            if (square_x >= 0 && static_cast<int>(x) >= square_x &&
+                static_cast<int>(x) < square_x + 64 && static_cast<int>(y) >= square_y &&
+                static_cast<int>(y) < square_y + 96) {
+                value = 220;
+            }
+            luma[static_cast<size_t>(y) * WIDTH + x] = static_cast<uint8_t>(value);
+        }
+    }
+}
+
+struct event_log {
+    std::vector<motion_event> events;
+    void operator()(motion_event const& event) { events.push_back(event); }
+};
+
+// Left and right halves of the frame, one controller each
+void add_halves(motion_detector& detector) {
+    detector.add_region(motion_region{0, 0, WIDTH / 2, HEIGHT, 0.02f, 0.005f, 15, 100});
+    detector.add_region(motion_region{WIDTH / 2, 0, WIDTH / 2, HEIGHT, 0.02f, 0.005f, 15, 200});
+}
+
+}  // namespace
+
+// Test the SIMD cell SADs equal the scalar ones, including an odd trailing cell
+TEST(motion_detector_test, simd_matches_scalar) {
+    std::mt19937 rng(86);
+    uint32_t const widths[] = {640, 72, 8, 24};
+    for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+        uint32_t const width = widths[w];
+        uint32_t const height = 43;  // partial cell row at the bottom is ignored
+        std::vector<uint8_t> a(static_cast<size_t>(width) * height);
+        std::vector<uint8_t> b(a.size());
+        for (size_t i = 0; i < a.size(); ++i) {
+            a[i] = static_cast<uint8_t>(rng());
+            b[i] = static_cast<uint8_t>(i % 3 == 0 ? rng() : a[i]);
+        }
+        size_t const cells = static_cast<size_t>(width / MOTION_CELL) * (height / MOTION_CELL);
+        std::vector<uint16_t> simd(cells, 1);
+        std::vector<uint16_t> scalar(cells, 2);
+        motion_cell_sad(a.data(), b.data(), width, height, width, simd.data());
+        motion_cell_sad_scalar(a.data(), b.data(), width, height, width, scalar.data());
+        EXPECT_EQ(simd, scalar) << width;
+    }
+
+    // Extreme difference: every pixel 0 vs 255
+    std::vector<uint8_t> black(64 * 8, 0);
+    std::vector<uint8_t> white(64 * 8, 255);
+    std::vector<uint16_t> sad(8);
+    motion_cell_sad(black.data(), white.data(), 64, 8, 64, sad.data());
+    EXPECT_EQ(sad[0], 64u * 255u);
+    EXPECT_EQ(sad[7], 64u * 255u);
+}
+
+// Test a recorded walk-through: noise is ignored, each half fires once for its controller
+TEST(motion_detector_test, recorded_walkthrough) {
+    char const* path = "test_motion_walkthrough.yuv";
+    std::mt19937 rng(1086);
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> const chroma(static_cast<size_t>(WIDTH / 2) * (HEIGHT / 2) * 2, 128);
+    std::FILE* file = std::fopen(path, "wb");
+    ASSERT_NE(file, nullptr);
+    for (int frame = 0; frame < 120; ++frame) {
+        // Quiet for 30 frames, then a figure crosses left to right at 16 px per frame
+        int const x = frame < 30 ? -1 : (frame - 30) * 16;
+        render(rng, luma, x < static_cast<int>(WIDTH) ? x : -1, 200);
+        std::fwrite(luma.data(), 1, luma.size(), file);
+        std::fwrite(chroma.data(), 1, chroma.size(), file);
+    }
+    std::fclose(file);
+
+    raw_video_reader video(path, WIDTH, HEIGHT, raw_video_format::yuv420p);
+    ASSERT_TRUE(video.ok());
+    motion_detector detector(WIDTH, HEIGHT, 12);
+    add_halves(detector);
+    event_log log;
+    while (video.read(luma)) {
+        detector.process(luma.data(), log);
+        if (detector.frames() == 30) {
+            EXPECT_TRUE(log.events.empty()) << "noise must not trigger";
+        }
+    }
+    EXPECT_EQ(video.frames(), 120u);
+
+    ASSERT_EQ(log.events.size(), 2u);
+    EXPECT_EQ(log.events[0].command.type, show_command_type::trigger);
+    EXPECT_EQ(log.events[0].command.controller_id, 100u);
+    EXPECT_EQ(log.events[0].frame, 30u);  // first frame with the figure
+    EXPECT_EQ(log.events[1].command.controller_id, 200u);
+    // Both moving edges (2 x 2 x 12 cells) are right of x = 320 from frame 30 + 21
+    EXPECT_GE(log.events[1].frame, 30u + 17u);
+    EXPECT_LE(log.events[1].frame, 30u + 21u);
+    EXPECT_GE(log.events[1].activity, 0.02f);
+    std::remove(path);
+}
+
+// Test a region re-arms only after going quiet and respects its hold-off
+TEST(motion_detector_test, rearm_and_hold) {
+    std::mt19937 rng(2086);
+    motion_detector detector(WIDTH, HEIGHT, 12);
+    add_halves(detector);
+    event_log log;
+    std::vector<uint8_t> luma;
+    // Motion in the left half for 10 frames, quiet 2, motion again, quiet 20, motion again
+    int const pattern[] = {0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 1, 1, 0, 0, 0, 0,
+                           0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1};
+    for (size_t frame = 0; frame < sizeof(pattern) / sizeof(pattern[0]); ++frame) {
+        render(rng, luma, pattern[frame] != 0 ? static_cast<int>(frame % 2) * 64 : -1, 100);
+        detector.process(luma.data(), log);
+    }
+    ASSERT_EQ(log.events.size(), 2u);
+    EXPECT_EQ(log.events[0].frame, 1u);
+    // Re-armed during the 2-frame pause but still inside the 15-frame hold-off
+    EXPECT_EQ(log.events[1].frame, 35u);
+    EXPECT_EQ(detector.triggers(), 2u);
+    EXPECT_EQ(detector.activity(1), 0.0f);
+}
+
+// Test gray8 files and truncated last frames
+TEST(motion_detector_test, gray_reader) {
+    char const* path = "test_motion_gray.raw";
+    std::vector<uint8_t> bytes(16 * 8 * 2 + 5, 7);
+    std::FILE* file = std::fopen(path, "wb");
+    ASSERT_NE(file, nullptr);
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+
+    raw_video_reader video(path, 16, 8, raw_video_format::gray8);
+    std::vector<uint8_t> luma;
+    EXPECT_TRUE(video.read(luma));
+    EXPECT_EQ(luma.size(), 128u);
+    EXPECT_TRUE(video.read(luma));
+    EXPECT_FALSE(video.read(luma));
+    EXPECT_EQ(video.frames(), 2u);
+    std::remove(path);
+
+    raw_video_reader missing("no_such_video.yuv", 16, 8, raw_video_format::gray8);
+    EXPECT_FALSE(missing.ok());
+    EXPECT_FALSE(missing.read(luma));
+}
+
+// Test 640x480 frames process in a few milliseconds on one core
+TEST(motion_detector_test, frame_cost) {
+    std::mt19937 rng(3086);
+    std::vector<std::vector<uint8_t>> frames(8);
+    for (size_t i = 0; i < frames.size(); ++i) {
+        render(rng, frames[i], static_cast<int>(i) * 40, 100);
+    }
+    motion_detector detector(WIDTH, HEIGHT, 12);
+    add_halves(detector);
+    event_log log;
+    int const FRAMES = 300;
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        detector.process(frames[static_cast<size_t>(i) % frames.size()].data(), log);
+    }
+    double const frame_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+            .count() /
+        FRAMES;
+
+    std::vector<uint16_t> sad(static_cast<size_t>(detector.columns()) * detector.rows());
+    auto const scalar_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        motion_cell_sad_scalar(frames[static_cast<size_t>(i) % frames.size()].data(),
+                               frames[static_cast<size_t>(i + 1) % frames.size()].data(), WIDTH,
+                               HEIGHT, WIDTH, sad.data());
+    }
+    double const scalar_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scalar_start)
+            .count() /
+        FRAMES;
+    std::printf("640x480: %.3f ms per frame (scalar cell SAD alone %.3f ms)\n", frame_ms,
+                scalar_ms);
+    // The scalar pass calibrates the host: past 10 ms it is too weak (or too
+    // heavily instrumented) for a per-frame budget to mean anything
+    if (scalar_ms < 10.0) {
+        EXPECT_LT(frame_ms, 5.0);
+    }
+}
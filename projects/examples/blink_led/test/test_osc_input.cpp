@@ -0,0 +1,503 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "console_simulator.h"
+#include "mock_hardware.h"
+#include "osc_input.h"
+#include "show_partition.h"
+#include "spsc_queue.h"
+
+namespace {
+
+void put_padded_string(std::vector<uint8_t>& out, char const* text) {
+    size_t const length = std::strlen(text);
+    out.insert(out.end(), text, text + length);
+    out.resize(out.size() + osc_message_view::padded(length + 1) - length, 0);
+}
+
+void put_be32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+std::vector<uint8_t> osc_int(char const* address, int32_t value) {
+    std::vector<uint8_t> out;
+    put_padded_string(out, address);
+    put_padded_string(out, ",i");
+    put_be32(out, static_cast<uint32_t>(value));
+    return out;
+}
+
+std::vector<uint8_t> osc_float(char const* address, char const* leading_tags, float value) {
+    std::vector<uint8_t> out;
+    put_padded_string(out, address);
+    std::string tags = std::string(",") + leading_tags + "f";
+    put_padded_string(out, tags.c_str());
+    for (char const* tag = leading_tags; *tag != 0; ++tag) {
+        if (*tag == 's') {
+            put_padded_string(out, "label");
+        } else if (*tag == 'i' || *tag == 'c' || *tag == 'r' || *tag == 'm') {
+            put_be32(out, 0x447a0000);  // 1000.0f if misread as the float
+        }
+    }
+    uint32_t word = 0;
+    std::memcpy(&word, &value, sizeof(word));
+    put_be32(out, word);
+    return out;
+}
+
+// Message with one 64-bit argument ('h' int64 or 'd' double)
+std::vector<uint8_t> osc_wide(char const* address, char tag, uint64_t bits) {
+    std::vector<uint8_t> out;
+    put_padded_string(out, address);
+    char const tags[] = {',', tag, 0};
+    put_padded_string(out, tags);
+    put_be32(out, static_cast<uint32_t>(bits >> 32));
+    put_be32(out, static_cast<uint32_t>(bits));
+    return out;
+}
+
+std::vector<uint8_t> osc_bundle(std::vector<std::vector<uint8_t>> const& elements) {
+    std::vector<uint8_t> out;
+    put_padded_string(out, "#bundle");
+    put_be32(out, 0);
+    put_be32(out, 1);  // time tag "immediately"
+    for (size_t i = 0; i < elements.size(); ++i) {
+        put_be32(out, static_cast<uint32_t>(elements[i].size()));
+        out.insert(out.end(), elements[i].begin(), elements[i].end());
+    }
+    return out;
+}
+
+std::vector<uint8_t> rtp_midi(std::vector<uint8_t> const& commands, bool first_has_delta) {
+    std::vector<uint8_t> out = {0x80, 0x61, 0x00, 0x01, 0, 0, 0, 0, 0x12, 0x34, 0x56, 0x78};
+    uint8_t const z = first_has_delta ? 0x20 : 0;
+    if (commands.size() > 15) {  // B: 12-bit length
+        out.push_back(static_cast<uint8_t>(0x80 | z | (commands.size() >> 8)));
+        out.push_back(static_cast<uint8_t>(commands.size()));
+    } else {
+        out.push_back(static_cast<uint8_t>(z | commands.size()));
+    }
+    out.insert(out.end(), commands.begin(), commands.end());
+    return out;
+}
+
+std::vector<osc_route> show_routes() {
+    std::vector<osc_route> routes;
+    routes.push_back({"/show/start", show_command_type::start, ALL_CONTROLLERS});
+    routes.push_back({"/show/stop", show_command_type::stop, ALL_CONTROLLERS});
+    routes.push_back({"/show/seek", show_command_type::seek, ALL_CONTROLLERS});
+    routes.push_back({"/prop/0/trigger", show_command_type::trigger, 0});
+    routes.push_back({"/prop/1/trigger", show_command_type::trigger, 1});
+    routes.push_back({"/prop/2/trigger", show_command_type::trigger, 2});
+    return routes;
+}
+
+struct udp_sender {
+    udp_sender(uint16_t port) : fd(::socket(AF_INET, SOCK_DGRAM, 0)) {
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    ~udp_sender() { ::close(fd); }
+    bool send(std::vector<uint8_t> const& packet) const {
+        sockaddr const* to = reinterpret_cast<sockaddr const*>(&addr);
+        return ::sendto(fd, packet.data(), packet.size(), 0, to, sizeof(addr)) ==
+               static_cast<ssize_t>(packet.size());
+    }
+    int fd;
+    sockaddr_in addr = {};
+};
+
+}  // namespace
+
+// Test messages are parsed in place
+TEST(osc_input_test, parse_message) {
+    std::vector<uint8_t> const packet = osc_float("/prop/1/trigger", "s", 0.5f);
+    osc_message_view message;
+    ASSERT_TRUE(parse_osc_message(packet.data(), packet.size(), message));
+    EXPECT_EQ(std::string(message.address, message.address_length), "/prop/1/trigger");
+    EXPECT_EQ(message.address, reinterpret_cast<char const*>(packet.data()));
+    EXPECT_EQ(message.arg_count, 2u);
+    float value = 0.0f;
+    EXPECT_FALSE(message.numeric_arg(0, value));  // string
+    ASSERT_TRUE(message.numeric_arg(1, value));
+    EXPECT_FLOAT_EQ(value, 0.5f);
+    EXPECT_FALSE(message.numeric_arg(2, value));
+}
+
+// Test every argument size is known: 4-byte c / r / m, zero-size T / F / N / I
+TEST(osc_input_test, parse_argument_sizes) {
+    char const* const leading[] = {"c", "r", "m", "TFNI", "rcTm", "s[iI]"};
+    for (char const* tags : leading) {
+        std::vector<uint8_t> const packet = osc_float("/show/seek", tags, 1500.0f);
+        osc_message_view message;
+        ASSERT_TRUE(parse_osc_message(packet.data(), packet.size(), message)) << tags;
+        uint32_t time_ms = 0;
+        ASSERT_TRUE(message.time_arg(message.arg_count - 1, time_ms)) << tags;
+        EXPECT_EQ(time_ms, 1500u) << tags;
+    }
+
+    // An unknown tag makes every later argument unreadable
+    std::vector<uint8_t> const unknown = osc_float("/show/seek", "x", 1500.0f);
+    osc_message_view message;
+    ASSERT_TRUE(parse_osc_message(unknown.data(), unknown.size(), message));
+    uint32_t time_ms = 0;
+    EXPECT_FALSE(message.time_arg(1, time_ms));
+}
+
+// Test malformed and truncated packets are rejected
+TEST(osc_input_test, parse_rejects_malformed) {
+    std::vector<uint8_t> const good = osc_int("/show/seek", 42);
+    osc_message_view message;
+    float value = 0.0f;
+    for (size_t size = 0; size < good.size(); ++size) {
+        EXPECT_FALSE(parse_osc_message(good.data(), size, message) &&
+                     message.numeric_arg(0, value))
+            << size;
+    }
+    std::vector<uint8_t> no_slash = good;
+    no_slash[0] = 'x';
+    EXPECT_FALSE(parse_osc_message(no_slash.data(), no_slash.size(), message));
+    std::vector<uint8_t> no_tags;
+    put_padded_string(no_tags, "/show/stop");
+    EXPECT_FALSE(parse_osc_message(no_tags.data(), no_tags.size(), message));
+}
+
+// Test bundles (including nested) visit every message in order
+TEST(osc_input_test, bundles) {
+    std::vector<std::vector<uint8_t>> inner;
+    inner.push_back(osc_int("/prop/1/trigger", 1));
+    inner.push_back(osc_int("/prop/2/trigger", 1));
+    std::vector<std::vector<uint8_t>> outer;
+    outer.push_back(osc_int("/prop/0/trigger", 1));
+    outer.push_back(osc_bundle(inner));
+    std::vector<uint8_t> const packet = osc_bundle(outer);
+
+    std::vector<std::string> addresses;
+    auto collect = [&](osc_message_view const& m) {
+        addresses.push_back(std::string(m.address, m.address_length));
+    };
+    ASSERT_TRUE(for_each_osc_message(packet.data(), packet.size(), collect));
+    ASSERT_EQ(addresses.size(), 3u);
+    EXPECT_EQ(addresses[0], "/prop/0/trigger");
+    EXPECT_EQ(addresses[2], "/prop/2/trigger");
+
+    std::vector<uint8_t> truncated(packet.begin(), packet.end() - 4);
+    EXPECT_FALSE(for_each_osc_message(truncated.data(), truncated.size(), collect));
+}
+
+// Test the address table routes exact matches only
+TEST(osc_input_test, address_table) {
+    osc_address_table const table(show_routes());
+    show_command_type type = show_command_type::start;
+    uint32_t id = 0;
+    char const address[] = "/prop/2/trigger-and-more";
+    ASSERT_TRUE(table.lookup(address, 15, type, id));
+    EXPECT_EQ(type, show_command_type::trigger);
+    EXPECT_EQ(id, 2u);
+    EXPECT_FALSE(table.lookup(address, sizeof(address) - 1, type, id));
+    EXPECT_FALSE(table.lookup("/prop/3/trigger", 15, type, id));
+    ASSERT_TRUE(table.lookup("/show/seek", 10, type, id));
+    EXPECT_EQ(type, show_command_type::seek);
+}
+
+// Test many routes survive collisions
+TEST(osc_input_test, address_table_many_routes) {
+    std::vector<std::string> names;
+    std::vector<osc_route> routes;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        names.push_back("/prop/" + std::to_string(i) + "/trigger");
+    }
+    for (uint32_t i = 0; i < 1000; ++i) {
+        routes.push_back({names[i].c_str(), show_command_type::trigger, i});
+    }
+    osc_address_table const table(routes);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        show_command_type type;
+        uint32_t id = 0;
+        ASSERT_TRUE(table.lookup(names[i].data(), names[i].size(), type, id));
+        EXPECT_EQ(id, i);
+    }
+}
+
+// Test OSC values: buttons fire on press, start/seek carry show time
+TEST(osc_input_test, osc_commands) {
+    osc_address_table const table(show_routes());
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::osc, &table, nullptr, queue);
+
+    std::vector<uint8_t> const press = osc_int("/prop/1/trigger", 1);
+    std::vector<uint8_t> const release = osc_float("/prop/1/trigger", "", 0.0f);
+    std::vector<uint8_t> const seek = osc_float("/show/seek", "", 1500.0f);
+    std::vector<uint8_t> const unknown = osc_int("/lights/9", 1);
+    EXPECT_EQ(input.process(press.data(), press.size()), 1u);
+    EXPECT_EQ(input.process(release.data(), release.size()), 0u);
+    EXPECT_EQ(input.process(seek.data(), seek.size()), 1u);
+    EXPECT_EQ(input.process(unknown.data(), unknown.size()), 0u);
+    EXPECT_EQ(input.process(press.data(), 3), 0u);
+
+    timed_show_command item;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item.command.type, show_command_type::trigger);
+    EXPECT_EQ(item.command.controller_id, 1u);
+    EXPECT_GT(item.received_ns, 0u);
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item.command.type, show_command_type::seek);
+    EXPECT_EQ(item.command.show_time_ms, 1500u);
+    EXPECT_FALSE(queue.pop(item));
+    EXPECT_EQ(input.packets(), 5u);
+    EXPECT_EQ(input.commands(), 2u);
+    EXPECT_EQ(input.unrouted(), 1u);
+    EXPECT_EQ(input.malformed(), 1u);
+}
+
+// Test out-of-range and NaN show times are clamped or rejected, never cast as is
+TEST(osc_input_test, osc_value_range) {
+    osc_address_table const table(show_routes());
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::osc, &table, nullptr, queue);
+
+    float const values[] = {1e12f, std::numeric_limits<float>::infinity(), -5.0f,
+                            -std::numeric_limits<float>::infinity()};
+    uint32_t const expected[] = {UINT32_MAX, UINT32_MAX, 0, 0};
+    for (size_t i = 0; i < 4; ++i) {
+        std::vector<uint8_t> const seek = osc_float("/show/seek", "", values[i]);
+        ASSERT_EQ(input.process(seek.data(), seek.size()), 1u) << i;
+        timed_show_command item;
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item.command.show_time_ms, expected[i]) << i;
+    }
+
+    std::vector<uint8_t> const nan_seek =
+        osc_float("/show/seek", "", std::numeric_limits<float>::quiet_NaN());
+    std::vector<uint8_t> const nan_press =
+        osc_float("/prop/0/trigger", "", std::numeric_limits<float>::quiet_NaN());
+    EXPECT_EQ(input.process(nan_seek.data(), nan_seek.size()), 0u);
+    EXPECT_EQ(input.process(nan_press.data(), nan_press.size()), 0u);
+    EXPECT_EQ(queue.size(), 0u);
+    EXPECT_EQ(input.malformed(), 2u);
+}
+
+// Test integer and double show times past 2^24 ms (4.66 h) seek to the exact millisecond
+TEST(osc_input_test, osc_exact_show_time) {
+    osc_address_table const table(show_routes());
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::osc, &table, nullptr, queue);
+
+    double const exact = 16777217.0;  // 2^24 + 1: a float rounds it to 2^24
+    uint64_t double_bits = 0;
+    std::memcpy(&double_bits, &exact, sizeof(double_bits));
+    std::vector<std::vector<uint8_t>> const seeks = {
+        osc_int("/show/seek", 16777217),
+        osc_wide("/show/seek", 'h', 4000000001ull),
+        osc_wide("/show/seek", 'd', double_bits),
+        osc_wide("/show/seek", 'h', 1ull << 40),  // clamped
+        osc_int("/show/seek", -1),  // clamped
+        osc_float("/show/seek", "", 16777217.0f),  // rounded by the float itself
+    };
+    uint32_t const expected[] = {16777217, 4000000001u, 16777217, UINT32_MAX, 0, 16777216};
+    for (size_t i = 0; i < seeks.size(); ++i) {
+        ASSERT_EQ(input.process(seeks[i].data(), seeks[i].size()), 1u) << i;
+        timed_show_command item;
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item.command.show_time_ms, expected[i]) << i;
+    }
+
+    // A NaN double is malformed like a NaN float
+    double const nan = std::numeric_limits<double>::quiet_NaN();
+    std::memcpy(&double_bits, &nan, sizeof(double_bits));
+    std::vector<uint8_t> const nan_seek = osc_wide("/show/seek", 'd', double_bits);
+    EXPECT_EQ(input.process(nan_seek.data(), nan_seek.size()), 0u);
+    EXPECT_EQ(input.malformed(), 1u);
+}
+
+// Test a full queue drops and counts instead of blocking
+TEST(osc_input_test, full_queue_drops) {
+    osc_address_table const table(show_routes());
+    spsc_queue<timed_show_command> queue(2);
+    udp_control_input input(control_protocol::osc, &table, nullptr, queue);
+    std::vector<uint8_t> const press = osc_int("/prop/0/trigger", 1);
+    for (int i = 0; i < 5; ++i) {
+        input.process(press.data(), press.size());
+    }
+    EXPECT_EQ(queue.size(), 2u);
+    EXPECT_EQ(input.dropped(), 3u);
+}
+
+// Test RTP-MIDI note-ons with running status and delta times
+TEST(osc_input_test, rtp_midi_note_on) {
+    midi_note_map notes;
+    notes.map(0, 60, 0);
+    notes.map(0, 62, 1);
+    notes.map(9, 36, 2);
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::rtp_midi, nullptr, &notes, queue);
+
+    // Note on 60, (delta) running-status note 62, (delta) note off via velocity 0,
+    // (delta) drum channel note 36, (delta) unmapped note 70
+    std::vector<uint8_t> const commands = {0x90, 60, 100, 0x00, 62,  90, 0x00, 60,  0,
+                                           0x05, 0x99, 36, 127, 0x81, 0x00, 0x99, 70, 1};
+    std::vector<uint8_t> const packet = rtp_midi(commands, false);
+    EXPECT_EQ(input.process(packet.data(), packet.size()), 3u);
+    EXPECT_EQ(input.unrouted(), 1u);
+    EXPECT_EQ(input.malformed(), 0u);
+
+    uint32_t expected[] = {0, 1, 2};
+    for (uint32_t id : expected) {
+        timed_show_command item;
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item.command.type, show_command_type::trigger);
+        EXPECT_EQ(item.command.controller_id, id);
+    }
+
+    std::vector<uint8_t> const bad_version = {0x40, 0x61, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0x03,
+                                              0x90, 60, 100};
+    EXPECT_EQ(input.process(bad_version.data(), bad_version.size()), 0u);
+    std::vector<uint8_t> truncated = packet;
+    truncated.pop_back();
+    input.process(truncated.data(), truncated.size());
+    EXPECT_EQ(input.malformed(), 2u);
+}
+
+// Test an RTP header extension is skipped and padding stripped, not read as MIDI
+TEST(osc_input_test, rtp_midi_extension_and_padding) {
+    midi_note_map notes;
+    notes.map(0, 60, 0);
+    notes.map(0, 62, 1);
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::rtp_midi, nullptr, &notes, queue);
+
+    std::vector<uint8_t> packet = rtp_midi({0x90, 60, 100}, false);
+    // X: one-word extension whose bytes would be a note-on 62 if parsed as MIDI
+    packet[0] |= 0x10;
+    std::vector<uint8_t> const extension = {0xBE, 0xDE, 0x00, 0x01, 0x90, 62, 100, 0x00};
+    packet.insert(packet.begin() + 12, extension.begin(), extension.end());
+    // P: three padding bytes, the last one counting them; the first would be a note-on
+    packet[0] |= 0x20;
+    packet.push_back(0x90);
+    packet.push_back(62);
+    packet.push_back(3);
+    EXPECT_EQ(input.process(packet.data(), packet.size()), 1u);
+    EXPECT_EQ(input.malformed(), 0u);
+    timed_show_command item;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(item.command.controller_id, 0u);
+    EXPECT_FALSE(queue.pop(item));
+
+    // Padding longer than the packet, or an extension running past it, is malformed
+    std::vector<uint8_t> overpadded = rtp_midi({0x90, 60, 100}, false);
+    overpadded[0] |= 0x20;
+    overpadded.push_back(200);
+    std::vector<uint8_t> overextended = rtp_midi({0x90, 60, 100}, false);
+    overextended[0] |= 0x10;
+    std::vector<uint8_t> const long_header = {0xBE, 0xDE, 0x00, 0x09};
+    overextended.insert(overextended.begin() + 12, long_header.begin(), long_header.end());
+    EXPECT_EQ(input.process(overpadded.data(), overpadded.size()), 0u);
+    EXPECT_EQ(input.process(overextended.data(), overextended.size()), 0u);
+    EXPECT_EQ(input.malformed(), 2u);
+}
+
+// Test system messages consume their data bytes and keep the command list in step
+TEST(osc_input_test, rtp_midi_system_messages) {
+    midi_note_map notes;
+    notes.map(0, 60, 0);
+    notes.map(0, 62, 1);
+    notes.map(0, 64, 2);
+    spsc_queue<timed_show_command> queue(16);
+    udp_control_input input(control_protocol::rtp_midi, nullptr, &notes, queue);
+
+    // Song position pointer, note on 60, (delta) MTC quarter frame, (delta) note on 62,
+    // (delta) timing clock then running-status note 64, (delta) song select
+    std::vector<uint8_t> const commands = {0xF2, 0x10, 0x20, 0x00, 0x90, 60, 100, 0x00, 0xF1,
+                                           0x35, 0x00, 0x90, 62, 100, 0x00, 0xF8, 0x00, 64,
+                                           100, 0x00, 0xF3, 0x05};
+    std::vector<uint8_t> const packet = rtp_midi(commands, false);
+    EXPECT_EQ(input.process(packet.data(), packet.size()), 3u);
+    EXPECT_EQ(input.malformed(), 0u);
+    for (uint32_t id = 0; id < 3; ++id) {
+        timed_show_command item;
+        ASSERT_TRUE(queue.pop(item));
+        EXPECT_EQ(item.command.controller_id, id);
+    }
+
+    // System common cancels running status: a bare data byte after it is malformed
+    std::vector<uint8_t> const cancelled = rtp_midi({0x90, 60, 100, 0x00, 0xF3, 0x05, 0x00, 62,
+                                                     100},
+                                                    false);
+    input.process(cancelled.data(), cancelled.size());
+    EXPECT_EQ(input.malformed(), 1u);
+}
+
+// Test end to end over loopback UDP: receiver thread -> queue -> show_node edge
+TEST(osc_input_test, loopback_input_to_edge_latency) {
+    osc_address_table const table(show_routes());
+    spsc_queue<timed_show_command> queue(256);
+    udp_control_input input(control_protocol::osc, &table, nullptr, queue);
+    ASSERT_TRUE(input.open(0));
+    ASSERT_NE(input.port(), 0u);
+
+    std::atomic<bool> stop(false);
+    std::thread receiver([&]() {
+        while (!stop.load()) {
+            input.poll(5);
+        }
+    });
+
+    real_time_timer timer;
+    std::vector<blink_timing> const timings(3, blink_timing{60000, 0});
+    show_node<mock_pin, real_time_timer> node(0, 0, timer, timings);
+    node.apply(show_command{show_command_type::start, ALL_CONTROLLERS, 0}, monotonic_ns());
+
+    udp_sender sender(input.port());
+    size_t const TRIGGERS = 200;
+    size_t applied = 0;
+    uint64_t total_ns = 0;
+    uint64_t worst_ns = 0;
+    for (size_t i = 0; i < TRIGGERS; ++i) {
+        char address[32];
+        std::snprintf(address, sizeof(address), "/prop/%u/trigger", static_cast<unsigned>(i % 3));
+        uint64_t const sent_ns = monotonic_ns();
+        ASSERT_TRUE(sender.send(osc_int(address, 1)));
+        timed_show_command item;
+        uint64_t const deadline = sent_ns + 1000000000ull;
+        bool received = false;
+        while (!(received = queue.pop(item)) && monotonic_ns() < deadline) {
+            node.update();
+        }
+        if (!received) {
+            // Not ASSERT: the receiver thread must still be stopped and joined
+            ADD_FAILURE() << "trigger " << i << " not received within 1 s";
+            break;
+        }
+        EXPECT_EQ(item.command.controller_id, i % 3);
+        node.apply(item.command, item.received_ns);
+        uint64_t const edge_ns = monotonic_ns() - sent_ns;
+        total_ns += edge_ns;
+        worst_ns = std::max(worst_ns, edge_ns);
+        ++applied;
+        node.update();
+    }
+    stop = true;
+    receiver.join();
+
+    EXPECT_EQ(applied, TRIGGERS);
+    EXPECT_EQ(input.commands(), TRIGGERS);
+    EXPECT_EQ(input.dropped(), 0u);
+    node_health const health = node.health();
+    EXPECT_GE(health.edges, TRIGGERS);
+    std::printf("send->edge: mean %.1f us, max %.1f us; receive->edge max %.1f us\n",
+                total_ns / 1000.0 / TRIGGERS, worst_ns / 1000.0,
+                health.max_trigger_latency_ns / 1000.0);
+    RecordProperty("mean_send_to_edge_ns", static_cast<int>(total_ns / TRIGGERS));
+    RecordProperty("max_receive_to_edge_ns", static_cast<int>(health.max_trigger_latency_ns));
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "palette_frame.h"
+
+namespace {
+
+// Random indices and palettes in every segment
+void fill(std::mt19937& rng, palette_frame& frame) {
+    for (size_t p = 0; p < frame.pixels(); ++p) {
+        frame.set_pixel(p, static_cast<uint8_t>(rng()));
+    }
+    for (size_t s = 0; s < frame.segments(); ++s) {
+        for (size_t i = 0; i < frame.palette_size(); ++i) {
+            frame.set_color(s, static_cast<uint8_t>(i), rng());
+        }
+    }
+}
+
+}  // namespace
+
+// Test pixel indices pack and read back at both depths
+TEST(palette_frame_test, indices_round_trip) {
+    palette_frame nibbles(33, palette_depth::bits4);
+    palette_frame bytes(33, palette_depth::bits8);
+    for (size_t p = 0; p < 33; ++p) {
+        nibbles.set_pixel(p, static_cast<uint8_t>(p * 7));
+        bytes.set_pixel(p, static_cast<uint8_t>(p * 7));
+    }
+    for (size_t p = 0; p < 33; ++p) {
+        EXPECT_EQ(nibbles.pixel(p), (p * 7) & 0x0F) << p;
+        EXPECT_EQ(bytes.pixel(p), (p * 7) & 0xFF) << p;
+    }
+    EXPECT_EQ(nibbles.index_bytes(), 17u);
+    EXPECT_EQ(bytes.index_bytes(), 33u);
+    EXPECT_EQ(nibbles.segments(), 1u);
+    EXPECT_EQ(nibbles.segment_pixels(), 48u);  // rounded up to whole 16-pixel blocks
+
+    nibbles.set_color(0, 3, 0x12345678);
+    EXPECT_EQ(nibbles.color(0, 3), 0x345678u);
+    nibbles.set_pixel(10, 3);
+    EXPECT_EQ(nibbles.rgb(10), 0x345678u);
+}
+
+// Test the gather expansion equals the scalar one for every depth, segment size and tail
+TEST(palette_frame_test, gather_matches_scalar) {
+    std::mt19937 rng(89);
+    size_t const sizes[] = {1, 8, 9, 10, 17, 100, 1023, 4096};
+    size_t const segments[] = {0, 16, 40};
+    palette_depth const depths[] = {palette_depth::bits4, palette_depth::bits8};
+    for (size_t d = 0; d < 2; ++d) {
+        for (size_t n = 0; n < sizeof(sizes) / sizeof(sizes[0]); ++n) {
+            for (size_t s = 0; s < sizeof(segments) / sizeof(segments[0]); ++s) {
+                palette_frame frame(sizes[n], depths[d], segments[s]);
+                fill(rng, frame);
+                // A guard byte after the output must survive the 28-byte stores
+                std::vector<uint8_t> gathered(sizes[n] * 3 + 1, 0xA5);
+                std::vector<uint8_t> scalar(sizes[n] * 3 + 1, 0xA5);
+                frame.expand_rgb(gathered.data());
+                frame.expand_rgb_scalar(scalar.data());
+                ASSERT_EQ(gathered, scalar) << sizes[n] << " pixels, segment " << segments[s];
+                EXPECT_EQ(gathered.back(), 0xA5);
+                size_t const last = sizes[n] - 1;
+                uint32_t const color = frame.rgb(last);
+                EXPECT_EQ(scalar[last * 3], color >> 16);
+                EXPECT_EQ(scalar[last * 3 + 2], color & 0xFF);
+            }
+        }
+    }
+    std::printf("gather path %s\n", palette_frame::gather_available() ? "AVX2" : "scalar");
+}
+
+// Test palette animation recolors pixels without writing them
+TEST(palette_frame_test, palette_animation) {
+    palette_frame frame(64, palette_depth::bits4, 32);
+    for (size_t p = 0; p < 64; ++p) {
+        frame.set_pixel(p, static_cast<uint8_t>(p % 4));
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+        frame.set_color(0, i, 0x100000u * (i + 1));
+        frame.set_color(1, i, 0x000010u * (i + 1));
+    }
+    std::vector<uint8_t> const before(frame.indices(), frame.indices() + frame.index_bytes());
+    EXPECT_EQ(frame.rgb(1), 0x200000u);
+    EXPECT_EQ(frame.rgb(33), 0x000020u);
+
+    // Chase: entries 0..3 cycle, in segment 0 only
+    frame.rotate_colors(0, 0, 4);
+    EXPECT_EQ(frame.rgb(0), 0x400000u);
+    EXPECT_EQ(frame.rgb(1), 0x100000u);
+    EXPECT_EQ(frame.rgb(33), 0x000020u);
+    for (int i = 0; i < 3; ++i) {
+        frame.rotate_colors(0, 0, 4);
+    }
+    EXPECT_EQ(frame.rgb(1), 0x200000u);
+
+    frame.set_color(1, 2, 0xFFFFFF);
+    std::vector<uint8_t> rgb(64 * 3);
+    frame.expand_rgb(rgb.data());
+    EXPECT_EQ(rgb[34 * 3], 0xFF);
+    EXPECT_EQ(rgb[34 * 3 + 2], 0xFF);
+    EXPECT_EQ(rgb[2 * 3], 0x30);
+    EXPECT_EQ(std::vector<uint8_t>(frame.indices(), frame.indices() + frame.index_bytes()),
+              before);
+}
+
+// Test rotate_colors clamps its range to the palette instead of reading past it
+TEST(palette_frame_test, rotate_colors_clamps_range) {
+    palette_frame frame(64, palette_depth::bits4, 32);
+    for (uint8_t i = 0; i < 16; ++i) {
+        frame.set_color(0, i, i);
+        frame.set_color(1, i, 0x100 + i);
+    }
+
+    // 14..14+200 clamps to 14..15
+    frame.rotate_colors(0, 14, 200);
+    EXPECT_EQ(frame.color(0, 14), 15u);
+    EXPECT_EQ(frame.color(0, 15), 14u);
+    EXPECT_EQ(frame.color(0, 13), 13u);
+    EXPECT_EQ(frame.color(1, 0), 0x100u);
+
+    // Past the end of a 16-entry palette: nothing moves
+    frame.rotate_colors(0, 16, 4);
+    frame.rotate_colors(0, 200, 40);
+    for (uint8_t i = 0; i < 14; ++i) {
+        EXPECT_EQ(frame.color(0, i), i);
+    }
+    for (uint8_t i = 0; i < 16; ++i) {
+        EXPECT_EQ(frame.color(1, i), 0x100u + i);
+    }
+}
+
+// Benchmark: memory per frame, frame copy and expansion cost for a 100k-pixel installation
+TEST(palette_frame_test, memory_and_bandwidth) {
+    std::mt19937 rng(1089);
+    size_t const PIXELS = 100000;
+    size_t const RGB_BYTES = PIXELS * 3;
+    palette_frame wide(PIXELS, palette_depth::bits8);
+    palette_frame segmented(PIXELS, palette_depth::bits4, 1024);
+    fill(rng, wide);
+    fill(rng, segmented);
+
+    // Both against packed 24-bit RGB, the smallest unindexed frame
+    double const wide_ratio = static_cast<double>(RGB_BYTES) / wide.memory_bytes();
+    double const segmented_ratio = static_cast<double>(RGB_BYTES) / segmented.memory_bytes();
+    std::printf("100k pixels: rgb24 %zu B, 8-bit %zu B (%.2fx of rgb24), "
+                "4-bit / 1024-pixel palettes %zu B (%.2fx of rgb24)\n",
+                RGB_BYTES, wide.memory_bytes(), wide_ratio, segmented.memory_bytes(),
+                segmented_ratio);
+    // 8-bit: one byte per pixel plus the 1 KB palette; 4-bit clears 3x
+    EXPECT_GE(wide_ratio, 2.95);
+    EXPECT_GE(segmented_ratio, 3.0);
+
+    int const FRAMES = 200;
+    std::vector<uint8_t> rgb(RGB_BYTES);
+    std::vector<uint8_t> copy(RGB_BYTES);
+    auto time_us = [&](int kind) {
+        auto const start = std::chrono::steady_clock::now();
+        for (int i = 0; i < FRAMES; ++i) {
+            if (kind == 0) {
+                std::memcpy(copy.data(), rgb.data(), RGB_BYTES);
+            } else if (kind == 1) {
+                std::memcpy(copy.data(), segmented.indices(), segmented.index_bytes());
+            } else if (kind == 2) {
+                segmented.expand_rgb(rgb.data());
+            } else if (kind == 3) {
+                segmented.expand_rgb_scalar(rgb.data());
+            } else {
+                wide.expand_rgb(rgb.data());
+            }
+        }
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() -
+                                                         start)
+                   .count() /
+               FRAMES;
+    };
+    double const copy_rgb = time_us(0);
+    double const copy_indexed = time_us(1);
+    double const expand4 = time_us(2);
+    double const expand4_scalar = time_us(3);
+    double const expand8 = time_us(4);
+    std::printf("per frame: copy rgb24 %.1f us, copy 4-bit %.1f us; expand 4-bit %.1f us "
+                "(scalar %.1f us), 8-bit %.1f us (%s)\n",
+                copy_rgb, copy_indexed, expand4, expand4_scalar, expand8,
+                palette_frame::gather_available() ? "AVX2 gather" : "scalar");
+    EXPECT_LT(expand4, 20000.0);
+}
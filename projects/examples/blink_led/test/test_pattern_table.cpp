@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "blink_controller.h"
+#include "mock_hardware.h"
+#include "pattern_table.h"
+
+namespace {
+
+constexpr uint32_t FRAME_MS = 20;
+
+// Eyes, jaw and strobe of one prop (50 fps)
+constexpr blink_timing PROP[] = {{100, 100}, {40, 120}, {20, 20}};
+constexpr auto PROP_TABLE =
+    make_pattern_table<pattern_table_frames(PROP, FRAME_MS)>(PROP, FRAME_MS);
+static_assert(pattern_table_matches_controllers(PROP_TABLE, PROP, FRAME_MS),
+              "prop table differs from blink_controller");
+static_assert(PROP_TABLE.period() == 40, "lcm of 10, 8 and 2 frames");
+static_assert(PROP_TABLE.state(0, 5) && !PROP_TABLE.state(0, 10), "eyes: off 5, on 5");
+
+// Edge cases: zero phases, durations not a multiple of the frame, one-frame phases
+constexpr blink_timing EDGES[] = {{0, 0}, {0, 7}, {7, 0}, {1, 1}, {30, 50}, {19, 21}};
+constexpr auto EDGES_TABLE =
+    make_pattern_table<pattern_table_frames(EDGES, FRAME_MS)>(EDGES, FRAME_MS);
+static_assert(pattern_table_matches_controllers(EDGES_TABLE, EDGES, FRAME_MS),
+              "edge-case table differs from blink_controller");
+
+// A table checked against different timings (same size) fails
+constexpr blink_timing PROP_RETIMED[] = {{120, 80}, {40, 120}, {20, 20}};
+static_assert(pattern_table_frames(PROP_RETIMED, FRAME_MS) == PROP_TABLE.frames(), "same size");
+static_assert(!pattern_table_matches_controllers(PROP_TABLE, PROP_RETIMED, FRAME_MS),
+              "mismatched timings must not pass");
+
+// More than 64 channels spans several words per frame
+constexpr blink_timing make_wide_timing(size_t i) {
+    return blink_timing{static_cast<uint32_t>(FRAME_MS * (1 + i % 2)),
+                        static_cast<uint32_t>(FRAME_MS * (1 + (i / 2) % 3))};
+}
+
+constexpr blink_timing WIDE[] = {
+#define WIDE_ROW(n)                                                                   \
+    make_wide_timing(n + 0), make_wide_timing(n + 1), make_wide_timing(n + 2),       \
+        make_wide_timing(n + 3), make_wide_timing(n + 4), make_wide_timing(n + 5),   \
+        make_wide_timing(n + 6), make_wide_timing(n + 7), make_wide_timing(n + 8),   \
+        make_wide_timing(n + 9)
+    WIDE_ROW(0), WIDE_ROW(10), WIDE_ROW(20), WIDE_ROW(30), WIDE_ROW(40),
+    WIDE_ROW(50), WIDE_ROW(60)
+#undef WIDE_ROW
+};
+constexpr auto WIDE_TABLE =
+    make_pattern_table<pattern_table_frames(WIDE, FRAME_MS)>(WIDE, FRAME_MS);
+static_assert(pattern_table_matches_controllers(WIDE_TABLE, WIDE, FRAME_MS),
+              "wide table differs from blink_controller");
+static_assert(decltype(WIDE_TABLE)::WORDS == 2, "70 channels need two words per frame");
+
+}  // namespace
+
+// Test table lookups match running controllers far past the rendered frames
+TEST(pattern_table_test, matches_controllers_at_runtime) {
+    size_t const CHANNELS = sizeof(WIDE) / sizeof(WIDE[0]);
+    std::vector<mock_pin> pins(CHANNELS);
+    std::vector<blink_controller<mock_pin>> controllers;
+    controllers.reserve(CHANNELS);
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        controllers.emplace_back(pins[i], WIDE[i].on_ms, WIDE[i].off_ms);
+    }
+    for (uint64_t frame = 0; frame < 100000; ++frame) {
+        uint64_t const* bits = WIDE_TABLE.frame_bits(frame);
+        for (size_t i = 0; i < CHANNELS; ++i) {
+            controllers[i].update(static_cast<uint32_t>(frame * FRAME_MS));
+            ASSERT_EQ(pins[i].get_state(), WIDE_TABLE.state(i, frame)) << i << " @ " << frame;
+            ASSERT_EQ(pins[i].get_state(), ((bits[i / 64] >> (i % 64)) & 1) != 0);
+        }
+    }
+}
+
+// Test rows: prefix frames map to themselves, later frames into the period
+TEST(pattern_table_test, rows) {
+    EXPECT_EQ(EDGES_TABLE.prefix(), 3u);  // ceil(50 / 20)
+    EXPECT_EQ(EDGES_TABLE.row(2), 2u);
+    EXPECT_EQ(EDGES_TABLE.row(3), 3u);
+    EXPECT_EQ(EDGES_TABLE.row(3 + EDGES_TABLE.period()), 3u);
+    EXPECT_EQ(EDGES_TABLE.row(1000000007ull), 3 + (1000000007ull - 3) % EDGES_TABLE.period());
+    EXPECT_EQ(EDGES_TABLE.frames(), EDGES_TABLE.prefix() + EDGES_TABLE.period());
+}
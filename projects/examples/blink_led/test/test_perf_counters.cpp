@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "blink_bank.h"
+#include "blink_controller.h"
+#include "pattern_table.h"
+#include "perf_counters.h"
+
+namespace {
+
+constexpr uint32_t TABLE_FRAME_MS = 20;
+
+// One prop's channels at 50 fps, rendered at compile time for the lookup report
+constexpr blink_timing TABLE_TIMINGS[] = {{100, 100}, {40, 120}, {20, 20}, {60, 40},
+                                          {200, 100}, {80, 80},  {40, 40}, {120, 60}};
+constexpr auto TIMING_TABLE = make_pattern_table<pattern_table_frames(
+    TABLE_TIMINGS, TABLE_FRAME_MS)>(TABLE_TIMINGS, TABLE_FRAME_MS);
+
+struct byte_pin {
+    void set(bool state) { value = state ? 1 : 0; }
+    uint8_t value = 0;
+};
+
+struct layout_result {
+    double ns;
+    perf_counter_values counters;
+    uint64_t on;  // controllers on at the end, to check the layouts agree
+};
+
+template<typename frame_t>
+layout_result measure(uint32_t frames, frame_t frame) {
+    perf_counters counters;
+    auto const start = std::chrono::steady_clock::now();
+    counters.start();
+    for (uint32_t now = 0; now < frames; ++now) {
+        frame(now);
+    }
+    layout_result result;
+    result.counters = counters.stop();
+    result.ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    result.on = 0;
+    return result;
+}
+
+std::string column(perf_counter_values const& values, perf_counter kind, uint64_t updates) {
+    if (!values.has(kind)) {
+        return "n/a";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.3f", values.per(kind, updates));
+    return text;
+}
+
+void print_row(char const* layout, size_t channels, char const* timing,
+               layout_result const& result, uint64_t updates) {
+    perf_counter_values const& v = result.counters;
+    std::printf("%-10s %8zu  %-5s %8.3f %8s %8s %10s %11s\n", layout, channels, timing,
+                result.ns / updates, column(v, perf_counter::cycles, updates).c_str(),
+                column(v, perf_counter::instructions, updates).c_str(),
+                column(v, perf_counter::cache_misses, updates).c_str(),
+                column(v, perf_counter::branch_misses, updates).c_str());
+}
+
+}  // namespace
+
+// Test counters either count or report themselves missing, never fail the benchmark
+TEST(perf_counters_test, counts_or_reports_missing) {
+    perf_counters counters;
+    counters.start();
+    volatile uint64_t sum = 0;
+    for (uint32_t i = 0; i < 1000000; ++i) {
+        sum = sum + i;
+    }
+    perf_counter_values const values = counters.stop();
+    for (size_t i = 0; i < PERF_COUNTER_KINDS; ++i) {
+        perf_counter const kind = static_cast<perf_counter>(i);
+        EXPECT_EQ(values.has(kind), counters.has(kind));
+        if (!values.has(kind)) {
+            EXPECT_EQ(values.get(kind), 0u);
+            EXPECT_EQ(values.per(kind, 10), 0.0);
+        }
+    }
+    if (values.has(perf_counter::task_clock_ns)) {
+        EXPECT_GT(values.get(perf_counter::task_clock_ns), 0u);
+    }
+    if (!counters.hardware_available()) {
+        GTEST_SKIP() << "no hardware counters here (perf_event_open unsupported or forbidden)";
+    }
+    if (values.has(perf_counter::instructions)) {
+        EXPECT_GT(values.get(perf_counter::instructions), 1000000u);
+    }
+}
+
+// Report: AoS blink_controller arrays vs batched blink_bank, per controller update
+TEST(perf_counters_test, layout_report) {
+    uint64_t const UPDATES_PER_ROW = 8000000;
+    size_t const SIZES[] = {1024, 262144};
+    struct timing_range {
+        char const* name;
+        uint32_t min_ms;
+        uint32_t max_ms;
+    };
+    // Slow: toggles are rare and predictable. Fast: toggles every few updates.
+    timing_range const TIMINGS[] = {{"slow", 200, 2000}, {"fast", 1, 6}};
+
+    perf_counters probe;
+    std::printf("hardware counters %s\n", probe.hardware_available() ? "available" : "n/a");
+    std::printf("%-10s %8s  %-5s %8s %8s %8s %10s %11s\n", "layout", "channels", "time",
+                "ns/upd", "cycles", "instr", "cache-miss", "branch-miss");
+    for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); ++s) {
+        for (size_t t = 0; t < sizeof(TIMINGS) / sizeof(TIMINGS[0]); ++t) {
+            size_t const channels = SIZES[s];
+            timing_range const& timing = TIMINGS[t];
+            uint32_t const frames = static_cast<uint32_t>(UPDATES_PER_ROW / channels);
+            uint64_t const updates = static_cast<uint64_t>(frames) * channels;
+            std::mt19937 rng(static_cast<uint32_t>(92 + s * 2 + t));
+            std::vector<blink_timing> timings(channels);
+            for (size_t i = 0; i < channels; ++i) {
+                uint32_t const span = timing.max_ms - timing.min_ms + 1;
+                uint32_t const on = timing.min_ms + rng() % span;
+                uint32_t const off = timing.min_ms + rng() % span;
+                timings[i] = blink_timing{on, off};
+            }
+
+            // Array of controllers, each with a reference to its own pin
+            std::vector<byte_pin> pins(channels);
+            std::vector<blink_controller<byte_pin>> aos;
+            aos.reserve(channels);
+            for (size_t i = 0; i < channels; ++i) {
+                aos.emplace_back(pins[i], timings[i].on_ms, timings[i].off_ms);
+            }
+            layout_result aos_result = measure(frames, [&](uint32_t now) {
+                for (size_t i = 0; i < channels; ++i) {
+                    aos[i].update(now);
+                }
+            });
+
+            // Controllers allocated one by one and visited in shuffled order
+            std::vector<byte_pin> heap_pins(channels);
+            std::vector<std::unique_ptr<blink_controller<byte_pin>>> heap;
+            for (size_t i = 0; i < channels; ++i) {
+                heap.emplace_back(new blink_controller<byte_pin>(heap_pins[i], timings[i].on_ms,
+                                                                 timings[i].off_ms));
+            }
+            std::shuffle(heap.begin(), heap.end(), rng);
+            layout_result heap_result = measure(frames, [&](uint32_t now) {
+                for (size_t i = 0; i < channels; ++i) {
+                    heap[i]->update(now);
+                }
+            });
+
+            blink_bank bank;
+            for (size_t i = 0; i < channels; ++i) {
+                bank.add(timings[i].on_ms, timings[i].off_ms);
+            }
+            layout_result bank_result = measure(frames, [&](uint32_t now) { bank.update(now); });
+
+            for (size_t i = 0; i < channels; ++i) {
+                aos_result.on += pins[i].value;
+                heap_result.on += heap_pins[i].value;
+                bank_result.on += bank.states()[i];
+            }
+            EXPECT_EQ(aos_result.on, bank_result.on);
+            EXPECT_EQ(heap_result.on, bank_result.on);
+
+            print_row("aos", channels, timing.name, aos_result, updates);
+            print_row("aos_heap", channels, timing.name, heap_result, updates);
+            print_row("bank", channels, timing.name, bank_result, updates);
+        }
+    }
+}
+
+// Report: evaluating blink_controllers every frame vs looking states up in a pattern_table
+TEST(perf_counters_test, pattern_table_report) {
+    size_t const CHANNELS = sizeof(TABLE_TIMINGS) / sizeof(TABLE_TIMINGS[0]);
+    uint32_t const FRAMES = 1000000;
+    uint64_t const updates = static_cast<uint64_t>(FRAMES) * CHANNELS;
+
+    std::vector<byte_pin> pins(CHANNELS);
+    std::vector<blink_controller<byte_pin>> controllers;
+    controllers.reserve(CHANNELS);
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        controllers.emplace_back(pins[i], TABLE_TIMINGS[i].on_ms, TABLE_TIMINGS[i].off_ms);
+    }
+    layout_result controller_result = measure(FRAMES, [&](uint32_t frame) {
+        for (size_t i = 0; i < CHANNELS; ++i) {
+            controllers[i].update(frame * TABLE_FRAME_MS);
+        }
+    });
+
+    std::vector<byte_pin> table_pins(CHANNELS);
+    layout_result table_result = measure(FRAMES, [&](uint32_t frame) {
+        uint64_t const bits = TIMING_TABLE.frame_bits(frame)[0];
+        for (size_t i = 0; i < CHANNELS; ++i) {
+            table_pins[i].set(((bits >> i) & 1) != 0);
+        }
+    });
+
+    for (size_t i = 0; i < CHANNELS; ++i) {
+        controller_result.on += pins[i].value;
+        table_result.on += table_pins[i].value;
+        EXPECT_EQ(table_pins[i].value, pins[i].value) << i;
+    }
+    print_row("controller", CHANNELS, "prop", controller_result, updates);
+    print_row("lookup", CHANNELS, "prop", table_result, updates);
+}
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "blink_bank.h"
+#include "rs485_link.h"
+
+namespace {
+
+/**
+ * @brief The slave boards of a simulated bus, served from a thread
+ *
+ * Every slave sees every byte, as on a multi-drop line; replies are written
+ * back to the master. Every corrupt_every-th reply gets a byte flipped.
+ */
+struct simulated_bus {
+   public:
+    simulated_bus(int fd, size_t corrupt_every) : fd_(fd), corrupt_every_(corrupt_every) {}
+
+    void start() {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    void join() { thread_.join(); }
+
+    std::vector<rs485_slave> slaves;
+
+   private:
+    void run() {
+        uint8_t buffer[256];
+        uint8_t reply[RS485_MAX_REPLY];
+        size_t replies = 0;
+        for (;;) {
+            ssize_t const n = ::read(fd_, buffer, sizeof(buffer));
+            if (n <= 0) {
+                return;
+            }
+            for (ssize_t i = 0; i < n; ++i) {
+                for (size_t s = 0; s < slaves.size(); ++s) {
+                    size_t const size = slaves[s].receive(buffer[i], reply);
+                    if (size == 0) {
+                        continue;
+                    }
+                    if (corrupt_every_ != 0 && ++replies % corrupt_every_ == 0) {
+                        reply[3] ^= 0x40;
+                    }
+                    ASSERT_EQ(::write(fd_, reply, size), static_cast<ssize_t>(size));
+                }
+            }
+        }
+    }
+
+    int fd_;
+    size_t corrupt_every_;
+    std::thread thread_;
+};
+
+}  // namespace
+
+// Test the CRC check value and framing through noise
+TEST(rs485_link_test, crc_and_framing) {
+    uint8_t const check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    EXPECT_EQ(rs485_crc16(check, sizeof(check)), 0x4B37);
+
+    rs485_frame frame;
+    frame.address = 0x21;
+    frame.type = rs485_type::keyframe;
+    frame.sequence = 7;
+    frame.length = 3;
+    frame.payload[0] = RS485_FLAG;  // escaped on the wire
+    frame.payload[1] = RS485_ESCAPE;
+    frame.payload[2] = 0xFF;
+    uint8_t wire[RS485_MAX_WIRE];
+    size_t const size = rs485_encode(frame, wire);
+    ASSERT_EQ(size, 12u);
+    for (size_t i = 1; i < size; ++i) {
+        EXPECT_NE(wire[i], RS485_FLAG) << i;
+    }
+
+    // Noise, a copy with a corrupted length (claims a longer frame), then the good frame
+    std::vector<uint8_t> stream = {0x00, RS485_FLAG, 0x13};
+    size_t const corrupted = stream.size() + 4;
+    stream.insert(stream.end(), wire, wire + size);
+    stream[corrupted] = 40;
+    stream.insert(stream.end(), wire, wire + size);
+    rs485_parser parser;
+    rs485_frame parsed;
+    size_t frames = 0;
+    for (size_t i = 0; i < stream.size(); ++i) {
+        if (parser.push(stream[i], parsed)) {
+            ++frames;
+            EXPECT_EQ(i, stream.size() - 1);
+        }
+    }
+    ASSERT_EQ(frames, 1u);
+    EXPECT_EQ(parser.crc_errors(), 2u);  // the noise frame and the corrupted one, both cut short
+    EXPECT_EQ(parsed.address, 0x21);
+    EXPECT_EQ(parsed.type, rs485_type::keyframe);
+    EXPECT_EQ(parsed.sequence, 7);
+    ASSERT_EQ(parsed.length, 3);
+    EXPECT_EQ(std::memcmp(parsed.payload, frame.payload, 3), 0);
+}
+
+// Test deltas round-trip, stay small for sparse changes and give up past the limit
+TEST(rs485_link_test, delta_encoding) {
+    std::mt19937 rng(5);
+    size_t const outputs = 300;
+    size_t const bytes = rs485_bitmap_bytes(outputs);
+    for (size_t changes = 1; changes <= 64; changes *= 2) {
+        std::vector<uint8_t> base(bytes);
+        for (size_t i = 0; i < outputs; ++i) {
+            base[i >> 3] |= static_cast<uint8_t>((rng() & 1) << (i & 7));
+        }
+        std::vector<uint8_t> current = base;
+        for (size_t c = 0; c < changes; ++c) {
+            size_t const i = rng() % outputs;
+            current[i >> 3] ^= static_cast<uint8_t>(1u << (i & 7));
+        }
+        uint8_t delta[RS485_MAX_PAYLOAD];
+        size_t const size =
+            rs485_encode_delta(base.data(), current.data(), outputs, delta, sizeof(delta));
+        EXPECT_LE(size, 4 * changes) << changes;
+        std::vector<uint8_t> applied = base;
+        ASSERT_TRUE(rs485_apply_delta(delta, size, applied.data(), outputs));
+        EXPECT_EQ(applied, current) << changes;
+        EXPECT_EQ(rs485_encode_delta(base.data(), current.data(), outputs, delta, size - 1), 0u);
+    }
+
+    uint8_t bitmap[2] = {0, 0};
+    uint8_t const past_end[] = {10, 7};
+    uint8_t const truncated[] = {0x80};
+    EXPECT_FALSE(rs485_apply_delta(past_end, sizeof(past_end), bitmap, 16));
+    EXPECT_FALSE(rs485_apply_delta(truncated, sizeof(truncated), bitmap, 16));
+}
+
+// Test a slave applies deltas against older bases and NAKs unknown ones
+TEST(rs485_link_test, slave_history) {
+    rs485_slave slave(0x30, 16);
+    uint8_t wire[RS485_MAX_WIRE];
+    uint8_t reply[RS485_MAX_REPLY];
+    rs485_parser parser;
+    rs485_frame answer;
+    auto const exchange = [&](rs485_frame const& frame) {
+        size_t const size = rs485_encode(frame, wire);
+        size_t replied = 0;
+        for (size_t i = 0; i < size; ++i) {
+            replied = slave.receive(wire[i], reply);
+        }
+        for (size_t i = 0; i < replied; ++i) {
+            parser.push(reply[i], answer);
+        }
+        // keyframe stands for "no reply"
+        return replied != 0 && answer.sequence == frame.sequence ? answer.type
+                                                                 : rs485_type::keyframe;
+    };
+
+    rs485_frame frame;
+    frame.address = 0x30;
+    frame.type = rs485_type::keyframe;
+    frame.sequence = 1;
+    frame.length = 2;
+    frame.payload[0] = 0x0F;
+    frame.payload[1] = 0x00;
+    EXPECT_EQ(exchange(frame), rs485_type::ack);
+    EXPECT_TRUE(slave.output(3));
+    EXPECT_FALSE(slave.output(4));
+
+    // Flip outputs 4..5 against 1; then (ACK "lost") flip output 8 against 1 again
+    frame.type = rs485_type::delta;
+    frame.sequence = 2;
+    frame.length = 3;
+    frame.payload[0] = 1;
+    frame.payload[1] = 4;
+    frame.payload[2] = 2;
+    EXPECT_EQ(exchange(frame), rs485_type::ack);
+    EXPECT_TRUE(slave.output(5));
+    frame.sequence = 3;
+    frame.payload[1] = 8;
+    frame.payload[2] = 1;
+    EXPECT_EQ(exchange(frame), rs485_type::ack);
+    EXPECT_FALSE(slave.output(5));
+    EXPECT_TRUE(slave.output(8));
+
+    frame.sequence = 4;
+    frame.payload[0] = 99;
+    EXPECT_EQ(exchange(frame), rs485_type::nak);
+    frame.address = 0x31;  // another slave's frame: no reply
+    frame.sequence = 5;
+    frame.payload[0] = 3;
+    EXPECT_EQ(exchange(frame), rs485_type::keyframe);
+    EXPECT_EQ(slave.applied(), 3u);
+    EXPECT_EQ(slave.naks(), 1u);
+}
+
+// Test add_slave rejects more outputs than a frame can carry
+TEST(rs485_link_test, add_slave_rejects_oversized_bitmap) {
+    rs485_master master(-1, 250000);
+    size_t index = 7;
+    EXPECT_FALSE(master.add_slave(0x10, RS485_MAX_OUTPUTS + 1, index));
+    EXPECT_EQ(index, 7u);
+    EXPECT_TRUE(master.add_slave(0x10, RS485_MAX_OUTPUTS, index));
+    EXPECT_EQ(index, 0u);
+    EXPECT_TRUE(master.add_slave(0x11, 8, index));
+    EXPECT_EQ(index, 1u);
+}
+
+// Test a blinking show stays in sync over a socketpair with corrupted replies,
+// and report effective outputs per second of bus time
+TEST(rs485_link_test, socketpair_show) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    size_t const SLAVES = 16;
+    size_t const OUTPUTS = 64;
+    uint32_t const BAUD = 250000;
+    uint32_t const FRAME_MS = 20;
+
+    simulated_bus bus(fds[1], 97);
+    blink_bank bank;
+    std::mt19937 rng(11);
+    rs485_master master(fds[0], BAUD, 100, 5);
+    for (size_t s = 0; s < SLAVES; ++s) {
+        bus.slaves.push_back(rs485_slave(static_cast<uint8_t>(0x10 + s), OUTPUTS));
+        size_t index = 0;
+        ASSERT_TRUE(master.add_slave(static_cast<uint8_t>(0x10 + s), OUTPUTS, index));
+        ASSERT_EQ(index, s);
+        for (size_t i = 0; i < OUTPUTS; ++i) {
+            bank.add(200 + rng() % 1800, 200 + rng() % 1800);
+        }
+    }
+    bus.start();
+
+    size_t in_sync_cycles = 0;
+    uint32_t const CYCLES = 1000;
+    for (uint32_t cycle = 0; cycle < CYCLES; ++cycle) {
+        bank.update(cycle * FRAME_MS);
+        for (size_t s = 0; s < SLAVES; ++s) {
+            master.set_outputs(s, bank.states() + s * OUTPUTS, OUTPUTS);
+        }
+        master.cycle(FRAME_MS * 1000);
+        bool all = true;
+        for (size_t s = 0; s < SLAVES; ++s) {
+            all = all && master.in_sync(s);
+        }
+        in_sync_cycles += all ? 1 : 0;
+    }
+    // Settle: no new changes, retry whatever a corrupted reply left behind
+    for (size_t settle = 0; settle < 4; ++settle) {
+        master.cycle(FRAME_MS * 1000);
+    }
+    shutdown(fds[0], SHUT_WR);
+    bus.join();
+    close(fds[0]);
+    close(fds[1]);
+
+    for (size_t s = 0; s < SLAVES; ++s) {
+        EXPECT_TRUE(master.in_sync(s)) << s;
+        for (size_t i = 0; i < OUTPUTS; ++i) {
+            EXPECT_EQ(bus.slaves[s].output(i), bank.is_on(s * OUTPUTS + i)) << s << " " << i;
+        }
+    }
+    rs485_master_stats const& stats = master.stats();
+    EXPECT_GT(stats.timeouts, 0u);  // corrupted replies were recovered from
+    // A corrupted ACK leaves its slave behind for a cycle; the budget rarely does
+    EXPECT_LE(CYCLES - in_sync_cycles, stats.timeouts + CYCLES / 20);
+
+    // One frame (2-byte index + value) and ACK per change is the naive alternative
+    double const naive_us = master.wire_us(RS485_HEADER_BYTES + 3 + RS485_CRC_BYTES +
+                                           RS485_HEADER_BYTES + RS485_CRC_BYTES) +
+                            200.0;
+    double const outputs_per_s = stats.changes / (stats.bus_us / 1e6);
+    std::printf("rs485 link: %zu outputs, %llu changes in %llu frames (%llu keyframes, %llu "
+                "timeouts, %llu naks), %.1f ms bus time\n",
+                SLAVES * OUTPUTS, static_cast<unsigned long long>(stats.changes),
+                static_cast<unsigned long long>(stats.frames),
+                static_cast<unsigned long long>(stats.keyframes),
+                static_cast<unsigned long long>(stats.timeouts),
+                static_cast<unsigned long long>(stats.naks), stats.bus_us / 1e3);
+    std::printf("rs485 link: %.0f output changes/s of bus time at %u baud, naive %.0f/s\n",
+                outputs_per_s, BAUD, 1e6 / naive_us);
+    EXPECT_GT(outputs_per_s, 1e6 / naive_us);
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+#include "sampling_profiler.h"
+
+namespace {
+
+struct null_pin {
+    void set(bool state) { last = state; }
+    volatile bool last = false;
+};
+
+// CPU time of this thread in milliseconds
+double thread_cpu_ms() {
+    timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+// Spin on real controller work for a number of CPU milliseconds (of this thread, which is
+// what ITIMER_PROF samples, however much of the CPU the host hands out)
+void busy(std::vector<blink_controller<null_pin>>& bank, double cpu_ms) {
+    double const start = thread_cpu_ms();
+    uint32_t now = 0;
+    while (thread_cpu_ms() - start < cpu_ms) {
+        for (size_t i = 0; i < bank.size(); ++i) {
+            bank[i].update(now);
+        }
+        ++now;
+    }
+}
+
+}  // namespace
+
+// Test samples aggregate per exact stack and dump as folded lines
+TEST(sampling_profiler_test, aggregates_folded_stacks) {
+    sampling_profiler profiler("show");
+    uint16_t const flicker = profiler.add_phase("flicker");
+    uint16_t const encode = profiler.add_phase("encode");
+    uint16_t const flush = profiler.add_phase("flush");
+
+    profile_marker& marker = profile_thread_marker();
+    profiler.record(marker);  // outside any scope
+    {
+        profile_scope frame(flicker, 3);
+        for (int i = 0; i < 5; ++i) {
+            profiler.record(marker);
+        }
+        profile_scope inner(flush);
+        profiler.record(marker);
+    }
+    {
+        profile_scope scope(encode);
+        profiler.record(marker);
+        profiler.record(marker);
+    }
+    EXPECT_EQ(marker.depth, 0u);
+
+    EXPECT_EQ(profiler.samples(), 9u);
+    EXPECT_EQ(profiler.dropped(), 0u);
+    profile_frame const flicker3[] = {{flicker, 3}, {flush, PROFILE_NO_GROUP}};
+    EXPECT_EQ(profiler.count(flicker3, 1), 5u);
+    EXPECT_EQ(profiler.count(flicker3, 2), 1u);
+    EXPECT_EQ(profiler.count(nullptr, 0), 1u);
+
+    std::string const folded = profiler.folded();
+    EXPECT_NE(folded.find("show;(untagged) 1\n"), std::string::npos) << folded;
+    EXPECT_NE(folded.find("show;flicker/3 5\n"), std::string::npos) << folded;
+    EXPECT_NE(folded.find("show;flicker/3;flush 1\n"), std::string::npos) << folded;
+    EXPECT_NE(folded.find("show;encode 2\n"), std::string::npos) << folded;
+
+    char const* path = "test_profile.folded";
+    ASSERT_TRUE(profiler.write_folded(path));
+    std::ifstream file(path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(), folded);
+    std::remove(path);
+}
+
+// Test a full table counts drops instead of blocking, and deep nesting keeps outer frames
+TEST(sampling_profiler_test, full_table_and_deep_nesting) {
+    sampling_profiler profiler("loop", 16);
+    uint16_t const bank = profiler.add_phase("bank");
+    profile_marker& marker = profile_thread_marker();
+    for (uint32_t group = 0; group < 20; ++group) {
+        profile_scope scope(bank, group);
+        profiler.record(marker);
+    }
+    EXPECT_EQ(profiler.samples(), 20u);
+    EXPECT_EQ(profiler.dropped(), 4u);
+
+    sampling_profiler deep;
+    uint16_t const level = deep.add_phase("level");
+    std::vector<profile_scope*> scopes;
+    for (uint32_t i = 0; i < PROFILE_MAX_DEPTH + 3; ++i) {
+        scopes.push_back(new profile_scope(level, i));
+    }
+    deep.record(marker);
+    for (size_t i = scopes.size(); i > 0; --i) {
+        delete scopes[i - 1];
+    }
+    EXPECT_EQ(marker.depth, 0u);
+    std::string const folded = deep.folded();
+    EXPECT_NE(folded.find(";level/7 1\n"), std::string::npos) << folded;
+    EXPECT_EQ(folded.find("level/8"), std::string::npos) << folded;
+}
+
+// Test live SIGPROF sampling attributes CPU time to the phase and group doing the work
+TEST(sampling_profiler_test, attributes_cpu_time) {
+    sampling_profiler profiler("loop");
+    uint16_t const flicker = profiler.add_phase("flicker");
+    uint16_t const encode = profiler.add_phase("encode");
+    null_pin pin;
+    std::vector<blink_controller<null_pin>> bank(256, blink_controller<null_pin>(pin, 100, 50));
+
+    ASSERT_TRUE(profiler.start(1000));
+    EXPECT_TRUE(profiler.running());
+    sampling_profiler other;
+    EXPECT_FALSE(other.start(1000));  // one profiler at a time
+
+    profile_frame const flicker1[] = {{flicker, 1}};
+    profile_frame const flicker9[] = {{flicker, 9}};
+    profile_frame const encoding[] = {{encode, PROFILE_NO_GROUP}};
+
+    // A second thread works in its own group while this one alternates phases 3:1.
+    // ITIMER_PROF is process-wide, so the worker takes its share of the samples;
+    // the main thread keeps going until its own split has enough samples to compare.
+    uint64_t const MAIN_SAMPLES = 100;
+    std::thread worker([&] {
+        std::vector<blink_controller<null_pin>> own(bank);
+        profile_scope scope(flicker, 9);
+        busy(own, 150);
+    });
+    auto const main_samples = [&] {
+        return profiler.count(flicker1, 1) + profiler.count(encoding, 1);
+    };
+    // At least 10 rounds (400 ms), at most 200 (8 s of this thread's CPU)
+    for (int round = 0; round < 10 || (round < 200 && main_samples() < MAIN_SAMPLES); ++round) {
+        {
+            profile_scope scope(flicker, 1);
+            busy(bank, 30);
+        }
+        {
+            profile_scope scope(encode);
+            busy(bank, 10);
+        }
+    }
+    worker.join();
+    profiler.stop();
+    EXPECT_FALSE(profiler.running());
+
+    uint64_t const a = profiler.count(flicker1, 1);
+    uint64_t const b = profiler.count(encoding, 1);
+    uint64_t const c = profiler.count(flicker9, 1);
+    std::printf("%llu samples: flicker/1 %llu, encode %llu, flicker/9 (thread) %llu\n%s",
+                static_cast<unsigned long long>(profiler.samples()),
+                static_cast<unsigned long long>(a), static_cast<unsigned long long>(b),
+                static_cast<unsigned long long>(c), profiler.folded().c_str());
+    // 150 ms of worker CPU at the kernel's profiling tick (>= 100 Hz)
+    EXPECT_GT(c, 0u);
+
+    // Stopped: no more samples
+    uint64_t const total = profiler.samples();
+    busy(bank, 50);
+    EXPECT_EQ(profiler.samples(), total);
+
+    if (a + b < MAIN_SAMPLES) {
+        GTEST_SKIP() << "only " << a + b << " main-thread samples in 8 s of CPU; too few to "
+                     << "compare the 3:1 split";
+    }
+    // 3:1 expected; at >= 100 samples even an even split is far outside the noise
+    EXPECT_GT(a, b);
+    EXPECT_GT(b, 0u);
+}
+
+// Test profilers torn down while another thread is being sampled (stop() waits out handlers)
+TEST(sampling_profiler_test, teardown_under_sampling) {
+    null_pin pin;
+    std::vector<blink_controller<null_pin>> bank(64, blink_controller<null_pin>(pin, 100, 50));
+    std::atomic<bool> done(false);
+    std::thread worker([&] {
+        std::vector<blink_controller<null_pin>> own(bank);
+        profile_scope scope(0, 7);
+        while (!done.load()) {
+            busy(own, 1);
+        }
+    });
+    uint64_t samples = 0;
+    for (int round = 0; round < 50; ++round) {
+        std::unique_ptr<sampling_profiler> profiler(new sampling_profiler("loop", 16));
+        profiler->add_phase("flicker");
+        ASSERT_TRUE(profiler->start(10000));
+        busy(bank, 5);
+        samples += profiler->samples();
+        profiler.reset();  // destructor stops
+    }
+    done = true;
+    worker.join();
+    std::printf("%llu samples across 50 profilers\n", static_cast<unsigned long long>(samples));
+    sampling_profiler after;
+    EXPECT_TRUE(after.start(1000));
+}
@@ -0,0 +1,301 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mock_hardware.h"
+#include "show_config.h"
+
+namespace {
+
+std::string make_line(size_t index, uint32_t on_ms, uint32_t off_ms) {
+    char line[64];
+    std::snprintf(line, sizeof(line), "prop_%zu %u %u\n", index, on_ms, off_ms);
+    return line;
+}
+
+bool write_file(std::string const& path, std::string const& text) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool const ok = std::fwrite(text.data(), 1, text.size(), file) == text.size();
+    return std::fclose(file) == 0 && ok;
+}
+
+// Check every controller of text is live with its timing, and nothing else is
+void expect_matches(show_config_file const& file, live_show<mock_pin> const& show,
+                    std::string const& text) {
+    std::vector<show_config_entry> entries;
+    size_t error_line = 0;
+    ASSERT_TRUE(parse_show_config(text.data(), text.size(), entries, error_line));
+    EXPECT_EQ(file.size(), entries.size());
+    EXPECT_EQ(show.size(), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        uint32_t slot = 0;
+        ASSERT_TRUE(file.find(entries[i].name, slot)) << entries[i].name;
+        ASSERT_TRUE(show.is_active(slot));
+        EXPECT_EQ(show.controller(slot).get_on_duration(), entries[i].timing.on_ms);
+        EXPECT_EQ(show.controller(slot).get_off_duration(), entries[i].timing.off_ms);
+    }
+}
+
+}  // namespace
+
+// Test the file format: comments, blank lines, CRLF and malformed lines
+TEST(show_config_test, parse) {
+    std::string const text =
+        "# name on off\n"
+        "\n"
+        "eyes   100 100   # both eyes\r\n"
+        "\tjaw 40\t120\n"
+        "strobe 20 20";
+    std::vector<show_config_entry> entries;
+    size_t error_line = 0;
+    ASSERT_TRUE(parse_show_config(text.data(), text.size(), entries, error_line));
+    ASSERT_EQ(entries.size(), 3u);
+    EXPECT_EQ(entries[0].name, "eyes");
+    EXPECT_EQ(entries[0].timing.on_ms, 100u);
+    EXPECT_EQ(entries[1].name, "jaw");
+    EXPECT_EQ(entries[1].timing.off_ms, 120u);
+    EXPECT_EQ(entries[2].name, "strobe");
+    EXPECT_EQ(error_line, 0u);
+
+    char const* const bad[] = {"eyes 100\n", "eyes 100 100 100\n", "eyes 1x0 100\n",
+                               "eyes 100 4294967296\n", "eyes -1 100\n"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        std::string const bad_text = std::string("ok 1 1\n\n") + bad[i];
+        entries.clear();
+        EXPECT_FALSE(parse_show_config(bad_text.data(), bad_text.size(), entries, error_line))
+            << bad[i];
+        EXPECT_EQ(error_line, 3u) << bad[i];
+    }
+    std::string const max = "eyes 4294967295 0\n";
+    entries.clear();
+    EXPECT_TRUE(parse_show_config(max.data(), max.size(), entries, error_line));
+    EXPECT_EQ(entries[0].timing.on_ms, UINT32_MAX);
+}
+
+// Test a reload adds, removes and retimes while untouched controllers keep their phase
+TEST(show_config_test, reload_keeps_phase) {
+    live_show<mock_pin> show;
+    show_config_file file("props.show");
+    show_reload_stats stats;
+    std::string text = "eyes 100 100\njaw 40 120\nstrobe 20 20\n";
+    ASSERT_TRUE(file.reload(text, show, 0, stats));
+    EXPECT_EQ(stats.added, 3u);
+
+    // Reference controllers that never see a reload
+    mock_pin eyes_pin;
+    mock_pin jaw_pin;
+    blink_controller<mock_pin> eyes(eyes_pin, 100, 100);
+    blink_controller<mock_pin> jaw(jaw_pin, 40, 120);
+    uint32_t eyes_slot = 0;
+    uint32_t jaw_slot = 0;
+    uint32_t strobe_slot = 0;
+    ASSERT_TRUE(file.find("eyes", eyes_slot));
+    ASSERT_TRUE(file.find("jaw", jaw_slot));
+    ASSERT_TRUE(file.find("strobe", strobe_slot));
+
+    uint32_t now = 0;
+    for (; now < 730; now += 10) {
+        show.update(now);
+        eyes.update(now);
+        jaw.update(now);
+    }
+
+    // Retime the strobe, drop the jaw, add a beacon
+    text = "eyes 100 100\nstrobe 30 10\nbeacon 500 500\n";
+    ASSERT_TRUE(file.reload(text, show, now, stats));
+    EXPECT_EQ(stats.added, 1u);
+    EXPECT_EQ(stats.removed, 1u);
+    EXPECT_EQ(stats.retimed, 1u);
+    EXPECT_EQ(stats.parsed_lines, 2u);
+    uint32_t removed_slot = 0;
+    EXPECT_FALSE(file.find("jaw", removed_slot));
+    EXPECT_FALSE(show.pin(jaw_slot).get_state());
+    EXPECT_EQ(show.controller(strobe_slot).get_on_duration(), 30u);
+    uint32_t beacon_slot = 0;
+    ASSERT_TRUE(file.find("beacon", beacon_slot));
+    EXPECT_EQ(beacon_slot, jaw_slot);  // freed slot reused
+    EXPECT_EQ(show.controller(beacon_slot).get_last_toggle_time(), now);
+    expect_matches(file, show, text);
+
+    for (; now < 5000; now += 10) {
+        show.update(now);
+        eyes.update(now);
+        ASSERT_EQ(show.pin(eyes_slot).get_state(), eyes_pin.get_state()) << now;
+    }
+    EXPECT_EQ(show.controller(eyes_slot).get_last_toggle_time(), eyes.get_last_toggle_time());
+}
+
+// Test a broken edit changes nothing and reports its line; fixing it applies
+TEST(show_config_test, errors_keep_last_good_version) {
+    live_show<mock_pin> show;
+    show_config_file file("props.show");
+    show_reload_stats stats;
+    std::string const good = "a 1 1\nb 2 2\nc 3 3\nd 4 4\n";
+    ASSERT_TRUE(file.reload(good, show, 0, stats));
+
+    EXPECT_FALSE(file.reload("a 1 1\nb 2 2\nc 3\nd 4 4\n", show, 10, stats));
+    EXPECT_EQ(file.error_line(), 3u);
+    expect_matches(file, show, good);
+
+    // Duplicate inside the changed region, and against an unchanged line
+    EXPECT_FALSE(file.reload("a 1 1\nb 2 2\nx 5 5\nx 6 6\nd 4 4\n", show, 10, stats));
+    EXPECT_EQ(file.error_line(), 4u);
+    EXPECT_FALSE(file.reload("a 1 1\nb 2 2\nc 3 3\nd 4 4\na 9 9\n", show, 10, stats));
+    EXPECT_EQ(file.error_line(), 5u);
+    expect_matches(file, show, good);
+
+    // Moving a controller to another line is not a duplicate
+    std::string const moved = "b 2 2\nc 3 3\nd 4 4\na 1 2\n";
+    ASSERT_TRUE(file.reload(moved, show, 10, stats));
+    EXPECT_EQ(stats.added + stats.removed, 0u);
+    EXPECT_EQ(stats.retimed, 1u);
+    EXPECT_EQ(file.error_line(), 0u);
+    expect_matches(file, show, moved);
+}
+
+// Test random edit sequences: the live show always matches a full parse
+TEST(show_config_test, incremental_matches_full_parse) {
+    std::mt19937 rng(84);
+    live_show<mock_pin> show;
+    show_config_file file("props.show");
+    show_reload_stats stats;
+    std::vector<std::string> lines;
+    size_t next_name = 0;
+    for (int round = 0; round < 500; ++round) {
+        int const edits = 1 + static_cast<int>(rng() % 3);
+        for (int e = 0; e < edits; ++e) {
+            size_t const at = lines.empty() ? 0 : rng() % (lines.size() + 1);
+            switch (rng() % 5) {
+                case 0:
+                case 1:
+                    lines.insert(lines.begin() + static_cast<long>(at),
+                                 make_line(next_name++, rng() % 50, rng() % 50));
+                    break;
+                case 2:
+                    if (at < lines.size()) {
+                        lines.erase(lines.begin() + static_cast<long>(at));
+                    }
+                    break;
+                case 3:
+                    if (at < lines.size() && lines[at].compare(0, 5, "prop_") == 0) {
+                        size_t const name = std::strtoul(lines[at].c_str() + 5, nullptr, 10);
+                        lines[at] = make_line(name, rng() % 50, rng() % 50);
+                    }
+                    break;
+                default:
+                    lines.insert(lines.begin() + static_cast<long>(at),
+                                 rng() % 2 ? "\n" : "# comment\n");
+                    break;
+            }
+        }
+        std::string text;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            text += lines[i];
+        }
+        if (rng() % 4 == 0 && !text.empty()) {
+            text.erase(text.size() - 1);  // no trailing newline
+        }
+        ASSERT_TRUE(file.reload(text, show, round, stats)) << round;
+        expect_matches(file, show, text);
+    }
+    EXPECT_LE(show.slot_count(), next_name);
+}
+
+// Test saved files are picked up by the watcher, including rename-over saves
+TEST(show_config_test, watcher_hot_reload) {
+    char directory[] = "/tmp/show_config_XXXXXX";
+    ASSERT_NE(::mkdtemp(directory), nullptr);
+    std::string const props = std::string(directory) + "/props.show";
+    std::string const lights = std::string(directory) + "/lights.show";
+    ASSERT_TRUE(write_file(props, "eyes 100 100\njaw 40 120\n"));
+    ASSERT_TRUE(write_file(lights, "beacon 500 500\n"));
+
+    live_show<mock_pin> show;
+    show_hot_reload<mock_pin> reload(show);
+    ASSERT_TRUE(reload.add_file(props, 0));
+    ASSERT_TRUE(reload.add_file(lights, 0));
+    EXPECT_FALSE(reload.add_file(std::string(directory) + "/missing.show", 0));
+    EXPECT_EQ(show.size(), 3u);
+    EXPECT_EQ(reload.poll(0, 0), 0u);
+
+    // In-place save
+    ASSERT_TRUE(write_file(props, "eyes 100 100\njaw 60 120\n"));
+    EXPECT_EQ(reload.poll(1000, 100), 1u);
+    EXPECT_EQ(reload.last_reload().retimed, 1u);
+
+    // Editor-style save: write a temporary file, rename it over the original
+    std::string const temporary = lights + ".tmp";
+    ASSERT_TRUE(write_file(temporary, "beacon 500 500\nflood 0 0\n"));
+    ASSERT_EQ(std::rename(temporary.c_str(), lights.c_str()), 0);
+    EXPECT_EQ(reload.poll(1000, 200), 1u);
+    EXPECT_EQ(reload.last_reload().added, 1u);
+    EXPECT_EQ(show.size(), 4u);
+
+    // A broken save is counted and changes nothing
+    ASSERT_TRUE(write_file(props, "eyes 100\njaw 60 120\n"));
+    EXPECT_EQ(reload.poll(1000, 300), 0u);
+    EXPECT_EQ(reload.failed_reloads(), 1u);
+    EXPECT_EQ(reload.file(0).error_line(), 1u);
+    EXPECT_EQ(show.size(), 4u);
+    EXPECT_EQ(reload.reloads(), 2u);
+
+    // A file broken when added is still watched, and reports its bad line
+    std::string const spots = std::string(directory) + "/spots.show";
+    ASSERT_TRUE(write_file(spots, "left 100 100\nright 100 x\n"));
+    EXPECT_FALSE(reload.add_file(spots, 400));
+    ASSERT_EQ(reload.file_count(), 3u);
+    EXPECT_EQ(reload.file(reload.file_count() - 1).error_line(), 2u);
+
+    std::remove(props.c_str());
+    std::remove(lights.c_str());
+    std::remove(spots.c_str());
+    ::rmdir(directory);
+}
+
+// Test a one-line edit of a 50k-controller show reloads in milliseconds
+TEST(show_config_test, large_show_one_line_edit) {
+    size_t const CONTROLLERS = 50000;
+    std::string text;
+    for (size_t i = 0; i < CONTROLLERS; ++i) {
+        text += make_line(i, 100 + i % 400, 100 + i % 300);
+    }
+    live_show<mock_pin> show;
+    show_config_file file("large.show");
+    show_reload_stats stats;
+    auto const load_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(file.reload(text, show, 0, stats));
+    auto const load_time = std::chrono::steady_clock::now() - load_start;
+    EXPECT_EQ(stats.added, CONTROLLERS);
+    for (uint32_t now = 0; now < 1000; now += 20) {
+        show.update(now);
+    }
+
+    std::string edited = text;
+    std::string const old_line = make_line(31337, 100 + 31337 % 400, 100 + 31337 % 300);
+    size_t const at = edited.find(old_line);
+    ASSERT_NE(at, std::string::npos);
+    edited.replace(at, old_line.size(), make_line(31337, 5, 5));
+
+    auto const reload_start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(file.reload(edited, show, 1000, stats));
+    auto const reload_time = std::chrono::steady_clock::now() - reload_start;
+    EXPECT_EQ(stats.retimed, 1u);
+    EXPECT_EQ(stats.added + stats.removed, 0u);
+    EXPECT_EQ(stats.parsed_lines, 1u);
+    uint32_t slot = 0;
+    ASSERT_TRUE(file.find("prop_31337", slot));
+    EXPECT_EQ(show.controller(slot).get_on_duration(), 5u);
+
+    double const reload_ms = std::chrono::duration<double, std::milli>(reload_time).count();
+    std::printf("50k controllers: full load %.1f ms, one-line reload %.3f ms\n",
+                std::chrono::duration<double, std::milli>(load_time).count(), reload_ms);
+    EXPECT_LT(reload_ms, 100.0);
+}
@@ -0,0 +1,433 @@
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "console_simulator.h"
+#include "mock_hardware.h"
+#include "show_partition.h"
+
+namespace {
+
+std::vector<blink_timing> uniform_timings(uint32_t count, uint32_t on_ms, uint32_t off_ms) {
+    blink_timing const timing = {on_ms, off_ms};
+    return std::vector<blink_timing>(count, timing);
+}
+
+// Fork a worker process serving its partition slice over fd; returns the child pid.
+// The child closes every coordinator end it inherited so workers see EOF on hang-up.
+pid_t spawn_worker(show_partition const& partition, uint16_t node, int fd,
+                   std::vector<blink_timing> const& timings,
+                   std::vector<frame_channel> const& inherited) {
+    pid_t const pid = ::fork();
+    if (pid == 0) {
+        for (size_t i = 0; i < inherited.size(); ++i) {
+            ::close(inherited[i].fd());
+        }
+        real_time_timer timer;
+        uint32_t const first = partition.first_controller(node);
+        std::vector<blink_timing> const slice(timings.begin() + first,
+                                              timings.begin() + first +
+                                                  partition.controllers_on(node));
+        show_node<mock_pin, real_time_timer> worker(node, first, timer, slice);
+        frame_channel channel(fd);
+        run_show_worker(worker, channel, 1);
+        channel.close();
+        ::_exit(0);
+    }
+    return pid;
+}
+
+}  // namespace
+
+// Test wire header round trip and size
+TEST(show_wire, header_round_trip) {
+    std::vector<uint8_t> bytes;
+    show_message_header const header = {show_message_kind::command_batch, 7, 3, 42,
+                                        0x0102030405060708ull};
+    encode_show_header(bytes, header);
+    EXPECT_EQ(bytes.size(), SHOW_MESSAGE_HEADER_SIZE);
+
+    wire_reader reader(bytes.data(), bytes.size());
+    show_message_header decoded;
+    ASSERT_TRUE(decode_show_header(reader, decoded));
+    EXPECT_EQ(decoded.kind, show_message_kind::command_batch);
+    EXPECT_EQ(decoded.node_id, 7);
+    EXPECT_EQ(decoded.count, 3);
+    EXPECT_EQ(decoded.sequence, 42u);
+    EXPECT_EQ(decoded.sent_ns, 0x0102030405060708ull);
+}
+
+// Test malformed headers are rejected
+TEST(show_wire, rejects_truncated_and_foreign_messages) {
+    std::vector<uint8_t> bytes;
+    show_message_header const header = {show_message_kind::health_request, 0, 0, 1, 0};
+    encode_show_header(bytes, header);
+
+    wire_reader truncated(bytes.data(), bytes.size() - 1);
+    show_message_header decoded;
+    EXPECT_FALSE(decode_show_header(truncated, decoded));
+
+    bytes[0] = 0;
+    wire_reader foreign(bytes.data(), bytes.size());
+    EXPECT_FALSE(decode_show_header(foreign, decoded));
+}
+
+// Test command encoding is fixed-size and round trips
+TEST(show_wire, command_round_trip) {
+    std::vector<uint8_t> bytes;
+    show_command const command = {show_command_type::trigger, 123456, 789};
+    encode_show_command(bytes, command);
+    EXPECT_EQ(bytes.size(), SHOW_COMMAND_WIRE_SIZE);
+
+    wire_reader reader(bytes.data(), bytes.size());
+    show_command decoded;
+    ASSERT_TRUE(decode_show_command(reader, decoded));
+    EXPECT_EQ(decoded.type, show_command_type::trigger);
+    EXPECT_EQ(decoded.controller_id, 123456u);
+    EXPECT_EQ(decoded.show_time_ms, 789u);
+}
+
+// Test balanced partition covers every id exactly once
+TEST(show_partition_test, balanced_ranges) {
+    show_partition const partition = show_partition::balanced(10, 3);
+
+    EXPECT_EQ(partition.node_count(), 3);
+    EXPECT_EQ(partition.controller_count(), 10u);
+    EXPECT_EQ(partition.controllers_on(0) + partition.controllers_on(1) +
+                  partition.controllers_on(2),
+              10u);
+    for (uint32_t id = 0; id < 10; ++id) {
+        uint16_t const node = partition.node_of(id);
+        EXPECT_GE(id, partition.first_controller(node));
+        EXPECT_LT(id, partition.first_controller(node) + partition.controllers_on(node));
+    }
+
+    // Zero nodes is treated as one instead of dividing by zero
+    show_partition const single = show_partition::balanced(10, 0);
+    EXPECT_EQ(single.node_count(), 1);
+    EXPECT_EQ(single.controllers_on(0), 10u);
+}
+
+// Test node does nothing until started
+TEST(show_node_test, idle_until_started) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(4, 100, 100));
+
+    timer.advance(1000);
+    node.update();
+    EXPECT_FALSE(node.is_running());
+    EXPECT_EQ(node.health().frames, 0u);
+    EXPECT_EQ(node.show_time_ms(), 0u);
+}
+
+// Test start runs the show clock from the given time
+TEST(show_node_test, start_runs_show_clock) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(2, 100, 50));
+    timer.set_time(5000);
+
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 1000};
+    node.apply(start, 0);
+    EXPECT_EQ(node.show_time_ms(), 1000u);
+
+    // 1000 ms into the 50 off / 100 on cycle: on since 950, off again at 1050
+    EXPECT_TRUE(node.controller(0).is_on());
+    timer.advance(49);
+    node.update();
+    EXPECT_TRUE(node.controller(0).is_on());
+    timer.advance(1);
+    node.update();
+    EXPECT_FALSE(node.controller(0).is_on());
+    EXPECT_EQ(node.show_time_ms(), 1050u);
+}
+
+// Test stop freezes the clock and drives outputs off
+TEST(show_node_test, stop_freezes_clock) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(1, 100, 0));
+
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    node.apply(start, 0);
+    node.update();
+    EXPECT_TRUE(node.controller(0).is_on());
+
+    timer.advance(30);
+    show_command const stop = {show_command_type::stop, ALL_CONTROLLERS, 0};
+    node.apply(stop, 0);
+    EXPECT_FALSE(node.controller(0).is_on());
+
+    timer.advance(1000);
+    node.update();
+    EXPECT_EQ(node.show_time_ms(), 30u);
+    EXPECT_FALSE(node.controller(0).is_on());
+}
+
+// Test seek moves the show clock
+TEST(show_node_test, seek_moves_clock) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(1, 100, 100));
+
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    node.apply(start, 0);
+    timer.advance(10);
+    show_command const seek = {show_command_type::seek, ALL_CONTROLLERS, 60000};
+    node.apply(seek, 0);
+    EXPECT_EQ(node.show_time_ms(), 60000u);
+    EXPECT_EQ(node.controller(0).get_last_toggle_time(), 60000u);
+}
+
+// Test a seek while stopped moves the clock but leaves every output off
+TEST(show_node_test, seek_while_stopped) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(4, 100, 0));
+
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    node.apply(start, 0);
+    node.update();
+    show_command const stop = {show_command_type::stop, ALL_CONTROLLERS, 0};
+    node.apply(stop, 0);
+    uint64_t const edges = node.health().edges;
+
+    // 100 ms on, 0 off: every controller is on at 50 ms of a played-through show
+    show_command const seek = {show_command_type::seek, ALL_CONTROLLERS, 50};
+    node.apply(seek, 0);
+    EXPECT_EQ(node.show_time_ms(), 50u);
+    timer.advance(1000);
+    node.update();
+    EXPECT_EQ(node.show_time_ms(), 50u);
+    for (size_t i = 0; i < node.size(); ++i) {
+        EXPECT_FALSE(node.controller(i).is_on()) << i;
+    }
+    EXPECT_EQ(node.health().edges, edges);
+}
+
+// Test a seek leaves every controller where a run played through from 0 would be
+TEST(show_node_test, seek_matches_play_through) {
+    std::vector<blink_timing> timings;
+    for (uint32_t i = 0; i < 8; ++i) {
+        blink_timing const timing = {30 + 17 * i, 45 + 29 * i};
+        timings.push_back(timing);
+    }
+
+    mock_timer played_timer;
+    mock_timer seeked_timer;
+    show_node<mock_pin, mock_timer> played(0, 0, played_timer, timings);
+    show_node<mock_pin, mock_timer> seeked(0, 0, seeked_timer, timings);
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    played.apply(start, 0);
+    seeked.apply(start, 0);
+    played.update();
+
+    uint32_t const SEEK_MS = 12345;
+    show_command const seek = {show_command_type::seek, ALL_CONTROLLERS, SEEK_MS};
+    seeked.apply(seek, 0);
+    for (uint32_t t = 1; t < SEEK_MS + 1000; ++t) {
+        played_timer.advance(1);
+        played.update();
+        if (t < SEEK_MS) {
+            continue;
+        }
+        if (t > SEEK_MS) {
+            seeked_timer.advance(1);
+        }
+        seeked.update();
+        for (size_t i = 0; i < timings.size(); ++i) {
+            ASSERT_EQ(seeked.controller(i).is_on(), played.controller(i).is_on())
+                << "controller " << i << " at " << t << " ms";
+            ASSERT_EQ(seeked.controller(i).get_last_toggle_time(),
+                      played.controller(i).get_last_toggle_time())
+                << "controller " << i << " at " << t << " ms";
+        }
+    }
+}
+
+// Test trigger addresses global ids and restarts only that controller
+TEST(show_node_test, trigger_restarts_one_controller) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(1, 100, timer, uniform_timings(3, 1000, 0));
+
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    node.apply(start, 0);
+    node.update();
+    EXPECT_TRUE(node.controller(1).is_on());
+
+    show_command const trigger = {show_command_type::trigger, 101, 0};
+    node.apply(trigger, monotonic_ns());
+    EXPECT_FALSE(node.controller(1).is_on());
+    EXPECT_TRUE(node.controller(0).is_on());
+    EXPECT_TRUE(node.controller(2).is_on());
+    EXPECT_GT(node.health().last_trigger_latency_ns, 0u);
+
+    // Already off: latency is taken when the trigger applies, not at the next (off_ms later) edge
+    uint64_t const sent_ns = monotonic_ns() - 5000000;
+    node.apply(trigger, sent_ns);
+    EXPECT_GE(node.health().last_trigger_latency_ns, 5000000u);
+    EXPECT_LT(node.health().last_trigger_latency_ns, 500000000u);
+
+    // Ids owned by other nodes are ignored
+    show_command const foreign = {show_command_type::trigger, 5, 0};
+    node.apply(foreign, 0);
+    EXPECT_TRUE(node.controller(0).is_on());
+}
+
+// Test batches with skipped sequence numbers are counted as gaps
+TEST(show_node_test, counts_sequence_gaps) {
+    mock_timer timer;
+    show_node<mock_pin, mock_timer> node(0, 0, timer, uniform_timings(1, 100, 100));
+    std::vector<uint8_t> empty;
+    wire_reader reader(empty.data(), 0);
+
+    show_message_header header = {show_message_kind::command_batch, 0, 0, 1, 0};
+    node.apply_batch(header, reader);
+    header.sequence = 2;
+    node.apply_batch(header, reader);
+    EXPECT_EQ(node.health().sequence_gaps, 0u);
+
+    header.sequence = 5;
+    node.apply_batch(header, reader);
+    EXPECT_EQ(node.health().sequence_gaps, 1u);
+    EXPECT_EQ(node.health().last_sequence, 5u);
+}
+
+// Test coordinator fans commands out to separate worker processes
+TEST(show_multi_process, fan_out_and_health) {
+    uint32_t const CONTROLLERS = 3000;
+    uint16_t const NODES = 3;
+    show_partition const partition = show_partition::balanced(CONTROLLERS, NODES);
+    std::vector<blink_timing> const timings = uniform_timings(CONTROLLERS, 60000, 0);
+
+    std::vector<frame_channel> channels;
+    std::vector<pid_t> pids;
+    for (uint16_t node = 0; node < NODES; ++node) {
+        int fds[2];
+        ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+        channels.push_back(frame_channel(fds[0]));
+        pids.push_back(spawn_worker(partition, node, fds[1], timings, channels));
+        ::close(fds[1]);
+    }
+
+    show_coordinator coordinator(partition, channels, 64);
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    ASSERT_TRUE(coordinator.queue(start));
+    ASSERT_TRUE(coordinator.flush());
+
+    // One trigger per node, batched into a single message each
+    for (uint16_t node = 0; node < NODES; ++node) {
+        show_command const trigger = {show_command_type::trigger,
+                                      partition.first_controller(node) + 5, 0};
+        ASSERT_TRUE(coordinator.queue(trigger));
+    }
+    ASSERT_TRUE(coordinator.flush());
+
+    std::vector<node_health> health;
+    ASSERT_TRUE(coordinator.collect_health(health));
+    ASSERT_EQ(health.size(), NODES);
+
+    uint64_t max_latency_ns = 0;
+    for (uint16_t node = 0; node < NODES; ++node) {
+        EXPECT_EQ(health[node].node_id, node);
+        EXPECT_EQ(health[node].controller_count, partition.controllers_on(node));
+        EXPECT_EQ(health[node].last_sequence, 2u);
+        EXPECT_EQ(health[node].sequence_gaps, 0u);
+        EXPECT_EQ(health[node].commands_applied, 2u);
+        // Every controller turned on once; the triggered one also turned off
+        EXPECT_GE(health[node].edges, partition.controllers_on(node) + 1u);
+        EXPECT_GT(health[node].last_trigger_latency_ns, 0u);
+        // Socket hop plus scheduling; generous for a loaded single-core host
+        EXPECT_LT(health[node].max_trigger_latency_ns, 250000000ull);
+        max_latency_ns = std::max(max_latency_ns, health[node].max_trigger_latency_ns);
+    }
+    std::printf("command-to-trigger latency across %u nodes: max %.1f us\n", NODES,
+                static_cast<double>(max_latency_ns) / 1000.0);
+    ::testing::Test::RecordProperty("max_command_to_trigger_latency_ns",
+                                    static_cast<int>(max_latency_ns));
+
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i].close();
+    }
+    for (size_t i = 0; i < pids.size(); ++i) {
+        int status = 0;
+        ASSERT_EQ(::waitpid(pids[i], &status, 0), pids[i]);
+        EXPECT_TRUE(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+    }
+}
+
+// Test a dead worker fails the send instead of killing the coordinator with SIGPIPE
+TEST(show_multi_process, dead_worker) {
+    show_partition const partition = show_partition::balanced(10, 1);
+    std::vector<blink_timing> const timings = uniform_timings(10, 500, 500);
+
+    int fds[2];
+    ASSERT_EQ(::socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    std::vector<frame_channel> channels(1, frame_channel(fds[0]));
+    pid_t const pid = spawn_worker(partition, 0, fds[1], timings, channels);
+    ::close(fds[1]);
+    ASSERT_EQ(::kill(pid, SIGKILL), 0);
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFSIGNALED(status));
+
+    show_coordinator coordinator(partition, channels);
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    ASSERT_TRUE(coordinator.queue(start));
+    EXPECT_FALSE(coordinator.flush());
+    EXPECT_EQ(coordinator.batches_sent(), 0u);
+    EXPECT_EQ(coordinator.sequence(0), 0u);
+
+    std::vector<node_health> health;
+    EXPECT_FALSE(coordinator.collect_health(health));
+    channels[0].close();
+}
+
+// Test a worker connected over loopback TCP, as on another host
+TEST(show_multi_process, tcp_worker) {
+    show_partition const partition = show_partition::balanced(100, 1);
+    std::vector<blink_timing> const timings = uniform_timings(100, 60000, 0);
+
+    int const listen_fd = tcp_listen(0, true);
+    ASSERT_GE(listen_fd, 0);
+    uint16_t const port = tcp_local_port(listen_fd);
+
+    pid_t const pid = ::fork();
+    if (pid == 0) {
+        ::close(listen_fd);
+        int const fd = tcp_connect("127.0.0.1", port);
+        if (fd < 0) {
+            ::_exit(1);
+        }
+        real_time_timer timer;
+        show_node<mock_pin, real_time_timer> worker(0, 0, timer, timings);
+        frame_channel channel(fd);
+        run_show_worker(worker, channel, 1);
+        channel.close();
+        ::_exit(0);
+    }
+    int const fd = tcp_accept(listen_fd);
+    ::close(listen_fd);
+    ASSERT_GE(fd, 0);
+
+    std::vector<frame_channel> channels(1, frame_channel(fd));
+    show_coordinator coordinator(partition, channels);
+    show_command const start = {show_command_type::start, ALL_CONTROLLERS, 0};
+    show_command const trigger = {show_command_type::trigger, 42, 0};
+    ASSERT_TRUE(coordinator.queue(start));
+    ASSERT_TRUE(coordinator.queue(trigger));
+    ASSERT_TRUE(coordinator.flush());
+    EXPECT_EQ(coordinator.batches_sent(), 1u);
+
+    std::vector<node_health> health;
+    ASSERT_TRUE(coordinator.collect_health(health));
+    EXPECT_EQ(health[0].commands_applied, 2u);
+    EXPECT_GT(health[0].last_trigger_latency_ns, 0u);
+
+    channels[0].close();
+    int status = 0;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+}
@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+#include "console_simulator.h"
+#include "strobe_runner.h"
+
+namespace {
+
+// micros() clock the test steps by hand
+struct manual_micros_timer {
+    uint32_t micros() const { return now_us; }
+    uint32_t now_us = 0;
+};
+
+// Pin that timestamps its edges on a micros() clock
+template<typename timer_t>
+struct timestamp_pin {
+    void set(bool state) {
+        if (state != on) {
+            edges_us.push_back(timer->micros());
+            on = state;
+        }
+    }
+
+    timer_t const* timer = nullptr;
+    bool on = false;
+    std::vector<uint32_t> edges_us;
+};
+
+struct edge_error {
+    uint32_t median_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+    size_t edges;
+};
+
+// Error of each recorded edge against the ideal schedule from time 0, restarted (like the
+// runner) after an edge more than resync_us off
+edge_error measure(std::vector<uint32_t> const& edges_us, uint32_t on_us, uint32_t off_us,
+                   uint32_t resync_us, std::vector<uint32_t>& all_errors) {
+    std::vector<uint32_t> errors;
+    int64_t ideal = 0;
+    for (size_t e = 0; e < edges_us.size(); ++e) {
+        ideal += e % 2 == 0 ? off_us : on_us;
+        int64_t const error = static_cast<int64_t>(edges_us[e]) - ideal;
+        uint32_t const size = static_cast<uint32_t>(error < 0 ? -error : error);
+        if (size > resync_us) {
+            ideal = edges_us[e];
+            continue;
+        }
+        errors.push_back(size);
+    }
+    all_errors.insert(all_errors.end(), errors.begin(), errors.end());
+    std::sort(errors.begin(), errors.end());
+    edge_error result = {0, 0, 0, errors.size()};
+    if (!errors.empty()) {
+        result.median_us = errors[errors.size() / 2];
+        result.p99_us = errors[errors.size() * 99 / 100];
+        result.max_us = errors.back();
+    }
+    return result;
+}
+
+}  // namespace
+
+// Test late service delays one edge without shifting later ones, and far-late edges resync
+TEST(strobe_runner_test, edges_keep_schedule) {
+    manual_micros_timer timer;
+    timestamp_pin<manual_micros_timer> pin;
+    pin.timer = &timer;
+    blink_controller<timestamp_pin<manual_micros_timer>> strobe(pin, 100, 300);  // 2.5 kHz
+    strobe_runner<manual_micros_timer, blink_controller<timestamp_pin<manual_micros_timer>>>
+        runner(timer, &strobe, 1, 250);
+
+    EXPECT_EQ(runner.service(), 300u);
+    timer.now_us = 340;  // 40 us late
+    EXPECT_EQ(runner.service(), 60u);  // off edge still due at 400, not 440
+    EXPECT_EQ(strobe.get_last_toggle_time(), 300u);
+    timer.now_us = 400;
+    EXPECT_EQ(runner.service(), 300u);
+    timer.now_us = 700;
+    EXPECT_EQ(runner.service(), 100u);
+    EXPECT_EQ(runner.max_late_us(), 40u);
+    EXPECT_EQ(runner.resyncs(), 0u);
+
+    // 2 ms stall: restart from now rather than replaying the missed edges
+    timer.now_us = 2800;
+    EXPECT_EQ(runner.service(), 300u);
+    EXPECT_EQ(strobe.get_last_toggle_time(), 2800u);
+    EXPECT_EQ(runner.resyncs(), 1u);
+    EXPECT_EQ(runner.edges(), 4u);
+    std::vector<uint32_t> const expected = {340, 400, 700, 2800};
+    EXPECT_EQ(pin.edges_us, expected);
+}
+
+// Measure edge timing of strobes in the fast loop against a millisecond show loop
+TEST(strobe_runner_test, host_edge_error) {
+    typedef timestamp_pin<real_time_timer> pin_t;
+    real_time_timer timer;
+    pin_t pins[4];
+    for (size_t i = 0; i < 4; ++i) {
+        pins[i].timer = &timer;
+    }
+    uint32_t const durations[3][2] = {{500, 500}, {150, 250}, {1000, 2333}};  // 1k, 2.5k, 300 Hz
+    std::vector<blink_controller<pin_t>> strobes;
+    for (size_t i = 0; i < 3; ++i) {
+        strobes.emplace_back(pins[i], durations[i][0], durations[i][1]);
+    }
+    strobe_runner<real_time_timer, blink_controller<pin_t>> runner(timer, strobes.data(), 3);
+    strobe_thread<real_time_timer, blink_controller<pin_t>> fast(runner);
+
+    // Show loop: a 250 Hz strobe at millisecond resolution, the way it ran before
+    blink_controller<pin_t> slow_strobe(pins[3], 2, 2);
+    timer.reset();
+    fast.start();
+    while (timer.millis() < 1000) {
+        slow_strobe.update(timer.millis());
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    fast.stop();
+
+    // Wall-clock timing only holds with a core to spare for the fast loop; on a loaded or
+    // single-core host the numbers below are a report
+    unsigned const cores = std::thread::hardware_concurrency();
+    std::vector<uint32_t> fast_errors;
+    std::vector<uint32_t> slow_errors;
+    for (size_t i = 0; i < 3; ++i) {
+        edge_error const e = measure(pins[i].edges_us, durations[i][0], durations[i][1], 1000,
+                                     fast_errors);
+        std::printf("strobe %u/%u us: %zu edges, error median %u us, p99 %u us, max %u us\n",
+                    durations[i][0], durations[i][1], e.edges, e.median_us, e.p99_us, e.max_us);
+        if (cores >= 4) {
+            EXPECT_GT(e.edges, 1000000u / (durations[i][0] + durations[i][1]));
+        }
+    }
+    edge_error const slow = measure(pins[3].edges_us, 2000, 2000, 100000, slow_errors);
+    std::sort(fast_errors.begin(), fast_errors.end());
+    std::printf("fast loop: %llu edges, %llu resyncs, longest service delay %u us; "
+                "ms show loop at 250 Hz: median %u us, max %u us\n",
+                static_cast<unsigned long long>(runner.edges()),
+                static_cast<unsigned long long>(runner.resyncs()), runner.max_late_us(),
+                slow.median_us, slow.max_us);
+
+    if (!fast_errors.empty()) {
+        std::printf("fast loop edge error: median %u us, p99 %u us\n",
+                    fast_errors[fast_errors.size() / 2],
+                    fast_errors[fast_errors.size() * 99 / 100]);
+    }
+    if (cores >= 4) {
+        ASSERT_FALSE(fast_errors.empty());
+        // Typical edges land within tens of microseconds; resyncs (descheduled thread) are rare
+        EXPECT_LT(fast_errors[fast_errors.size() / 2], 200u);
+        EXPECT_LT(runner.resyncs() * 20, runner.edges());
+    }
+}
@@ -0,0 +1,244 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "blink_bank.h"
+#include "tempo_map.h"
+
+namespace {
+
+// One controller of the scalar reference: the tick schedule written out plainly
+struct reference_controller {
+    void update(uint32_t ticks) {
+        if (static_cast<int32_t>(ticks - next_edge) >= 0) {
+            next_edge += on ? off_ticks : on_ticks;
+            on = !on;
+        }
+        if (static_cast<int32_t>(ticks - next_edge) >= 0) {
+            align(ticks);
+        }
+    }
+
+    // Walk the pattern from tick 0 to the period containing ticks
+    void align(uint32_t ticks) {
+        uint32_t start = 0;
+        while (on_ticks + off_ticks != 0 && start + on_ticks + off_ticks <= ticks) {
+            start += on_ticks + off_ticks;
+        }
+        on = on_ticks + off_ticks != 0 && ticks - start >= off_ticks;
+        next_edge = start + (on ? on_ticks + off_ticks : off_ticks);
+    }
+
+    uint32_t on_ticks;
+    uint32_t off_ticks;
+    uint32_t next_edge;
+    bool on;
+};
+
+// Exact time of a song tick under a tempo map, in milliseconds
+double tick_time_ms(tempo_map const& map, uint64_t tick) {
+    double start_ms = 0;
+    double start_tick = 0;
+    for (size_t i = 0;; ++i) {
+        double const ms_per_tick = map[i].us_per_beat / (1000.0 * TEMPO_PPQ);
+        if (i + 1 == map.size()) {
+            return start_ms + (tick - start_tick) * ms_per_tick;
+        }
+        double const end_tick = start_tick + (map[i + 1].time_ms - start_ms) / ms_per_tick;
+        if (tick < end_tick) {
+            return start_ms + (tick - start_tick) * ms_per_tick;
+        }
+        start_ms = map[i + 1].time_ms;
+        start_tick = end_tick;
+    }
+}
+
+}  // namespace
+
+// Test tempo lookup and the order rule for changes
+TEST(tempo_map_test, lookup) {
+    tempo_map map(tempo_us_per_beat(120));
+    EXPECT_EQ(map[0].us_per_beat, 500000u);
+    EXPECT_TRUE(map.add(1000, tempo_us_per_beat(60)));
+    EXPECT_TRUE(map.add(5000, tempo_us_per_beat(150)));
+    EXPECT_FALSE(map.add(5000, tempo_us_per_beat(90)));  // not after the last change
+    EXPECT_FALSE(map.add(6000, 0));
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_EQ(map.us_per_beat_at(999), 500000u);
+    EXPECT_EQ(map.us_per_beat_at(1000), 1000000u);
+    EXPECT_EQ(map.us_per_beat_at(4999), 1000000u);
+    EXPECT_EQ(map.us_per_beat_at(UINT32_MAX), 400000u);
+    EXPECT_NEAR(tick_time_ms(map, TEMPO_PPQ * 2), 1000.0, 1e-9);
+    EXPECT_NEAR(tick_time_ms(map, TEMPO_PPQ * 6), 5000.0, 1e-9);
+    EXPECT_NEAR(tick_time_ms(map, TEMPO_PPQ * 7), 5400.0, 1e-9);
+}
+
+// Test a tempo change mid-period keeps the phase and later periods use the new tempo
+TEST(tempo_map_test, change_keeps_phase) {
+    tempo_map map(tempo_us_per_beat(120));
+    map.add(1250, tempo_us_per_beat(60));  // halfway through the second off beat
+    tempo_bank bank(map);
+    bank.add(TEMPO_PPQ, TEMPO_PPQ);
+    std::vector<uint32_t> edges;
+    bool on = false;
+    for (uint32_t t = 0; t <= 6000; ++t) {
+        bank.update(t);
+        if (bank.is_on(0) != on) {
+            on = bank.is_on(0);
+            edges.push_back(t);
+        }
+    }
+    // 500 ms beats at 120 bpm; the off beat from 1000 is half done at 1250, its other
+    // half takes 500 ms at 60 bpm, then whole beats of 1000 ms
+    std::vector<uint32_t> const expected = {500, 1000, 1750, 2750, 3750, 4750, 5750};
+    EXPECT_EQ(edges, expected);
+    EXPECT_EQ(bank.us_per_beat(), 1000000u);
+    EXPECT_EQ(bank.next_edge(0), 8 * TEMPO_PPQ);
+
+    // Added mid-song, a controller joins the grid it would have run on from tick 0
+    EXPECT_EQ(bank.add(TEMPO_PPQ, TEMPO_PPQ), 1u);
+    EXPECT_EQ(bank.is_on(1), bank.is_on(0));
+    EXPECT_EQ(bank.next_edge(1), bank.next_edge(0));
+
+    // Sparse updates land on the grid: the on beat from 500 has ended by 1000, and the
+    // change at 1250 is applied on the way to 1700
+    tempo_bank sparse(map);
+    sparse.add(TEMPO_PPQ, TEMPO_PPQ);
+    sparse.update(1000);
+    EXPECT_FALSE(sparse.is_on(0));
+    EXPECT_EQ(sparse.next_edge(0), 3 * TEMPO_PPQ);
+    sparse.update(1700);
+    EXPECT_FALSE(sparse.is_on(0));
+    sparse.update(1750);
+    EXPECT_TRUE(sparse.is_on(0));
+}
+
+// Test edges stay within a millisecond of their ideal tick times over a long, uneven song
+TEST(tempo_map_test, edges_stay_on_grid) {
+    tempo_map map(tempo_us_per_beat(140));
+    map.add(300000, tempo_us_per_beat(97));
+    map.add(600001, tempo_us_per_beat(173));
+    map.add(900007, tempo_us_per_beat(140));
+    tempo_bank bank(map);
+    uint32_t const lengths[4][2] = {
+        {TEMPO_PPQ / 3, TEMPO_PPQ / 3},           // triplets: 142.86 ms at 140 bpm
+        {TEMPO_PPQ * 3 / 4, TEMPO_PPQ / 4},       // dotted eighth, sixteenth
+        {TEMPO_PPQ / 8, TEMPO_PPQ * 7 / 8},       // thirty-second flash per beat
+        {TEMPO_PPQ * 7 / 5, TEMPO_PPQ * 11 / 5},  // quintuplet lengths off the beat
+    };
+    for (size_t i = 0; i < 4; ++i) {
+        bank.add(lengths[i][0], lengths[i][1]);
+    }
+
+    uint64_t edge_tick[4] = {0, 0, 0, 0};
+    size_t edges[4] = {0, 0, 0, 0};
+    double worst = 0;
+    for (uint32_t t = 0; t <= 1200000; ++t) {  // 20 minutes at 1 ms
+        bank.update(t);
+        for (size_t i = 0; i < 4; ++i) {
+            if (bank.is_on(i) == (edges[i] % 2 == 0)) {
+                // The edge just taken ends an off length on even counts, an on length on odd
+                edge_tick[i] += lengths[i][edges[i] % 2 == 0 ? 1 : 0];
+                ++edges[i];
+                double const error = t - tick_time_ms(map, edge_tick[i]);
+                ASSERT_GE(error, 0.0) << "#" << i << " edge " << edges[i];
+                ASSERT_LE(error, 1.0 + 1e-6) << "#" << i << " edge " << edges[i];
+                worst = error > worst ? error : worst;
+            }
+        }
+    }
+    std::printf("edges %zu / %zu / %zu / %zu over 20 minutes, worst %.3f ms after the grid\n",
+                edges[0], edges[1], edges[2], edges[3], worst);
+    EXPECT_GT(edges[0], 8000u);  // no toggle was missed or doubled
+}
+
+// Test the SIMD pass matches the scalar reference through many tempo changes
+TEST(tempo_map_test, matches_reference) {
+    std::mt19937 rng(98);
+    tempo_map map(tempo_us_per_beat(128));
+    uint32_t time_ms = 0;
+    for (size_t i = 0; i < 60; ++i) {
+        time_ms += 50 + rng() % 700;
+        map.add(time_ms, tempo_us_per_beat(40 + rng() % 200));
+    }
+    tempo_bank bank(map);
+    size_t const COUNT = 203;  // not a multiple of the SIMD width
+    std::vector<reference_controller> reference(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        reference_controller& r = reference[i];
+        r.on_ticks = rng() % (4 * TEMPO_PPQ);  // includes 0-tick periods
+        r.off_ticks = rng() % (4 * TEMPO_PPQ);
+        r.align(0);
+        EXPECT_EQ(bank.add(r.on_ticks, r.off_ticks), i);
+    }
+
+    uint32_t last_ticks = 0;
+    for (uint32_t t = 0; t < time_ms + 2000; t += 1 + rng() % 3) {
+        bank.update(t);
+        ASSERT_GE(bank.ticks(), last_ticks);
+        last_ticks = bank.ticks();
+        for (size_t i = 0; i < COUNT; ++i) {
+            reference[i].update(bank.ticks());
+            ASSERT_EQ(bank.is_on(i), reference[i].on) << "t=" << t << " #" << i;
+            ASSERT_EQ(bank.next_edge(i), reference[i].next_edge) << "t=" << t << " #" << i;
+        }
+    }
+}
+
+// Benchmark a tempo change over 100k controllers, and the update after it, against rebuilding
+TEST(tempo_map_test, retime_benchmark) {
+    size_t const COUNT = 100000;
+    size_t const CHANGES = 200;
+    std::mt19937 rng(100);
+    tempo_map map(tempo_us_per_beat(120));
+    tempo_bank bank(map);
+    std::vector<uint32_t> on_ticks(COUNT);
+    std::vector<uint32_t> off_ticks(COUNT);
+    for (size_t i = 0; i < COUNT; ++i) {
+        on_ticks[i] = TEMPO_PPQ / 4 * (1 + rng() % 16);
+        off_ticks[i] = TEMPO_PPQ / 4 * (1 + rng() % 16);
+        bank.add(on_ticks[i], off_ticks[i]);
+    }
+    bank.update(777);
+    std::vector<uint32_t> const states_before(&bank.states()[0], &bank.states()[0] + COUNT);
+
+    auto const begin = std::chrono::steady_clock::now();
+    for (size_t c = 0; c < CHANGES; ++c) {
+        bank.set_tempo(777, tempo_us_per_beat(c % 2 == 0 ? 126 : 120));
+        bank.update(777);
+    }
+    auto const retimed = std::chrono::steady_clock::now();
+    // Baseline: what a tempo change costs rebuilding a millisecond bank (and losing phase)
+    for (size_t c = 0; c < CHANGES / 10; ++c) {
+        blink_bank rebuilt;
+        uint32_t const us_per_beat = tempo_us_per_beat(c % 2 == 0 ? 126 : 120);
+        for (size_t i = 0; i < COUNT; ++i) {
+            rebuilt.add(static_cast<uint32_t>(uint64_t(on_ticks[i]) * us_per_beat /
+                                              (TEMPO_PPQ * 1000u)),
+                        static_cast<uint32_t>(uint64_t(off_ticks[i]) * us_per_beat /
+                                              (TEMPO_PPQ * 1000u)));
+        }
+        EXPECT_EQ(rebuilt.size(), COUNT);
+    }
+    auto const end = std::chrono::steady_clock::now();
+
+    double const retime_us =
+        std::chrono::duration<double, std::micro>(retimed - begin).count() / CHANGES;
+    double const rebuild_us =
+        std::chrono::duration<double, std::micro>(end - retimed).count() / (CHANGES / 10);
+    std::printf("tempo change and update over %zu controllers: %.0f us (%.2f ns/controller), "
+                "rebuilding the bank %.0f us\n",
+                COUNT, retime_us, retime_us * 1000 / COUNT, rebuild_us);
+
+    // Changes at one instant move no controller: the position and every phase stay put
+    EXPECT_EQ(bank.us_per_beat(), tempo_us_per_beat(120));
+    EXPECT_EQ(bank.ticks(), 777u * TEMPO_PPQ / 500);
+    std::vector<uint32_t> const states_after(&bank.states()[0], &bank.states()[0] + COUNT);
+    EXPECT_EQ(states_after, states_before);
+    // Comfortably inside one frame at 60 fps
+    EXPECT_LT(retime_us, 16000.0);
+}
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "temporal_dither.h"
+
+namespace {
+
+// Mean 8-bit output of one channel over a number of frames
+double mean_output(temporal_dither& dither, size_t channel, int frames) {
+    uint64_t total = 0;
+    for (int i = 0; i < frames; ++i) {
+        total += dither.render()[channel];
+    }
+    return static_cast<double>(total) / frames;
+}
+
+}  // namespace
+
+// Test the SIMD pass equals the scalar pass frame by frame, including a partial block
+TEST(temporal_dither_test, simd_matches_scalar) {
+    std::mt19937 rng(88);
+    size_t const CHANNELS = 1000 + 7;
+    temporal_dither simd(CHANNELS);
+    temporal_dither scalar(CHANNELS);
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        uint16_t const level = static_cast<uint16_t>(c % 5 == 0 ? (c % 2) * 65535 : rng());
+        simd.set_level(c, level);
+        scalar.set_level(c, level);
+    }
+    for (int frame = 0; frame < 300; ++frame) {
+        uint8_t const* a = simd.render();
+        uint8_t const* b = scalar.render_scalar();
+        for (size_t c = 0; c < CHANNELS; ++c) {
+            ASSERT_EQ(a[c], b[c]) << "frame " << frame << " channel " << c;
+        }
+    }
+}
+
+// Test every 16-bit level averages to level * 255 / 65535 over 256 frames
+TEST(temporal_dither_test, average_level_accuracy) {
+    size_t const CHANNELS = 65536;
+    temporal_dither dither(CHANNELS);
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        dither.set_level(c, static_cast<uint16_t>(c));
+    }
+    std::vector<uint32_t> totals(CHANNELS, 0);
+    int const FRAMES = 256;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        uint8_t const* out = dither.render();
+        for (size_t c = 0; c < CHANNELS; ++c) {
+            totals[c] += out[c];
+        }
+    }
+    double worst = 0.0;
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        double const expected = static_cast<double>(c) * 255.0 / 65535.0;
+        worst = std::max(worst, std::fabs(static_cast<double>(totals[c]) / FRAMES - expected));
+    }
+    // One frame's carried fraction, spread over the run, plus the 1/256 mapping step
+    EXPECT_LT(worst, 2.0 / FRAMES);
+
+    // Low levels that plain 8-bit output would round to 0 or 1, over a long run: within the
+    // 8.8 fixed point resolution of 1/256 of an output step
+    double const RESOLUTION = 1.0 / 256;
+    temporal_dither dim(3);
+    dim.set_level(0, 100);
+    dim.set_level(1, 300);
+    dim.set_level(2, 700);
+    EXPECT_NEAR(mean_output(dim, 0, 2560), 100 * 255.0 / 65535.0, RESOLUTION);
+    EXPECT_NEAR(mean_output(dim, 1, 2560), 300 * 255.0 / 65535.0, RESOLUTION);
+    EXPECT_NEAR(mean_output(dim, 2, 2560), 700 * 255.0 / 65535.0, RESOLUTION);
+}
+
+// Test exact levels never flicker and outputs only straddle the target
+TEST(temporal_dither_test, exact_levels_are_steady) {
+    temporal_dither dither(4);
+    dither.set_level(0, 0);
+    dither.set_level(1, 65535);
+    dither.set_level(2, 257 * 100);
+    dither.set_level(3, 257 * 100 + 128);
+    for (int frame = 0; frame < 500; ++frame) {
+        uint8_t const* out = dither.render();
+        ASSERT_EQ(out[0], 0);
+        ASSERT_EQ(out[1], 255);
+        ASSERT_EQ(out[2], 100);
+        ASSERT_GE(out[3], 100);
+        ASSERT_LE(out[3], 101);
+    }
+    EXPECT_EQ(dither.level(3), 257 * 100 + 128);
+    EXPECT_EQ(dither.channels(), 4u);
+}
+
+// Test a slow low-brightness fade rises smoothly instead of in visible 8-bit steps
+TEST(temporal_dither_test, slow_fade_is_smooth) {
+    // Fade 0 -> 4/255 over 10 s at 100 frames per second, one new 16-bit level per frame
+    temporal_dither dither(1);
+    int const FRAMES = 1000;
+    uint32_t const TOP = 4 * 257;
+    std::vector<double> window_means;
+    int const WINDOW = 20;  // 200 ms, roughly what the eye integrates
+    uint32_t window_total = 0;
+    for (int frame = 0; frame < FRAMES; ++frame) {
+        dither.set_level(0, static_cast<uint16_t>(TOP * static_cast<uint32_t>(frame) / FRAMES));
+        window_total += dither.render()[0];
+        if ((frame + 1) % WINDOW == 0) {
+            window_means.push_back(static_cast<double>(window_total) / WINDOW);
+            window_total = 0;
+        }
+    }
+    // Undithered output is 0, 1, 2, 3: three jumps of a whole step. Dithered windows
+    // move in small increments and never go backwards by more than one frame's worth.
+    double largest_step = 0.0;
+    for (size_t i = 1; i < window_means.size(); ++i) {
+        largest_step = std::max(largest_step, window_means[i] - window_means[i - 1]);
+        EXPECT_GE(window_means[i] - window_means[i - 1], -1.0 / WINDOW - 1e-9) << i;
+    }
+    EXPECT_LE(largest_step, 0.2);
+    EXPECT_NEAR(window_means.back(), 4.0 * (FRAMES - WINDOW / 2) / FRAMES, 0.1);
+}
+
+// Benchmark: per-frame cost of the dithering pass at 10k channels
+TEST(temporal_dither_test, frame_cost) {
+    std::mt19937 rng(1088);
+    size_t const CHANNELS = 10000;
+    temporal_dither dither(CHANNELS);
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        dither.set_level(c, static_cast<uint16_t>(rng()));
+    }
+    int const FRAMES = 2000;
+    uint32_t checksum = 0;
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        checksum += dither.render()[static_cast<size_t>(i) % CHANNELS];
+    }
+    double const frame_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start)
+            .count() /
+        FRAMES;
+
+    auto const scalar_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < FRAMES; ++i) {
+        checksum += dither.render_scalar()[static_cast<size_t>(i) % CHANNELS];
+    }
+    double const scalar_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - scalar_start)
+            .count() /
+        FRAMES;
+    std::printf("10k channels: %.2f us per frame (scalar %.2f us, checksum %u)\n", frame_us,
+                scalar_us, checksum);
+    // Well inside a 100 Hz frame
+    EXPECT_LT(frame_us, 1000.0);
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "blink_controller.h"
+#include "tickless_runner.h"
+
+namespace {
+
+// Pin that records the true (simulated) time of every edge
+struct edge_pin {
+    void set(bool state) {
+        if (state != on) {
+            edges_us.push_back(platform->true_us());
+            on = state;
+        }
+    }
+
+    simulated_sleep_platform const* platform = nullptr;
+    bool on = false;
+    std::vector<uint64_t> edges_us;
+};
+
+struct show_result {
+    double average_ma;
+    double power_down_share;
+    uint32_t correction_ms;
+    int64_t clock_error_ms;
+};
+
+// Four controllers for an hour of simulated time under the given depth limit
+show_result run_show(sleep_depth deepest) {
+    simulated_sleep_platform platform;
+    edge_pin pins[4];
+    for (size_t i = 0; i < 4; ++i) {
+        pins[i].platform = &platform;
+    }
+    blink_controller<edge_pin> controllers[4] = {blink_controller<edge_pin>(pins[0], 1000, 500),
+                                                 blink_controller<edge_pin>(pins[1], 300, 700),
+                                                 blink_controller<edge_pin>(pins[2], 2000, 2000),
+                                                 blink_controller<edge_pin>(pins[3], 50, 4950)};
+    tickless_runner<simulated_sleep_platform, blink_controller<edge_pin>> runner(
+        platform, controllers, 4, deepest);
+    while (platform.true_us() < 3600ull * 1000000) {
+        runner.step();
+    }
+    show_result result;
+    result.average_ma = platform.average_ma();
+    result.power_down_share = static_cast<double>(platform.time_in_us(sleep_depth::power_down)) /
+                              static_cast<double>(platform.true_us());
+    result.correction_ms = runner.correction_ms();
+    result.clock_error_ms =
+        static_cast<int64_t>(runner.now()) - static_cast<int64_t>(platform.true_us() / 1000);
+    return result;
+}
+
+}  // namespace
+
+// Test edges land on time although millis() stops in power-down
+TEST(tickless_runner_test, edges_on_time) {
+    simulated_sleep_platform platform;
+    edge_pin pins[2];
+    pins[0].platform = &platform;
+    pins[1].platform = &platform;
+    blink_controller<edge_pin> controllers[2] = {blink_controller<edge_pin>(pins[0], 1000, 500),
+                                                 blink_controller<edge_pin>(pins[1], 300, 700)};
+    tickless_runner<simulated_sleep_platform, blink_controller<edge_pin>> runner(platform,
+                                                                                 controllers, 2);
+    while (platform.true_us() < 60ull * 1000000) {
+        runner.step();
+    }
+
+    // Ideal edges: off period first, then alternating; allow the wake time and 1 ms rounding
+    uint32_t const durations[2][2] = {{500, 1000}, {700, 300}};
+    for (size_t c = 0; c < 2; ++c) {
+        ASSERT_GT(pins[c].edges_us.size(), 50u);
+        uint64_t ideal_us = 0;
+        for (size_t e = 0; e < pins[c].edges_us.size(); ++e) {
+            ideal_us += durations[c][e % 2] * 1000ull;
+            EXPECT_GE(pins[c].edges_us[e] + 1000, ideal_us) << c << " " << e;
+            EXPECT_LE(pins[c].edges_us[e], ideal_us + 2000) << c << " " << e;
+        }
+    }
+    EXPECT_GT(runner.correction_ms(), 50000u);
+    EXPECT_LE(std::llabs(static_cast<long long>(runner.now()) -
+                         static_cast<long long>(platform.true_us() / 1000)),
+              1);
+    EXPECT_LT(runner.wakes(), 60u * 20);  // not a spin: a few wakes per edge
+}
+
+// Test the battery estimate for an hour of show at each allowed depth
+TEST(tickless_runner_test, battery_estimate) {
+    show_result const deep = run_show(sleep_depth::power_down);
+    show_result const idle = run_show(sleep_depth::idle);
+    sleep_power_model const model;
+
+    EXPECT_GT(deep.power_down_share, 0.9);
+    EXPECT_LT(deep.average_ma, model.active_ma / 10);
+    EXPECT_LE(std::llabs(deep.clock_error_ms), 1);
+    EXPECT_EQ(idle.power_down_share, 0.0);
+    EXPECT_EQ(idle.correction_ms, 0u);
+    EXPECT_LT(idle.average_ma, model.active_ma);
+    EXPECT_GT(idle.average_ma, model.idle_ma);
+
+    double const capacity_mah = 2000.0;
+    std::printf("tickless: 2000 mAh lasts %.0f h spinning (%.2f mA), %.0f h idle-only (%.2f mA), "
+                "%.0f h with power-down (%.3f mA, %.1f%% of the time)\n",
+                capacity_mah / model.active_ma, model.active_ma, capacity_mah / idle.average_ma,
+                idle.average_ma, capacity_mah / deep.average_ma, deep.average_ma,
+                deep.power_down_share * 100);
+}
@@ -0,0 +1,271 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "blink_controller.h"
+#include "trace_checker.h"
+
+namespace {
+
+// Per-millisecond states of one channel, from a trace (brute-force reference)
+std::vector<uint8_t> rasterize(pin_trace const& trace, size_t channel) {
+    std::vector<uint8_t> states(trace.end_ms(), 0);
+    std::vector<uint64_t> const& edges = trace.edges(channel);
+    for (size_t i = 0; i < edges.size(); i += 2) {
+        uint64_t const end = i + 1 < edges.size() ? edges[i + 1] : trace.end_ms();
+        for (uint64_t t = edges[i]; t < end; ++t) {
+            states[t] = 1;
+        }
+    }
+    return states;
+}
+
+// Random on/off runs with the given maximum run length, ms resolution
+pin_trace random_trace(std::mt19937& rng, size_t channels, uint64_t end_ms, uint32_t max_run) {
+    pin_trace trace(channels);
+    std::vector<uint64_t> next(channels, 0);
+    std::vector<uint8_t> on(channels, 0);
+    for (uint64_t t = 0; t < end_ms; ++t) {
+        trace.set_time(t);
+        for (size_t c = 0; c < channels; ++c) {
+            if (t == next[c]) {
+                on[c] ^= 1;
+                next[c] = t + 1 + rng() % max_run;
+            }
+            trace.record(c, on[c] != 0);
+        }
+    }
+    trace.finish(end_ms);
+    return trace;
+}
+
+}  // namespace
+
+// Test a simulated controller's trace becomes the expected intervals
+TEST(trace_checker_test, records_controller_intervals) {
+    pin_trace trace(1);
+    trace_pin pin(trace, 0);
+    blink_controller<trace_pin> controller(pin, 300, 200);
+    for (uint32_t now = 0; now <= 2000; now += 50) {
+        trace.set_time(now);
+        controller.update(now);
+    }
+    interval_index const index(trace);
+    std::vector<on_interval> const& intervals = index.intervals(0);
+    ASSERT_EQ(intervals.size(), 4u);
+    EXPECT_EQ(intervals[0].start_ms, 200u);
+    EXPECT_EQ(intervals[0].end_ms, 500u);
+    EXPECT_EQ(intervals[3].start_ms, 1700u);
+    EXPECT_EQ(intervals[3].end_ms, 2000u);  // still on at the end of the trace
+    EXPECT_FALSE(index.on_at(0, 199));
+    EXPECT_TRUE(index.on_at(0, 200));
+    EXPECT_FALSE(index.on_at(0, 500));
+    EXPECT_EQ(index.on_time(0, 0, 2000), 1200u);
+    EXPECT_EQ(index.on_time(0, 350, 750), 150u + 50u);
+    EXPECT_EQ(index.on_time(0, 250, 260), 10u);
+    EXPECT_EQ(index.on_time(0, 500, 700), 0u);
+}
+
+// Test each rule kind on a hand-made trace
+TEST(trace_checker_test, rules) {
+    size_t const FOG = 0;
+    size_t const RELAY_A = 1;
+    size_t const RELAY_B = 2;
+    size_t const STROBE = 3;
+    pin_trace trace(4);
+    struct edge {
+        uint64_t time_ms;
+        size_t channel;
+        bool on;
+    };
+    edge const edges[] = {
+        {0, FOG, true},        {8000, FOG, false},    {20000, FOG, true},   {32000, FOG, false},
+        {1000, RELAY_A, true}, {2000, RELAY_A, false}, {2000, RELAY_B, true},  // handover
+        {2500, RELAY_A, true}, {2600, RELAY_B, false}, {3000, RELAY_A, false},
+    };
+    for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) {
+        trace.set_time(edges[i].time_ms);
+        trace.record(edges[i].channel, edges[i].on);
+    }
+    // Strobe: 100 on / 100 off, then a 5 s burst of 150 on / 50 off
+    for (uint64_t t = 0; t < 40000; t += 200) {
+        bool const burst = t >= 30000 && t < 35000;
+        trace.set_time(t);
+        trace.record(STROBE, true);
+        trace.set_time(t + (burst ? 150 : 100));
+        trace.record(STROBE, false);
+    }
+    trace.finish(40000);
+
+    std::vector<trace_rule> rules;
+    rules.push_back(trace_rule::max_on(FOG, 10000));
+    rules.push_back(trace_rule::exclusive(std::vector<size_t>{RELAY_A, RELAY_B}));
+    rules.push_back(trace_rule::duty(STROBE, 2000, 1100));
+    std::vector<trace_violation> violations;
+    EXPECT_FALSE(check_trace_rules(interval_index(trace), rules, violations));
+
+    ASSERT_EQ(violations.size(), 3u);
+    EXPECT_EQ(violations[0].rule, 0u);
+    EXPECT_EQ(violations[0].start_ms, 20000u);
+    EXPECT_EQ(violations[0].value, 12000u);
+    EXPECT_EQ(violations[1].rule, 1u);
+    EXPECT_EQ(violations[1].start_ms, 2500u);
+    EXPECT_EQ(violations[1].end_ms, 2600u);
+    EXPECT_EQ(violations[1].value, 2u);
+    EXPECT_EQ(violations[2].rule, 2u);
+    EXPECT_EQ(violations[2].channel, STROBE);
+    EXPECT_EQ(violations[2].value, 1500u);  // 10 burst pulses of 150 ms
+    EXPECT_GE(violations[2].start_ms, 28000u);
+    EXPECT_LE(violations[2].end_ms, 37000u);
+
+    // Relaxed limits pass
+    rules[0].limit_ms = 12000;
+    rules[1].limit_count = 2;
+    rules[2].limit_ms = 1500;
+    violations.clear();
+    EXPECT_TRUE(check_trace_rules(interval_index(trace), rules, violations));
+}
+
+// Test the sweeps against per-millisecond brute force on random traces
+TEST(trace_checker_test, matches_brute_force) {
+    std::mt19937 rng(85);
+    for (int round = 0; round < 20; ++round) {
+        uint64_t const END = 5000;
+        pin_trace const trace = random_trace(rng, 3, END, 1 + round * 20);
+        interval_index const index(trace);
+        std::vector<std::vector<uint8_t>> states;
+        for (size_t c = 0; c < 3; ++c) {
+            states.push_back(rasterize(trace, c));
+        }
+
+        // on_time
+        for (int q = 0; q < 200; ++q) {
+            uint64_t const from = rng() % END;
+            uint64_t const to = from + rng() % (END - from + 1);
+            uint64_t expected = 0;
+            for (uint64_t t = from; t < to; ++t) {
+                expected += states[0][t];
+            }
+            ASSERT_EQ(index.on_time(0, from, to), expected) << from << ".." << to;
+        }
+
+        // exclusive: violation spans cover exactly the ms with two or more on
+        std::vector<trace_violation> violations;
+        std::vector<trace_rule> rules(1, trace_rule::exclusive(std::vector<size_t>{0, 1, 2}));
+        check_trace_rules(index, rules, violations);
+        std::vector<uint8_t> covered(END, 0);
+        for (size_t v = 0; v < violations.size(); ++v) {
+            for (uint64_t t = violations[v].start_ms; t < violations[v].end_ms; ++t) {
+                covered[t] = 1;
+            }
+        }
+        for (uint64_t t = 0; t < END; ++t) {
+            ASSERT_EQ(covered[t], states[0][t] + states[1][t] + states[2][t] > 1 ? 1 : 0) << t;
+        }
+
+        // duty: the worst window found is the worst window there is
+        uint64_t const WINDOW = 100 + round * 37;
+        uint64_t worst = 0;
+        for (uint64_t from = 0; from < END; ++from) {
+            uint64_t on = 0;
+            for (uint64_t t = from; t < from + WINDOW && t < END; ++t) {
+                on += states[1][t];
+            }
+            worst = std::max(worst, on);
+        }
+        uint64_t const limit = worst * 3 / 4;
+        violations.clear();
+        rules.assign(1, trace_rule::duty(1, WINDOW, limit));
+        check_trace_rules(index, rules, violations);
+        uint64_t found = 0;
+        for (size_t v = 0; v < violations.size(); ++v) {
+            found = std::max(found, violations[v].value);
+        }
+        EXPECT_EQ(found, worst > limit ? worst : 0u) << round;
+    }
+}
+
+// Test the rule file format
+TEST(trace_checker_test, parse_rules) {
+    std::vector<std::string> const names = {"fog", "relay_a", "relay_b", "strobe"};
+    std::string const text =
+        "# pre-show safety\n"
+        "max_on fog 10000\n"
+        "exclusive relay_a relay_b   # one high-current relay at a time\n"
+        "exclusive relay_a relay_b strobe max 2\n"
+        "\n"
+        "duty strobe 60000 20000\n";
+    std::vector<trace_rule> rules;
+    size_t error_line = 0;
+    ASSERT_TRUE(parse_trace_rules(text, names, rules, error_line));
+    ASSERT_EQ(rules.size(), 4u);
+    EXPECT_EQ(rules[0].kind, trace_rule_kind::max_on);
+    EXPECT_EQ(rules[0].limit_ms, 10000u);
+    EXPECT_EQ(rules[1].channels, (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(rules[1].limit_count, 1u);
+    EXPECT_EQ(rules[2].limit_count, 2u);
+    EXPECT_EQ(rules[3].window_ms, 60000u);
+    EXPECT_EQ(rules[3].limit_ms, 20000u);
+
+    char const* const bad[] = {"max_on smoke 10\n",     "max_on fog\n",
+                               "exclusive fog\n",       "exclusive fog strobe 2\n",
+                               "duty strobe 0 10\n",    "duty strobe 100\n",
+                               "max_brightness fog 1\n", "max_on 10 fog\n",
+                               "exclusive fog max strobe\n", "exclusive fog max strobe 2\n",
+                               "exclusive fog strobe max\n", "exclusive fog strobe max 0\n"};
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+        rules.clear();
+        EXPECT_FALSE(parse_trace_rules(std::string("max_on fog 1\n") + bad[i], names, rules,
+                                       error_line))
+            << bad[i];
+        EXPECT_EQ(error_line, 2u) << bad[i];
+    }
+}
+
+// Test a night of edges (millions) checks in seconds
+TEST(trace_checker_test, night_of_edges) {
+    size_t const CHANNELS = 32;
+    uint64_t const NIGHT_MS = 8ull * 3600 * 1000;
+    pin_trace trace(CHANNELS);
+    std::mt19937 rng(1085);
+    uint64_t edges = 0;
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        bool on = false;
+        for (uint64_t t = 0; t < NIGHT_MS; t += 20 + rng() % 400) {
+            on = !on;
+            trace.set_time(t);
+            trace.record(c, on);
+            ++edges;
+        }
+    }
+    trace.finish(NIGHT_MS);
+
+    std::vector<trace_rule> rules;
+    for (size_t c = 0; c < CHANNELS; ++c) {
+        rules.push_back(trace_rule::max_on(c, 10000));
+        rules.push_back(trace_rule::duty(c, 60000, 45000));
+    }
+    std::vector<size_t> relays;
+    for (size_t c = 0; c < 8; ++c) {
+        relays.push_back(c);
+    }
+    rules.push_back(trace_rule::exclusive(relays, 6));
+
+    auto const start = std::chrono::steady_clock::now();
+    interval_index const index(trace);
+    auto const indexed = std::chrono::steady_clock::now();
+    std::vector<trace_violation> violations;
+    check_trace_rules(index, rules, violations);
+    auto const checked = std::chrono::steady_clock::now();
+
+    double const index_s = std::chrono::duration<double>(indexed - start).count();
+    double const check_s = std::chrono::duration<double>(checked - indexed).count();
+    std::printf("%llu edges: index %.3f s, %zu rules %.3f s, %zu violations\n",
+                static_cast<unsigned long long>(edges), index_s, rules.size(), check_s,
+                violations.size());
+    EXPECT_GT(edges, 2000000u);
+    EXPECT_LT(index_s + check_s, 10.0);
+}
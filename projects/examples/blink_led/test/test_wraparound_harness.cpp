@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "mock_hardware.h"
+#include "wraparound_harness.h"
+
+namespace {
+
+// blink_controller with the classic off-by-one wraparound bug, to prove the
+// harness can catch it
+template<typename output_pin_t>
+struct off_by_one_wrap_controller {
+   public:
+    off_by_one_wrap_controller(output_pin_t& output, uint32_t on_ms, uint32_t off_ms)
+        : output_(output), on_ms_(on_ms), off_ms_(off_ms), last_ms_(0), on_(false) {}
+
+    void update(uint32_t now_ms) {
+        uint32_t const elapsed =
+            now_ms >= last_ms_ ? now_ms - last_ms_ : (UINT32_MAX - last_ms_) + now_ms;
+        if (elapsed >= (on_ ? on_ms_ : off_ms_)) {
+            on_ = !on_;
+            last_ms_ = now_ms;
+        }
+        output_.set(on_);
+    }
+
+    void restart(uint32_t now_ms) {
+        last_ms_ = now_ms;
+        on_ = false;
+        output_.set(false);
+    }
+
+   private:
+    output_pin_t& output_;
+    uint32_t on_ms_;
+    uint32_t off_ms_;
+    uint32_t last_ms_;
+    bool on_;
+};
+
+}  // namespace
+
+// Test the model against a hand-stepped controller across the wrap
+TEST(blink_reference_model_test, matches_controller_across_wrap) {
+    uint64_t const start = (1ull << 32) - 1000;
+    blink_reference_model const model(100, 50, start, 1);
+    mock_pin pin;
+    blink_controller<mock_pin> controller(pin, 100, 50);
+
+    for (uint64_t t = start; t < start + 5000; ++t) {
+        controller.update(static_cast<uint32_t>(t));
+        ASSERT_EQ(pin.get_state(), model.state_at(t)) << t;
+    }
+}
+
+// Test the model's first toggle before and after the off duration
+TEST(blink_reference_model_test, first_toggle) {
+    EXPECT_EQ(blink_reference_model(100, 500, 0, 1).first_toggle(), 500u);
+    EXPECT_EQ(blink_reference_model(100, 500, 0, 7).first_toggle(), 504u);
+    EXPECT_EQ(blink_reference_model(100, 500, 9000, 1).first_toggle(), 9000u);
+    EXPECT_EQ(blink_reference_model(0, 0, 0, 1).first_toggle(), 0u);
+}
+
+// Test zero durations behave as one-sample phases
+TEST(blink_reference_model_test, zero_durations) {
+    blink_reference_model const model(0, 0, 0, 1);
+    EXPECT_EQ(model.period(), 2u);
+    EXPECT_TRUE(model.state_at(0));
+    EXPECT_FALSE(model.state_at(1));
+    EXPECT_TRUE(model.state_at(2));
+}
+
+// Test fill() agrees with state_at() sample by sample
+TEST(blink_reference_model_test, fill_matches_state_at) {
+    blink_reference_model const model(13, 29, 5, 3);
+    std::vector<uint8_t> states(1000);
+    model.fill(5 + 3 * 7, states.size(), states.data());
+    for (size_t i = 0; i < states.size(); ++i) {
+        ASSERT_EQ(states[i] != 0, model.state_at(5 + 3 * (7 + i))) << i;
+    }
+}
+
+// Test a segment seeded mid-sweep behaves like a continuous run
+TEST(wraparound_harness_test, seeded_segments_pass) {
+    wraparound_sweep sweep = {(1ull << 32) - 100000, 1, 300000, 25000};
+    wraparound_config const configs[] = {{1000, 500}, {0, 7}, {7, 0}, {100, 100}};
+    std::vector<wraparound_config> const list(configs, configs + 4);
+    EXPECT_TRUE(verify_wraparound(list, sweep, 2).empty());
+}
+
+// Test shipped configurations over the whole 32-bit range (sampled) on all cores
+TEST(wraparound_harness_test, shipped_configs_sampled_full_range) {
+    std::vector<wraparound_mismatch> const mismatches =
+        verify_wraparound(shipped_wraparound_configs(), wraparound_sweep::sampled(4099));
+    for (size_t i = 0; i < mismatches.size(); ++i) {
+        ADD_FAILURE() << "on=" << mismatches[i].on_ms << " off=" << mismatches[i].off_ms
+                      << " t=" << mismatches[i].time;
+    }
+}
+
+// Test the harness catches a wraparound bug
+TEST(wraparound_harness_test, detects_off_by_one_wrap) {
+    wraparound_sweep const sweep = {(1ull << 32) - 10000, 1, 20000, 4096};
+    wraparound_config const config = {100, 100};
+    std::vector<wraparound_mismatch> const mismatches =
+        verify_wraparound<off_by_one_wrap_controller>(std::vector<wraparound_config>(1, config),
+                                                      sweep, 1);
+    ASSERT_EQ(mismatches.size(), 1u);
+    EXPECT_GE(mismatches[0].time, 1ull << 32);  // only wrong after the wrap
+}
@@ -0,0 +1,73 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "wraparound_harness.h"
+
+/**
+ * @brief Exhaustive wraparound verification of blink_controller
+ *
+ * Checks update() against the closed-form reference model for every shipped
+ * timing configuration. By default every uint32 millisecond value is visited
+ * (the counter wraps once); --sampled N checks every Nth millisecond instead.
+ *
+ * Usage: verify_wraparound [--sampled N] [--threads N]
+ * Exit status is 1 if any configuration disagrees with the model, 2 on bad arguments.
+ */
+namespace {
+
+// Positive integer option value, or 0 if missing, malformed or out of range
+uint32_t parse_count(int argc, char** argv, int i) {
+    if (i + 1 >= argc) {
+        return 0;
+    }
+    char* end = nullptr;
+    unsigned long const value = std::strtoul(argv[i + 1], &end, 10);
+    if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-' || value > UINT32_MAX) {
+        return 0;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    wraparound_sweep sweep = wraparound_sweep::full();
+    unsigned threads = 0;
+    for (int i = 1; i < argc; i += 2) {
+        bool const sampled = std::strcmp(argv[i], "--sampled") == 0;
+        uint32_t const value = parse_count(argc, argv, i);
+        if ((!sampled && std::strcmp(argv[i], "--threads") != 0) || value == 0) {
+            std::fprintf(stderr, "usage: %s [--sampled N] [--threads N]  (N >= 1)\n", argv[0]);
+            return 2;
+        }
+        if (sampled) {
+            sweep = wraparound_sweep::sampled(value);
+        } else {
+            threads = value;
+        }
+    }
+
+    std::vector<wraparound_config> const configs = shipped_wraparound_configs();
+    std::printf("Verifying %zu configurations, %llu samples each (step %u ms)\n", configs.size(),
+                static_cast<unsigned long long>(sweep.count), sweep.step);
+
+    auto const start = std::chrono::steady_clock::now();
+    std::vector<wraparound_mismatch> const mismatches = verify_wraparound(configs, sweep, threads);
+    double const seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < mismatches.size(); ++i) {
+        std::printf("MISMATCH on=%u off=%u at t=%llu (uint32 %u): expected %s\n",
+                    mismatches[i].on_ms, mismatches[i].off_ms,
+                    static_cast<unsigned long long>(mismatches[i].time),
+                    static_cast<uint32_t>(mismatches[i].time),
+                    mismatches[i].expected ? "ON" : "OFF");
+    }
+    double const updates = static_cast<double>(sweep.count) * static_cast<double>(configs.size());
+    std::printf("%s in %.1f s (%.2f ns per update)\n", mismatches.empty() ? "PASS" : "FAIL",
+                seconds, seconds * 1e9 / updates);
+    return mismatches.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,299 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "blink_controller.h"
+
+/**
+ * @brief Closed-form reference model of blink_controller timing
+ *
+ * Models a fresh controller (off, last toggle 0) updated at absolute times
+ * start, start + step, start + 2*step, ... where the controller sees each time
+ * truncated to uint32_t. The model works in 64-bit time and never wraps, so
+ * it is an independent check of the controller's wraparound handling.
+ *
+ * - First toggle (to ON) at the first sample whose uint32 value is >= off
+ * - After that each phase lasts max(1, ceil(duration / step)) samples
+ *
+ * Valid while every effective phase is shorter than 2^32 ms (durations up to
+ * 2^31 with any step); longer phases would alias in the controller's 32-bit
+ * elapsed arithmetic by design.
+ */
+struct blink_reference_model {
+   public:
+    blink_reference_model(uint32_t on_ms, uint32_t off_ms, uint64_t start, uint32_t step)
+        : step_(step),
+          on_span_(phase_span(on_ms, step)),
+          period_(on_span_ + phase_span(off_ms, step)) {
+        if (start >= off_ms) {
+            first_toggle_ = start;
+        } else {
+            first_toggle_ = start + (off_ms - start + step - 1) / step * step;
+        }
+    }
+
+    /**
+     * @brief Expected LED state at sample time t (a sample time of this run)
+     */
+    bool state_at(uint64_t t) const {
+        if (t < first_toggle_) {
+            return false;
+        }
+        return (t - first_toggle_) % period_ < on_span_;
+    }
+
+    /**
+     * @brief Time of the last toggle at or before sample time t
+     *
+     * Only meaningful when t >= first_toggle().
+     */
+    uint64_t last_toggle_at(uint64_t t) const {
+        uint64_t const cycles = (t - first_toggle_) / period_;
+        uint64_t const cycle_start = first_toggle_ + cycles * period_;
+        return t - cycle_start < on_span_ ? cycle_start : cycle_start + on_span_;
+    }
+
+    /**
+     * @brief Fill expected states for count samples starting at sample time t
+     *
+     * Emits whole runs with memset, so cost is per edge, not per sample.
+     */
+    void fill(uint64_t t, size_t count, uint8_t* out) const {
+        size_t i = 0;
+        if (t < first_toggle_) {
+            size_t const before = static_cast<size_t>(
+                std::min<uint64_t>(count, (first_toggle_ - t + step_ - 1) / step_));
+            std::memset(out, 0, before);
+            i = before;
+        }
+        while (i < count) {
+            uint64_t const now = t + static_cast<uint64_t>(i) * step_;
+            uint64_t const phase = (now - first_toggle_) % period_;
+            bool const on = phase < on_span_;
+            uint64_t const remaining = (on ? on_span_ - phase : period_ - phase) / step_;
+            size_t const run = static_cast<size_t>(std::min<uint64_t>(count - i, remaining));
+            std::memset(out + i, on ? 1 : 0, run);
+            i += run;
+        }
+    }
+
+    uint64_t first_toggle() const { return first_toggle_; }
+    uint64_t period() const { return period_; }
+    uint64_t on_span() const { return on_span_; }
+
+   private:
+    static uint64_t phase_span(uint32_t duration_ms, uint32_t step) {
+        uint64_t const samples = (static_cast<uint64_t>(duration_ms) + step - 1) / step;
+        return std::max<uint64_t>(samples, 1) * step;
+    }
+
+    uint64_t step_;
+    uint64_t on_span_;
+    uint64_t period_;
+    uint64_t first_toggle_;
+};
+
+/**
+ * @brief Output pin that appends each state to a byte buffer
+ */
+struct buffer_pin {
+   public:
+    void set(bool state) { *cursor_++ = state ? 1 : 0; }
+    void reset(uint8_t* buffer) { cursor_ = buffer; }
+
+   private:
+    uint8_t* cursor_ = nullptr;
+};
+
+/// One timing configuration to verify
+struct wraparound_config {
+    uint32_t on_ms;
+    uint32_t off_ms;
+};
+
+/// First disagreement between controller and model
+struct wraparound_mismatch {
+    bool found;
+    uint32_t on_ms;
+    uint32_t off_ms;
+    uint64_t time;
+    bool expected;
+};
+
+/**
+ * @brief Sweep plan: which samples to check for each configuration
+ *
+ * Samples are start, start + step, ... for count samples. The full sweep is
+ * start 0, step 1 and count just over 2^32, so every uint32 value is seen
+ * (and the counter wraps once) for every configuration.
+ */
+struct wraparound_sweep {
+    uint64_t start;
+    uint32_t step;
+    uint64_t count;
+    uint64_t segment_samples;  // unit of parallel work
+
+    static wraparound_sweep full() {
+        wraparound_sweep const sweep = {0, 1, (1ull << 32) + (1ull << 20), 1ull << 26};
+        return sweep;
+    }
+
+    /// Every step-th millisecond across the whole range
+    static wraparound_sweep sampled(uint32_t step) {
+        wraparound_sweep const sweep = {0, step, ((1ull << 32) + (1ull << 20)) / step + 1,
+                                        1ull << 20};
+        return sweep;
+    }
+};
+
+/**
+ * @brief Check one segment of a sweep against the model
+ *
+ * The controller is seeded into the model's state at the segment start using
+ * its public restart()/update() API, so segments are independent and can run
+ * on any thread.
+ *
+ * @tparam controller_t blink_controller-compatible template (for mutation tests)
+ */
+template<template<typename> class controller_t>
+wraparound_mismatch verify_segment(wraparound_config const& config, wraparound_sweep const& sweep,
+                                   uint64_t first_sample, uint64_t sample_count) {
+    size_t const BLOCK = 4096;
+    std::vector<uint8_t> actual(BLOCK);
+    std::vector<uint8_t> expected(BLOCK);
+    blink_reference_model const model(config.on_ms, config.off_ms, sweep.start, sweep.step);
+    buffer_pin pin;
+    controller_t<buffer_pin> controller(pin, config.on_ms, config.off_ms);
+
+    uint64_t const t0 = sweep.start + first_sample * sweep.step;
+    pin.reset(actual.data());
+    if (first_sample > 0 && t0 > model.first_toggle()) {
+        // Seed: reproduce the last toggle before this segment
+        uint64_t const previous = t0 - sweep.step;
+        uint64_t const last = model.last_toggle_at(previous);
+        uint32_t const last32 = static_cast<uint32_t>(last);
+        if (model.state_at(previous)) {
+            controller.restart(last32 - config.off_ms);
+            controller.update(last32);
+        } else {
+            controller.restart(last32);
+        }
+        pin.reset(actual.data());
+    }
+
+    wraparound_mismatch result = {false, config.on_ms, config.off_ms, 0, false};
+    for (uint64_t done = 0; done < sample_count; done += BLOCK) {
+        size_t const n = static_cast<size_t>(std::min<uint64_t>(BLOCK, sample_count - done));
+        uint64_t const t = t0 + done * sweep.step;
+        pin.reset(actual.data());
+        for (size_t i = 0; i < n; ++i) {
+            controller.update(static_cast<uint32_t>(t + i * sweep.step));
+        }
+        model.fill(t, n, expected.data());
+        if (std::memcmp(actual.data(), expected.data(), n) != 0) {
+            size_t i = 0;
+            while (actual[i] == expected[i]) {
+                ++i;
+            }
+            result.found = true;
+            result.time = t + i * sweep.step;
+            result.expected = expected[i] != 0;
+            return result;
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Verify every configuration over a sweep, spread across threads
+ *
+ * Parallel across cores only. update() is the code under test and carries
+ * state from one sample to the next, so it runs scalar; the reference side
+ * is already bulk work (memset runs per edge, memcmp per 4096-sample block)
+ * and is a small share of the sweep.
+ *
+ * @param threads Worker count (0 = hardware concurrency)
+ * @return First mismatch per configuration that has one (empty = all pass)
+ */
+template<template<typename> class controller_t = blink_controller>
+std::vector<wraparound_mismatch> verify_wraparound(std::vector<wraparound_config> const& configs,
+                                                   wraparound_sweep const& sweep,
+                                                   unsigned threads = 0) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    uint64_t const segments = (sweep.count + sweep.segment_samples - 1) / sweep.segment_samples;
+    uint64_t const tasks = segments * configs.size();
+    std::atomic<uint64_t> next_task(0);
+    std::vector<wraparound_mismatch> results(configs.size());
+    std::vector<std::atomic<bool>> failed(configs.size());
+    for (size_t i = 0; i < configs.size(); ++i) {
+        results[i].found = false;
+        failed[i] = false;
+    }
+    std::vector<wraparound_mismatch> segment_failures(static_cast<size_t>(tasks));
+
+    auto worker = [&]() {
+        for (uint64_t task = next_task++; task < tasks; task = next_task++) {
+            size_t const config = static_cast<size_t>(task / segments);
+            if (failed[config]) {
+                continue;
+            }
+            uint64_t const segment = task % segments;
+            uint64_t const first = segment * sweep.segment_samples;
+            uint64_t const count = std::min(sweep.segment_samples, sweep.count - first);
+            segment_failures[task] =
+                verify_segment<controller_t>(configs[config], sweep, first, count);
+            if (segment_failures[task].found) {
+                failed[config] = true;
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (size_t i = 0; i < pool.size(); ++i) {
+        pool[i].join();
+    }
+
+    // Report the earliest failing segment of each configuration
+    std::vector<wraparound_mismatch> mismatches;
+    for (size_t config = 0; config < configs.size(); ++config) {
+        for (uint64_t segment = 0; segment < segments; ++segment) {
+            wraparound_mismatch const& failure =
+                segment_failures[static_cast<size_t>(config * segments + segment)];
+            if (failure.found) {
+                mismatches.push_back(failure);
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+/**
+ * @brief Timing configurations shipped in the demo, the sketch and the tests
+ */
+inline std::vector<wraparound_config> shipped_wraparound_configs() {
+    wraparound_config const configs[] = {
+        {1000, 500},         // blink_demo / blink_led.ino
+        {100, 100},          // fast blink
+        {5000, 5000},        // slow blink
+        {3000, 200},         // asymmetric
+        {0, 0},              // toggle every update
+        {0, 7},              // zero on-time
+        {7, 0},              // zero off-time
+        {1, 1},              // fastest real period
+        {60000, 0},          // trigger-driven (show_partition tests)
+        {65535, 1},          // 16-bit boundary
+        {86400000, 1},       // one day on
+        {1, 2147483648u},    // longest supported phase (2^31)
+    };
+    return std::vector<wraparound_config>(configs, configs + sizeof(configs) / sizeof(configs[0]));
+}